@@ -58,22 +58,43 @@ extern "C"
 {
 #endif /* __cplusplus */
 
+/* a plan and how to recreate it, which an upgrade publishes at once */
+typedef struct {
+     plan *pln;
+     plan_trace *trace;
+} apiplan_version;
+
 /* the API ``plan'' contains both the kernel plan and problem */
 struct X(plan_s) {
      plan *pln;
      problem *prb;
      size_t refcount;
      int sign;
+     plan_trace *trace; /* how to recreate PLN, or 0 */
+     size_t wssz; /* see X(plan_workspace_size) */
+     struct upgrade_s *up; /* FFTW_ANYTIME planning, or 0 */
+     const apiplan_version *cur; /* with UP, the one in use */
 };
 
 /* shorthand */
 typedef struct X(plan_s) apiplan;
 
+/* The plan of P and its trace.  While P is being upgraded (see
+   FFTW_ANYTIME in apiplan.c), another thread may replace P->CUR at
+   any time, so read it once per execution */
+#define APIPLAN_CUR(p) \
+  ((const apiplan_version *) X(apiplan_loadp)((void **) &(p)->cur))
+#define APIPLAN_PLN(p) ((p)->up ? APIPLAN_CUR(p)->pln : (p)->pln)
+#define APIPLAN_TRACE(p) ((p)->up ? APIPLAN_CUR(p)->trace : (p)->trace)
+
 /* complex type for internal use */
 typedef R C[2];
 
 #define EXTRACT_REIM(sign, c, r, i) X(extract_reim)(sign, (c)[0], r, i)
 
+/* the transform of P, without the operations of plan-with-edge.c */
+#define API_PROBLEM(p) X(edge_transform)((p)->prb)
+
 #define TAINT_UNALIGNED(p, flg) TAINT(p, ((flg) & FFTW_UNALIGNED) != 0)
 
 tensor *X(mktensor_rowmajor)(int rnk, const int *n,
@@ -94,6 +115,7 @@ int X(guru64_kosherp)(int rank, const X(iodim64) *dims,
 /* Note: FFTW_EXTERN is used for "internal" functions used in tests/hook.c */
 
 FFTW_EXTERN printer *X(mkprinter_file)(FILE *f);
+scanner *X(mkscanner_file)(FILE *f);
 
 printer *X(mkprinter_cnt)(size_t *cnt);
 printer *X(mkprinter_str)(char *s);
@@ -104,6 +126,12 @@ void X(configure_planner)(planner *plnr);
 void X(mapflags)(planner *, unsigned);
 
 apiplan *X(mkapiplan)(int sign, unsigned flags, problem *prb);
+apiplan *X(mkapiplan_replay)(int sign, problem *prb, plan_trace *t);
+problem *X(mkproblem_api_edge)(int sign, unsigned flags, problem *prb);
+void X(edge_suspend)(edgeop saved[2]);
+void X(edge_resume)(const edgeop saved[2]);
+void *X(apiplan_loadp)(void **p);
+problem *X(mkproblem_shadow)(const problem *prb, void **buf);
 
 rdft_kind *X(map_r2r_kind)(int rank, const X(r2r_kind) * kind);
 
@@ -111,6 +139,44 @@ typedef void (*planner_hook_t)(void);
 
 void X(set_planner_hooks)(planner_hook_t before, planner_hook_t after);
 
+/* X(run_batch), and thus X(execute_batch), calls WORK(DATA, I) for
+   0 <= I < N via the hook installed by the threads library */
+typedef void (*batch_hook_t)(int n, void (*work)(void *data, int i),
+			     void *data);
+
+void X(set_batch_hook)(batch_hook_t hook);
+void X(run_batch)(int n, void (*work)(void *data, int i), void *data);
+
+/* X(execute_async) hands WORK(DATA) to the threads library, which
+   runs in order the works whose byte ranges [RANGE[2*i],
+   RANGE[2*i+1]), 0 <= i < NRANGE, overlap.  SPAWN
+   returns a handle, or 0 if the work is already done.  WAIT waits
+   for the work and releases the handle. */
+typedef void *(*async_spawn_hook_t)(void (*work)(void *data), void *data,
+				    void *const *range, int nrange);
+typedef int (*async_test_hook_t)(void *task);
+typedef void (*async_wait_hook_t)(void *task);
+
+void X(set_async_hooks)(async_spawn_hook_t spawn, async_test_hook_t test,
+			async_wait_hook_t wait);
+
+int X(new_arrays_okp)(const X(plan) p);
+void X(execute_arrays)(const X(plan) p, void *in, void *out);
+
+/* X(mkapiplan) with FFTW_ANYTIME plans in the background with SPAWN,
+   TEST and WAIT, as in the async hooks, and publishes the better
+   plans with STOREP, which readers see through LOADP; see
+   APIPLAN_PLN */
+typedef void *(*upgrade_spawn_hook_t)(void (*work)(void *data),
+				      void *data);
+typedef void *(*upgrade_loadp_hook_t)(void **p);
+typedef void (*upgrade_storep_hook_t)(void **p, void *x);
+
+void X(set_upgrade_hooks)(upgrade_spawn_hook_t spawn,
+			  async_test_hook_t test, async_wait_hook_t wait,
+			  upgrade_loadp_hook_t loadp,
+			  upgrade_storep_hook_t storep);
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif /* __cplusplus */
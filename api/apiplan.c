@@ -28,16 +28,55 @@ void X(set_planner_hooks)(planner_hook_t before, planner_hook_t after)
      after_planner_hook = after;
 }
 
+static upgrade_spawn_hook_t upgrade_spawn_hook = 0;
+static async_test_hook_t upgrade_test_hook = 0;
+static async_wait_hook_t upgrade_wait_hook = 0;
+static upgrade_loadp_hook_t loadp_hook = 0;
+static upgrade_storep_hook_t storep_hook = 0;
+
+void X(set_upgrade_hooks)(upgrade_spawn_hook_t spawn,
+			  async_test_hook_t test, async_wait_hook_t wait,
+			  upgrade_loadp_hook_t loadp,
+			  upgrade_storep_hook_t storep)
+{
+     upgrade_spawn_hook = spawn;
+     upgrade_test_hook = test;
+     upgrade_wait_hook = wait;
+     loadp_hook = loadp;
+     storep_hook = storep;
+}
+
+void *X(apiplan_loadp)(void **p)
+{
+     return loadp_hook ? loadp_hook(p) : *p;
+}
+
+static void storep(void **p, void *x)
+{
+     if (storep_hook)
+	  storep_hook(p, x);
+     else
+	  *p = x;
+}
+
 static plan *mkplan0(planner *plnr, unsigned flags,
 		     const problem *prb, unsigned hash_info,
 		     wisdom_state_t wisdom_state)
 {
      /* map API flags into FFTW flags */
      X(mapflags)(plnr, flags);
+     plnr->no_execute_alloc = (flags & FFTW_NO_EXECUTE_ALLOC) != 0;
 
      plnr->flags.hash_info = hash_info;
      plnr->wisdom_state = wisdom_state;
 
+     if (plnr->trace) {
+	  plnr->trace->n = 0;
+	  plnr->trace->nthr = plnr->nthr;
+	  plnr->trace->flags = flags;
+	  plnr->trace->ok = 1;
+     }
+
      /* create plan */
      return plnr->adt->mkplan(plnr, prb);
 }
@@ -83,21 +122,317 @@ static plan *mkplan(planner *plnr, unsigned flags,
      return pln;
 }
 
+/* awake PLN and return the size of its workspace */
+static size_t awake(planner *plnr, plan *pln)
+{
+     size_t wssz;
+
+     X(planner_lock)(plnr);
+     X(scratch_layout_begin)(&wssz, plnr->nthr);
+     if (sizeof(trigreal) > sizeof(R)) {
+	  /* this is probably faster, and we have enough trigreal
+	     bits to maintain accuracy */
+	  X(plan_awake)(pln, AWAKE_SQRTN_TABLE);
+     } else {
+	  /* more accurate */
+	  X(plan_awake)(pln, AWAKE_SINCOS);
+     }
+     X(scratch_layout_end)();
+     X(planner_unlock)(plnr);
+     return wssz;
+}
+
+/* the trace of PLN, which PLNR has just created, for X(export_plan) */
+static plan_trace *detach_trace(planner *plnr, const plan *pln)
+{
+     plan_trace *t = plnr->trace;
+
+     plnr->trace = 0;
+     if (t && (!pln || !t->ok)) {
+	  X(trace_destroy)(t);
+	  t = 0;
+     }
+     return t;
+}
+
+/* put PLN to sleep and destroy it */
+static void destroy_awake(plan *pln)
+{
+     planner *plnr = X(the_planner)();
+     X(planner_lock)(plnr);
+     X(plan_awake)(pln, SLEEPY);
+     X(planner_unlock)(plnr);
+     X(plan_destroy_internal)(pln);
+}
+
+static apiplan *mkapi(int sign, problem *prb, plan *pln, plan_trace *t,
+		     size_t wssz)
+{
+     apiplan *p = (apiplan *) MALLOC(sizeof(apiplan), PLANS);
+     p->prb = prb;
+     p->refcount = 1u;
+     p->sign = sign; /* cache for execute_dft */
+     p->pln = pln;
+     p->trace = t;
+     p->wssz = wssz;
+     p->up = 0;
+     p->cur = 0;
+     return p;
+}
+
+/* whether plans can be created from wisdom without holding the
+   planner hooks, see below.  The planner lock alone does not suffice,
+   since X(plan_with_search_nthreads) installs it for its own threads
+   while the user may still plan from several threads under a lock of
+   their own; the planner hooks are set only by
+   X(make_planner_thread_safe), which makes the promise. */
+static int wise_concurrentp(const planner *plnr)
+{
+     return (before_planner_hook
+	     && plnr->lock_hook
+	     && !plnr->hook
+	     && !plnr->cost_hook
+	     && !plnr->wisdom_ok_hook
+	     && !plnr->nowisdom_hook
+	     && !plnr->bogosity_hook);
+}
+
+/* Create the plan from wisdom alone, in a view of the planner.  The
+   view shares the wisdom with the other threads, which are excluded
+   only while we insert new wisdom or awake the plan, and thus
+   threads that plan from wisdom run concurrently with each other and
+   with a thread that is searching.  While awakening a threaded plan,
+   this thread may execute work queued by a concurrent search (see
+   search_par() in kernel/planner.c), which would deadlock on the
+   planner lock that we hold; hence, in that case we also take the
+   planner hooks, which exclude any search.  Return 0 if the
+   wisdom is not sufficient, in which case the caller plans as
+   usual. */
+static apiplan *mkapiplan_wise(int sign, unsigned flags, problem *prb)
+{
+     planner *plnr = X(mkplanner_view)(X(the_planner)());
+     plan *pln;
+     plan_trace *t;
+     int hooks;
+     size_t wssz = 0;
+
+     plnr->trace = X(mktrace)();
+     pln = mkplan0(plnr, flags, prb, BLESSING, WISDOM_ONLY);
+     t = detach_trace(plnr, pln);
+     if (pln) {
+	  hooks = (plnr->nthr > 1);
+	  if (hooks && before_planner_hook)
+	       before_planner_hook();
+	  wssz = awake(plnr, pln);
+	  if (hooks && after_planner_hook)
+	       after_planner_hook();
+     }
+     X(planner_destroy_view)(plnr);
+
+     return pln ? mkapi(sign, prb, pln, t, wssz) : 0;
+}
+
+static const unsigned int pats[] = {FFTW_ESTIMATE, FFTW_MEASURE,
+				    FFTW_PATIENT, FFTW_EXHAUSTIVE};
+
+/* FFTW_ANYTIME: X(mkapiplan) returns an estimated plan at once, and a
+   background task then plans at increasing patience, up to the one
+   requested, replacing the plan after each level.  The search
+   measures on a shadow of the problem (see X(mkproblem_shadow)), so
+   that the user may execute the plan meanwhile, and the new plan is
+   then recreated from wisdom on the arrays of the problem.  Each
+   plan is published together with its trace, as P->CUR, which
+   readers load once per call (see APIPLAN_PLN), so that they never
+   pair a plan with the trace of another.  Since we cannot tell when a
+   reader is done with the plan that it loaded, the plans that we
+   replace stay awake until the apiplan is destroyed.  There are at
+   most PAT_MAX of them.  The search also stops at the next timeout
+   check of the planner once X(destroy_plan) sets CANCEL.
+
+   X(test_upgrade), X(wait_upgrade) and X(destroy_plan) read and
+   reset TASK without a lock, so only one thread at a time may call
+   them for a given plan, as the manual says. */
+struct upgrade_s {
+     apiplan *p;
+     problem *shadow;
+     void *buf;           /* arrays of SHADOW */
+     unsigned flags;      /* without the patience */
+     int pat_max;
+     void *task;          /* 0 when done, see X(wait_upgrade) */
+     void *cancel;        /* nonzero when X(destroy_plan) wants it */
+     int nv;
+     apiplan_version v[4]; /* published so far; v[0] is P->PLN, P->TRACE */
+};
+
+/* the cancel hook of the planner, see timeout_p() in planner.c */
+static int upgrade_cancelledp(void *data)
+{
+     struct upgrade_s *up = (struct upgrade_s *) data;
+     return X(apiplan_loadp)(&up->cancel) != 0;
+}
+
+static void upgrade_work(void *data)
+{
+     struct upgrade_s *up = (struct upgrade_s *) data;
+     apiplan *p = up->p;
+     crude_time start_time = X(get_crude_time)();
+     int pat;
+
+     for (pat = 1; pat <= up->pat_max; ++pat) {
+	  unsigned flags = up->flags | pats[pat];
+	  planner *plnr;
+	  plan *pln, *pln1 = 0;
+	  plan_trace *t = 0;
+	  size_t wssz = 0;
+
+	  if (upgrade_cancelledp(up))
+	       break;
+
+	  if (before_planner_hook)
+	       before_planner_hook();
+	  plnr = X(mkplanner_view)(X(the_planner)());
+	  plnr->start_time = start_time;
+	  plnr->cancel_hook = upgrade_cancelledp;
+	  plnr->cancel_data = (void *) up;
+
+	  pln = mkplan(plnr, flags, up->shadow, 0u);
+	  if (pln) {
+	       /* the shadow has the same hash as P->PRB */
+	       plnr->trace = X(mktrace)();
+	       pln1 = mkplan0(plnr, flags, p->prb, BLESSING, WISDOM_ONLY);
+	       t = detach_trace(plnr, pln1);
+	       if (pln1) {
+		    pln1->pcost = pln->pcost;
+		    wssz = awake(plnr, pln1);
+	       }
+	       X(plan_destroy_internal)(pln);
+	  }
+
+	  plnr->adt->forget(plnr, FORGET_ACCURSED);
+	  X(planner_destroy_view)(plnr);
+	  if (after_planner_hook)
+	       after_planner_hook();
+
+	  if (!pln1)
+	       break; /* failed, timed out, or cancelled */
+
+	  if (wssz > p->wssz) {
+	       /* the user may have allocated the workspace of the
+		  estimated plan already, see X(plan_workspace_size) */
+	       destroy_awake(pln1);
+	       X(trace_destroy)(t);
+	       continue;
+	  }
+
+	  /* only this task writes P->CUR */
+	  A(up->nv < 4);
+	  up->v[up->nv].pln = pln1;
+	  up->v[up->nv].trace = t;
+	  storep((void **) &p->cur, (void *) (up->v + up->nv++));
+     }
+}
+
+/* Return the estimated plan for FLAGS with a background upgrade, or
+   0 if the problem, the planner, or the threads do not allow it, in
+   which case the caller plans as usual */
+static apiplan *mkapiplan_anytime(int sign, unsigned flags, int pat_max,
+				  problem *prb)
+{
+     planner *plnr;
+     plan *pln;
+     plan_trace *t;
+     problem *shadow;
+     void *buf;
+     struct upgrade_s *up;
+     apiplan *p;
+     int hooks;
+     size_t wssz;
+
+     if (!(flags & FFTW_ANYTIME) || pat_max == 0
+	 || (flags & FFTW_WISDOM_ONLY) || !upgrade_spawn_hook
+	 || !before_planner_hook
+	 || !wise_concurrentp(X(the_planner)()))
+	  return 0;
+
+     if (!(shadow = X(mkproblem_shadow)(prb, &buf)))
+	  return 0;
+
+     /* as in mkapiplan_wise(), but searching */
+     plnr = X(mkplanner_view)(X(the_planner)());
+     plnr->trace = X(mktrace)();
+     pln = mkplan0(plnr, force_estimator(flags), prb, BLESSING,
+		   WISDOM_NORMAL);
+     t = detach_trace(plnr, pln);
+     if (!pln) {
+	  X(planner_destroy_view)(plnr);
+	  X(problem_destroy)(shadow);
+	  X(ifree)(buf);
+	  return 0;
+     }
+     hooks = (plnr->nthr > 1);
+     if (hooks)
+	  before_planner_hook();
+     wssz = awake(plnr, pln);
+     if (hooks && after_planner_hook)
+	  after_planner_hook();
+     X(planner_destroy_view)(plnr);
+
+     p = mkapi(sign, prb, pln, t, wssz);
+     up = (struct upgrade_s *) MALLOC(sizeof(struct upgrade_s), PLANS);
+     up->p = p;
+     up->shadow = shadow;
+     up->buf = buf;
+     up->flags = flags & ~(FFTW_ESTIMATE | FFTW_MEASURE |
+			   FFTW_PATIENT | FFTW_EXHAUSTIVE);
+     up->pat_max = pat_max;
+     up->cancel = 0;
+     up->v[0].pln = pln;
+     up->v[0].trace = t;
+     up->nv = 1;
+     p->cur = up->v;
+     p->up = up;
+     up->task = upgrade_spawn_hook(upgrade_work, (void *) up);
+     return p;
+}
+
 apiplan *X(mkapiplan)(int sign, unsigned flags, problem *prb)
 {
      apiplan *p = 0;
      plan *pln;
      unsigned flags_used_for_planning;
      planner *plnr;
-     static const unsigned int pats[] = {FFTW_ESTIMATE, FFTW_MEASURE,
-                                         FFTW_PATIENT, FFTW_EXHAUSTIVE};
      int pat, pat_max;
      double pcost = 0;
 
+     pat_max = flags & FFTW_ESTIMATE ? 0 :
+	  (flags & FFTW_EXHAUSTIVE ? 3 :
+	   (flags & FFTW_PATIENT ? 2 : 1));
+
+     /* fuse the pending load and store operations and the
+	normalization, if any */
+     prb = X(mkproblem_api_edge)(sign, flags, prb);
+
+     if (wise_concurrentp(X(the_planner)())) {
+	  /* the flags with which the loop below would finish,
+	     barring timeouts */
+	  unsigned wflags = flags;
+	  if (!(flags & FFTW_WISDOM_ONLY))
+	       wflags = (flags & ~(FFTW_ESTIMATE | FFTW_MEASURE |
+				   FFTW_PATIENT | FFTW_EXHAUSTIVE))
+		    | pats[pat_max];
+	  p = mkapiplan_wise(sign, wflags, prb);
+	  if (p)
+	       return p;
+     }
+
+     p = mkapiplan_anytime(sign, flags, pat_max, prb);
+     if (p)
+	  return p;
+
      if (before_planner_hook)
           before_planner_hook();
 
-     plnr = X(the_planner)();
+     plnr = X(mkplanner_view)(X(the_planner)());
 
      if (flags & FFTW_WISDOM_ONLY) {
 	  /* Special mode that returns a plan only if wisdom is present,
@@ -106,9 +441,6 @@ apiplan *X(mkapiplan)(int sign, unsigned flags, problem *prb)
 	  flags_used_for_planning = flags;
 	  pln = mkplan0(plnr, flags, prb, 0, WISDOM_ONLY);
      } else {
-	  pat_max = flags & FFTW_ESTIMATE ? 0 :
-	       (flags & FFTW_EXHAUSTIVE ? 3 :
-		(flags & FFTW_PATIENT ? 2 : 1));
 	  pat = plnr->timelimit >= 0 ? 0 : pat_max;
 
 	  flags &= ~(FFTW_ESTIMATE | FFTW_MEASURE |
@@ -137,26 +469,18 @@ apiplan *X(mkapiplan)(int sign, unsigned flags, problem *prb)
      }
 
      if (pln) {
-	  /* build apiplan */
-	  p = (apiplan *) MALLOC(sizeof(apiplan), PLANS);
-	  p->prb = prb;
-	  p->refcount = 1u;
-	  p->sign = sign; /* cache for execute_dft */
+	  plan *pln1;
 
-	  /* re-create plan from wisdom, adding blessing */
-	  p->pln = mkplan(plnr, flags_used_for_planning, prb, BLESSING);
+	  /* build apiplan, re-creating the plan from wisdom and adding
+	     blessing */
+	  plnr->trace = X(mktrace)();
+	  pln1 = mkplan(plnr, flags_used_for_planning, prb, BLESSING);
+	  p = mkapi(sign, prb, pln1, detach_trace(plnr, pln1), 0);
 
 	  /* record pcost from most recent measurement for use in X(cost) */
 	  p->pln->pcost = pcost;
 
-	  if (sizeof(trigreal) > sizeof(R)) {
-	       /* this is probably faster, and we have enough trigreal
-		  bits to maintain accuracy */
-	       X(plan_awake)(p->pln, AWAKE_SQRTN_TABLE);
-	  } else {
-	       /* more accurate */
-	       X(plan_awake)(p->pln, AWAKE_SINCOS);
-	  }
+	  p->wssz = awake(plnr, p->pln);
 
 	  /* we don't use pln for p->pln, above, since by re-creating the
 	     plan we might use more patient wisdom from a timed-out mkplan */
@@ -166,6 +490,7 @@ apiplan *X(mkapiplan)(int sign, unsigned flags, problem *prb)
 
      /* discard all information not necessary to reconstruct the plan */
      plnr->adt->forget(plnr, FORGET_ACCURSED);
+     X(planner_destroy_view)(plnr);
 
 #ifdef FFTW_RANDOM_ESTIMATOR
      X(random_estimate_seed)++; /* subsequent "random" plans are distinct */
@@ -177,6 +502,52 @@ apiplan *X(mkapiplan)(int sign, unsigned flags, problem *prb)
      return p;
 }
 
+/* Recreate the plan recorded in T for PRB, which has the same shape
+   as the original problem but possibly other arrays.  Only the
+   solvers run, and the wisdom is not touched.  Return 0 if the
+   solvers do not accept the problem; in either case, T is consumed. */
+apiplan *X(mkapiplan_replay)(int sign, problem *prb, plan_trace *t)
+{
+     planner *plnr = X(mkplanner_view)(X(the_planner)());
+     plan *pln;
+     int hooks;
+     size_t wssz = 0;
+
+     /* the flags that are not in the steps of T, such as
+	FFTW_NO_EXECUTE_ALLOC, still matter to the solvers */
+     X(mapflags)(plnr, t->flags);
+     plnr->no_execute_alloc = (t->flags & FFTW_NO_EXECUTE_ALLOC) != 0;
+     plnr->nthr = t->nthr;
+     plnr->trace = t;
+     t->replay = 1;
+     t->pos = 0;
+     pln = plnr->adt->mkplan(plnr, prb);
+     if (pln && (!t->ok || t->pos != t->n)) {
+	  X(plan_destroy_internal)(pln);
+	  pln = 0;
+     }
+     plnr->trace = 0;
+     t->replay = 0;
+
+     if (pln) {
+	  /* see mkapiplan_wise() */
+	  hooks = (plnr->nthr > 1);
+	  if (hooks && before_planner_hook)
+	       before_planner_hook();
+	  wssz = awake(plnr, pln);
+	  if (hooks && after_planner_hook)
+	       after_planner_hook();
+     }
+     X(planner_destroy_view)(plnr);
+
+     if (!pln) {
+	  X(trace_destroy)(t);
+	  X(problem_destroy)(prb);
+	  return 0;
+     }
+     return mkapi(sign, prb, pln, t, wssz);
+}
+
 X(plan) X(copy_plan)(X(plan) p)
 {
      if (p) {
@@ -191,16 +562,64 @@ X(plan) X(copy_plan)(X(plan) p)
      return p;
 }
 
+/* 1 if the upgrade of P is over, or if there is none, 0 otherwise */
+int X(test_upgrade)(const X(plan) p)
+{
+     struct upgrade_s *up = p->up;
+     return (!up || !up->task || upgrade_test_hook(up->task));
+}
+
+void X(wait_upgrade)(const X(plan) p)
+{
+     struct upgrade_s *up = p->up;
+     if (up && up->task) {
+	  upgrade_wait_hook(up->task);
+	  up->task = 0;
+     }
+}
+
+/* wait for the cancelled upgrade of P and free what it retained */
+static void destroy_upgrade(apiplan *p)
+{
+     struct upgrade_s *up = p->up;
+     int i;
+
+     X(wait_upgrade)(p);
+     for (i = 1; i < up->nv; ++i) { /* v[0] is P->PLN, P->TRACE */
+	  destroy_awake(up->v[i].pln);
+	  X(trace_destroy)(up->v[i].trace);
+     }
+     X(problem_destroy)(up->shadow);
+     X(ifree)(up->buf);
+     X(ifree)(up);
+     p->up = 0;
+}
+
 void X(destroy_plan)(X(plan) p)
 {
      if (p) {
+	  /* Cancel the upgrade before we wait for the planner, which
+	     the upgrade holds while it plans a level of patience, so
+	     that it stops at its next timeout check.  Other copies of
+	     P keep the plan that is in use. */
+	  if (p->up)
+	       storep(&p->up->cancel, (void *) p->up);
+
           if (before_planner_hook)
                before_planner_hook();
 
           if (p->refcount-- == 1u) {
-               X(plan_awake)(p->pln, SLEEPY);
-               X(plan_destroy_internal)(p->pln);
+	       if (p->up) {
+		    /* the upgrade needs the planner hooks */
+		    if (after_planner_hook)
+			 after_planner_hook();
+		    destroy_upgrade(p);
+		    if (before_planner_hook)
+			 before_planner_hook();
+	       }
+	       destroy_awake(p->pln);
                X(problem_destroy)(p->prb);
+	       X(trace_destroy)(p->trace);
                X(ifree)(p);
           }
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/* Binary wisdom files, which hold an image of the wisdom that the
+   planner uses in place (see X(planner_map_wisdom)).  Where mmap()
+   is available, the file is mapped read-only, so that all processes
+   that import it share the pages of one copy, and importing costs
+   nothing but checking the header. */
+
+#include "api/api.h"
+#include <stdio.h>
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  define USE_MMAP 1
+#endif
+
+int X(export_binary_wisdom_to_filename)(const char *filename)
+{
+     planner *plnr = X(the_planner)();
+     size_t len = 0, n;
+     void *img = 0;
+     FILE *f;
+     int ret;
+
+     /* retry if the wisdom grows between the two calls */
+     while ((n = X(planner_wisdom_image)(plnr, img, len)) > len) {
+	  X(ifree0)(img);
+	  img = MALLOC(n, HASHT);
+	  len = n;
+     }
+
+     f = fopen(filename, "wb");
+     ret = (f != 0);
+     if (f) {
+	  if (fwrite(img, 1, n, f) != n) ret = 0;
+	  if (fclose(f)) ret = 0; /* error closing file */
+     }
+     X(ifree)(img);
+     return ret;
+}
+
+#ifdef USE_MMAP
+static void unmap_file(const void *img, size_t len)
+{
+     munmap((void *) img, len);
+}
+
+int X(import_binary_wisdom_from_filename)(const char *filename)
+{
+     FILE *f = fopen(filename, "rb");
+     struct stat st;
+     void *img;
+     size_t len;
+     int ret = 0;
+
+     if (!f) return 0; /* error opening file */
+     if (!fstat(fileno(f), &st) && st.st_size > 0) {
+	  len = (size_t) st.st_size;
+	  img = mmap(0, len, PROT_READ, MAP_SHARED, fileno(f), 0);
+	  if (img != MAP_FAILED) {
+	       ret = X(planner_map_wisdom)(X(the_planner)(), img, len,
+					   unmap_file);
+	       if (!ret) munmap(img, len);
+	  }
+     }
+     fclose(f); /* the mapping survives */
+     return ret;
+}
+#else
+static void free_image(const void *img, size_t len)
+{
+     UNUSED(len);
+     X(ifree)((void *) img);
+}
+
+/* no mmap(): each process reads its own copy */
+int X(import_binary_wisdom_from_filename)(const char *filename)
+{
+     FILE *f = fopen(filename, "rb");
+     void *img = 0;
+     long len;
+     int ret = 0;
+
+     if (!f) return 0; /* error opening file */
+     if (!fseek(f, 0, SEEK_END) && (len = ftell(f)) > 0
+	 && !fseek(f, 0, SEEK_SET)) {
+	  img = MALLOC((size_t) len, HASHT);
+	  if (fread(img, 1, (size_t) len, f) == (size_t) len)
+	       ret = X(planner_map_wisdom)(X(the_planner)(), img, 
+					   (size_t) len, free_image);
+	  if (!ret) X(ifree)(img);
+     }
+     fclose(f);
+     return ret;
+}
+#endif
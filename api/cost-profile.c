@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Profiles for the learned estimator, see kernel/costmodel.c.  A
+   profile is created by recording samples while planning in MEASURE
+   mode (or better), and fitting the coefficients to the samples.
+   Once imported or fitted, the profile is used by FFTW_ESTIMATE. */
+
+#include "api/api.h"
+
+void X(record_cost_samples)(int on)
+{
+     X(costmodel_record)(X(the_planner)(), on);
+}
+
+int X(fit_cost_profile)(void)
+{
+     return X(costmodel_fit)(X(the_planner)());
+}
+
+void X(forget_cost_profile)(void)
+{
+     X(costmodel_forget)(X(the_planner)());
+}
+
+void X(export_cost_profile_to_file)(FILE *output_file)
+{
+     printer *p = X(mkprinter_file)(output_file);
+     X(costmodel_export)(X(the_planner)(), p);
+     X(printer_destroy)(p);
+}
+
+int X(export_cost_profile_to_filename)(const char *filename)
+{
+     FILE *f = fopen(filename, "w");
+     int ret;
+     if (!f) return 0; /* error opening file */
+     X(export_cost_profile_to_file)(f);
+     ret = !ferror(f);
+     if (fclose(f)) ret = 0; /* error closing file */
+     return ret;
+}
+
+int X(import_cost_profile_from_file)(FILE *input_file)
+{
+     scanner *s = X(mkscanner_file)(input_file);
+     int ret = X(costmodel_import)(X(the_planner)(), s);
+     X(scanner_destroy)(s);
+     return ret;
+}
+
+int X(import_cost_profile_from_filename)(const char *filename)
+{
+     FILE *f = fopen(filename, "r");
+     int ret;
+     if (!f) return 0; /* error opening file */
+     ret = X(import_cost_profile_from_file)(f);
+     if (fclose(f)) ret = 0; /* error closing file */
+     return ret;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "api/api.h"
+#include "dft/dft.h"
+#include "rdft/rdft.h"
+
+static async_spawn_hook_t spawn_hook = 0;
+static async_test_hook_t test_hook = 0;
+static async_wait_hook_t wait_hook = 0;
+
+void X(set_async_hooks)(async_spawn_hook_t spawn, async_test_hook_t test,
+			async_wait_hook_t wait)
+{
+     spawn_hook = spawn;
+     test_hook = test;
+     wait_hook = wait;
+}
+
+struct X(request_s) {
+     X(plan) p;
+     void *in, *out;   /* 0 for the arrays of the plan */
+     void *task;       /* handle of the hooks, or 0 if done */
+};
+
+static void execute_request(void *data)
+{
+     X(request) r = (X(request)) data;
+
+     if (r->in)
+	  X(execute_arrays)(r->p, r->in, r->out);
+     else
+	  X(execute)(r->p);
+}
+
+/* extend [*LO, *HI] by the offsets of the elements of SZ, along the
+   output strides if OUTP, else the input strides */
+static void span(const tensor *sz, int outp, INT *lo, INT *hi)
+{
+     int i;
+
+     if (!FINITE_RNK(sz->rnk))
+	  return;
+     for (i = 0; i < sz->rnk; ++i) {
+	  INT d = (sz->dims[i].n - 1)
+	       * (outp ? sz->dims[i].os : sz->dims[i].is);
+	  if (d < 0) *lo += d; else *hi += d;
+     }
+}
+
+/* RANGE[0..1] = the bytes of the elements A + [LO, HI] and B + [LO, HI],
+   of which the lower of A and B is the array that the user passed,
+   moved to NEWP if not 0 */
+static void extent(const R *a, const R *b, INT lo, INT hi, void *newp,
+		   void **range)
+{
+     const R *p = a < b ? a : b, *q = a < b ? b : a;
+     const char *base = (const char *) p;
+     ptrdiff_t d = newp ? (const char *) newp - base : 0;
+
+     range[0] = (void *) (base + d + lo * (ptrdiff_t) sizeof(R));
+     range[1] = (void *) ((const char *) q + d
+			  + (hi + 1) * (ptrdiff_t) sizeof(R));
+}
+
+/* the bytes that R reads and writes, for the ordering of requests */
+static int ranges(X(request) r, void **range)
+{
+     const problem *prb = API_PROBLEM(r->p);
+     INT lo = 0, hi = 0;
+
+     switch (prb->adt->problem_kind) {
+	 case PROBLEM_DFT: {
+	      const problem_dft *p = (const problem_dft *) prb;
+	      span(p->sz, 0, &lo, &hi);
+	      span(p->vecsz, 0, &lo, &hi);
+	      extent(p->ri, p->ii, lo, hi, r->in, range);
+	      lo = hi = 0;
+	      span(p->sz, 1, &lo, &hi);
+	      span(p->vecsz, 1, &lo, &hi);
+	      extent(p->ro, p->io, lo, hi, r->out, range + 2);
+	      return 2;
+	 }
+	 case PROBLEM_RDFT: {
+	      const problem_rdft *p = (const problem_rdft *) prb;
+	      span(p->sz, 0, &lo, &hi);
+	      span(p->vecsz, 0, &lo, &hi);
+	      extent(p->I, p->I, lo, hi, r->in, range);
+	      lo = hi = 0;
+	      span(p->sz, 1, &lo, &hi);
+	      span(p->vecsz, 1, &lo, &hi);
+	      extent(p->O, p->O, lo, hi, r->out, range + 2);
+	      return 2;
+	 }
+	 case PROBLEM_RDFT2: {
+	      /* the logical size bounds the complex side too */
+	      const problem_rdft2 *p = (const problem_rdft2 *) prb;
+	      int r2hc = R2HC_KINDP(p->kind);
+	      span(p->sz, !r2hc, &lo, &hi);
+	      span(p->vecsz, !r2hc, &lo, &hi);
+	      extent(p->r0, p->r1, lo, hi, r2hc ? r->in : r->out,
+		     range + (r2hc ? 0 : 2));
+	      lo = hi = 0;
+	      span(p->sz, r2hc, &lo, &hi);
+	      span(p->vecsz, r2hc, &lo, &hi);
+	      extent(p->cr, p->ci, lo, hi, r2hc ? r->out : r->in,
+		     range + (r2hc ? 2 : 0));
+	      return 2;
+	 }
+	 case PROBLEM_CONV: {
+	      /* complex elements are interleaved pairs of reals */
+	      const problem_conv *p = (const problem_conv *) prb;
+	      INT extra = p->realp ? 0 : 1;
+	      int i;
+	      span(p->sz, 0, &lo, &hi);
+	      extent(p->I, p->I, lo, hi + extra, r->in, range);
+	      lo = hi = 0;
+	      for (i = 0; i < p->sz->rnk; ++i) {
+		   /* the linear convolution is longer by the kernel */
+		   INT n = p->sz->dims[i].n
+			+ (p->circular ? 0 : p->ksz->dims[i].n - 1);
+		   hi += (n - 1) * p->sz->dims[i].os;
+	      }
+	      extent(p->O, p->O, lo, hi + extra, r->out, range + 2);
+	      return 2;
+	 }
+	 case PROBLEM_CZT: {
+	      const problem_czt *p = (const problem_czt *) prb;
+	      INT di = (p->n - 1) * p->is, d = (p->m - 1) * p->os;
+	      extent(p->ri, p->ii, X(imin)(di, 0), X(imax)(di, 0),
+		     r->in, range);
+	      extent(p->ro, p->io, X(imin)(d, 0), X(imax)(d, 0),
+		     r->out, range + 2);
+	      return 2;
+	 }
+	 case PROBLEM_DFT_PRUNED: {
+	      const problem_dft_pruned *p = (const problem_dft_pruned *) prb;
+	      INT di = (p->n_in - 1) * p->is, dv = (p->vl - 1) * p->ivs;
+	      extent(p->ri, p->ii, X(imin)(di, 0) + X(imin)(dv, 0),
+		     X(imax)(di, 0) + X(imax)(dv, 0), r->in, range);
+	      di = (p->n_out - 1) * p->os;
+	      dv = (p->vl - 1) * p->ovs;
+	      extent(p->ro, p->io, X(imin)(di, 0) + X(imin)(dv, 0),
+		     X(imax)(di, 0) + X(imax)(dv, 0), r->out, range + 2);
+	      return 2;
+	 }
+	 default:
+	      /* ordered with the other requests of the same plan only */
+	      range[0] = (void *) r->p;
+	      range[1] = (void *) ((char *) r->p + 1);
+	      return 1;
+     }
+}
+
+/* Start executing P on IN and OUT (interpreted as in X(execute_batch),
+   with IN == 0 meaning the arrays of the plan), and return at once.
+   Requests whose arrays overlap are executed in the order in which
+   they were made.  Without the threads library, the
+   execution is synchronous. */
+X(request) X(execute_async)(const X(plan) p, void *in, void *out)
+{
+     X(request) r;
+     void *range[4];
+
+     if (in)
+	  CK(X(new_arrays_okp)(p));
+
+     r = (X(request)) MALLOC(sizeof(*r), OTHER);
+     r->p = p;
+     r->in = in;
+     r->out = in ? out : 0;
+     r->task = 0;
+
+     if (spawn_hook)
+	  r->task = spawn_hook(execute_request, (void *) r, range,
+			       ranges(r, range));
+     else
+	  execute_request((void *) r);
+     return r;
+}
+
+/* 1 if R is done, 0 otherwise */
+int X(test)(X(request) r)
+{
+     return !r->task || test_hook(r->task);
+}
+
+/* wait until R is done, and release R */
+void X(wait)(X(request) r)
+{
+     if (r->task)
+	  wait_hook(r->task);
+     X(ifree)(r);
+}
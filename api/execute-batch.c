@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "api/api.h"
+
+static batch_hook_t batch_hook = 0;
+
+void X(set_batch_hook)(batch_hook_t hook)
+{
+     batch_hook = hook;
+}
+
+typedef struct {
+     const X(plan) *plans;
+     void **ins, **outs;
+} batch;
+
+/* whether X(execute_arrays) can execute P on new arrays, i.e. whether
+   P has a new-array execute function */
+int X(new_arrays_okp)(const X(plan) p)
+{
+     switch (API_PROBLEM(p)->adt->problem_kind) {
+	 case PROBLEM_DFT:
+	 case PROBLEM_CZT:
+	 case PROBLEM_DFT_PRUNED:
+	 case PROBLEM_RDFT:
+	 case PROBLEM_CONV:
+	 case PROBLEM_RDFT2:
+	      return 1;
+	 default:
+	      return 0;
+     }
+}
+
+/* execute P on IN and OUT, whose type depends on the kind of problem,
+   as in the new-array execute functions.  P must satisfy
+   X(new_arrays_okp) */
+void X(execute_arrays)(const X(plan) p, void *in, void *out)
+{
+     const problem *prb = API_PROBLEM(p);
+
+     switch (prb->adt->problem_kind) {
+	 case PROBLEM_DFT:
+	 case PROBLEM_CZT:
+	 case PROBLEM_DFT_PRUNED:
+	      X(execute_dft)(p, (C *) in, (C *) out);
+	      break;
+	 case PROBLEM_RDFT:
+	      X(execute_r2r)(p, (R *) in, (R *) out);
+	      break;
+	 case PROBLEM_CONV:
+	      if (((const problem_conv *) prb)->realp)
+		   X(execute_convolve_r)(p, (R *) in, (R *) out);
+	      else
+		   X(execute_convolve)(p, (C *) in, (C *) out);
+	      break;
+	 case PROBLEM_RDFT2:
+	      if (R2HC_KINDP(((const problem_rdft2 *) prb)->kind))
+		   X(execute_dft_r2c)(p, (R *) in, (C *) out);
+	      else
+		   X(execute_dft_c2r)(p, (C *) in, (R *) out);
+	      break;
+	 default:
+	      /* e.g. MPI plans, which would ignore IN and OUT */
+	      CK(X(new_arrays_okp)(p));
+	      break;
+     }
+}
+
+/* call WORK(DATA, I) for 0 <= I < N, on the threads if there are any */
+void X(run_batch)(int n, void (*work)(void *data, int i), void *data)
+{
+     int i;
+
+     if (batch_hook && n > 1)
+	  batch_hook(n, work, data);
+     else
+	  for (i = 0; i < n; ++i)
+	       work(data, i);
+}
+
+static void execute_one(void *data, int i)
+{
+     const batch *b = (const batch *) data;
+
+     if (b->ins)
+	  X(execute_arrays)(b->plans[i], b->ins[i], b->outs[i]);
+     else
+	  X(execute)(b->plans[i]);
+}
+
+/* Execute N independent plans.  With the threads library, the
+   executions are distributed over the threads in a single fork/join,
+   and each plan may in turn use threads of its own. */
+void X(execute_batch)(const X(plan) *plans, void **ins, void **outs, int n)
+{
+     batch b;
+     int i;
+
+     /* reject the whole batch before executing any of it */
+     if (ins)
+	  for (i = 0; i < n; ++i)
+	       CK(X(new_arrays_okp)(plans[i]));
+
+     b.plans = plans;
+     b.ins = ins;
+     b.outs = outs;
+     X(run_batch)(n, execute_one, (void *) &b);
+}
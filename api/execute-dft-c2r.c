@@ -24,7 +24,7 @@
 /* guru interface: requires care in alignment, r - i, etcetera. */
 void X(execute_dft_c2r)(const X(plan) p, C *in, R *out)
 {
-     plan_rdft2 *pln = (plan_rdft2 *) p->pln;
-     problem_rdft2 *prb = (problem_rdft2 *) p->prb;
+     plan_rdft2 *pln = (plan_rdft2 *) APIPLAN_PLN(p);
+     const problem_rdft2 *prb = (const problem_rdft2 *) API_PROBLEM(p);
      pln->apply((plan *) pln, out, out + (prb->r1 - prb->r0), in[0], in[0]+1);
 }
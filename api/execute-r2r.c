@@ -24,6 +24,6 @@
 /* guru interface: requires care in alignment, etcetera. */
 void X(execute_r2r)(const X(plan) p, R *in, R *out)
 {
-     plan_rdft *pln = (plan_rdft *) p->pln;
+     plan_rdft *pln = (plan_rdft *) APIPLAN_PLN(p);
      pln->apply((plan *) pln, in, out);
 }
@@ -24,7 +24,7 @@
 /* guru interface: requires care in alignment, r - i, etcetera. */
 void X(execute_split_dft_r2c)(const X(plan) p, R *in, R *ro, R *io)
 {
-     plan_rdft2 *pln = (plan_rdft2 *) p->pln;
-     problem_rdft2 *prb = (problem_rdft2 *) p->prb;
+     plan_rdft2 *pln = (plan_rdft2 *) APIPLAN_PLN(p);
+     const problem_rdft2 *prb = (const problem_rdft2 *) API_PROBLEM(p);
      pln->apply((plan *) pln, in, in + (prb->r1 - prb->r0), ro, io);
 }
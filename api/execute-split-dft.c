@@ -24,6 +24,6 @@
 /* guru interface: requires care in alignment, r - i, etcetera. */
 void X(execute_split_dft)(const X(plan) p, R *ri, R *ii, R *ro, R *io)
 {
-     plan_dft *pln = (plan_dft *) p->pln;
+     plan_dft *pln = (plan_dft *) APIPLAN_PLN(p);
      pln->apply((plan *) pln, ri, ii, ro, io);
 }
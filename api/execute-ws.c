@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "api/api.h"
+
+/* Execute with scratch from the caller's workspace WS, which must be
+   at least X(plan_workspace_size)(p) bytes, aligned as X(malloc)
+   would.  The workspace is bound to the calling thread for the
+   duration of the call (see kernel/scratch.c), so that the threads
+   executing P can share it; nothing is carried in P itself, and the
+   same plan may run concurrently in different workspaces.  Without
+   THREAD_LOCAL (see kernel/ifftw.h) there is nowhere to bind it, the
+   size is 0, and the workspace is ignored. */
+
+size_t X(plan_workspace_size)(const X(plan) p)
+{
+     return p->wssz;
+}
+
+void X(execute_ws)(const X(plan) p, void *ws)
+{
+     void *prev = X(scratch_bind)(ws);
+     X(execute)(p);
+     X(scratch_bind)(prev);
+}
+
+void X(execute_dft_ws)(const X(plan) p, C *in, C *out, void *ws)
+{
+     void *prev = X(scratch_bind)(ws);
+     X(execute_dft)(p, in, out);
+     X(scratch_bind)(prev);
+}
+
+void X(execute_dft_r2c_ws)(const X(plan) p, R *in, C *out, void *ws)
+{
+     void *prev = X(scratch_bind)(ws);
+     X(execute_dft_r2c)(p, in, out);
+     X(scratch_bind)(prev);
+}
+
+void X(execute_dft_c2r_ws)(const X(plan) p, C *in, R *out, void *ws)
+{
+     void *prev = X(scratch_bind)(ws);
+     X(execute_dft_c2r)(p, in, out);
+     X(scratch_bind)(prev);
+}
+
+void X(execute_r2r_ws)(const X(plan) p, R *in, R *out, void *ws)
+{
+     void *prev = X(scratch_bind)(ws);
+     X(execute_r2r)(p, in, out);
+     X(scratch_bind)(prev);
+}
@@ -22,6 +22,6 @@
 
 void X(execute)(const X(plan) p)
 {
-     plan *pln = p->pln;
+     plan *pln = APIPLAN_PLN(p);
      pln->adt->solve(pln, p->prb);
 }
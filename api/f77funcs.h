@@ -25,7 +25,7 @@
 
 FFTW_VOIDFUNC F77(execute, EXECUTE)(X(plan) * const p)
 {
-     plan *pln = (*p)->pln;
+     plan *pln = APIPLAN_PLN(*p);
      pln->adt->solve(pln, (*p)->prb);
 }
 
@@ -178,7 +178,7 @@ FFTW_VOIDFUNC F77(plan_guru_split_dft, PLAN_GURU_SPLIT_DFT)(X(plan) *p, int *ran
 
 FFTW_VOIDFUNC F77(execute_dft, EXECUTE_DFT)(X(plan) * const p, C *in, C *out)
 {
-     plan_dft *pln = (plan_dft *) (*p)->pln;
+     plan_dft *pln = (plan_dft *) APIPLAN_PLN(*p);
      if ((*p)->sign == FFT_SIGN)
           pln->apply((plan *) pln, in[0], in[0]+1, out[0], out[0]+1);
      else
@@ -188,7 +188,7 @@ FFTW_VOIDFUNC F77(execute_dft, EXECUTE_DFT)(X(plan) * const p, C *in, C *out)
 FFTW_VOIDFUNC F77(execute_split_dft, EXECUTE_SPLIT_DFT)(X(plan) * const p,
 					       R *ri, R *ii, R *ro, R *io)
 {
-     plan_dft *pln = (plan_dft *) (*p)->pln;
+     plan_dft *pln = (plan_dft *) APIPLAN_PLN(*p);
      pln->apply((plan *) pln, ri, ii, ro, io);
 }
 
@@ -273,7 +273,7 @@ FFTW_VOIDFUNC F77(plan_guru_split_dft_r2c, PLAN_GURU_SPLIT_DFT_R2C)(
 
 FFTW_VOIDFUNC F77(execute_dft_r2c, EXECUTE_DFT_R2C)(X(plan) * const p, R *in, C *out)
 {
-     plan_rdft2 *pln = (plan_rdft2 *) (*p)->pln;
+     plan_rdft2 *pln = (plan_rdft2 *) APIPLAN_PLN(*p);
      problem_rdft2 *prb = (problem_rdft2 *) (*p)->prb;
      pln->apply((plan *) pln, in, in + (prb->r1 - prb->r0), out[0], out[0]+1);
 }
@@ -281,7 +281,7 @@ FFTW_VOIDFUNC F77(execute_dft_r2c, EXECUTE_DFT_R2C)(X(plan) * const p, R *in, C
 FFTW_VOIDFUNC F77(execute_split_dft_r2c, EXECUTE_SPLIT_DFT_R2C)(X(plan) * const p,
 						       R *in, R *ro, R *io)
 {
-     plan_rdft2 *pln = (plan_rdft2 *) (*p)->pln;
+     plan_rdft2 *pln = (plan_rdft2 *) APIPLAN_PLN(*p);
      problem_rdft2 *prb = (problem_rdft2 *) (*p)->prb;
      pln->apply((plan *) pln, in, in + (prb->r1 - prb->r0), ro, io);
 }
@@ -367,7 +367,7 @@ FFTW_VOIDFUNC F77(plan_guru_split_dft_c2r, PLAN_GURU_SPLIT_DFT_C2R)(
 
 FFTW_VOIDFUNC F77(execute_dft_c2r, EXECUTE_DFT_C2R)(X(plan) * const p, C *in, R *out)
 {
-     plan_rdft2 *pln = (plan_rdft2 *) (*p)->pln;
+     plan_rdft2 *pln = (plan_rdft2 *) APIPLAN_PLN(*p);
      problem_rdft2 *prb = (problem_rdft2 *) (*p)->prb;
      pln->apply((plan *) pln, out, out + (prb->r1 - prb->r0), in[0], in[0]+1);
 }
@@ -375,7 +375,7 @@ FFTW_VOIDFUNC F77(execute_dft_c2r, EXECUTE_DFT_C2R)(X(plan) * const p, C *in, R
 FFTW_VOIDFUNC F77(execute_split_dft_c2r, EXECUTE_SPLIT_DFT_C2R)(X(plan) * const p,
 					   R *ri, R *ii, R *out)
 {
-     plan_rdft2 *pln = (plan_rdft2 *) (*p)->pln;
+     plan_rdft2 *pln = (plan_rdft2 *) APIPLAN_PLN(*p);
      problem_rdft2 *prb = (problem_rdft2 *) (*p)->prb;
      pln->apply((plan *) pln, out, out + (prb->r1 - prb->r0), ri, ii);
 }
@@ -458,6 +458,6 @@ FFTW_VOIDFUNC F77(plan_guru_r2r, PLAN_GURU_R2R)(
 
 FFTW_VOIDFUNC F77(execute_r2r, EXECUTE_R2R)(X(plan) * const p, R *in, R *out)
 {
-     plan_rdft *pln = (plan_rdft *) (*p)->pln;
+     plan_rdft *pln = (plan_rdft *) APIPLAN_PLN(*p);
      pln->apply((plan *) pln, in, out);
 }
@@ -99,6 +99,16 @@ enum fftw_r2r_kind_do_not_use_me {
      FFTW_RODFT00=7, FFTW_RODFT01=8, FFTW_RODFT10=9, FFTW_RODFT11=10
 };
 
+enum fftw_conv_kind_do_not_use_me {
+     FFTW_CONV_LINEAR=0, FFTW_CONV_CIRCULAR=1,
+     FFTW_CORR_LINEAR=2, FFTW_CORR_CIRCULAR=3
+};
+
+enum fftw_edge_kind_do_not_use_me {
+     FFTW_EDGE_NONE=0, FFTW_EDGE_SCALE=1, FFTW_EDGE_WINDOW=2,
+     FFTW_EDGE_MODULATE=3, FFTW_EDGE_CALLBACK=4
+};
+
 struct fftw_iodim_do_not_use_me {
      int n;                     /* dimension size */
      int is;			/* input stride */
@@ -130,10 +140,23 @@ FFTW_DEFINE_COMPLEX(R, C);                                              \
                                                                         \
 typedef struct X(plan_s) *X(plan);                                      \
                                                                         \
+typedef struct X(request_s) *X(request);                                \
+                                                                        \
+typedef struct X(stft_s) *X(stft);                                      \
+                                                                        \
+typedef struct X(nufft_s) *X(nufft);                                    \
+                                                                        \
 typedef struct fftw_iodim_do_not_use_me X(iodim);                       \
 typedef struct fftw_iodim64_do_not_use_me X(iodim64);                   \
                                                                         \
 typedef enum fftw_r2r_kind_do_not_use_me X(r2r_kind);                   \
+typedef enum fftw_conv_kind_do_not_use_me X(conv_kind);                 \
+typedef enum fftw_edge_kind_do_not_use_me X(edge_kind);                 \
+                                                                        \
+typedef void (FFTW_CDECL *X(edge_callback))(R *re, R *im, ptrdiff_t n,  \
+                                            ptrdiff_t stride,           \
+                                            ptrdiff_t first,            \
+                                            void *data);                \
                                                                         \
 typedef fftw_write_char_func_do_not_use_me X(write_char_func);          \
 typedef fftw_read_char_func_do_not_use_me X(read_char_func);            \
@@ -156,6 +179,14 @@ FFTW_CDECL X(plan_dft_3d)(int n0, int n1, int n2,                       \
                           C *in, C *out, int sign, unsigned flags);     \
                                                                         \
 FFTW_EXTERN X(plan)                                                     \
+FFTW_CDECL X(plan_czt)(int n, int m, const C *w, const C *a,            \
+                       C *in, C *out, unsigned flags);                  \
+                                                                        \
+FFTW_EXTERN X(plan)                                                     \
+FFTW_CDECL X(plan_dft_pruned)(int n, int n_in, int n_out,               \
+                              C *in, C *out, int sign, unsigned flags); \
+                                                                        \
+FFTW_EXTERN X(plan)                                                     \
 FFTW_CDECL X(plan_many_dft)(int rank, const int *n,                     \
                             int howmany,                                \
                             C *in, const int *inembed,                  \
@@ -366,8 +397,108 @@ FFTW_EXTERN void                                                        \
 FFTW_CDECL X(execute_r2r)(const X(plan) p, R *in, R *out);              \
                                                                         \
 FFTW_EXTERN X(plan)                                                     \
+FFTW_CDECL X(plan_convolve)(int rank, const int *n, const int *nk,      \
+                            const C *kernel, C *in, C *out,             \
+                            X(conv_kind) kind, unsigned flags);         \
+                                                                        \
+FFTW_EXTERN X(plan)                                                     \
+FFTW_CDECL X(plan_convolve_r)(int rank, const int *n, const int *nk,    \
+                              const R *kernel, R *in, R *out,           \
+                              X(conv_kind) kind, unsigned flags);       \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_convolve)(const X(plan) p, C *in, C *out);         \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_convolve_r)(const X(plan) p, R *in, R *out);       \
+                                                                        \
+FFTW_EXTERN size_t                                                      \
+FFTW_CDECL X(plan_workspace_size)(const X(plan) p);                     \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_ws)(const X(plan) p, void *ws);                    \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_dft_ws)(const X(plan) p, C *in, C *out, void *ws); \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_dft_r2c_ws)(const X(plan) p, R *in, C *out,        \
+                                void *ws);                              \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_dft_c2r_ws)(const X(plan) p, C *in, R *out,        \
+                                void *ws);                              \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_r2r_ws)(const X(plan) p, R *in, R *out, void *ws); \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(execute_batch)(const X(plan) *plans, void **ins,           \
+                            void **outs, int n);                        \
+                                                                        \
+FFTW_EXTERN X(request)                                                  \
+FFTW_CDECL X(execute_async)(const X(plan) p, void *in, void *out);      \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(test)(X(request) r);                                       \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(wait)(X(request) r);                                       \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(test_upgrade)(const X(plan) p);                            \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(wait_upgrade)(const X(plan) p);                            \
+                                                                        \
+FFTW_EXTERN X(stft)                                                     \
+FFTW_CDECL X(plan_stft)(const R *window, int n, int hop,                \
+                        unsigned flags);                                \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(stft_frames)(const X(stft) s, int nin);                    \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(stft_execute)(X(stft) s, const R *in, int nin, C *out);    \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(stft_reset)(X(stft) s);                                    \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(destroy_stft)(X(stft) s);                                  \
+                                                                        \
+FFTW_EXTERN X(nufft)                                                    \
+FFTW_CDECL X(plan_nufft)(int type, int rank, const int *n, int sign,    \
+                         double tol, unsigned flags);                   \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(nufft_setpts)(X(nufft) p, int m, const R *x,               \
+                           int nk, const R *s);                         \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(nufft_execute)(X(nufft) p, C *c, C *f);                    \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(destroy_nufft)(X(nufft) p);                                \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(plan_with_load)(X(edge_kind) kind, const R *arg,           \
+                             X(edge_callback) f, void *data);           \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(plan_with_store)(X(edge_kind) kind, const R *arg,          \
+                              X(edge_callback) f, void *data);          \
+                                                                        \
+FFTW_EXTERN X(plan)                                                     \
 FFTW_CDECL X(copy_plan)(X(plan) p);                                     \
                                                                         \
+FFTW_EXTERN size_t                                                      \
+FFTW_CDECL X(export_plan)(const X(plan) p, void *buf, size_t len);      \
+                                                                        \
+FFTW_EXTERN X(plan)                                                     \
+FFTW_CDECL X(import_plan)(const void *buf, size_t len,                  \
+                        void *in, void *out);                           \
+                                                                        \
 FFTW_EXTERN void                                                        \
 FFTW_CDECL X(destroy_plan)(X(plan) p);                                  \
                                                                         \
@@ -380,11 +511,20 @@ FFTW_EXTERN void                                                        \
 FFTW_CDECL X(set_timelimit)(double t);                                  \
                                                                         \
 FFTW_EXTERN void                                                        \
+FFTW_CDECL X(set_robust_timing)(int level);                             \
+                                                                        \
+FFTW_EXTERN void                                                        \
 FFTW_CDECL X(plan_with_nthreads)(int nthreads);                         \
                                                                         \
 FFTW_EXTERN int                                                         \
 FFTW_CDECL X(planner_nthreads)(void);                                   \
                                                                         \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(plan_with_affinity)(const int *cpus, int ncpus);           \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(plan_with_search_nthreads)(int nthreads);                  \
+                                                                        \
 FFTW_EXTERN int                                                         \
 FFTW_CDECL X(init_threads)(void);                                       \
                                                                         \
@@ -426,6 +566,41 @@ FFTW_CDECL X(import_wisdom_from_string)(const char *input_string);      \
 FFTW_EXTERN int                                                         \
 FFTW_CDECL X(import_wisdom)(X(read_char_func) read_char, void *data);   \
                                                                         \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(export_binary_wisdom_to_filename)(const char *filename);   \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(import_binary_wisdom_from_filename)(const char *filename); \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(record_cost_samples)(int on);                              \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(fit_cost_profile)(void);                                   \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(forget_cost_profile)(void);                                \
+                                                                        \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(export_cost_profile_to_filename)(const char *filename);    \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(export_cost_profile_to_file)(FILE *output_file);           \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(import_cost_profile_from_filename)(const char *filename);  \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(import_cost_profile_from_file)(FILE *input_file);          \
+                                                                        \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(record_planner_stats)(int on);                             \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(forget_planner_stats)(void);                               \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(export_planner_stats_to_filename)(const char *filename);   \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(export_planner_stats_to_file)(FILE *output_file);          \
+FFTW_EXTERN int                                                         \
+FFTW_CDECL X(export_planner_trace_to_filename)(const char *filename);   \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(export_planner_trace_to_file)(FILE *output_file);          \
+                                                                        \
 FFTW_EXTERN void                                                        \
 FFTW_CDECL X(fprint_plan)(const X(plan) p, FILE *output_file);          \
                                                                         \
@@ -435,8 +610,17 @@ FFTW_CDECL X(print_plan)(const X(plan) p);                              \
 FFTW_EXTERN char *                                                      \
 FFTW_CDECL X(sprint_plan)(const X(plan) p);                             \
                                                                         \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(profile_plan)(const X(plan) p, int on);                    \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(fprint_plan_profile)(const X(plan) p, FILE *output_file);  \
+FFTW_EXTERN void                                                        \
+FFTW_CDECL X(print_plan_profile)(const X(plan) p);                      \
+                                                                        \
 FFTW_EXTERN void *                                                      \
 FFTW_CDECL X(malloc)(size_t n);                                         \
+FFTW_EXTERN void *                                                      \
+FFTW_CDECL X(malloc_onnode)(size_t n, int node);                        \
                                                                         \
 FFTW_EXTERN R *                                                         \
 FFTW_CDECL X(alloc_real)(size_t n);                                     \
@@ -501,6 +685,10 @@ FFTW_DEFINE_API(FFTW_MANGLE_QUAD, __float128, fftwq_complex)
 #define FFTW_PATIENT (1U << 5) /* IMPATIENT is default */
 #define FFTW_ESTIMATE (1U << 6)
 #define FFTW_WISDOM_ONLY (1U << 21)
+#define FFTW_NO_EXECUTE_ALLOC (1U << 22)
+#define FFTW_NORMALIZE_ORTHO (1U << 23)
+#define FFTW_NORMALIZE_BACKWARD (1U << 24)
+#define FFTW_ANYTIME (1U << 25)
 
 /* undocumented beyond-guru flags */
 #define FFTW_ESTIMATE_PATIENT (1U << 7)
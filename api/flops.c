@@ -23,7 +23,7 @@
 void X(flops)(const X(plan) p, double *add, double *mul, double *fma)
 {
      planner *plnr = X(the_planner)();
-     opcnt *o = &p->pln->ops;
+     opcnt *o = &APIPLAN_PLN(p)->ops;
      *add = o->add; *mul = o->mul; *fma = o->fma;
      if (plnr->cost_hook) {
 	  *add = plnr->cost_hook(p->prb, *add, COST_SUM);
@@ -34,10 +34,10 @@ void X(flops)(const X(plan) p, double *add, double *mul, double *fma)
 
 double X(estimate_cost)(const X(plan) p)
 {
-     return X(iestimate_cost)(X(the_planner)(), p->pln, p->prb);
+     return X(iestimate_cost)(X(the_planner)(), APIPLAN_PLN(p), p->prb);
 }
 
 double X(cost)(const X(plan) p)
 {
-     return p->pln->pcost;
+     return APIPLAN_PLN(p)->pcost;
 }
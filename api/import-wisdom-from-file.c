@@ -53,7 +53,7 @@ static int getchr_file(scanner * sc_)
      return *(sc->bufr++);
 }
 
-static scanner *mkscanner_file(FILE *f)
+scanner *X(mkscanner_file)(FILE *f)
 {
      S *sc = (S *) X(mkscanner)(sizeof(S), getchr_file);
      sc->f = f;
@@ -63,7 +63,7 @@ static scanner *mkscanner_file(FILE *f)
 
 int X(import_wisdom_from_file)(FILE *input_file)
 {
-     scanner *s = mkscanner_file(input_file);
+     scanner *s = X(mkscanner_file)(input_file);
      planner *plnr = X(the_planner)();
      int ret = plnr->adt->imprt(plnr, s);
      X(scanner_destroy)(s);
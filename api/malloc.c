@@ -26,6 +26,13 @@ void *X(malloc)(size_t n)
      return X(kernel_malloc)(n);
 }
 
+/* like X(malloc), but place the memory on NUMA node NODE if the
+   system lets us */
+void *X(malloc_onnode)(size_t n, int node)
+{
+     return X(kernel_malloc_onnode)(n, node);
+}
+
 void X(free)(void *p)
 {
      X(kernel_free)(p);
@@ -0,0 +1,744 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "api/api.h"
+#include <math.h>
+#include <string.h>
+
+/* Non-uniform FFTs of types 1, 2 and 3 in up to three dimensions.
+
+   Types 1 and 2 spread the points onto, or interpolate them from, a
+   fine grid oversampled SIGMA times, with the "exponential of
+   semicircle" kernel
+
+       phi(z) = exp(beta * (sqrt(1 - z^2) - 1)),   |z| < 1,
+
+   w fine grid points wide, transform the fine grid by an ordinary
+   plan, and divide the Fourier transform of the kernel out of the
+   modes.  Type 3 spreads onto a grid scaled to the extent of the
+   points and the frequencies, and evaluates the spectrum of the grid
+   at the frequencies by a type 2 transform.
+
+   The points are sorted by bins of the fine grid, so that consecutive
+   points touch nearby parts of the grid.  The grid is split into slabs
+   of rows along its first dimension.  The points of each slab are
+   spread into a private padded subgrid, and then the rows of each
+   slab of the grid are summed from the subgrids that overlap them, so
+   that the threads never write the same memory. */
+
+#define SIGMA 2          /* oversampling of the fine grid */
+#define BINSZ 16         /* fine grid points per bin in each dimension */
+#define MAXW 16          /* width of the kernel for the smallest tol */
+
+static const double pi = 3.14159265358979323846264338327950288;
+
+typedef struct {
+     INT start, end;     /* rows of the fine grid */
+     INT lo, hi;         /* the sorted points whose rows are in the slab */
+     C *buf;             /* their subgrid, padded by P on each side */
+} slab;
+
+/* The dimensions are numbered 0, 1, 2, the first 3 - rank of which
+   have size 1 and are not spread over. */
+struct X(nufft_s) {
+     int type, rank, sign;
+     unsigned flags;
+     double tol, beta;
+     int w;              /* kernel width */
+     INT P;              /* padding of the subgrids */
+     int d0;             /* first dimension of size > 1 */
+     INT n[3];           /* modes */
+     INT nf[3];          /* fine grid */
+     C *grid;
+     X(plan) fft;        /* in place on grid; types 1 and 2 */
+     R *corr[3];         /* 1 / transform of the kernel at the modes */
+
+     int nslab;
+     slab *slabs;
+
+     INT m;              /* points */
+     double *g;          /* their fine grid coordinates, sorted */
+     INT *perm;          /* and their indices before sorting */
+
+     /* type 3 */
+     INT nk;             /* frequencies */
+     C *pre, *post;      /* phases of the points and the frequencies */
+     C *tmp;             /* output of inner */
+     X(nufft) inner;
+};
+
+static double phi(double beta, double z)
+{
+     return z * z < 1.0 ? exp(beta * (sqrt(1.0 - z * z) - 1.0)) : 0.0;
+}
+
+/* the W kernel values at the fine grid points I0, I0 + 1, ... around
+   the point G; return I0 */
+static INT kernel(const X(nufft) p, double g, R *k)
+{
+     double hw = 0.5 * p->w;
+     INT i0 = (INT) ceil(g - hw);
+     int l;
+
+     for (l = 0; l < p->w; ++l)
+	  k[l] = (R) phi(p->beta, ((double) (i0 + l) - g) / hw);
+     return i0;
+}
+
+/* Gauss-Legendre nodes and weights of order Q on (-1, 1) */
+static void gauss_legendre(int q, double *z, double *wt)
+{
+     int i, j, it;
+
+     for (i = 0; i < q; ++i) {
+	  double x = cos(pi * (i + 0.75) / (q + 0.5)), p0, p1, p2, dp, dx;
+	  for (it = 0; it < 100; ++it) {
+	       p0 = 1.0; p1 = x;
+	       for (j = 2; j <= q; ++j) {
+		    p2 = ((2 * j - 1) * x * p1 - (j - 1) * p0) / j;
+		    p0 = p1; p1 = p2;
+	       }
+	       dp = q * (x * p1 - p0) / (x * x - 1.0);
+	       dx = p1 / dp;
+	       x -= dx;
+	       if (fabs(dx) < 1e-15)
+		    break;
+	  }
+	  z[i] = x;
+	  wt[i] = 2.0 / ((1.0 - x * x) * dp * dp);
+     }
+}
+
+typedef struct {
+     int q;
+     double z[2 * MAXW + 2], wt[2 * MAXW + 2];
+} quadrature;
+
+static void mkquadrature(const X(nufft) p, quadrature *Q)
+{
+     Q->q = 2 * p->w + 2;
+     gauss_legendre(Q->q, Q->z, Q->wt);
+}
+
+/* The Fourier transform of the kernel at frequency T, on a fine grid
+   of NF points per period 2 pi, scaled by NF / (2 pi) so that spreading
+   and interpolation are undone by dividing by it. */
+static double kernel_ft(const X(nufft) p, const quadrature *Q, double t,
+			INT nf)
+{
+     double s = 0.0, a = pi * p->w * t / (double) nf;
+     int i;
+
+     for (i = 0; i < Q->q; ++i)
+	  s += Q->wt[i] * phi(p->beta, Q->z[i]) * cos(a * Q->z[i]);
+     return 0.5 * p->w * s;
+}
+
+static INT choose_grid_size(INT minsz)
+{
+     while (minsz % 2 || !X(factors_into_small_primes)(minsz))
+	  ++minsz;
+     return minsz;
+}
+
+/* the size of dimension D of the subgrid of slab S */
+static INT subgrid_n(const X(nufft) p, const slab *s, int d)
+{
+     if (d < p->d0)
+	  return 1;
+     return (d == p->d0 ? s->end - s->start : p->nf[d]) + 2 * p->P;
+}
+
+static void destroy_slabs(X(nufft) p)
+{
+     int s;
+
+     if (p->slabs) {
+	  for (s = 0; s < p->nslab; ++s)
+	       if (p->slabs[s].buf)
+		    X(free)(p->slabs[s].buf);
+	  X(ifree)(p->slabs);
+	  p->slabs = 0;
+     }
+}
+
+/* split the fine grid into slabs, at least P rows each, and as many as
+   there are threads to keep busy */
+static void mkslabs(X(nufft) p)
+{
+     INT nrow = p->nf[p->d0];
+     int s, nthr = X(the_planner)()->nthr;
+
+     destroy_slabs(p);
+     p->nslab = 1;
+     if (nthr > 1)
+	  p->nslab = (int) X(imax)(1, X(imin)(4 * nthr, nrow / (4 * p->P + 2)));
+     p->slabs = (slab *) MALLOC(sizeof(slab) * (size_t) p->nslab, OTHER);
+     for (s = 0; s < p->nslab; ++s) {
+	  slab *sl = p->slabs + s;
+	  sl->start = nrow * s / p->nslab;
+	  sl->end = nrow * (s + 1) / p->nslab;
+	  sl->lo = sl->hi = 0;
+	  sl->buf = X(alloc_complex)((size_t) (subgrid_n(p, sl, 0)
+					       * subgrid_n(p, sl, 1)
+					       * subgrid_n(p, sl, 2)));
+     }
+}
+
+/* the fine grid coordinates of the point X(d) in [-pi, pi) */
+static double grid_coord(double x, INT nf)
+{
+     double g = x * (double) nf / (2.0 * pi);
+     g -= (double) nf * floor(g / (double) nf);
+     return g < (double) nf ? g : 0.0;
+}
+
+/* Sort the M points with fine grid coordinates G (three per point) by
+   bins, into p->g and p->perm, and find the points of each slab. */
+static void sort_points(X(nufft) p, INT m, double *g)
+{
+     INT nb[3], nbin, i, j, r, *rowbin, *key, *cnt;
+     int d, s, d0 = p->d0;
+
+     /* the bins of the rows are numbered slab by slab */
+     rowbin = (INT *) MALLOC(sizeof(INT) * (size_t) p->nf[d0], OTHER);
+     for (s = 0, j = 0; s < p->nslab; ++s) {
+	  const slab *sl = p->slabs + s;
+	  for (r = sl->start; r < sl->end; ++r)
+	       rowbin[r] = j + (r - sl->start) / BINSZ;
+	  j += (sl->end - sl->start + BINSZ - 1) / BINSZ;
+     }
+     nb[d0] = j;
+     for (d = d0 + 1; d < 3; ++d)
+	  nb[d] = (p->nf[d] + BINSZ - 1) / BINSZ;
+     for (d = nbin = 1; d < 3 - d0; ++d)
+	  nbin *= nb[d0 + d];
+
+     key = (INT *) MALLOC(sizeof(INT) * (size_t) X(imax)(m, 1), OTHER);
+     for (i = 0; i < m; ++i) {
+	  INT k = rowbin[(INT) g[3 * i + d0]];
+	  for (d = d0 + 1; d < 3; ++d)
+	       k = k * nb[d] + (INT) g[3 * i + d] / BINSZ;
+	  key[i] = k;
+     }
+
+     /* counting sort */
+     nbin *= nb[d0];
+     cnt = (INT *) MALLOC(sizeof(INT) * (size_t) (nbin + 1), OTHER);
+     for (j = 0; j <= nbin; ++j)
+	  cnt[j] = 0;
+     for (i = 0; i < m; ++i)
+	  ++cnt[key[i] + 1];
+     for (j = 0; j < nbin; ++j)
+	  cnt[j + 1] += cnt[j];
+
+     for (s = 0; s < p->nslab; ++s) {
+	  slab *sl = p->slabs + s;
+	  INT per_row = nbin / nb[d0];
+	  sl->lo = cnt[rowbin[sl->start] * per_row];
+	  sl->hi = (s + 1 < p->nslab) ?
+	       cnt[rowbin[p->slabs[s + 1].start] * per_row] : m;
+     }
+
+     X(ifree0)(p->g);
+     X(ifree0)(p->perm);
+     p->g = (double *) MALLOC(sizeof(double) * 3 * (size_t) X(imax)(m, 1),
+			      OTHER);
+     p->perm = (INT *) MALLOC(sizeof(INT) * (size_t) X(imax)(m, 1), OTHER);
+     for (i = 0; i < m; ++i) {
+	  j = cnt[key[i]]++;
+	  p->perm[j] = i;
+	  for (d = 0; d < 3; ++d)
+	       p->g[3 * j + d] = g[3 * i + d];
+     }
+     p->m = m;
+
+     X(ifree)(cnt);
+     X(ifree)(key);
+     X(ifree)(rowbin);
+}
+
+/* the kernel of the sorted point I along each dimension: *W values K,
+   starting at fine grid point *I0 */
+static void point_kernel(const X(nufft) p, INT i, R k[3][MAXW], int *w,
+			 INT *i0)
+{
+     int d;
+
+     for (d = 0; d < 3; ++d) {
+	  if (d < p->d0) {
+	       k[d][0] = K(1.0);
+	       w[d] = 1;
+	       i0[d] = 0;
+	  } else {
+	       i0[d] = kernel(p, p->g[3 * i + d], k[d]);
+	       w[d] = p->w;
+	  }
+     }
+}
+
+typedef struct {
+     X(nufft) p;
+     C *c;
+} work;
+
+static void spread_slab(void *data, int s_)
+{
+     const work *wk = (const work *) data;
+     X(nufft) p = wk->p;
+     const slab *sl = p->slabs + s_;
+     INT n1 = subgrid_n(p, sl, 1), n2 = subgrid_n(p, sl, 2);
+     INT i, u[3];
+     R k[3][MAXW];
+     int w[3], l0, l1, l2, d;
+
+     memset(sl->buf, 0, sizeof(C) * (size_t) (subgrid_n(p, sl, 0) * n1 * n2));
+
+     for (i = sl->lo; i < sl->hi; ++i) {
+	  const R *c = wk->c[p->perm[i]];
+	  R cr = c[0], ci = c[1];
+
+	  if (p->pre) {
+	       const R *e = p->pre[i];
+	       R t = cr * e[0] - ci * e[1];
+	       ci = cr * e[1] + ci * e[0];
+	       cr = t;
+	  }
+
+	  point_kernel(p, i, k, w, u);
+	  for (d = p->d0; d < 3; ++d)
+	       u[d] += p->P - (d == p->d0 ? sl->start : 0);
+
+	  for (l0 = 0; l0 < w[0]; ++l0)
+	       for (l1 = 0; l1 < w[1]; ++l1) {
+		    R a = k[0][l0] * k[1][l1], ar = a * cr, ai = a * ci;
+		    R *row = sl->buf[((u[0] + l0) * n1 + u[1] + l1) * n2 + u[2]];
+		    const R *k2 = k[2];
+		    for (l2 = 0; l2 < w[2]; ++l2) {
+			 row[2 * l2] += ar * k2[l2];
+			 row[2 * l2 + 1] += ai * k2[l2];
+		    }
+	       }
+     }
+}
+
+/* add the padded subgrid S of dimensions D..2 to the grid G, which is
+   periodic in those dimensions */
+static void fold(const X(nufft) p, R *G, const R *S, int d)
+{
+     INT u, j, n = p->nf[d], ns = n + 2 * p->P;
+
+     if (d == 2) {
+	  for (u = 0, j = n - p->P; u < ns; ++u) {
+	       G[2 * j] += S[2 * u];
+	       G[2 * j + 1] += S[2 * u + 1];
+	       if (++j == n) j = 0;
+	  }
+     } else {
+	  INT gs = 2 * p->nf[2], ss = 2 * (p->nf[2] + 2 * p->P);
+	  for (u = 0, j = n - p->P; u < ns; ++u) {
+	       fold(p, G + j * gs, S + u * ss, 2);
+	       if (++j == n) j = 0;
+	  }
+     }
+}
+
+/* sum the rows of slab S of the grid from the subgrids */
+static void fold_slab(void *data, int s_)
+{
+     const work *wk = (const work *) data;
+     X(nufft) p = wk->p;
+     const slab *sl = p->slabs + s_;
+     INT nrow = p->nf[p->d0], rowsz = 1, u, r;
+     int d, i, j, t[3];
+
+     for (d = p->d0 + 1; d < 3; ++d)
+	  rowsz *= p->nf[d];
+     memset(p->grid[sl->start * rowsz], 0,
+	    sizeof(C) * (size_t) ((sl->end - sl->start) * rowsz));
+
+     t[0] = s_;
+     t[1] = (s_ + p->nslab - 1) % p->nslab;
+     t[2] = (s_ + 1) % p->nslab;
+     for (i = 0; i < 3; ++i) {
+	  const slab *src;
+	  INT srowsz = 1;
+
+	  for (j = 0; j < i; ++j)
+	       if (t[j] == t[i]) break;
+	  if (j < i)
+	       continue;   /* seen */
+
+	  src = p->slabs + t[i];
+	  for (d = p->d0 + 1; d < 3; ++d)
+	       srowsz *= subgrid_n(p, src, d);
+	  for (u = 0; u < src->end - src->start + 2 * p->P; ++u) {
+	       r = src->start + u - p->P;
+	       r = r < 0 ? r + nrow : (r >= nrow ? r - nrow : r);
+	       if (r < sl->start || r >= sl->end)
+		    continue;
+	       if (p->d0 == 2) {
+		    p->grid[r][0] += src->buf[u][0];
+		    p->grid[r][1] += src->buf[u][1];
+	       } else
+		    fold(p, p->grid[r * rowsz], src->buf[u * srowsz],
+			 p->d0 + 1);
+	  }
+     }
+}
+
+/* spread the values C at the points into p->grid */
+static void spread(X(nufft) p, C *c)
+{
+     work wk;
+     wk.p = p;
+     wk.c = c;
+     X(run_batch)(p->nslab, spread_slab, (void *) &wk);
+     X(run_batch)(p->nslab, fold_slab, (void *) &wk);
+}
+
+/* interpolate p->grid at the points of slab S into C */
+static void interp_slab(void *data, int s_)
+{
+     const work *wk = (const work *) data;
+     X(nufft) p = wk->p;
+     const slab *sl = p->slabs + s_;
+     INT i, i0[3], j[3][MAXW], n1 = p->nf[1], n2 = p->nf[2];
+     R k[3][MAXW];
+     int w[3], l0, l1, l2, d;
+
+     for (i = sl->lo; i < sl->hi; ++i) {
+	  R sr = 0, si = 0;
+
+	  point_kernel(p, i, k, w, i0);
+	  for (d = 0; d < 3; ++d)
+	       for (l0 = 0; l0 < w[d]; ++l0) {
+		    INT x = i0[d] + l0, n = p->nf[d];
+		    j[d][l0] = x < 0 ? x + n : (x >= n ? x - n : x);
+	       }
+
+	  for (l0 = 0; l0 < w[0]; ++l0)
+	       for (l1 = 0; l1 < w[1]; ++l1) {
+		    const C *row = p->grid + (j[0][l0] * n1 + j[1][l1]) * n2;
+		    R a = k[0][l0] * k[1][l1], rr = 0, ri = 0;
+		    for (l2 = 0; l2 < w[2]; ++l2) {
+			 rr += row[j[2][l2]][0] * k[2][l2];
+			 ri += row[j[2][l2]][1] * k[2][l2];
+		    }
+		    sr += a * rr;
+		    si += a * ri;
+	       }
+
+	  wk->c[p->perm[i]][0] = sr;
+	  wk->c[p->perm[i]][1] = si;
+     }
+}
+
+/* between the modes F and the fine grid, dividing by the transform of
+   the kernel: F from the grid if TO_MODES, else the grid from F */
+static void deconvolve(X(nufft) p, C *f, int to_modes)
+{
+     INT q0, q1, q2, k0, k1, k2;
+     const INT *n = p->n, *nf = p->nf;
+
+     if (!to_modes)
+	  memset(p->grid, 0, sizeof(C) * (size_t) (nf[0] * nf[1] * nf[2]));
+
+     for (q0 = 0; q0 < n[0]; ++q0) {
+	  k0 = q0 - n[0] / 2;
+	  k0 += k0 < 0 ? nf[0] : 0;
+	  for (q1 = 0; q1 < n[1]; ++q1) {
+	       R a = p->corr[0][q0] * p->corr[1][q1];
+	       C *x = f + (q0 * n[1] + q1) * n[2];
+	       C *G;
+	       k1 = q1 - n[1] / 2;
+	       k1 += k1 < 0 ? nf[1] : 0;
+	       G = p->grid + (k0 * nf[1] + k1) * nf[2];
+	       for (q2 = 0; q2 < n[2]; ++q2) {
+		    R b = a * p->corr[2][q2];
+		    k2 = q2 - n[2] / 2;
+		    k2 += k2 < 0 ? nf[2] : 0;
+		    if (to_modes) {
+			 x[q2][0] = G[k2][0] * b;
+			 x[q2][1] = G[k2][1] * b;
+		    } else {
+			 G[k2][0] = x[q2][0] * b;
+			 G[k2][1] = x[q2][1] * b;
+		    }
+	       }
+	  }
+     }
+}
+
+static void mkcorr(X(nufft) p)
+{
+     quadrature Q;
+     INT q;
+     int d;
+
+     mkquadrature(p, &Q);
+     for (d = 0; d < 3; ++d) {
+	  p->corr[d] = (R *) MALLOC(sizeof(R) * (size_t) p->n[d], OTHER);
+	  for (q = 0; q < p->n[d]; ++q)
+	       p->corr[d][q] = (d < p->d0) ? K(1.0) :
+		    (R) (1.0 / kernel_ft(p, &Q, (double) (q - p->n[d] / 2),
+					 p->nf[d]));
+     }
+}
+
+/* Plan a non-uniform FFT of TYPE 1, 2 or 3 and RANK 1 to 3, with N[i]
+   modes in dimension i for types 1 and 2 (N is not used by type 3),
+   exponent sign SIGN, and relative accuracy about TOL.  The points
+   are given later, by X(nufft_setpts). */
+X(nufft) X(plan_nufft)(int type, int rank, const int *n, int sign,
+			double tol, unsigned flags)
+{
+     X(nufft) p;
+     int d;
+
+     if (type < 1 || type > 3 || rank < 1 || rank > 3 || !(tol > 0.0))
+	  return 0;
+     if (type != 3)
+	  for (d = 0; d < rank; ++d)
+	       if (n[d] <= 0)
+		    return 0;
+
+     p = (X(nufft)) MALLOC(sizeof(*p), OTHER);
+     memset(p, 0, sizeof(*p));
+     p->type = type;
+     p->rank = rank;
+     p->sign = sign < 0 ? FFTW_FORWARD : FFTW_BACKWARD;
+     p->flags = flags & ~(FFTW_NORMALIZE_ORTHO | FFTW_NORMALIZE_BACKWARD);
+     p->tol = tol;
+     p->w = (int) X(imax)(2, X(imin)(MAXW, (INT) ceil(-log10(tol)) + 1));
+     p->beta = 2.30 * p->w;
+     p->P = (p->w + 1) / 2;
+     p->d0 = 3 - rank;
+     for (d = 0; d < 3; ++d)
+	  p->n[d] = p->nf[d] = 1;
+
+     if (type == 3)
+	  return p;
+
+     for (d = p->d0; d < 3; ++d) {
+	  p->n[d] = n[d - p->d0];
+	  p->nf[d] = choose_grid_size(X(imax)(SIGMA * p->n[d], 2 * p->w));
+     }
+     mkcorr(p);
+     mkslabs(p);
+     sort_points(p, 0, 0);
+
+     p->grid = X(alloc_complex)((size_t) (p->nf[0] * p->nf[1] * p->nf[2]));
+     {
+	  int nf[3];
+	  edgeop saved[2];
+	  for (d = 0; d < rank; ++d)
+	       nf[d] = (int) p->nf[p->d0 + d];
+	  X(edge_suspend)(saved);
+	  p->fft = X(plan_dft)(rank, nf, p->grid, p->grid, p->sign,
+			       p->flags);
+	  X(edge_resume)(saved);
+     }
+     if (!p->fft) {
+	  X(destroy_nufft)(p);
+	  return 0;
+     }
+     return p;
+}
+
+/* type 3: choose the fine grid for the points X and the frequencies S,
+   and plan the type 2 transform from it to the frequencies */
+static int setpts3(X(nufft) p, INT m, const R *x, INT nk, const R *s)
+{
+     double cx[3], hx[3], cs[3], hs[3], gam[3], *g;
+     R *theta;
+     quadrature Q;
+     INT i, j;
+     int d, rank = p->rank, d0 = p->d0, nf[3];
+
+     for (d = 0; d < rank; ++d) {
+	  double lo = 0, hi = 0;
+	  for (i = 0; i < m; ++i) {
+	       double v = x[i * rank + d];
+	       if (i == 0 || v < lo) lo = v;
+	       if (i == 0 || v > hi) hi = v;
+	  }
+	  cx[d] = 0.5 * (hi + lo);
+	  hx[d] = 0.5 * (hi - lo);
+	  lo = hi = 0;
+	  for (i = 0; i < nk; ++i) {
+	       double v = s[i * rank + d];
+	       if (i == 0 || v < lo) lo = v;
+	       if (i == 0 || v > hi) hi = v;
+	  }
+	  cs[d] = 0.5 * (hi + lo);
+	  hs[d] = 0.5 * (hi - lo);
+
+	  /* degenerate extents */
+	  if (hx[d] == 0.0 && hs[d] == 0.0)
+	       hx[d] = hs[d] = 1.0;
+	  else if (hx[d] == 0.0)
+	       hx[d] = 1.0 / hs[d];
+	  else if (hs[d] == 0.0)
+	       hs[d] = 1.0 / hx[d];
+
+	  p->nf[d0 + d] = choose_grid_size(X(imax)(
+	       2 * p->w, (INT) (2.0 * SIGMA / pi * hx[d] * hs[d]) + p->w + 1));
+	  nf[d] = (int) p->nf[d0 + d];
+	  gam[d] = (double) p->nf[d0 + d] / (2.0 * SIGMA * hs[d]);
+     }
+
+     /* spread the points at (x - cx) / gam, shifted by pi so that the
+	grid is in the order of the modes of the type 2 transform */
+     mkslabs(p);
+     g = (double *) MALLOC(sizeof(double) * 3 * (size_t) X(imax)(m, 1),
+			   OTHER);
+     for (i = 0; i < m; ++i)
+	  for (d = 0; d < 3; ++d)
+	       g[3 * i + d] = (d < d0) ? 0.0 :
+		    grid_coord((x[i * rank + d - d0] - cx[d - d0])
+			       / gam[d - d0] + pi, p->nf[d]);
+     sort_points(p, m, g);
+     X(ifree)(g);
+
+     X(ifree0)(p->pre);
+     p->pre = (C *) MALLOC(sizeof(C) * (size_t) X(imax)(m, 1), OTHER);
+     for (i = 0; i < m; ++i) {
+	  double a = 0;
+	  j = p->perm[i];
+	  for (d = 0; d < rank; ++d)
+	       a += cs[d] * (x[j * rank + d] - cx[d]);
+	  p->pre[i][0] = (R) cos(a);
+	  p->pre[i][1] = (R) (p->sign * sin(a));
+     }
+
+     if (p->grid)
+	  X(free)(p->grid);
+     p->grid = X(alloc_complex)((size_t) (p->nf[0] * p->nf[1] * p->nf[2]));
+
+     X(destroy_nufft)(p->inner);
+     p->inner = X(plan_nufft)(2, rank, nf, p->sign, p->tol, p->flags);
+     if (!p->inner)
+	  return 0;
+
+     mkquadrature(p, &Q);
+     theta = (R *) MALLOC(sizeof(R) * (size_t) X(imax)(nk * rank, 1),
+			  OTHER);
+     X(ifree0)(p->post);
+     if (p->tmp)
+	  X(free)(p->tmp);
+     p->post = (C *) MALLOC(sizeof(C) * (size_t) X(imax)(nk, 1), OTHER);
+     p->tmp = X(alloc_complex)((size_t) X(imax)(nk, 1));
+     for (i = 0; i < nk; ++i) {
+	  double a = 0, c = 1;
+	  for (d = 0; d < rank; ++d) {
+	       double sd = s[i * rank + d], t = gam[d] * (sd - cs[d]);
+	       theta[i * rank + d] = (R) (2.0 * pi * t / nf[d]);
+	       a += sd * cx[d];
+	       c *= kernel_ft(p, &Q, t, nf[d]);
+	  }
+	  p->post[i][0] = (R) (cos(a) / c);
+	  p->post[i][1] = (R) (p->sign * sin(a) / c);
+     }
+     p->nk = nk;
+     i = X(nufft_setpts)(p->inner, (int) nk, theta, 0, 0);
+     X(ifree)(theta);
+     return (int) i;
+}
+
+/* Set the M points X, with RANK coordinates each in row-major order,
+   and for type 3 the NK frequencies S in the same format.  The points
+   of types 1 and 2 are taken modulo 2 pi.  Return 0 on failure. */
+int X(nufft_setpts)(X(nufft) p, int m, const R *x, int nk, const R *s)
+{
+     double *g;
+     INT i;
+     int d, d0 = p->d0;
+
+     if (m < 0 || (p->type == 3 && nk < 0))
+	  return 0;
+     if (p->type == 3)
+	  return setpts3(p, m, x, nk, s);
+
+     g = (double *) MALLOC(sizeof(double) * 3 * (size_t) X(imax)(m, 1),
+			   OTHER);
+     for (i = 0; i < m; ++i)
+	  for (d = 0; d < 3; ++d)
+	       g[3 * i + d] = (d < d0) ? 0.0 :
+		    grid_coord(x[i * p->rank + d - d0], p->nf[d]);
+     sort_points(p, m, g);
+     X(ifree)(g);
+     return 1;
+}
+
+/* Type 1: F[k] = sum_j C[j] exp(sign i k.x_j) for the modes k, whose
+   components run from -floor(n/2) to floor((n-1)/2), in row-major
+   order.  Type 2: C[j] = sum_k F[k] exp(sign i k.x_j).  Type 3:
+   F[k] = sum_j C[j] exp(sign i s_k.x_j). */
+void X(nufft_execute)(X(nufft) p, C *c, C *f)
+{
+     INT i;
+     work wk;
+
+     switch (p->type) {
+	 case 1:
+	      spread(p, c);
+	      X(execute)(p->fft);
+	      deconvolve(p, f, 1);
+	      break;
+	 case 2:
+	      deconvolve(p, f, 0);
+	      X(execute)(p->fft);
+	      wk.p = p;
+	      wk.c = c;
+	      X(run_batch)(p->nslab, interp_slab, (void *) &wk);
+	      break;
+	 case 3:
+	      spread(p, c);
+	      X(nufft_execute)(p->inner, p->tmp, p->grid);
+	      for (i = 0; i < p->nk; ++i) {
+		   const R *t = p->tmp[i], *e = p->post[i];
+		   f[i][0] = t[0] * e[0] - t[1] * e[1];
+		   f[i][1] = t[0] * e[1] + t[1] * e[0];
+	      }
+	      break;
+     }
+}
+
+void X(destroy_nufft)(X(nufft) p)
+{
+     int d;
+
+     if (p) {
+	  X(destroy_nufft)(p->inner);
+	  X(destroy_plan)(p->fft);
+	  destroy_slabs(p);
+	  for (d = 0; d < 3; ++d)
+	       X(ifree0)(p->corr[d]);
+	  if (p->grid)
+	       X(free)(p->grid);
+	  if (p->tmp)
+	       X(free)(p->tmp);
+	  X(ifree0)(p->pre);
+	  X(ifree0)(p->post);
+	  X(ifree0)(p->g);
+	  X(ifree0)(p->perm);
+	  X(ifree)(p);
+     }
+}
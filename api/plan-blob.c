@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/* Binary export and import of single plans.  The blob records the
+   shape of the problem and the trace of the solvers that created the
+   plan (see plan_trace in kernel/ifftw.h), so that importing it costs
+   no search and no hashing, other than checking the signature of the
+   configuration as the wisdom does.  Since the arrays are not part of
+   the blob, they are passed to X(import_plan), interpreted as in the
+   new-array execute functions.
+
+   The blob is in the native byte order and word size of the machine,
+   which the header records, and it is therefore not portable. */
+
+#include "api/api.h"
+#include "dft/dft.h"
+#include "rdft/rdft.h"
+#include <string.h>
+
+static const char magic[8] = { 'F', 'F', 'T', 'W', 'P', 'L', 'N', '2' };
+#define BYTEORDER ((INT) 0x0102)
+
+typedef struct {
+     unsigned char *buf; /* 0 when we only count */
+     size_t len, n;      /* capacity, bytes written or read */
+     int ok;
+} blob;
+
+static void put(blob *b, INT x)
+{
+     if (b->buf && b->n + sizeof(INT) <= b->len)
+	  memcpy(b->buf + b->n, &x, sizeof(INT));
+     b->n += sizeof(INT);
+}
+
+static INT get(blob *b)
+{
+     INT x = 0;
+     if (b->n + sizeof(INT) <= b->len)
+	  memcpy(&x, b->buf + b->n, sizeof(INT));
+     else
+	  b->ok = 0;
+     b->n += sizeof(INT);
+     return x;
+}
+
+static void put_tensor(blob *b, const tensor *t)
+{
+     int i;
+
+     if (!FINITE_RNK(t->rnk)) {
+	  put(b, -1);
+	  return;
+     }
+     put(b, t->rnk);
+     for (i = 0; i < t->rnk; ++i) {
+	  put(b, t->dims[i].n);
+	  put(b, t->dims[i].is);
+	  put(b, t->dims[i].os);
+     }
+}
+
+static tensor *get_tensor(blob *b)
+{
+     INT rnk = get(b);
+     tensor *t;
+     int i;
+
+     if (rnk < 0)
+	  return X(mktensor)(RNK_MINFTY);
+     if (!b->ok || (size_t)rnk > (b->len - b->n) / (3 * sizeof(INT))) {
+	  b->ok = 0;
+	  return X(mktensor)(0);
+     }
+     t = X(mktensor)((int)rnk);
+     for (i = 0; i < t->rnk; ++i) {
+	  t->dims[i].n = get(b);
+	  t->dims[i].is = get(b);
+	  t->dims[i].os = get(b);
+	  if (t->dims[i].n <= 0)
+	       b->ok = 0;
+     }
+     return t;
+}
+
+/* An array of the problem is BASE + OFF, where BASE is the in or out
+   argument of the execute functions.  Complex arrays must be
+   interleaved, since split arrays have no common base. */
+static int interleavedp(R *r, R *i)
+{
+     INT d = UNTAINT(i) - UNTAINT(r);
+     return (d == 1 || d == -1);
+}
+
+static R *base2(R *r, R *i)
+{
+     return UNTAINT(r) < UNTAINT(i) ? UNTAINT(r) : UNTAINT(i);
+}
+
+/* write PRB, and store its bases into *INP and *OUTP, or return 0 if
+   we cannot represent it */
+static int put_problem(blob *b, const problem *prb, R **inp, R **outp)
+{
+     R *in, *out;
+
+     switch (prb->adt->problem_kind) {
+	 case PROBLEM_DFT: {
+	      const problem_dft *d = (const problem_dft *) prb;
+	      if (!interleavedp(d->ri, d->ii) || !interleavedp(d->ro, d->io))
+		   return 0;
+	      in = base2(d->ri, d->ii);
+	      out = base2(d->ro, d->io);
+	      put(b, PROBLEM_DFT);
+	      put_tensor(b, d->sz);
+	      put_tensor(b, d->vecsz);
+	      put(b, UNTAINT(d->ri) - in);
+	      put(b, UNTAINT(d->ro) - out);
+	      put(b, (INT)TAINTOF(d->ri));
+	      put(b, (INT)TAINTOF(d->ro));
+	      break;
+	 }
+	 case PROBLEM_RDFT: {
+	      const problem_rdft *d = (const problem_rdft *) prb;
+	      int i;
+	      in = UNTAINT(d->I);
+	      out = UNTAINT(d->O);
+	      put(b, PROBLEM_RDFT);
+	      put_tensor(b, d->sz);
+	      put_tensor(b, d->vecsz);
+	      for (i = 0; i < d->sz->rnk; ++i)
+		   put(b, (INT)d->kind[i]);
+	      put(b, (INT)TAINTOF(d->I));
+	      put(b, (INT)TAINTOF(d->O));
+	      break;
+	 }
+	 case PROBLEM_RDFT2: {
+	      const problem_rdft2 *d = (const problem_rdft2 *) prb;
+	      R *c;
+	      if (!interleavedp(d->cr, d->ci))
+		   return 0;
+	      c = base2(d->cr, d->ci);
+	      in = R2HC_KINDP(d->kind) ? UNTAINT(d->r0) : c;
+	      out = R2HC_KINDP(d->kind) ? c : UNTAINT(d->r0);
+	      put(b, PROBLEM_RDFT2);
+	      put_tensor(b, d->sz);
+	      put_tensor(b, d->vecsz);
+	      put(b, (INT)d->kind);
+	      put(b, UNTAINT(d->r1) - UNTAINT(d->r0));
+	      put(b, UNTAINT(d->cr) - c);
+	      put(b, (INT)TAINTOF(d->r0));
+	      put(b, (INT)TAINTOF(d->cr));
+	      break;
+	 }
+	 default:
+	      return 0;
+     }
+
+     put(b, in == out);
+     *inp = in;
+     *outp = out;
+     return 1;
+}
+
+/* Write the plan into BUF, if LEN bytes suffice, and return the size
+   of the blob.  Return 0 if the plan cannot be exported, because it
+   was not created from wisdom or because its problem has split
+   arrays. */
+size_t X(export_plan)(const X(plan) p, void *buf, size_t len)
+{
+     blob b;
+     md5 m;
+     unsigned i;
+     const plan_trace *t = APIPLAN_TRACE(p);
+     R *in, *out;
+
+     if (!t)
+	  return 0;
+
+     b.buf = (unsigned char *) buf;
+     b.len = len;
+     b.n = sizeof(magic) + 1;
+     b.ok = 1;
+     if (b.buf && b.n <= len) {
+	  memcpy(b.buf, magic, sizeof(magic));
+	  b.buf[sizeof(magic)] = (unsigned char) sizeof(INT);
+     }
+
+     X(planner_signature)(X(the_planner)(), &m);
+     put(&b, BYTEORDER);
+     for (i = 0; i < 4; ++i)
+	  put(&b, (INT)m.s[i]);
+     put(&b, p->sign);
+     put(&b, t->nthr);
+     put(&b, (INT)t->flags);
+
+     if (!put_problem(&b, p->prb, &in, &out))
+	  return 0;
+
+     put(&b, (INT)t->n);
+     for (i = 0; i < t->n; ++i) {
+	  const flags_t *f = t->step + i;
+	  put(&b, (INT)f->l);
+	  put(&b, (INT)f->u);
+	  put(&b, (INT)(f->timelimit_impatience | (f->hash_info << 9)
+			| (f->slvndx << 12)));
+     }
+
+     return b.n;
+}
+
+/* T is 0 or 1, checked by the caller, since TAINT() ors it into P */
+static R *taint(R *p, INT t)
+{
+     UNUSED(t); /* without SIMD */
+     return TAINT(p, t);
+}
+
+static problem *get_problem(blob *b, void *in_, void *out_)
+{
+     R *in = (R *) in_, *out = (R *) out_;
+     INT kind = get(b);
+     tensor *sz, *vecsz;
+     problem *prb;
+
+     if (!b->ok || !in || !out)
+	  return 0;
+
+     sz = get_tensor(b);
+     vecsz = get_tensor(b);
+     if (!b->ok || !FINITE_RNK(sz->rnk))
+	  goto bad;
+
+     switch (kind) {
+	 case PROBLEM_DFT: {
+	      INT oi = get(b), oo = get(b), ti = get(b), to = get(b);
+	      if (!b->ok || (oi & ~1) || (oo & ~1) || (ti & ~1) || (to & ~1))
+		   goto bad;
+	      prb = X(mkproblem_dft_d)(sz, vecsz,
+				       taint(in + oi, ti),
+				       taint(in + (1 - oi), ti),
+				       taint(out + oo, to),
+				       taint(out + (1 - oo), to));
+	      break;
+	 }
+	 case PROBLEM_RDFT: {
+	      rdft_kind *k;
+	      int i;
+	      INT ti, to;
+	      k = (rdft_kind *) MALLOC(sizeof(rdft_kind)
+				       * (unsigned)X(imax)(sz->rnk, 1), PROBLEMS);
+	      for (i = 0; i < sz->rnk; ++i) {
+		   INT ki = get(b);
+		   if (ki < R2HC00 || ki > RODFT11)
+			b->ok = 0;
+		   k[i] = (rdft_kind) ki;
+	      }
+	      ti = get(b);
+	      to = get(b);
+	      if (!b->ok || (ti & ~1) || (to & ~1)) {
+		   X(ifree)(k);
+		   goto bad;
+	      }
+	      prb = X(mkproblem_rdft_d)(sz, vecsz, taint(in, ti),
+					taint(out, to), k);
+	      X(ifree)(k);
+	      break;
+	 }
+	 case PROBLEM_RDFT2: {
+	      rdft_kind k = (rdft_kind) get(b);
+	      INT r1 = get(b), cr = get(b);
+	      INT tr = get(b), tc = get(b);
+	      R *r = R2HC_KINDP(k) ? in : out, *c = R2HC_KINDP(k) ? out : in;
+	      if (!b->ok || (cr & ~1) || (tr & ~1) || (tc & ~1)
+		  || (k != R2HC && k != R2HCII && k != HC2R && k != HC2RIII))
+		   goto bad;
+	      prb = X(mkproblem_rdft2_d)(sz, vecsz, taint(r, tr),
+					 taint(r + r1, tr),
+					 taint(c + cr, tc),
+					 taint(c + (1 - cr), tc), k);
+	      break;
+	 }
+	 default:
+	      goto bad;
+     }
+
+     /* the trace is only valid for the same placement */
+     if (!b->ok || get(b) != (in == out)) {
+	  X(problem_destroy)(prb);
+	  return 0;
+     }
+     return prb;
+
+ bad:
+     X(tensor_destroy2)(sz, vecsz);
+     return 0;
+}
+
+/* Recreate the plan exported into BUF for the arrays IN and OUT,
+   which must be in place iff the original arrays were.  Return 0 if
+   the blob does not come from this configuration of FFTW, or if the
+   plan does not apply to the arrays, e.g. because of their
+   alignment. */
+X(plan) X(import_plan)(const void *buf, size_t len, void *in, void *out)
+{
+     blob b;
+     md5 m;
+     unsigned i, n;
+     int sign, nthr;
+     unsigned flags;
+     problem *prb;
+     plan_trace *t;
+
+     b.buf = (unsigned char *) buf;
+     b.len = len;
+     b.n = sizeof(magic) + 1;
+     b.ok = 1;
+     if (!buf || len < b.n || memcmp(buf, magic, sizeof(magic))
+	 || b.buf[sizeof(magic)] != sizeof(INT) || get(&b) != BYTEORDER)
+	  return 0;
+
+     X(planner_signature)(X(the_planner)(), &m);
+     for (i = 0; i < 4; ++i)
+	  if (get(&b) != (INT)m.s[i])
+	       return 0;
+
+     sign = (int)get(&b);
+     nthr = (int)get(&b);
+     flags = (unsigned)get(&b);
+     if (!b.ok || nthr < 1 || !(prb = get_problem(&b, in, out)))
+	  return 0;
+
+     n = (unsigned)get(&b);
+     if (!b.ok || n > (len - b.n) / (3 * sizeof(INT))) {
+	  X(problem_destroy)(prb);
+	  return 0;
+     }
+
+     t = X(mktrace)();
+     t->nthr = nthr;
+     t->flags = flags;
+     for (i = 0; i < n; ++i) {
+	  unsigned l = (unsigned)get(&b), u = (unsigned)get(&b);
+	  unsigned w = (unsigned)get(&b);
+	  unsigned k = X(trace_push)(t);
+	  flags_t *f = t->step + k;
+	  f->l = l;
+	  f->u = u;
+	  f->timelimit_impatience = w & 511;
+	  f->hash_info = (w >> 9) & 7;
+	  f->slvndx = w >> 12;
+     }
+
+     return X(mkapiplan_replay)(sign, prb, t);
+}
+
+static int nonnegative_strides(const tensor *t)
+{
+     int i;
+
+     for (i = 0; i < t->rnk; ++i)
+	  if (t->dims[i].is < 0 || t->dims[i].os < 0)
+	       return 0;
+     return 1;
+}
+
+/* the address in BUF with the same alignment as P, modulo 64 bytes */
+static R *shadow(char *buf, const R *p)
+{
+     return (R *) (buf + (((uintptr_t) p - (uintptr_t) buf) & 63));
+}
+
+/* Return a copy of PRB on new arrays with the same layout and
+   alignment, on which the planner may measure while the user executes
+   on the arrays of PRB (see FFTW_ANYTIME in apiplan.c).  The arrays
+   are allocated in *BUFP, which the caller frees with X(ifree).
+   Return 0 if X(export_plan) could not represent PRB, or if PRB has
+   negative strides. */
+problem *X(mkproblem_shadow)(const problem *prb, void **bufp)
+{
+     blob b;
+     R *in, *out;
+     const tensor *sz, *vecsz;
+     INT len, r1 = 0;
+     char *buf;
+     problem *shadow_prb;
+
+     switch (prb->adt->problem_kind) {
+	 case PROBLEM_DFT:
+	      sz = ((const problem_dft *) prb)->sz;
+	      vecsz = ((const problem_dft *) prb)->vecsz;
+	      break;
+	 case PROBLEM_RDFT:
+	      sz = ((const problem_rdft *) prb)->sz;
+	      vecsz = ((const problem_rdft *) prb)->vecsz;
+	      break;
+	 case PROBLEM_RDFT2: {
+	      const problem_rdft2 *d = (const problem_rdft2 *) prb;
+	      sz = d->sz;
+	      vecsz = d->vecsz;
+	      r1 = UNTAINT(d->r1) - UNTAINT(d->r0);
+	      break;
+	 }
+	 default:
+	      return 0;
+     }
+     if (!FINITE_RNK(sz->rnk) || !FINITE_RNK(vecsz->rnk)
+	 || !nonnegative_strides(sz) || !nonnegative_strides(vecsz)
+	 || r1 < 0)
+	  return 0;
+
+     /* count the blob, and find the bases */
+     b.buf = 0;
+     b.len = b.n = 0;
+     b.ok = 1;
+     if (!put_problem(&b, prb, &in, &out))
+	  return 0;
+
+     /* the real and imaginary parts are one element apart */
+     len = X(tensor_max_index)(sz) + X(tensor_max_index)(vecsz) + r1 + 2;
+
+     buf = (char *) MALLOC((size_t)len * sizeof(R) * (in == out ? 1 : 2)
+			   + 128, BUFFERS);
+     b.buf = (unsigned char *) MALLOC(b.n, OTHER);
+     b.len = b.n;
+     b.n = 0;
+     put_problem(&b, prb, &in, &out);
+     b.n = 0;
+     if (in == out) {
+	  in = out = shadow(buf, in);
+     } else {
+	  R *in1 = shadow(buf, in);
+	  out = shadow((char *) (in1 + len), out);
+	  in = in1;
+     }
+     shadow_prb = get_problem(&b, in, out);
+     X(ifree)(b.buf);
+
+     if (!shadow_prb) {
+	  X(ifree)(buf);
+	  return 0;
+     }
+     *bufp = buf;
+     return shadow_prb;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "api/api.h"
+#include "rdft/rdft.h"
+
+/* Correlation is convolution with the conjugate of the reversed
+   kernel: k'[s] = conj(k[nk - 1 - s]) for linear correlation, and
+   k'[s] = conj(k[-s mod n]), of dimensions n, for circular
+   correlation.  Return k', with its dimensions in NK2. */
+static R *corr_kernel(int rank, const int *n, const int *nk,
+		      const R *k, int c, int circular, int *nk2)
+{
+     INT i, j, t, ktot = 1, kntot = 1;
+     int d;
+     R *k2;
+
+     for (d = 0; d < rank; ++d) {
+	  nk2[d] = circular ? n[d] : nk[d];
+	  ktot *= nk[d];
+	  kntot *= nk2[d];
+     }
+
+     k2 = (R *) MALLOC(sizeof(R) * c * kntot, PROBLEMS);
+     for (i = 0; i < c * kntot; ++i)
+	  k2[i] = K(0.0);
+
+     for (i = 0; i < ktot; ++i) {
+	  /* j is the index of the reflection of the element i */
+	  for (d = rank - 1, t = i, j = 0; d >= 0; --d) {
+	       INT s = t % nk[d], stride = 1;
+	       int e;
+	       t /= nk[d];
+	       for (e = d + 1; e < rank; ++e)
+		    stride *= nk2[e];
+	       s = circular ? (n[d] - s) % n[d] : nk[d] - 1 - s;
+	       j += s * stride;
+	  }
+	  k2[c * j] = k[c * i];
+	  if (c == 2)
+	       k2[c * j + 1] = -k[c * i + 1];
+     }
+     return k2;
+}
+
+static X(plan) mkconv(int rank, const int *n, const int *nk, const R *k,
+		      R *in, R *out, int c, X(conv_kind) kind,
+		      unsigned flags)
+{
+     int circular = (kind == FFTW_CONV_CIRCULAR
+		     || kind == FFTW_CORR_CIRCULAR);
+     int corr = (kind == FFTW_CORR_LINEAR || kind == FFTW_CORR_CIRCULAR);
+     int *no, *nk2 = 0;
+     int d;
+     R *k2 = 0;
+     X(plan) p;
+
+     if (!X(many_kosherp)(rank, n, 1) || !X(many_kosherp)(rank, nk, 1))
+	  return 0;
+     for (d = 0; d < rank; ++d)
+	  if (circular && nk[d] > n[d])
+	       return 0;
+
+     if (corr) {
+	  nk2 = (int *) MALLOC(sizeof(int) * (unsigned)rank, PROBLEMS);
+	  k2 = corr_kernel(rank, n, nk, k, c, circular, nk2);
+	  nk = nk2;
+	  k = k2;
+     }
+
+     no = (int *) MALLOC(sizeof(int) * (unsigned)rank, PROBLEMS);
+     for (d = 0; d < rank; ++d)
+	  no[d] = circular ? n[d] : n[d] + nk[d] - 1;
+
+     {
+	  tensor *sz = X(mktensor_rowmajor)(rank, n, n, no, c, c);
+	  tensor *ksz = X(mktensor_rowmajor)(rank, nk, nk, nk, c, c);
+	  p = X(mkapiplan)(0, flags,
+			   X(mkproblem_conv)(sz, ksz, k,
+					     TAINT_UNALIGNED(in, flags),
+					     TAINT_UNALIGNED(out, flags),
+					     c == 1, circular));
+	  X(tensor_destroy2)(sz, ksz);
+     }
+
+     X(ifree)(no);
+     X(ifree0)(nk2);
+     X(ifree0)(k2);
+     return p;
+}
+
+X(plan) X(plan_convolve)(int rank, const int *n, const int *nk,
+			 const C *kernel, C *in, C *out,
+			 X(conv_kind) kind, unsigned flags)
+{
+     return mkconv(rank, n, nk, kernel[0], in[0], out[0], 2, kind, flags);
+}
+
+X(plan) X(plan_convolve_r)(int rank, const int *n, const int *nk,
+			   const R *kernel, R *in, R *out,
+			   X(conv_kind) kind, unsigned flags)
+{
+     return mkconv(rank, n, nk, kernel, in, out, 1, kind, flags);
+}
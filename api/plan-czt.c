@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "api/api.h"
+#include "dft/dft.h"
+
+X(plan) X(plan_czt)(int n, int m, const C *w, const C *a,
+		    C *in, C *out, unsigned flags)
+{
+     R *ri, *ii, *ro, *io;
+
+     EXTRACT_REIM(FFT_SIGN, in, &ri, &ii);
+     EXTRACT_REIM(FFT_SIGN, out, &ro, &io);
+
+     return X(mkapiplan)(
+	  FFT_SIGN, flags,
+	  X(mkproblem_czt)(n, m, 2, 2,
+			   TAINT_UNALIGNED(ri, flags),
+			   TAINT_UNALIGNED(ii, flags),
+			   TAINT_UNALIGNED(ro, flags),
+			   TAINT_UNALIGNED(io, flags),
+			   *w, *a));
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Execution profile of a plan, see kernel/profile.c */
+
+#include "api/api.h"
+
+void X(profile_plan)(const X(plan) p, int on)
+{
+     X(profile_tree)(APIPLAN_PLN(p), on);
+}
+
+void X(fprint_plan_profile)(const X(plan) p, FILE *output_file)
+{
+     printer *pr = X(mkprinter_file)(output_file);
+     X(profile_print_tree)(APIPLAN_PLN(p), pr);
+     X(printer_destroy)(pr);
+}
+
+void X(print_plan_profile)(const X(plan) p)
+{
+     X(fprint_plan_profile)(p, stdout);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "api/api.h"
+#include "dft/dft.h"
+#include <math.h>
+
+/* The load and store operations of the DFT, r2c/c2r and r2r plans
+   created from now on, a planner setting like the number of threads.
+   The planners copy the window and modulation tables, so that ARG need
+   only be valid until the plan is created. */
+
+static edgeop load_op = { EDGE_NONE, K(1.0), 0, 0, 0 };
+static edgeop store_op = { EDGE_NONE, K(1.0), 0, 0, 0 };
+
+static void set(edgeop *op, X(edge_kind) kind, const R *arg,
+		X(edge_callback) f, void *data)
+{
+     op->kind = (int) kind;
+     op->s = (kind == FFTW_EDGE_SCALE) ? arg[0] : K(1.0);
+     op->w = (kind == FFTW_EDGE_WINDOW || kind == FFTW_EDGE_MODULATE) ?
+	  (R *) arg : 0;
+     op->f = (kind == FFTW_EDGE_CALLBACK) ? (edge_callback) f : 0;
+     op->data = data;
+}
+
+void X(plan_with_load)(X(edge_kind) kind, const R *arg,
+		       X(edge_callback) f, void *data)
+{
+     set(&load_op, kind, arg, f, data);
+}
+
+void X(plan_with_store)(X(edge_kind) kind, const R *arg,
+			X(edge_callback) f, void *data)
+{
+     set(&store_op, kind, arg, f, data);
+}
+
+/* The operations are the user's, and do not apply to the plans that
+   the library creates for itself, like the frame transforms of
+   X(plan_stft).  Such planning is bracketed by X(edge_suspend), which
+   saves the operations in SAVED and clears them, and X(edge_resume),
+   which restores them. */
+void X(edge_suspend)(edgeop saved[2])
+{
+     static const edgeop none = { EDGE_NONE, K(1.0), 0, 0, 0 };
+
+     saved[0] = load_op;
+     saved[1] = store_op;
+     load_op = store_op = none;
+}
+
+void X(edge_resume)(const edgeop saved[2])
+{
+     load_op = saved[0];
+     store_op = saved[1];
+}
+
+/* the logical size of an r2r transform of size N */
+static double logical_n(rdft_kind kind, INT n)
+{
+     switch (kind) {
+	 case REDFT00: return 2.0 * (double)(n - 1);
+	 case RODFT00: return 2.0 * (double)(n + 1);
+	 case R2HC: case HC2R: case DHT: return (double)n;
+	 default: return 2.0 * (double)n;
+     }
+}
+
+/* The factor by which FFTW_NORMALIZE_* in FLAGS multiply the output
+   of PRB: 1/sqrt(N) for ORTHO, 1/N for the backward transforms for
+   BACKWARD, where N is the logical size.  The dimensions of an r2r
+   transform are normalized separately, the backward ones being the
+   inverses HC2R, REDFT01 and RODFT01 of R2HC, REDFT10 and RODFT10. */
+static double normalization(int sign, unsigned flags, const problem *prb)
+{
+     double s = 1.0;
+     int ortho = (flags & FFTW_NORMALIZE_ORTHO) != 0;
+     int i;
+
+     if (!(flags & (FFTW_NORMALIZE_ORTHO | FFTW_NORMALIZE_BACKWARD)))
+	  return s;
+
+     switch (prb->adt->problem_kind) {
+	 case PROBLEM_DFT: {
+	      const problem_dft *p = (const problem_dft *) prb;
+	      if (ortho || sign == FFTW_BACKWARD)
+		   s = (double) X(tensor_sz)(p->sz);
+	      break;
+	 }
+	 case PROBLEM_RDFT2: {
+	      const problem_rdft2 *p = (const problem_rdft2 *) prb;
+	      if (ortho || p->kind == HC2R)
+		   s = (double) X(tensor_sz)(p->sz);
+	      break;
+	 }
+	 case PROBLEM_RDFT: {
+	      const problem_rdft *p = (const problem_rdft *) prb;
+	      if (FINITE_RNK(p->sz->rnk))
+		   for (i = 0; i < p->sz->rnk; ++i) {
+			rdft_kind k = p->kind[i];
+			if (ortho || k == HC2R || k == REDFT01 || k == RODFT01)
+			     s *= logical_n(k, p->sz->dims[i].n);
+		   }
+	      break;
+	 }
+	 default:
+	      break;
+     }
+
+     if (s <= 1.0)
+	  return 1.0;
+     return ortho ? 1.0 / sqrt(s) : 1.0 / s;
+}
+
+/* PRB with the current operations and the normalization of FLAGS, for
+   X(mkapiplan).  The normalization folds into the store operation. */
+problem *X(mkproblem_api_edge)(int sign, unsigned flags, problem *prb)
+{
+     edgeop store = store_op;
+     double s = normalization(sign, flags, prb);
+
+     if (s != 1.0) {
+	  if (store.kind == EDGE_NONE)
+	       store.kind = EDGE_SCALE;
+	  store.s *= (R) s;
+     }
+     return X(mkproblem_edge)(prb, &load_op, &store, sign == FFTW_BACKWARD);
+}
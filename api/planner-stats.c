@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Statistics and trace of the planner, see kernel/planlog.c */
+
+#include "api/api.h"
+
+void X(record_planner_stats)(int on)
+{
+     X(planlog_record)(X(the_planner)(), on);
+}
+
+void X(forget_planner_stats)(void)
+{
+     X(planlog_forget)(X(the_planner)());
+}
+
+void X(export_planner_stats_to_file)(FILE *output_file)
+{
+     printer *p = X(mkprinter_file)(output_file);
+     X(planlog_export_stats)(X(the_planner)(), p);
+     X(printer_destroy)(p);
+}
+
+void X(export_planner_trace_to_file)(FILE *output_file)
+{
+     printer *p = X(mkprinter_file)(output_file);
+     X(planlog_export_trace)(X(the_planner)(), p);
+     X(printer_destroy)(p);
+}
+
+static int to_filename(const char *filename, int tracep)
+{
+     FILE *f = fopen(filename, "w");
+     int ret;
+     if (!f) return 0; /* error opening file */
+     if (tracep)
+	  X(export_planner_trace_to_file)(f);
+     else
+	  X(export_planner_stats_to_file)(f);
+     ret = !ferror(f);
+     if (fclose(f)) ret = 0; /* error closing file */
+     return ret;
+}
+
+int X(export_planner_stats_to_filename)(const char *filename)
+{
+     return to_filename(filename, 0);
+}
+
+int X(export_planner_trace_to_filename)(const char *filename)
+{
+     return to_filename(filename, 1);
+}
@@ -24,7 +24,7 @@ char *X(sprint_plan)(const X(plan) p)
 {
      size_t cnt;
      char *s;
-     plan *pln = p->pln;
+     plan *pln = APIPLAN_PLN(p);
 
      printer *pr = X(mkprinter_cnt)(&cnt);
      pln->adt->print(pln, pr);
@@ -42,7 +42,7 @@ char *X(sprint_plan)(const X(plan) p)
 void X(fprint_plan)(const X(plan) p, FILE *output_file)
 {
      printer *pr = X(mkprinter_file)(output_file);
-     plan *pln = p->pln;
+     plan *pln = APIPLAN_PLN(p);
      pln->adt->print(pln, pr);
      X(printer_destroy)(pr);
 }
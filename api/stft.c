@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "api/api.h"
+#include <string.h>
+
+/* Streaming short-time Fourier transform: the frames of n samples
+   starting every hop samples of a stream that arrives in chunks of
+   any length.  Samples of incomplete frames are buffered between
+   calls.  Complete frames are windowed as they are copied out of the
+   buffer, and transformed by r2c plans with a vector loop, so that
+   the threads are forked once per batch rather than once per frame.
+   A call that completes fewer frames than a full batch splits them
+   among a ladder of plans for 1, 2, 4, ... frames, up to BATCH. */
+
+/* bound the frames that are transformed at once */
+#define MAX_BATCH 64
+#define MAX_BATCH_SZ (1 << 15) /* reals in the windowed frames */
+#define MAX_LADDER 8           /* 1, 2, 4, ..., MAX_BATCH */
+
+struct X(stft_s) {
+     X(plan) p[MAX_LADDER]; /* r2c transform of nb[k] frames */
+     int nb[MAX_LADDER];    /* 1, 2, 4, ..., batch */
+     int np;
+     R *w;            /* window, or 0 for a rectangular window */
+     R *buf;          /* buffered samples */
+     R *frames;       /* windowed frames, batch * n */
+     C *spec;         /* output array of the plans, batch * nc */
+     int n, hop, batch, nc;
+     int cap;         /* capacity of buf */
+     int len;         /* samples in buf */
+     int pos;         /* start of the next frame in buf */
+     int skip;        /* samples to drop before the next frame, if hop > n */
+};
+
+X(stft) X(plan_stft)(const R *window, int n, int hop, unsigned flags)
+{
+     X(stft) s;
+     size_t cap;
+     edgeop saved[2];
+     int i, b, ok = 1;
+
+     if (n <= 0 || hop <= 0)
+	  return 0;
+
+     s = (X(stft)) MALLOC(sizeof(*s), OTHER);
+     s->np = 0;
+     s->n = n;
+     s->hop = hop;
+     s->nc = n / 2 + 1;
+     s->batch = X(imax)(1, X(imin)(MAX_BATCH, MAX_BATCH_SZ / n));
+
+     /* Room for the frames of a batch, where a frame advances the
+	buffer by at most n samples, since those between frames are
+	skipped.  Any capacity of at least n is correct, so clamp it
+	where it does not fit in an int.  (This cannot overflow a
+	size_t, since n * batch <= MAX_BATCH_SZ unless batch == 1.) */
+     cap = (size_t) n + (size_t) X(imin)(hop, n) * (size_t) s->batch;
+     s->cap = cap > (size_t) INT_MAX ? INT_MAX : (int) cap;
+     s->len = s->pos = s->skip = 0;
+     s->w = 0;
+     if (window) {
+	  s->w = (R *) MALLOC(sizeof(R) * (unsigned) n, OTHER);
+	  for (i = 0; i < n; ++i)
+	       s->w[i] = window[i];
+     }
+     s->buf = (R *) MALLOC(sizeof(R) * (size_t) s->cap, BUFFERS);
+     s->frames = X(alloc_real)((size_t) s->batch * (size_t) n);
+     s->spec = X(alloc_complex)((size_t) s->batch * (size_t) s->nc);
+
+     /* the frames are scratch, and the window is ours to apply */
+     flags |= FFTW_DESTROY_INPUT;
+     X(edge_suspend)(saved);
+     for (b = 1; ok; b *= 2) {
+	  b = X(imin)(b, s->batch);
+	  s->nb[s->np] = b;
+	  s->p[s->np] = X(plan_many_dft_r2c)(1, &n, b,
+					     s->frames, 0, 1, n,
+					     s->spec, 0, 1, s->nc, flags);
+	  ok = (s->p[s->np++] != 0);
+	  if (b == s->batch)
+	       break;
+     }
+     X(edge_resume)(saved);
+
+     if (!ok) {
+	  X(destroy_stft)(s);
+	  return 0;
+     }
+     return s;
+}
+
+void X(destroy_stft)(X(stft) s)
+{
+     if (s) {
+	  int k;
+	  for (k = 0; k < s->np; ++k)
+	       X(destroy_plan)(s->p[k]);
+	  X(free)(s->spec);
+	  X(free)(s->frames);
+	  X(ifree)(s->buf);
+	  X(ifree0)(s->w);
+	  X(ifree)(s);
+     }
+}
+
+/* drop the buffered samples, as at the start of a new stream */
+void X(stft_reset)(X(stft) s)
+{
+     s->len = s->pos = s->skip = 0;
+}
+
+/* the number of frames that X(stft_execute) will emit for NIN more
+   samples */
+int X(stft_frames)(const X(stft) s, int nin)
+{
+     int end = s->len + X(imax)(0, nin - s->skip);
+     return end < s->pos + s->n ? 0 : (end - s->pos - s->n) / s->hop + 1;
+}
+
+/* execute P on the input I into OUT, where OUT may not have the
+   alignment of the output array of P */
+static void execute_into(const X(stft) s, X(plan) p, R *I, C *out, int nf)
+{
+     if (X(alignment_of)(out[0]) == X(alignment_of)(s->spec[0]))
+	  X(execute_dft_r2c)(p, I, out);
+     else {
+	  X(execute_dft_r2c)(p, I, s->spec);
+	  memcpy(out, s->spec, sizeof(C) * (size_t) nf * (size_t) s->nc);
+     }
+}
+
+/* transform the NF windowed frames into OUT, by the largest plans of
+   the ladder that fit */
+static void flush(const X(stft) s, int nf, C *out)
+{
+     int k = s->np - 1, done = 0, n = s->n;
+
+     while (done < nf) {
+	  R *f = s->frames + (size_t) done * n;
+	  int b;
+
+	  while (s->nb[k] > nf - done)
+	       --k;
+	  b = s->nb[k];
+	  if (X(alignment_of)(f) != X(alignment_of)(s->frames)) {
+	       /* the frames before F are done, so reuse their slots */
+	       memmove(s->frames, f, sizeof(R) * (size_t) b * (size_t) n);
+	       f = s->frames;
+	  }
+	  execute_into(s, s->p[k], f, out + (size_t) done * s->nc, b);
+	  done += b;
+     }
+}
+
+/* Append the NIN samples IN to the stream, and write the spectra
+   (n/2+1 complex numbers each) of the frames that are now complete
+   to OUT, which must have room for X(stft_frames)(s, nin) of them.
+   Return the number of frames written. */
+int X(stft_execute)(X(stft) s, const R *in, int nin, C *out)
+{
+     int i, m, nf = 0, nout = 0, n = s->n;
+     const R *w = s->w;
+
+     for (;;) {
+	  m = X(imin)(s->skip, nin);
+	  in += m; nin -= m; s->skip -= m;
+
+	  m = X(imin)(s->cap - s->len, nin);
+	  memcpy(s->buf + s->len, in, sizeof(R) * (size_t) m);
+	  in += m; nin -= m; s->len += m;
+
+	  while (s->pos + n <= s->len) {
+	       /* window the frame as it is copied */
+	       const R *x = s->buf + s->pos;
+	       R *f = s->frames + (size_t) nf * n;
+	       if (w)
+		    for (i = 0; i < n; ++i) f[i] = x[i] * w[i];
+	       else
+		    for (i = 0; i < n; ++i) f[i] = x[i];
+	       s->pos += s->hop;
+
+	       if (++nf == s->batch) {
+		    flush(s, nf, out + (size_t) nout * s->nc);
+		    nout += nf;
+		    nf = 0;
+	       }
+	  }
+
+	  /* keep the samples of the next frame */
+	  if (s->pos >= s->len) {
+	       s->skip += s->pos - s->len;
+	       s->len = 0;
+	  } else {
+	       memmove(s->buf, s->buf + s->pos,
+		       sizeof(R) * (size_t) (s->len - s->pos));
+	       s->len -= s->pos;
+	  }
+	  s->pos = 0;
+
+	  if (!nin) break;
+     }
+
+     if (nf) {
+	  flush(s, nf, out + (size_t) nout * s->nc);
+	  nout += nf;
+     }
+     return nout;
+}
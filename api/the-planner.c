@@ -28,6 +28,7 @@ planner *X(the_planner)(void)
      if (!plnr) {
           plnr = X(mkplanner)();
           X(configure_planner)(plnr);
+	  plnr->shadow_hook = X(mkproblem_shadow);
      }
 
      return plnr;
@@ -39,6 +40,7 @@ void X(cleanup)(void)
           X(planner_destroy)(plnr);
           plnr = 0;
      }
+     X(triggen_cleanup)();
 }
 
 void X(set_timelimit)(double tlim) 
@@ -47,3 +49,15 @@ void X(set_timelimit)(double tlim)
 	called, so use X(the_planner)() */
      X(the_planner)()->timelimit = tlim; 
 }
+
+/* LEVEL 0 times plans by the minimum of a few runs, 1 by a trimmed
+   mean with a confidence interval, re-measuring ties, and 2 also
+   checks the tick counter against the wall clock, whose rate we find
+   now.  See X(measure_execution_time_err). */
+void X(set_robust_timing)(int level)
+{
+     planner *plnr = X(the_planner)();
+     plnr->robust_timing = level < 0 ? 0 : (level > 2 ? 2 : level);
+     if (plnr->robust_timing > 1)
+	  plnr->tick_rate = X(tick_rate)();
+}
@@ -20,10 +20,29 @@
 
 #include "dft/dft.h"
 
+/* Bluestein's algorithm for a vector of VL prime-size transforms.
+   The transforms are convolved BATCH at a time, by a child plan for
+   a vector of BATCH DFTs of size NB, so that the child can use SIMD
+   codelets across the batch or be threaded by the planner, and the
+   remaining VL % BATCH transforms by a second child.  Each
+   registered solver pads the convolution to the next size that
+   factors into its own set of primes, and the planner picks the best
+   of them. */
+
 typedef struct {
      solver super;
+     size_t primes_ndx;
 } S;
 
+static const INT primes235[] = { 2, 3, 5, 0 };
+static const INT primes2357[] = { 2, 3, 5, 7, 0 };
+static const INT primes2[] = { 2, 0 };
+static const INT *const convprimes[] = { primes235, primes2357, primes2 };
+
+/* bound the BATCH transforms that are convolved at once */
+#define MAX_BATCH 8
+#define MAX_BATCH_SZ ((INT)1 << 17) /* complex numbers in the buffer */
+
 typedef struct {
      plan_dft super;
      INT n;     /* problem size */
@@ -31,7 +50,9 @@ typedef struct {
      R *w;      /* lambda k . exp(2*pi*i*k^2/(2*n)) */
      R *W;      /* DFT(w) */
      plan *cldf;
+     plan *cldr; /* for the last, short batch, or 0 */
      INT is, os;
+     INT vl, ivs, ovs, batch;
 } P;
 
 static void bluestein_sequence(enum wakefulness wakefulness, INT n, R *w)
@@ -53,7 +74,7 @@ static void mktwiddle(enum wakefulness wakefulness, P *p)
 {
      INT i;
      INT n = p->n, nb = p->nb;
-     R *w, *W;
+     R *w, *W, *b;
      E nbf = (E)nb;
 
      p->w = w = (R *) MALLOC(2 * n * sizeof(R), TWIDDLES);
@@ -61,32 +82,39 @@ static void mktwiddle(enum wakefulness wakefulness, P *p)
 
      bluestein_sequence(wakefulness, n, w);
 
-     for (i = 0; i < nb; ++i)
-          W[2*i] = W[2*i+1] = K(0.0);
+     /* cldf transforms a whole batch, of which we use the first */
+     b = (R *) MALLOC(2 * nb * p->batch * sizeof(R), BUFFERS);
+     for (i = 0; i < nb * p->batch; ++i)
+          b[2*i] = b[2*i+1] = K(0.0);
 
-     W[0] = w[0] / nbf;
-     W[1] = w[1] / nbf;
+     b[0] = w[0] / nbf;
+     b[1] = w[1] / nbf;
 
      for (i = 1; i < n; ++i) {
-          W[2*i] = W[2*(nb-i)] = w[2*i] / nbf;
-          W[2*i+1] = W[2*(nb-i)+1] = w[2*i+1] / nbf;
+          b[2*i] = b[2*(nb-i)] = w[2*i] / nbf;
+          b[2*i+1] = b[2*(nb-i)+1] = w[2*i+1] / nbf;
      }
 
      {
           plan_dft *cldf = (plan_dft *)p->cldf;
 	  /* cldf must be awake */
-          cldf->apply(p->cldf, W, W+1, W, W+1);
+          cldf->apply(p->cldf, b, b+1, b, b+1);
      }
+
+     for (i = 0; i < 2 * nb; ++i)
+	  W[i] = b[i];
+     X(ifree)(b);
 }
 
-static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+/* The loops below run over contiguous complex arrays, except for
+   the strided user data, so that the compiler can vectorize them. */
+
+/* multiply input by conjugate bluestein sequence, and pad */
+static void premultiply(INT n, INT nb, const R *w,
+			const R *ri, const R *ii, INT is, R *b)
 {
-     const P *ego = (const P *) ego_;
-     INT i, n = ego->n, nb = ego->nb, is = ego->is, os = ego->os;
-     R *w = ego->w, *W = ego->W;
-     R *b = (R *) MALLOC(2 * nb * sizeof(R), BUFFERS);
+     INT i;
 
-     /* multiply input by conjugate bluestein sequence */
      for (i = 0; i < n; ++i) {
 	  E xr = ri[i*is], xi = ii[i*is];
           E wr = w[2*i], wi = w[2*i+1];
@@ -95,36 +123,68 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
      }
 
      for (; i < nb; ++i) b[2*i] = b[2*i+1] = K(0.0);
+}
 
-     /* convolution: FFT */
-     {
-          plan_dft *cldf = (plan_dft *)ego->cldf;
-          cldf->apply(ego->cldf, b, b+1, b, b+1);
-     }
+/* convolution: pointwise multiplication, swapping real and imaginary
+   parts for the inverse FFT */
+static void pointwise(INT nb, const R *W, R *b)
+{
+     INT i;
 
-     /* convolution: pointwise multiplication */
      for (i = 0; i < nb; ++i) {
 	  E xr = b[2*i], xi = b[2*i+1];
           E wr = W[2*i], wi = W[2*i+1];
           b[2*i] = xi * wr + xr * wi;
           b[2*i+1] = xr * wr - xi * wi;
      }
+}
 
-     /* convolution: IFFT by FFT with real/imag input/output swapped */
-     {
-          plan_dft *cldf = (plan_dft *)ego->cldf;
-          cldf->apply(ego->cldf, b, b+1, b, b+1);
-     }
+/* multiply output by conjugate bluestein sequence */
+static void postmultiply(INT n, const R *w, const R *b,
+			 R *ro, R *io, INT os)
+{
+     INT i;
 
-     /* multiply output by conjugate bluestein sequence */
      for (i = 0; i < n; ++i) {
 	  E xi = b[2*i], xr = b[2*i+1];
           E wr = w[2*i], wi = w[2*i+1];
           ro[i*os] = xr * wr + xi * wi;
           io[i*os] = xi * wr - xr * wi;
      }
+}
+
+static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     INT j, v, m, n = ego->n, nb = ego->nb, is = ego->is, os = ego->os;
+     INT vl = ego->vl, ivs = ego->ivs, ovs = ego->ovs, batch = ego->batch;
+     const R *w = ego->w, *W = ego->W;
+     plan_dft *cld;
+     R *b = (R *) X(scratch_get)(ego_, 2 * nb * batch * sizeof(R));
+
+     for (v = 0; v < vl; v += batch) {
+	  m = X(imin)(batch, vl - v);
+	  cld = (plan_dft *) (m == batch ? ego->cldf : ego->cldr);
+
+	  for (j = 0; j < m; ++j)
+	       premultiply(n, nb, w, ri + (v+j) * ivs, ii + (v+j) * ivs, is,
+			   b + 2 * nb * j);
+
+	  /* convolution: FFT */
+          cld->apply((plan *) cld, b, b+1, b, b+1);
+
+	  for (j = 0; j < m; ++j)
+	       pointwise(nb, W, b + 2 * nb * j);
+
+	  /* convolution: IFFT by FFT with real/imag input/output swapped */
+          cld->apply((plan *) cld, b, b+1, b, b+1);
+
+	  for (j = 0; j < m; ++j)
+	       postmultiply(n, w, b + 2 * nb * j,
+			    ro + (v+j) * ovs, io + (v+j) * ovs, os);
+     }
 
-     X(ifree)(b);	  
+     X(scratch_put)(ego_, b);
 }
 
 static void awake(plan *ego_, enum wakefulness wakefulness)
@@ -132,6 +192,7 @@ static void awake(plan *ego_, enum wakefulness wakefulness)
      P *ego = (P *) ego_;
 
      X(plan_awake)(ego->cldf, wakefulness);
+     X(plan_awake)(ego->cldr, wakefulness);
 
      switch (wakefulness) {
 	 case SLEEPY:
@@ -145,52 +206,71 @@ static void awake(plan *ego_, enum wakefulness wakefulness)
      }
 }
 
-static int applicable(const solver *ego, const problem *p_, 
+static INT choose_transform_size(INT minsz, const INT *primes)
+{
+     while (!X(factors_into)(minsz, primes))
+	  ++minsz;
+     return minsz;
+}
+
+static int applicable(const S *ego, const problem *p_, 
 		      const planner *plnr)
 {
      const problem_dft *p = (const problem_dft *) p_;
-     UNUSED(ego);
-     return (1
-	     && p->sz->rnk == 1
-	     && p->vecsz->rnk == 0
-	     /* FIXME: allow other sizes */
-	     && X(is_prime)(p->sz->dims[0].n)
-
-	     /* FIXME: avoid infinite recursion of bluestein with itself.
-		This works because all factors in child problems are 2, 3, 5 */
-	     && p->sz->dims[0].n > 16
-
-	     && CIMPLIES(NO_SLOWP(plnr), p->sz->dims[0].n > BLUESTEIN_MAX_SLOW)
-	  );
+     INT n;
+     size_t i;
+
+     if (!(1
+	   && p->sz->rnk == 1
+	   && p->vecsz->rnk <= 1
+	   /* FIXME: allow other sizes */
+	   && X(is_prime)(n = p->sz->dims[0].n)
+
+	   /* FIXME: avoid infinite recursion of bluestein with itself.
+	      This works because all factors in child problems are 2, 3, 5 */
+	   && n > 16
+
+	   && CIMPLIES(NO_SLOWP(plnr), n > BLUESTEIN_MAX_SLOW)
+
+	   /* a batch is read entirely before it is written */
+	   && (p->vecsz->rnk == 0
+	       || p->ri != p->ro
+	       || X(tensor_inplace_strides2)(p->sz, p->vecsz))
+	      ))
+	  return 0;
+
+     /* leave a convolution size to the first solver that picks it */
+     for (i = 0; i < ego->primes_ndx; ++i)
+	  if (choose_transform_size(2 * n - 1, convprimes[i])
+	      == choose_transform_size(2 * n - 1, convprimes[ego->primes_ndx]))
+	       return 0;
+
+     return 1;
 }
 
 static void destroy(plan *ego_)
 {
      P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cldr);
      X(plan_destroy_internal)(ego->cldf);
 }
 
 static void print(const plan *ego_, printer *p)
 {
      const P *ego = (const P *)ego_;
-     p->print(p, "(dft-bluestein-%D/%D%(%p%))",
-              ego->n, ego->nb, ego->cldf);
+     p->print(p, "(dft-bluestein-%D/%D%v%(%p%)%(%p%))",
+              ego->n, ego->nb, ego->vl, ego->cldf, ego->cldr);
 }
 
-static INT choose_transform_size(INT minsz)
-{
-     while (!X(factors_into_small_primes)(minsz))
-	  ++minsz;
-     return minsz;
-}
-
-static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
+static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 {
+     const S *ego = (const S *) ego_;
      const problem_dft *p = (const problem_dft *) p_;
      P *pln;
-     INT n, nb;
-     plan *cldf = 0;
+     INT n, nb, vl, ivs, ovs, batch, nblk, rem;
+     plan *cldf = 0, *cldr = 0;
      R *buf = (R *) 0;
+     opcnt ops;
 
      static const plan_adt padt = {
 	  X(dft_solve), awake, print, destroy
@@ -200,17 +280,34 @@ static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
 	  return (plan *) 0;
 
      n = p->sz->dims[0].n;
-     nb = choose_transform_size(2 * n - 1);
-     buf = (R *) MALLOC(2 * nb * sizeof(R), BUFFERS);
+     nb = choose_transform_size(2 * n - 1, convprimes[ego->primes_ndx]);
+     X(tensor_tornk1)(p->vecsz, &vl, &ivs, &ovs);
+     batch = X(imin)(vl, X(imin)(MAX_BATCH, X(imax)(1, MAX_BATCH_SZ / nb)));
+     buf = (R *) MALLOC(2 * nb * batch * sizeof(R), BUFFERS);
 
      cldf = X(mkplan_f_d)(plnr, 
 			  X(mkproblem_dft_d)(X(mktensor_1d)(nb, 2, 2),
-					     X(mktensor_1d)(1, 0, 0),
+					     X(mktensor_1d)(batch,
+							    2 * nb, 2 * nb),
 					     buf, buf+1, 
 					     buf, buf+1),
 			  NO_SLOW, 0, 0);
      if (!cldf) goto nada;
 
+     nblk = vl / batch;
+     rem = vl - nblk * batch;
+     if (rem) {
+	  cldr = X(mkplan_f_d)(plnr, 
+			       X(mkproblem_dft_d)(X(mktensor_1d)(nb, 2, 2),
+						  X(mktensor_1d)(rem,
+								 2 * nb,
+								 2 * nb),
+						  buf, buf+1, 
+						  buf, buf+1),
+			       NO_SLOW, 0, 0);
+	  if (!cldr) goto nada;
+     }
+
      X(ifree)(buf);
 
      pln = MKPLAN_DFT(P, &padt, apply);
@@ -220,31 +317,47 @@ static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
      pln->w = 0;
      pln->W = 0;
      pln->cldf = cldf;
+     pln->cldr = cldr;
      pln->is = p->sz->dims[0].is;
      pln->os = p->sz->dims[0].os;
-
-     X(ops_add)(&cldf->ops, &cldf->ops, &pln->super.super.ops);
-     pln->super.super.ops.add += 4 * n + 2 * nb;
-     pln->super.super.ops.mul += 8 * n + 4 * nb;
-     pln->super.super.ops.other += 6 * (n + nb);
+     pln->vl = vl;
+     pln->ivs = ivs;
+     pln->ovs = ovs;
+     pln->batch = batch;
+     X(plan_scratch)(&pln->super.super, plnr, 2 * nb * batch * sizeof(R));
+
+     X(ops_add)(&cldf->ops, &cldf->ops, &ops);
+     X(ops_zero)(&pln->super.super.ops);
+     X(ops_madd2)(nblk, &ops, &pln->super.super.ops);
+     if (cldr) {
+	  X(ops_add)(&cldr->ops, &cldr->ops, &ops);
+	  X(ops_add2)(&ops, &pln->super.super.ops);
+     }
+     pln->super.super.ops.add += 4 * n * vl + 2 * nb * vl;
+     pln->super.super.ops.mul += 8 * n * vl + 4 * nb * vl;
+     pln->super.super.ops.other += 6 * (n * vl + nb * vl);
 
      return &(pln->super.super);
 
  nada:
      X(ifree0)(buf);
+     X(plan_destroy_internal)(cldr);
      X(plan_destroy_internal)(cldf);
      return (plan *)0;
 }
 
 
-static solver *mksolver(void)
+static solver *mksolver(size_t primes_ndx)
 {
      static const solver_adt sadt = { PROBLEM_DFT, mkplan, 0 };
      S *slv = MKSOLVER(S, &sadt);
+     slv->primes_ndx = primes_ndx;
      return &(slv->super);
 }
 
 void X(dft_bluestein_register)(planner *p)
 {
-     REGISTER_SOLVER(p, mksolver());
+     size_t i;
+     for (i = 0; i < NELEM(convprimes); ++i)
+	  REGISTER_SOLVER(p, mksolver(i));
 }
@@ -42,7 +42,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
 {
      const P *ego = (const P *) ego_;
      INT nbuf = ego->nbuf;
-     R *bufs = (R *)MALLOC(sizeof(R) * nbuf * ego->bufdist * 2, BUFFERS);
+     R *bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * ego->bufdist * 2);
 
      plan_dft *cld = (plan_dft *) ego->cld;
      plan_dft *cldcpy = (plan_dft *) ego->cldcpy;
@@ -61,7 +61,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
 	  ro += ovs_by_nbuf; io += ovs_by_nbuf;
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_dft *) ego->cldrest;
@@ -251,6 +251,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 
      pln->nbuf = nbuf;
      pln->bufdist = bufdist;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * nbuf * bufdist * 2);
 
      {
 	  opcnt t;
@@ -31,6 +31,9 @@ static const solvtab s =
      SOLVTAB(X(dft_generic_register)),
      SOLVTAB(X(dft_rader_register)),
      SOLVTAB(X(dft_bluestein_register)),
+     SOLVTAB(X(czt_bluestein_register)),
+     SOLVTAB(X(dft_pruned_register)),
+     SOLVTAB(X(dft_pruned_ct_register)),
      SOLVTAB(X(dft_nop_register)),
      SOLVTAB(X(ct_generic_register)),
      SOLVTAB(X(ct_genericbuf_register)),
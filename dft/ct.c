@@ -221,6 +221,9 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      pln->r = r;
      X(ops_add)(&cld->ops, &cldw->ops, &pln->super.super.ops);
 
+     /* the twiddle pass reads and writes the whole array, in place */
+     cldw->footprint = 4.0 * sizeof(R) * (double)n * (double)v;
+
      /* inherit could_prune_now_p attribute from cldw */
      pln->super.super.could_prune_now_p = cldw->could_prune_now_p;
      return &(pln->super.super);
@@ -244,12 +247,32 @@ ct_solver *X(mksolver_ct)(size_t size, INT r, int dec,
      return slv;
 }
 
+/* see kernel/profile.c */
+static void apply_profiled(const plan *ego, R *rio, R *iio)
+{
+     plan_profile *pr = ego->prof;
+     double t0 = X(profile_now)();
+     ((dftwapply) pr->apply)(ego, rio, iio);
+     X(profile_account)(pr, t0);
+}
+
+static void profile(plan *ego_, int on)
+{
+     plan_dftw *ego = (plan_dftw *) ego_;
+     if (on) {
+	  ego_->prof->apply = (void (*)(void)) ego->apply;
+	  ego->apply = apply_profiled;
+     } else
+	  ego->apply = (dftwapply) ego_->prof->apply;
+}
+
 plan *X(mkplan_dftw)(size_t size, const plan_adt *adt, dftwapply apply)
 {
      plan_dftw *ego;
 
      ego = (plan_dftw *) X(mkplan)(size, adt);
      ego->apply = apply;
+     ego->super.profile = profile;
 
      return &(ego->super);
 }
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "dft/dft.h"
+
+/* The chirp-z transform by Bluestein's algorithm: since
+   jk = (j^2 + k^2 - (k-j)^2) / 2,
+
+     X[k] = W^{k^2/2} sum_j (x[j] A^{-j} W^{j^2/2}) W^{-(k-j)^2/2},
+
+   a convolution of size nb >= n + m - 1, which we compute by FFTs as
+   in bluestein.c.  The cost is O((n+m) log(n+m)) whatever the
+   spiral, e.g. for m bins over a narrow band of frequencies. */
+
+typedef struct {
+     solver super;
+} S;
+
+typedef struct {
+     plan_dft super;
+     INT n, m;  /* problem size */
+     INT nb;    /* size of convolution */
+     R *pre;    /* A^{-j} W^{j^2/2}, j < n */
+     R *post;   /* W^{k^2/2}, k < m */
+     R *V;      /* DFT(W^{-t^2/2}) / nb, -n < t < m */
+     R w[2], a[2];
+     plan *cldf;
+     INT is, os;
+} P;
+
+/* RES = Z^T, rounded to R */
+static void spiral(const R *z, trigreal t, R *res)
+{
+     trigreal r[2];
+     X(cpow)(z[0], z[1], t, r);
+     res[0] = (R) r[0];
+     res[1] = (R) r[1];
+}
+
+static void mkchirps(P *p)
+{
+     INT j, n = p->n, m = p->m, nb = p->nb;
+     R *pre, *post, *V;
+     E nbf = (E)nb;
+
+     p->pre = pre = (R *) MALLOC(2 * n * sizeof(R), TWIDDLES);
+     p->post = post = (R *) MALLOC(2 * m * sizeof(R), TWIDDLES);
+     p->V = V = (R *) MALLOC(2 * nb * sizeof(R), TWIDDLES);
+
+     for (j = 0; j < n; ++j) {
+	  R aj[2], wj[2];
+	  spiral(p->a, -(trigreal)j, aj);
+	  spiral(p->w, (trigreal)j * j / 2, wj);
+	  pre[2*j] = aj[0] * wj[0] - aj[1] * wj[1];
+	  pre[2*j+1] = aj[0] * wj[1] + aj[1] * wj[0];
+     }
+
+     for (j = 0; j < m; ++j)
+	  spiral(p->w, (trigreal)j * j / 2, post + 2*j);
+
+     for (j = 0; j < nb; ++j)
+          V[2*j] = V[2*j+1] = K(0.0);
+
+     for (j = 0; j < m; ++j) {
+	  spiral(p->w, -(trigreal)j * j / 2, V + 2*j);
+	  V[2*j] /= nbf; V[2*j+1] /= nbf;
+     }
+
+     for (j = 1; j < n; ++j) {
+	  spiral(p->w, -(trigreal)j * j / 2, V + 2*(nb-j));
+	  V[2*(nb-j)] /= nbf; V[2*(nb-j)+1] /= nbf;
+     }
+
+     {
+          plan_dft *cldf = (plan_dft *)p->cldf;
+	  /* cldf must be awake */
+          cldf->apply(p->cldf, V, V+1, V, V+1);
+     }
+}
+
+static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     INT i, n = ego->n, m = ego->m, nb = ego->nb, is = ego->is, os = ego->os;
+     const R *pre = ego->pre, *post = ego->post, *V = ego->V;
+     plan_dft *cldf = (plan_dft *)ego->cldf;
+     R *b = (R *) X(scratch_get)(ego_, 2 * nb * sizeof(R));
+
+     /* multiply input by the pre-chirp, and pad */
+     for (i = 0; i < n; ++i) {
+	  E xr = ri[i*is], xi = ii[i*is];
+          E wr = pre[2*i], wi = pre[2*i+1];
+          b[2*i] = xr * wr - xi * wi;
+          b[2*i+1] = xr * wi + xi * wr;
+     }
+
+     for (; i < nb; ++i) b[2*i] = b[2*i+1] = K(0.0);
+
+     /* convolution: FFT */
+     cldf->apply(ego->cldf, b, b+1, b, b+1);
+
+     /* convolution: pointwise multiplication */
+     for (i = 0; i < nb; ++i) {
+	  E xr = b[2*i], xi = b[2*i+1];
+          E wr = V[2*i], wi = V[2*i+1];
+          b[2*i] = xi * wr + xr * wi;
+          b[2*i+1] = xr * wr - xi * wi;
+     }
+
+     /* convolution: IFFT by FFT with real/imag input/output swapped */
+     cldf->apply(ego->cldf, b, b+1, b, b+1);
+
+     /* multiply output by the post-chirp */
+     for (i = 0; i < m; ++i) {
+	  E xi = b[2*i], xr = b[2*i+1];
+          E wr = post[2*i], wi = post[2*i+1];
+          ro[i*os] = xr * wr - xi * wi;
+          io[i*os] = xr * wi + xi * wr;
+     }
+
+     X(scratch_put)(ego_, b);
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+
+     X(plan_awake)(ego->cldf, wakefulness);
+
+     switch (wakefulness) {
+	 case SLEEPY:
+	      X(ifree0)(ego->pre); ego->pre = 0;
+	      X(ifree0)(ego->post); ego->post = 0;
+	      X(ifree0)(ego->V); ego->V = 0;
+	      break;
+	 default:
+	      A(!ego->pre);
+	      mkchirps(ego);
+	      break;
+     }
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cldf);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *)ego_;
+     p->print(p, "(czt-bluestein-%D-%D/%D%(%p%))",
+              ego->n, ego->m, ego->nb, ego->cldf);
+}
+
+static INT choose_transform_size(INT minsz)
+{
+     while (!X(factors_into_small_primes)(minsz))
+	  ++minsz;
+     return minsz;
+}
+
+static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
+{
+     const problem_czt *p = (const problem_czt *) p_;
+     P *pln;
+     INT n, m, nb;
+     plan *cldf = 0;
+     R *buf = (R *) 0;
+
+     static const plan_adt padt = {
+	  X(czt_solve), awake, print, destroy
+     };
+
+     UNUSED(ego);
+
+     n = p->n;
+     m = p->m;
+     nb = choose_transform_size(n + m - 1);
+     buf = (R *) MALLOC(2 * nb * sizeof(R), BUFFERS);
+
+     cldf = X(mkplan_f_d)(plnr, 
+			  X(mkproblem_dft_d)(X(mktensor_1d)(nb, 2, 2),
+					     X(mktensor_1d)(1, 0, 0),
+					     buf, buf+1, 
+					     buf, buf+1),
+			  NO_SLOW, 0, 0);
+     if (!cldf) goto nada;
+
+     X(ifree)(buf);
+
+     pln = MKPLAN_DFT(P, &padt, apply);
+
+     pln->n = n;
+     pln->m = m;
+     pln->nb = nb;
+     pln->pre = pln->post = pln->V = 0;
+     pln->w[0] = p->w[0]; pln->w[1] = p->w[1];
+     pln->a[0] = p->a[0]; pln->a[1] = p->a[1];
+     pln->cldf = cldf;
+     pln->is = p->is;
+     pln->os = p->os;
+     X(plan_scratch)(&pln->super.super, plnr, 2 * nb * sizeof(R));
+
+     X(ops_add)(&cldf->ops, &cldf->ops, &pln->super.super.ops);
+     pln->super.super.ops.add += 2 * (n + m) + 2 * nb;
+     pln->super.super.ops.mul += 4 * (n + m) + 4 * nb;
+     pln->super.super.ops.other += 6 * (n + m + nb);
+
+     return &(pln->super.super);
+
+ nada:
+     X(ifree0)(buf);
+     X(plan_destroy_internal)(cldf);
+     return (plan *)0;
+}
+
+
+static solver *mksolver(void)
+{
+     static const solver_adt sadt = { PROBLEM_CZT, mkplan, 0 };
+     S *slv = MKSOLVER(S, &sadt);
+     return &(slv->super);
+}
+
+void X(czt_bluestein_register)(planner *p)
+{
+     REGISTER_SOLVER(p, mksolver());
+}
@@ -46,6 +46,34 @@ problem *X(mkproblem_dft_d)(tensor *sz, tensor *vecsz,
 /* solve.c: */
 void X(dft_solve)(const plan *ego_, const problem *p_);
 
+/* problem-czt.c: */
+typedef struct {
+     problem super;
+     INT n, m, is, os;
+     R *ri, *ii, *ro, *io;
+     R w[2], a[2];
+} problem_czt;
+
+problem *X(mkproblem_czt)(INT n, INT m, INT is, INT os,
+			  R *ri, R *ii, R *ro, R *io,
+			  const R *w, const R *a);
+void X(czt_solve)(const plan *ego_, const problem *p_);
+
+/* problem-pruned.c: */
+typedef struct {
+     problem super;
+     INT n;            /* transform size */
+     INT n_in, n_out;  /* nonzero inputs, wanted outputs */
+     INT is, os;
+     INT vl, ivs, ovs;
+     R *ri, *ii, *ro, *io;
+} problem_dft_pruned;
+
+problem *X(mkproblem_dft_pruned)(INT n, INT n_in, INT n_out,
+				 INT is, INT os, INT vl, INT ivs, INT ovs,
+				 R *ri, R *ii, R *ro, R *io);
+void X(dft_pruned_solve)(const plan *ego_, const problem *p_);
+
 /* plan.c: */
 typedef void (*dftapply) (const plan *ego, R *ri, R *ii, R *ro, R *io);
 
@@ -74,6 +102,9 @@ void X(dft_buffered_register)(planner *p);
 void X(dft_generic_register)(planner *p);
 void X(dft_rader_register)(planner *p);
 void X(dft_bluestein_register)(planner *p);
+void X(czt_bluestein_register)(planner *p);
+void X(dft_pruned_register)(planner *p);
+void X(dft_pruned_ct_register)(planner *p);
 void X(dft_nop_register)(planner *p);
 void X(ct_generic_register)(planner *p);
 void X(ct_genericbuf_register)(planner *p);
@@ -107,7 +107,7 @@ static void apply_buf(const plan *ego_, R *rio, R *iio)
      INT mb = ego->mb, me = ego->me;
      size_t bufsz = r * batchsz * 2 * sizeof(R);
 
-     BUF_ALLOC(R *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, R *, buf, bufsz);
 
      for (i = 0; i < v; ++i, rio += ego->vs, iio += ego->vs) {
 	  for (j = mb; j + batchsz < me; j += batchsz) 
@@ -116,7 +116,7 @@ static void apply_buf(const plan *ego_, R *rio, R *iio)
 	  dobatch(ego, rio, iio, j, me, buf);
      }
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 /*************************************************************
@@ -292,6 +292,9 @@ static plan *mkcldw(const ct_solver *ego_,
      pln->slv = ego;
      pln->brs = X(mkstride)(r, 2 * compute_batchsize(r));
      pln->extra_iter = extra_iter;
+     if (ego->bufferedp)
+	  PLAN_BUF_SCRATCH(&pln->super.super, plnr,
+			   r * compute_batchsize(r) * 2 * sizeof(R));
 
      X(ops_zero)(&pln->super.super.ops);
      X(ops_madd2)(v * (mcount/e->genus->vl), &e->ops, &pln->super.super.ops);
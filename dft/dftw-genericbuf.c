@@ -104,8 +104,8 @@ static void dobatch(const P *ego, INT mb, INT me, R *buf, R *rio, R *iio)
 static void apply(const plan *ego_, R *rio, R *iio)
 {
      const P *ego = (const P *) ego_;
-     R *buf = (R *) MALLOC(sizeof(R) * 2 * BATCHDIST(ego->r) * ego->batchsz,
-			   BUFFERS);
+     R *buf = (R *) X(scratch_get)(ego_, sizeof(R) * 2 * BATCHDIST(ego->r)
+				   * ego->batchsz);
      INT m;
 
      for (m = ego->mb; m < ego->me; m += ego->batchsz)
@@ -113,7 +113,7 @@ static void apply(const plan *ego_, R *rio, R *iio)
 
      A(m == ego->me);
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 static void awake(plan *ego_, enum wakefulness wakefulness)
@@ -190,6 +190,8 @@ static plan *mkcldw(const ct_solver *ego_,
      pln->batchsz = ego->batchsz;
      pln->mb = mstart;
      pln->me = mstart + mcount;
+     X(plan_scratch)(&pln->super.super, plnr, 
+		     sizeof(R) * 2 * BATCHDIST(r) * ego->batchsz);
 
      {
 	  double n0 = (r - 1) * (mcount - 1);
@@ -77,7 +77,7 @@ static void apply_buf(const plan *ego_, R *ri, R *ii, R *ro, R *io)
      INT i;
      size_t bufsz = n * batchsz * 2 * sizeof(R);
 
-     BUF_ALLOC(R *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, R *, buf, bufsz);
 
      for (i = 0; i < vl - batchsz; i += batchsz) {
 	  dobatch(ego, ri, ii, ro, io, buf, batchsz);
@@ -86,7 +86,7 @@ static void apply_buf(const plan *ego_, R *ri, R *ii, R *ro, R *io)
      }
      dobatch(ego, ri, ii, ro, io, buf, vl - i);
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
@@ -258,6 +258,9 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      pln->is = X(mkstride)(pln->n, d[0].is);
      pln->os = X(mkstride)(pln->n, d[0].os);
      pln->bufstride = X(mkstride)(pln->n, 2 * compute_batchsize(pln->n));
+     if (ego->bufferedp)
+	  PLAN_BUF_SCRATCH(&pln->super.super, plnr,
+			   pln->n * compute_batchsize(pln->n) * 2 * sizeof(R));
 
      X(tensor_tornk1)(p->vecsz, &pln->vl, &pln->ivs, &pln->ovs);
      pln->slv = ego;
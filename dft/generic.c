@@ -77,7 +77,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
      E *buf;
      size_t bufsz = n * 2 * sizeof(E);
 
-     BUF_ALLOC(E *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, E *, buf, bufsz);
      hartley(n, ri, ii, is, buf, ro, io);
 
      for (i = 1; i + i < n; ++i) {
@@ -87,7 +87,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
 	  W += n - 1;
      }
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 static void awake(plan *ego_, enum wakefulness wakefulness)
@@ -142,6 +142,7 @@ static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
 
      p = (const problem_dft *) p_;
      pln->n = n = p->sz->dims[0].n;
+     PLAN_BUF_SCRATCH(&pln->super.super, plnr, n * 2 * sizeof(E));
      pln->is = p->sz->dims[0].is;
      pln->os = p->sz->dims[0].os;
      pln->td = 0;
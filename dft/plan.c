@@ -21,12 +21,32 @@
 
 #include "dft/dft.h"
 
+/* see kernel/profile.c */
+static void apply_profiled(const plan *ego, R *ri, R *ii, R *ro, R *io)
+{
+     plan_profile *pr = ego->prof;
+     double t0 = X(profile_now)();
+     ((dftapply) pr->apply)(ego, ri, ii, ro, io);
+     X(profile_account)(pr, t0);
+}
+
+static void profile(plan *ego_, int on)
+{
+     plan_dft *ego = (plan_dft *) ego_;
+     if (on) {
+	  ego_->prof->apply = (void (*)(void)) ego->apply;
+	  ego->apply = apply_profiled;
+     } else
+	  ego->apply = (dftapply) ego_->prof->apply;
+}
+
 plan *X(mkplan_dft)(size_t size, const plan_adt *adt, dftapply apply)
 {
      plan_dft *ego;
 
      ego = (plan_dft *) X(mkplan)(size, adt);
      ego->apply = apply;
+     ego->super.profile = profile;
 
      return &(ego->super);
 }
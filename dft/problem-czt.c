@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "dft/dft.h"
+
+/* The chirp-z transform of n inputs x[j] with stride is into m
+   outputs X[k] with stride os,
+
+     X[k] = sum_{j < n} x[j] A^{-j} W^{jk},
+
+   for complex A and W, i.e. the z-transform at the points A W^{-k}
+   of a spiral in the complex plane.  For W = exp(-2 pi i / n),
+   A = 1, and m = n, it is the DFT. */
+
+static void destroy(problem *ego_)
+{
+     X(ifree)(ego_);
+}
+
+/* W and A do not enter the hash: they do not affect which solver
+   is best, and the plan is rebuilt from the problem anyway. */
+static void hash(const problem *p_, md5 *m)
+{
+     const problem_czt *p = (const problem_czt *) p_;
+     X(md5puts)(m, "czt");
+     X(md5int)(m, p->ri == p->ro);
+     X(md5INT)(m, p->ii - p->ri);
+     X(md5INT)(m, p->io - p->ro);
+     X(md5int)(m, X(ialignment_of)(p->ri));
+     X(md5int)(m, X(ialignment_of)(p->ii));
+     X(md5int)(m, X(ialignment_of)(p->ro));
+     X(md5int)(m, X(ialignment_of)(p->io));
+     X(md5INT)(m, p->n);
+     X(md5INT)(m, p->m);
+     X(md5INT)(m, p->is);
+     X(md5INT)(m, p->os);
+}
+
+static void print(const problem *ego_, printer *p)
+{
+     const problem_czt *ego = (const problem_czt *) ego_;
+     p->print(p, "(czt %d %d %d %D %D %D %D %D %D)", 
+	      ego->ri == ego->ro,
+	      X(ialignment_of)(ego->ri),
+	      X(ialignment_of)(ego->ro),
+	      (INT)(ego->ii - ego->ri), 
+	      (INT)(ego->io - ego->ro),
+	      ego->n, ego->m, ego->is, ego->os);
+}
+
+static void zero(const problem *ego_)
+{
+     const problem_czt *ego = (const problem_czt *) ego_;
+     tensor *sz = X(mktensor_1d)(ego->n, ego->is, ego->is);
+     X(dft_zerotens)(sz, UNTAINT(ego->ri), UNTAINT(ego->ii));
+     X(tensor_destroy)(sz);
+}
+
+static const problem_adt padt =
+{
+     PROBLEM_CZT,
+     hash,
+     zero,
+     print,
+     destroy,
+     0
+};
+
+problem *X(mkproblem_czt)(INT n, INT m, INT is, INT os,
+			  R *ri, R *ii, R *ro, R *io,
+			  const R *w, const R *a)
+{
+     problem_czt *ego;
+
+     /* enforce pointer equality if untainted pointers are equal */
+     if (UNTAINT(ri) == UNTAINT(ro))
+	  ri = ro = JOIN_TAINT(ri, ro);
+     if (UNTAINT(ii) == UNTAINT(io))
+	  ii = io = JOIN_TAINT(ii, io);
+
+     /* more correctness conditions: */
+     A(TAINTOF(ri) == TAINTOF(ii));
+     A(TAINTOF(ro) == TAINTOF(io));
+
+     if (n <= 0 || m <= 0 || (w[0] == 0 && w[1] == 0)
+	 || (a[0] == 0 && a[1] == 0))
+	  return X(mkproblem_unsolvable)();
+
+     if ((ri == ro) != (ii == io))
+	  /* If either real or imag pointers are in place, both must be. */
+	  return X(mkproblem_unsolvable)();
+
+     ego = (problem_czt *)X(mkproblem)(sizeof(problem_czt), &padt);
+
+     ego->n = n;
+     ego->m = m;
+     ego->is = is;
+     ego->os = os;
+     ego->ri = ri;
+     ego->ii = ii;
+     ego->ro = ro;
+     ego->io = io;
+     ego->w[0] = w[0]; ego->w[1] = w[1];
+     ego->a[0] = a[0]; ego->a[1] = a[1];
+
+     return &(ego->super);
+}
+
+/* use the apply() operation for CZT problems */
+void X(czt_solve)(const plan *ego_, const problem *p_)
+{
+     const plan_dft *ego = (const plan_dft *) ego_;
+     const problem_czt *p = (const problem_czt *) p_;
+     ego->apply(ego_, 
+		UNTAINT(p->ri), UNTAINT(p->ii), 
+		UNTAINT(p->ro), UNTAINT(p->io));
+}
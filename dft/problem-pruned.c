@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "dft/dft.h"
+
+/* A pruned DFT: vl transforms of size n of which only the first n_in
+   inputs may be nonzero and only the first n_out outputs are wanted,
+
+     Y[k] = sum_{j < n_in} x[j] exp(-2 pi i jk / n),  k < n_out.
+
+   The solver reads only the n_in inputs and writes only the n_out
+   outputs, so the caller need not store the zero padding. */
+
+static void destroy(problem *ego_)
+{
+     X(ifree)(ego_);
+}
+
+static void hash(const problem *p_, md5 *m)
+{
+     const problem_dft_pruned *p = (const problem_dft_pruned *) p_;
+     X(md5puts)(m, "pruned");
+     X(md5int)(m, p->ri == p->ro);
+     X(md5INT)(m, p->ii - p->ri);
+     X(md5INT)(m, p->io - p->ro);
+     X(md5int)(m, X(ialignment_of)(p->ri));
+     X(md5int)(m, X(ialignment_of)(p->ii));
+     X(md5int)(m, X(ialignment_of)(p->ro));
+     X(md5int)(m, X(ialignment_of)(p->io));
+     X(md5INT)(m, p->n);
+     X(md5INT)(m, p->n_in);
+     X(md5INT)(m, p->n_out);
+     X(md5INT)(m, p->is);
+     X(md5INT)(m, p->os);
+     X(md5INT)(m, p->vl);
+     X(md5INT)(m, p->ivs);
+     X(md5INT)(m, p->ovs);
+}
+
+static void print(const problem *ego_, printer *p)
+{
+     const problem_dft_pruned *ego = (const problem_dft_pruned *) ego_;
+     p->print(p, "(dft-pruned %d %d %d %D %D %D %D %D %D %D %D %D %D)",
+	      ego->ri == ego->ro,
+	      X(ialignment_of)(ego->ri),
+	      X(ialignment_of)(ego->ro),
+	      (INT)(ego->ii - ego->ri),
+	      (INT)(ego->io - ego->ro),
+	      ego->n, ego->n_in, ego->n_out, ego->is, ego->os,
+	      ego->vl, ego->ivs, ego->ovs);
+}
+
+static void zero(const problem *ego_)
+{
+     const problem_dft_pruned *ego = (const problem_dft_pruned *) ego_;
+     tensor *sz = X(mktensor_2d)(ego->vl, ego->ivs, ego->ivs,
+				 ego->n_in, ego->is, ego->is);
+     X(dft_zerotens)(sz, UNTAINT(ego->ri), UNTAINT(ego->ii));
+     X(tensor_destroy)(sz);
+}
+
+static const problem_adt padt =
+{
+     PROBLEM_DFT_PRUNED,
+     hash,
+     zero,
+     print,
+     destroy,
+     0
+};
+
+problem *X(mkproblem_dft_pruned)(INT n, INT n_in, INT n_out,
+				 INT is, INT os, INT vl, INT ivs, INT ovs,
+				 R *ri, R *ii, R *ro, R *io)
+{
+     problem_dft_pruned *ego;
+
+     /* enforce pointer equality if untainted pointers are equal */
+     if (UNTAINT(ri) == UNTAINT(ro))
+	  ri = ro = JOIN_TAINT(ri, ro);
+     if (UNTAINT(ii) == UNTAINT(io))
+	  ii = io = JOIN_TAINT(ii, io);
+
+     /* more correctness conditions: */
+     A(TAINTOF(ri) == TAINTOF(ii));
+     A(TAINTOF(ro) == TAINTOF(io));
+
+     if (n <= 0 || n_in <= 0 || n_in > n || n_out <= 0 || n_out > n
+	 || vl <= 0)
+	  return X(mkproblem_unsolvable)();
+
+     if ((ri == ro) != (ii == io))
+	  /* If either real or imag pointers are in place, both must be. */
+	  return X(mkproblem_unsolvable)();
+
+     ego = (problem_dft_pruned *)X(mkproblem)(sizeof(problem_dft_pruned),
+					      &padt);
+
+     ego->n = n;
+     ego->n_in = n_in;
+     ego->n_out = n_out;
+     ego->is = is;
+     ego->os = os;
+     ego->vl = vl;
+     ego->ivs = ivs;
+     ego->ovs = ovs;
+     ego->ri = ri;
+     ego->ii = ii;
+     ego->ro = ro;
+     ego->io = io;
+
+     return &(ego->super);
+}
+
+/* use the apply() operation for pruned DFT problems */
+void X(dft_pruned_solve)(const plan *ego_, const problem *p_)
+{
+     const plan_dft *ego = (const plan_dft *) ego_;
+     const problem_dft_pruned *p = (const problem_dft_pruned *) p_;
+     ego->apply(ego_,
+		UNTAINT(p->ri), UNTAINT(p->ii),
+		UNTAINT(p->ro), UNTAINT(p->io));
+}
@@ -65,13 +65,22 @@ static void zero(const problem *ego_)
      X(tensor_destroy)(sz);
 }
 
+static void tensors(const problem *ego_, 
+		    const tensor **sz, const tensor **vecsz)
+{
+     const problem_dft *ego = (const problem_dft *) ego_;
+     *sz = ego->sz;
+     *vecsz = ego->vecsz;
+}
+
 static const problem_adt padt =
 {
      PROBLEM_DFT,
      hash,
      zero,
      print,
-     destroy
+     destroy,
+     tensors
 };
 
 problem *X(mkproblem_dft)(const tensor *sz, const tensor *vecsz,
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "dft/ct.h"
+
+/* Cooley-Tukey steps for pruned DFTs.  Let n = r * m.
+
+   DIF, for n_in <= m: with k = r k2 + k1,
+
+     Y[r k2 + k1] = sum_{j < n_in} (x[j] w_n^{j k1}) w_m^{j k2},
+
+   i.e. r twiddled copies of the input, each transformed by a pruned
+   DFT of size m with n_in inputs and ceil(n_out/r) outputs.  The
+   radix-r butterflies of the first stage vanish, since all but one
+   of their inputs are zero.
+
+   DIT, for n_out <= m: with j = r j2 + j1,
+
+     Y[k] = sum_{j1 < r} w_n^{j1 k} sum_{j2} x[r j2 + j1] w_m^{j2 k},
+
+   i.e. r pruned DFTs of size m with ceil(n_in/r) inputs and n_out
+   outputs, combined by a twiddled sum computed only for k < n_out.
+
+   In both cases we pick the smallest such m, so that a single step
+   removes all the zero blocks of the input (DIF) or all the unwanted
+   blocks of the output (DIT), and the sub-transforms are as short as
+   the pruning allows.  The child is again a pruned problem, so that a
+   DIF step may be followed by a DIT step that prunes the outputs of
+   its sub-transforms; beyond that there is nothing left to skip, and
+   the child is an ordinary DFT (see pruned.c).  The cost is thus
+   about n log(m) instead of n log(n).
+
+   Only complex data are pruned: ct.c and the real-data hc2hc.c are
+   left alone, and pruned real transforms are not supported. */
+
+typedef struct {
+     solver super;
+     int dec;
+} S;
+
+typedef struct {
+     plan_dft super;
+     plan *cld;
+     R *tw;
+     INT n, r, m, n_in, n_out, m_in;
+     INT is, os;
+     INT vl, ivs, ovs;
+     int dec;
+} P;
+
+static void apply_dif(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     plan_dft *cld = (plan_dft *) ego->cld;
+     INT iv, j, k1, k2, k;
+     INT r = ego->r, m = ego->m, n_in = ego->n_in, n_out = ego->n_out;
+     INT is = ego->is, os = ego->os;
+     R *b = (R *) X(scratch_get)(ego_, 2 * ego->n * sizeof(R));
+
+     for (iv = 0; iv < ego->vl; ++iv) {
+	  /* twiddled copies; the child reads only n_in of each */
+	  for (k1 = 0; k1 < r; ++k1) {
+	       R *bk = b + 2 * k1 * m;
+	       const R *t = ego->tw + 2 * k1 * n_in;
+	       for (j = 0; j < n_in; ++j) {
+		    E xr = ri[j*is], xi = ii[j*is];
+		    E wr = t[2*j], wi = t[2*j+1];
+		    bk[2*j] = xr * wr - xi * wi;
+		    bk[2*j+1] = xr * wi + xi * wr;
+	       }
+	  }
+
+	  cld->apply(ego->cld, b, b+1, b, b+1);
+
+	  for (k2 = 0, k = 0; k < n_out; ++k2)
+	       for (k1 = 0; k1 < r && k < n_out; ++k1, ++k) {
+		    ro[k*os] = b[2*(k1*m + k2)];
+		    io[k*os] = b[2*(k1*m + k2)+1];
+	       }
+
+	  ri += ego->ivs; ii += ego->ivs;
+	  ro += ego->ovs; io += ego->ovs;
+     }
+
+     X(scratch_put)(ego_, b);
+}
+
+static void apply_dit(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     plan_dft *cld = (plan_dft *) ego->cld;
+     INT iv, j, j1, j2, k;
+     INT r = ego->r, m = ego->m, n_in = ego->n_in, n_out = ego->n_out;
+     INT m_in = ego->m_in, is = ego->is, os = ego->os;
+     R *b = (R *) X(scratch_get)(ego_, 2 * ego->n * sizeof(R));
+
+     for (iv = 0; iv < ego->vl; ++iv) {
+	  /* decimate, padding each subsequence to the m_in inputs
+	     that the child reads */
+	  for (j1 = 0; j1 < r; ++j1) {
+	       R *bj = b + 2 * j1 * m;
+	       for (j2 = 0, j = j1; j < n_in; ++j2, j += r) {
+		    bj[2*j2] = ri[j*is];
+		    bj[2*j2+1] = ii[j*is];
+	       }
+	       for (; j2 < m_in; ++j2)
+		    bj[2*j2] = bj[2*j2+1] = K(0.0);
+	  }
+
+	  cld->apply(ego->cld, b, b+1, b, b+1);
+
+	  for (k = 0; k < n_out; ++k) {
+	       const R *t = ego->tw + 2 * k * r;
+	       E yr = b[2*k], yi = b[2*k+1];
+	       for (j1 = 1; j1 < r; ++j1) {
+		    E xr = b[2*(j1*m + k)], xi = b[2*(j1*m + k)+1];
+		    E wr = t[2*j1], wi = t[2*j1+1];
+		    yr += xr * wr - xi * wi;
+		    yi += xr * wi + xi * wr;
+	       }
+	       ro[k*os] = yr;
+	       io[k*os] = yi;
+	  }
+
+	  ri += ego->ivs; ii += ego->ivs;
+	  ro += ego->ovs; io += ego->ovs;
+     }
+
+     X(scratch_put)(ego_, b);
+}
+
+/* DIF: tw[k1][j] = w_n^{j k1}, j < n_in.
+   DIT: tw[k][j1] = w_n^{j1 k}, k < n_out. */
+static void mktwiddle(enum wakefulness wakefulness, P *p)
+{
+     INT a, b, na, nb;
+     triggen *t = X(mktriggen)(wakefulness, p->n);
+     R *tw;
+
+     if (p->dec == DECDIF) {
+	  na = p->r; nb = p->n_in;
+     } else {
+	  na = p->n_out; nb = p->r;
+     }
+
+     p->tw = tw = (R *) MALLOC(2 * na * nb * sizeof(R), TWIDDLES);
+
+     /* a * b < r * m = n, so no reduction mod n is needed */
+     for (a = 0; a < na; ++a)
+	  for (b = 0; b < nb; ++b) {
+	       t->cexp(t, a * b, tw + 2 * (a * nb + b));
+	       tw[2 * (a * nb + b) + 1] = -tw[2 * (a * nb + b) + 1];
+	  }
+
+     X(triggen_destroy)(t);
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+
+     X(plan_awake)(ego->cld, wakefulness);
+
+     switch (wakefulness) {
+	 case SLEEPY:
+	      X(ifree0)(ego->tw);
+	      ego->tw = 0;
+	      break;
+	 default:
+	      A(!ego->tw);
+	      mktwiddle(wakefulness, ego);
+	      break;
+     }
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cld);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *) ego_;
+     p->print(p, "(dft-pruned-%s-%D-%D/%Dx%D%v%(%p%))",
+	      ego->dec == DECDIT ? "dit" : "dif",
+	      ego->n_in, ego->n_out, ego->r, ego->m, ego->vl, ego->cld);
+}
+
+/* the smallest divisor m of n with k <= m < n, or 0 if there is none */
+static INT choose_m(INT n, INT k)
+{
+     INT d, m = 0;
+
+     for (d = 1; d * d <= n; ++d)
+	  if (n % d == 0) {
+	       if (d >= k && d < n && (!m || d < m)) m = d;
+	       if (n / d >= k && n / d < n && (!m || n / d < m)) m = n / d;
+	  }
+     return m;
+}
+
+static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
+{
+     const S *ego = (const S *) ego_;
+     const problem_dft_pruned *p = (const problem_dft_pruned *) p_;
+     P *pln;
+     plan *cld;
+     R *buf;
+     INT n = p->n, r, m, m_in, m_out;
+
+     static const plan_adt padt = {
+	  X(dft_pruned_solve), awake, print, destroy
+     };
+
+     m = choose_m(n, ego->dec == DECDIF ? p->n_in : p->n_out);
+     if (!m) return (plan *) 0;
+     r = n / m;
+
+     if (ego->dec == DECDIF) {
+	  m_in = p->n_in;
+	  m_out = (p->n_out + r - 1) / r;
+     } else {
+	  m_in = (p->n_in + r - 1) / r;
+	  m_out = p->n_out;
+     }
+
+     buf = (R *) MALLOC(2 * n * sizeof(R), BUFFERS);
+     cld = X(mkplan_d)(plnr,
+		       X(mkproblem_dft_pruned)(m, m_in, m_out, 2, 2,
+					       r, 2 * m, 2 * m,
+					       buf, buf+1, buf, buf+1));
+     X(ifree)(buf);
+     if (!cld) return (plan *) 0;
+
+     pln = MKPLAN_DFT(P, &padt,
+		      ego->dec == DECDIF ? apply_dif : apply_dit);
+
+     pln->cld = cld;
+     pln->tw = 0;
+     pln->n = n;
+     pln->r = r;
+     pln->m = m;
+     pln->n_in = p->n_in;
+     pln->n_out = p->n_out;
+     pln->m_in = m_in;
+     pln->is = p->is;
+     pln->os = p->os;
+     pln->vl = p->vl;
+     pln->ivs = p->ivs;
+     pln->ovs = p->ovs;
+     pln->dec = ego->dec;
+     X(plan_scratch)(&pln->super.super, plnr, 2 * n * sizeof(R));
+
+     {
+	  /* operations for one transform of the vector */
+	  opcnt ops;
+	  X(ops_cpy)(&cld->ops, &ops);
+	  if (ego->dec == DECDIF) {
+	       ops.add += 2 * r * p->n_in;
+	       ops.mul += 4 * r * p->n_in;
+	       ops.other += 2 * p->n_out;
+	  } else {
+	       ops.add += 4 * (r - 1) * p->n_out;
+	       ops.mul += 4 * (r - 1) * p->n_out;
+	       ops.other += 2 * (p->n_in + p->n_out);
+	  }
+	  X(ops_zero)(&pln->super.super.ops);
+	  X(ops_madd2)(p->vl, &ops, &pln->super.super.ops);
+     }
+
+     return &(pln->super.super);
+}
+
+static solver *mksolver(int dec)
+{
+     static const solver_adt sadt = { PROBLEM_DFT_PRUNED, mkplan, 0 };
+     S *slv = MKSOLVER(S, &sadt);
+     slv->dec = dec;
+     return &(slv->super);
+}
+
+void X(dft_pruned_ct_register)(planner *p)
+{
+     REGISTER_SOLVER(p, mksolver(DECDIF));
+     REGISTER_SOLVER(p, mksolver(DECDIT));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "dft/dft.h"
+
+/* Pruned DFT by zero padding: copy the inputs to a buffer of size n,
+   pad with zeros, transform in place, and copy out the wanted outputs.
+   When nothing is pruned, the child transforms the arrays directly.
+   This solver applies to any pruned problem, and ends the recursion
+   of pruned-ct.c. */
+
+typedef struct {
+     solver super;
+} S;
+
+typedef struct {
+     plan_dft super;
+     plan *cld;
+     INT n, n_in, n_out;
+     INT is, os;
+     INT vl, ivs, ovs;
+} P;
+
+static void apply_full(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     plan_dft *cld = (plan_dft *) ego->cld;
+     cld->apply(ego->cld, ri, ii, ro, io);
+}
+
+static void apply_pad(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     plan_dft *cld = (plan_dft *) ego->cld;
+     INT i, iv, n = ego->n, n_in = ego->n_in, n_out = ego->n_out;
+     INT is = ego->is, os = ego->os;
+     R *b = (R *) X(scratch_get)(ego_, 2 * n * sizeof(R));
+
+     for (iv = 0; iv < ego->vl; ++iv) {
+	  for (i = 0; i < n_in; ++i) {
+	       b[2*i] = ri[i*is];
+	       b[2*i+1] = ii[i*is];
+	  }
+	  for (; i < n; ++i) b[2*i] = b[2*i+1] = K(0.0);
+
+	  cld->apply(ego->cld, b, b+1, b, b+1);
+
+	  for (i = 0; i < n_out; ++i) {
+	       ro[i*os] = b[2*i];
+	       io[i*os] = b[2*i+1];
+	  }
+
+	  ri += ego->ivs; ii += ego->ivs;
+	  ro += ego->ovs; io += ego->ovs;
+     }
+
+     X(scratch_put)(ego_, b);
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+     X(plan_awake)(ego->cld, wakefulness);
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cld);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *) ego_;
+     p->print(p, "(dft-pruned-pad-%D-%D/%D%v%(%p%))",
+	      ego->n_in, ego->n_out, ego->n, ego->vl, ego->cld);
+}
+
+static int fullp(const problem_dft_pruned *p)
+{
+     return p->n_in == p->n && p->n_out == p->n;
+}
+
+static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
+{
+     const problem_dft_pruned *p = (const problem_dft_pruned *) p_;
+     P *pln;
+     plan *cld;
+     R *buf = (R *) 0;
+     INT n = p->n;
+
+     static const plan_adt padt = {
+	  X(dft_pruned_solve), awake, print, destroy
+     };
+
+     UNUSED(ego);
+
+     if (fullp(p)) {
+	  cld = X(mkplan_d)(plnr,
+			    X(mkproblem_dft_d)(
+				 X(mktensor_1d)(n, p->is, p->os),
+				 X(mktensor_1d)(p->vl, p->ivs, p->ovs),
+				 p->ri, p->ii, p->ro, p->io));
+     } else {
+	  buf = (R *) MALLOC(2 * n * sizeof(R), BUFFERS);
+	  cld = X(mkplan_d)(plnr,
+			    X(mkproblem_dft_d)(
+				 X(mktensor_1d)(n, 2, 2),
+				 X(mktensor_1d)(1, 0, 0),
+				 buf, buf+1, buf, buf+1));
+	  X(ifree)(buf);
+     }
+     if (!cld) return (plan *) 0;
+
+     pln = MKPLAN_DFT(P, &padt, fullp(p) ? apply_full : apply_pad);
+
+     pln->cld = cld;
+     pln->n = n;
+     pln->n_in = p->n_in;
+     pln->n_out = p->n_out;
+     pln->is = p->is;
+     pln->os = p->os;
+     pln->vl = p->vl;
+     pln->ivs = p->ivs;
+     pln->ovs = p->ovs;
+
+     if (fullp(p)) {
+	  X(ops_cpy)(&cld->ops, &pln->super.super.ops);
+     } else {
+	  X(plan_scratch)(&pln->super.super, plnr, 2 * n * sizeof(R));
+	  X(ops_zero)(&pln->super.super.ops);
+	  pln->super.super.ops.other = 2 * (n + p->n_out) * p->vl;
+	  X(ops_madd2)(p->vl, &cld->ops, &pln->super.super.ops);
+     }
+
+     return &(pln->super.super);
+}
+
+static solver *mksolver(void)
+{
+     static const solver_adt sadt = { PROBLEM_DFT_PRUNED, mkplan, 0 };
+     S *slv = MKSOLVER(S, &sadt);
+     return &(slv->super);
+}
+
+void X(dft_pruned_register)(planner *p)
+{
+     REGISTER_SOLVER(p, mksolver());
+}
@@ -101,7 +101,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
      R r0 = ri[0], i0 = ii[0];
 
      r = ego->n; is = ego->is; os = ego->os; g = ego->g; 
-     buf = (R *) MALLOC(sizeof(R) * (r - 1) * 2, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * (r - 1) * 2);
 
      /* First, permute the input, storing in buf: */
      for (gpower = 1, k = 0; k < r - 1; ++k, gpower = MULMOD(gpower, g, r)) {
@@ -161,7 +161,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
      }
 
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 /***************************************************************************/
@@ -272,6 +272,7 @@ static int mkP(P *pln, INT n, INT is, INT os, R *ro, R *io,
      pln->n = n;
      pln->is = is;
      pln->os = os;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * (n - 1) * 2);
 
      X(ops_add)(&cld1->ops, &cld2->ops, &pln->super.super.ops);
      pln->super.super.ops.other += (n - 1) * (4 * 2 + 6) + 6;
@@ -0,0 +1,544 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Learned estimator.
+
+   The default estimator (see X(iestimate_cost)) charges one unit for
+   each flop and for each ``other'' operation of a plan, no matter
+   which solver performs them and how they access memory.  The
+   learned estimator charges instead
+
+	c[0] * flops + c[1] * other + c[2] * mem
+
+   for the operations that a solver performs itself, with coefficients
+   C of its own, plus the estimates of the children of the plan.  MEM
+   is a crude measure of the memory traffic of the problem: the number
+   of elements, weighted by the logarithm of the smallest input and
+   output strides, so that strided access costs more than unit-stride
+   access.  A solver without coefficients gets the default (1, 1, 0),
+   and thus an empty profile reproduces the default estimator.
+   Codelets are solvers, and so they get coefficients of their own.
+
+   Plans do not remember their children, and so the estimate is
+   accumulated bottom-up in the OPS of the plans.  When a solver
+   returns a plan, its OPS include the counts and the estimates of the
+   children, scaled by the solver in the usual way, and the counts
+   minus CFLOPS and COTHER, which are the counts of the children, are
+   the operations of the solver itself.
+
+   The coefficients are fitted to measurements on the host.  While
+   recording, each plan is timed as soon as its solver returns it, and
+   the time of the plan minus the time of its children is a sample of
+   the cost of the solver.  The samples are scaled to operation units
+   by a global time per operation, and the coefficients of each solver
+   are fitted to its samples by least squares in the relative error,
+   regularized towards the default, so that a solver with few samples
+   does not stray far from it. */
+
+#include "kernel/ifftw.h"
+#include <math.h>
+#include <string.h>
+
+#define NCOEF 3
+#define MINSAMPLES 2
+#define LAMBDA 1.0      /* weight of the default, in samples */
+#define CSCALE 65536.0  /* coefficients are exported in units of 1/CSCALE */
+#define CMAX 32767.0
+#define MAXNAM 64
+
+typedef struct {
+     int valid;
+     double c[NCOEF];
+} coefs;
+
+typedef struct {
+     unsigned slvndx;
+     double t;          /* seconds */
+     double f[NCOEF];
+} sample;
+
+struct cost_model_s {
+     coefs *cf;         /* indexed by slvndx */
+     unsigned ncf;
+     int nvalid;
+     int recording;
+     sample *smp;
+     unsigned nsmp, nsmpalloc;
+};
+
+static const double default_c[NCOEF] = { 1.0, 1.0, 0.0 };
+
+static cost_model *mkmodel(planner *ego)
+{
+     if (!ego->cmodel) {
+	  cost_model *m = (cost_model *)MALLOC(sizeof(cost_model), OTHER);
+	  m->cf = 0;
+	  m->ncf = 0;
+	  m->nvalid = 0;
+	  m->recording = 0;
+	  m->smp = 0;
+	  m->nsmp = m->nsmpalloc = 0;
+	  ego->cmodel = m;
+     }
+     return ego->cmodel;
+}
+
+/* make room for the coefficients of all solvers of EGO */
+static void grow_coefs(planner *ego, cost_model *m)
+{
+     if (m->ncf < ego->nslvdesc) {
+	  unsigned i, j, n = ego->nslvdesc;
+	  coefs *cf = (coefs *)MALLOC(n * sizeof(coefs), OTHER);
+	  for (i = 0; i < n; ++i) {
+	       if (i < m->ncf)
+		    cf[i] = m->cf[i];
+	       else {
+		    cf[i].valid = 0;
+		    for (j = 0; j < NCOEF; ++j)
+			 cf[i].c[j] = default_c[j];
+	       }
+	  }
+	  X(ifree0)(m->cf);
+	  m->cf = cf;
+	  m->ncf = n;
+     }
+}
+
+static const double *coefs_of(const cost_model *m, unsigned slvndx)
+{
+     if (slvndx < m->ncf && m->cf[slvndx].valid)
+	  return m->cf[slvndx].c;
+     return default_c;
+}
+
+static double flops(const opcnt *o)
+{
+#if HAVE_FMA
+     return o->add + o->mul + o->fma;
+#else
+     return o->add + o->mul + 2 * o->fma;
+#endif
+}
+
+static INT min_stride(const tensor *a, const tensor *b, int out)
+{
+     INT s = 0;
+     int i;
+
+     for (i = 0; i < a->rnk; ++i)
+	  if (a->dims[i].n > 1) {
+	       INT t = X(iabs)(out ? a->dims[i].os : a->dims[i].is);
+	       if (t > 0 && (s == 0 || t < s))
+		    s = t;
+	  }
+     for (i = 0; i < b->rnk; ++i)
+	  if (b->dims[i].n > 1) {
+	       INT t = X(iabs)(out ? b->dims[i].os : b->dims[i].is);
+	       if (t > 0 && (s == 0 || t < s))
+		    s = t;
+	  }
+     return s ? s : 1;
+}
+
+static double memory_traffic(const problem *p)
+{
+     const tensor *sz, *vecsz;
+
+     if (!p->adt->tensors)
+	  return 0;
+     p->adt->tensors(p, &sz, &vecsz);
+     if (!FINITE_RNK(sz->rnk) || !FINITE_RNK(vecsz->rnk))
+	  return 0;
+     return ((double)X(tensor_sz)(sz) * (double)X(tensor_sz)(vecsz)
+	     * (log(1.0 + (double)min_stride(sz, vecsz, 0))
+		+ log(1.0 + (double)min_stride(sz, vecsz, 1)))
+	     / log(2.0));
+}
+
+static void add_sample(planner *ego, unsigned slvndx, double t, 
+		       const double *f)
+{
+     cost_model *m = ego->cmodel;
+     sample *s;
+     int j;
+
+     X(planner_lock)(ego);
+     if (m->nsmp >= m->nsmpalloc) {
+	  unsigned i, nalloc = 2 * m->nsmpalloc + 256;
+	  sample *smp = (sample *)MALLOC(nalloc * sizeof(sample), OTHER);
+	  for (i = 0; i < m->nsmp; ++i)
+	       smp[i] = m->smp[i];
+	  X(ifree0)(m->smp);
+	  m->smp = smp;
+	  m->nsmpalloc = nalloc;
+     }
+     s = m->smp + m->nsmp++;
+     s->slvndx = slvndx;
+     s->t = t;
+     for (j = 0; j < NCOEF; ++j)
+	  s->f[j] = f[j];
+     X(planner_unlock)(ego);
+}
+
+void X(costmodel_attribute)(planner *ego, plan *pln, const problem *p,
+			    unsigned slvndx)
+{
+     cost_model *m = ego->cmodel;
+     opcnt *o = &pln->ops;
+     double f[NCOEF];
+     const double *c;
+     int j;
+
+     f[0] = flops(o) - o->cflops;
+     f[1] = o->other - o->cother;
+     f[2] = memory_traffic(p);
+     o->cflops = flops(o);
+     o->cother = o->other;
+
+     if (m->recording && !ESTIMATEP(ego)) {
+	  double t = X(measure_execution_time)(ego, pln, p);
+	  if (t >= 0) {
+	       /* the children were timed when they were created */
+	       add_sample(ego, slvndx, t - o->est, f);
+	       o->est = t;
+	       return;
+	  }
+     }
+
+     c = coefs_of(m, slvndx);
+     for (j = 0; j < NCOEF; ++j)
+	  o->est += c[j] * f[j];
+}
+
+int X(costmodel_estimatingp)(const planner *ego)
+{
+     return ego->cmodel && ego->cmodel->nvalid > 0 && !ego->cmodel->recording;
+}
+
+int X(costmodel_recordingp)(const planner *ego)
+{
+     return ego->cmodel && ego->cmodel->recording;
+}
+
+void X(costmodel_record)(planner *ego, int on)
+{
+     if (on || ego->cmodel)
+	  mkmodel(ego)->recording = on;
+}
+
+/*
+ * fitting
+ */
+
+/* normal equations of one solver */
+typedef struct {
+     double a[NCOEF][NCOEF], b[NCOEF];
+     unsigned n;
+} normeq;
+
+/* solve for the coefficients in FREE, the others being zero.  Return
+   0 if the system is singular */
+static int solve(const normeq *e, const int *free_, double *x)
+{
+     double a[NCOEF][NCOEF + 1];
+     int idx[NCOEF], n = 0, i, j, k;
+
+     for (i = 0; i < NCOEF; ++i) {
+	  x[i] = 0;
+	  if (free_[i])
+	       idx[n++] = i;
+     }
+     for (i = 0; i < n; ++i) {
+	  for (j = 0; j < n; ++j)
+	       a[i][j] = e->a[idx[i]][idx[j]];
+	  a[i][n] = e->b[idx[i]];
+     }
+
+     /* Gaussian elimination with partial pivoting */
+     for (k = 0; k < n; ++k) {
+	  int piv = k;
+	  for (i = k + 1; i < n; ++i)
+	       if (fabs(a[i][k]) > fabs(a[piv][k]))
+		    piv = i;
+	  if (a[piv][k] == 0.0)
+	       return 0;
+	  for (j = 0; j <= n; ++j) {
+	       double t = a[k][j];
+	       a[k][j] = a[piv][j];
+	       a[piv][j] = t;
+	  }
+	  for (i = k + 1; i < n; ++i) {
+	       double r = a[i][k] / a[k][k];
+	       for (j = k; j <= n; ++j)
+		    a[i][j] -= r * a[k][j];
+	  }
+     }
+     for (k = n - 1; k >= 0; --k) {
+	  double t = a[k][n];
+	  for (j = k + 1; j < n; ++j)
+	       t -= a[k][j] * x[idx[j]];
+	  x[idx[k]] = t / a[k][k];
+     }
+     return 1;
+}
+
+static int fit1(normeq *e, double *c)
+{
+     int free_[NCOEF], i, again;
+     double x[NCOEF];
+
+     if (e->n < MINSAMPLES)
+	  return 0;
+
+     /* regularize towards the default.  A coefficient whose feature
+	never occurs is pinned to the default. */
+     for (i = 0; i < NCOEF; ++i) {
+	  double lambda = LAMBDA * e->a[i][i] / e->n;
+	  if (lambda > 0) {
+	       e->a[i][i] += lambda;
+	       e->b[i] += lambda * default_c[i];
+	  } else {
+	       int j;
+	       for (j = 0; j < NCOEF; ++j)
+		    e->a[i][j] = e->a[j][i] = 0;
+	       e->a[i][i] = 1;
+	       e->b[i] = default_c[i];
+	  }
+	  free_[i] = 1;
+     }
+
+     /* costs are not negative: pin negative coefficients to zero and
+	solve again for the others */
+     do {
+	  if (!solve(e, free_, x))
+	       return 0;
+	  again = 0;
+	  for (i = 0; i < NCOEF; ++i)
+	       if (free_[i] && x[i] < 0) {
+		    free_[i] = 0;
+		    again = 1;
+	       }
+     } while (again);
+
+     for (i = 0; i < NCOEF; ++i)
+	  c[i] = x[i] < CMAX ? x[i] : CMAX;
+     return 1;
+}
+
+/* the time per operation, geometric mean over the samples of the
+   ratio of the time to the default cost */
+static double time_per_op(const cost_model *m)
+{
+     double s = 0;
+     unsigned i, n = 0;
+
+     for (i = 0; i < m->nsmp; ++i) {
+	  const sample *p = m->smp + i;
+	  double d = p->f[0] * default_c[0] + p->f[1] * default_c[1];
+	  if (p->t > 0 && d > 0) {
+	       s += log(p->t / d);
+	       ++n;
+	  }
+     }
+     return n ? exp(s / n) : 0;
+}
+
+int X(costmodel_fit)(planner *ego)
+{
+     cost_model *m = ego->cmodel;
+     normeq *e;
+     double tau;
+     unsigned i, s;
+     int nfit = 0;
+
+     if (!m || !(tau = time_per_op(m)))
+	  return 0;
+
+     grow_coefs(ego, m);
+     e = (normeq *)MALLOC(m->ncf * sizeof(normeq), OTHER);
+     memset(e, 0, m->ncf * sizeof(normeq));
+
+     for (i = 0; i < m->nsmp; ++i) {
+	  const sample *p = m->smp + i;
+	  double z = p->t / tau, d, w;
+	  normeq *q;
+	  int j, k;
+
+	  if (p->slvndx >= m->ncf)
+	       continue;
+
+	  /* weight for the relative error, with the default cost
+	     standing in for tiny or negative times */
+	  d = p->f[0] * default_c[0] + p->f[1] * default_c[1];
+	  if (z > d)
+	       d = z;
+	  if (d <= 0)
+	       continue;
+	  w = 1.0 / (d * d);
+
+	  q = e + p->slvndx;
+	  for (j = 0; j < NCOEF; ++j) {
+	       for (k = 0; k < NCOEF; ++k)
+		    q->a[j][k] += w * p->f[j] * p->f[k];
+	       q->b[j] += w * p->f[j] * z;
+	  }
+	  ++q->n;
+     }
+
+     for (s = 0; s < m->ncf; ++s)
+	  if (fit1(e + s, m->cf[s].c)) {
+	       m->cf[s].valid = 1;
+	       ++nfit;
+	  }
+
+     m->nvalid = 0;
+     for (s = 0; s < m->ncf; ++s)
+	  m->nvalid += m->cf[s].valid;
+
+     X(ifree)(e);
+     return nfit;
+}
+
+void X(costmodel_forget)(planner *ego)
+{
+     cost_model *m = ego->cmodel;
+     if (m) {
+	  X(ifree0)(m->cf);
+	  X(ifree0)(m->smp);
+	  X(ifree)(m);
+	  ego->cmodel = 0;
+     }
+}
+
+/*
+ * profiles
+ */
+
+#define PROFILE_PREAMBLE PACKAGE "-" VERSION " " STRINGIZE(X(cost_profile))
+
+static int coef_to_int(double c)
+{
+     return (int)((c < CMAX ? c : CMAX) * CSCALE + 0.5);
+}
+
+void X(costmodel_export)(planner *ego, printer *p)
+{
+     cost_model *m = ego->cmodel;
+     unsigned s;
+
+     X(planner_rdlock)(ego);
+     p->print(p, "(" PROFILE_PREAMBLE "\n");
+     if (m)
+	  for (s = 0; s < m->ncf; ++s)
+	       if (m->cf[s].valid) {
+		    const slvdesc *sp = ego->slvdescs + s;
+		    p->print(p, "  (%s %d %d %d %d)\n",
+			     sp->reg_nam, sp->reg_id,
+			     coef_to_int(m->cf[s].c[0]),
+			     coef_to_int(m->cf[s].c[1]),
+			     coef_to_int(m->cf[s].c[2]));
+	       }
+     X(planner_rdunlock)(ego);
+     p->print(p, ")\n");
+}
+
+static unsigned lookup(planner *ego, const char *nam, int id)
+{
+     unsigned s;
+     for (s = 0; s < ego->nslvdesc; ++s)
+	  if (ego->slvdescs[s].reg_id == id
+	      && !strcmp(ego->slvdescs[s].reg_nam, nam))
+	       return s;
+     return ego->nslvdesc;
+}
+
+/* Import a profile, replacing the coefficients of EGO.  Solvers that
+   do not exist in this configuration are ignored, since a profile
+   depends on the host rather than on the configuration. */
+int X(costmodel_import)(planner *ego, scanner *sc)
+{
+     char buf[MAXNAM + 1];
+     int reg_id, c[NCOEF];
+     unsigned s, n = 0, nalloc = 0;
+     coefs *cf = 0;
+     unsigned *ndx = 0;
+     cost_model *m;
+
+     if (!sc->scan(sc, "(" PROFILE_PREAMBLE))
+	  return 0;
+
+     while (!sc->scan(sc, ")")) {
+	  int j;
+
+	  if (!sc->scan(sc, "(%*s %d %d %d %d)",
+			MAXNAM, buf, &reg_id, c + 0, c + 1, c + 2))
+	       goto bad;
+	  for (j = 0; j < NCOEF; ++j)
+	       if (c[j] < 0)
+		    goto bad;
+
+	  s = lookup(ego, buf, reg_id);
+	  if (s >= ego->nslvdesc)
+	       continue;
+
+	  if (n >= nalloc) {
+	       unsigned i;
+	       coefs *ncf;
+	       unsigned *nndx;
+	       nalloc = 2 * nalloc + 64;
+	       ncf = (coefs *)MALLOC(nalloc * sizeof(coefs), OTHER);
+	       nndx = (unsigned *)MALLOC(nalloc * sizeof(unsigned), OTHER);
+	       for (i = 0; i < n; ++i) {
+		    ncf[i] = cf[i];
+		    nndx[i] = ndx[i];
+	       }
+	       X(ifree0)(cf);
+	       X(ifree0)(ndx);
+	       cf = ncf;
+	       ndx = nndx;
+	  }
+	  ndx[n] = s;
+	  cf[n].valid = 1;
+	  for (j = 0; j < NCOEF; ++j)
+	       cf[n].c[j] = c[j] / CSCALE;
+	  ++n;
+     }
+
+     X(planner_lock)(ego);
+     m = mkmodel(ego);
+     grow_coefs(ego, m);
+     for (s = 0; s < m->ncf; ++s)
+	  m->cf[s].valid = 0;
+     for (s = 0; s < n; ++s)
+	  m->cf[ndx[s]] = cf[s];
+     m->nvalid = 0;
+     for (s = 0; s < m->ncf; ++s)
+	  m->nvalid += m->cf[s].valid;
+     X(planner_unlock)(ego);
+
+     X(ifree0)(cf);
+     X(ifree0)(ndx);
+     return 1;
+
+ bad:
+     X(ifree0)(cf);
+     X(ifree0)(ndx);
+     return 0;
+}
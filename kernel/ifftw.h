@@ -59,6 +59,18 @@ extern "C"
 #  define IFFTW_EXTERN extern
 #endif
 
+/* storage class of per-thread variables, if the compiler has one */
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#  define THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#  define THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L \
+     && !defined(__STDC_NO_THREADS__)
+#  define THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#  define THREAD_LOCAL __thread
+#endif
+
 /* determine precision and name-mangling scheme */
 #define CONCAT(prefix, name) prefix ## name
 #if defined(FFTW_SINGLE)
@@ -213,6 +225,33 @@ void *alloca(size_t);
      }						\
 }
 
+/* the same for the apply() of plan EGO, which takes large buffers
+   from its scratch (see scratch.c) */
+#define PLAN_BUF_ALLOC(ego, T, p, n)		\
+{						\
+     if ((n) < MAX_STACK_ALLOC) {			\
+	  STACK_MALLOC(T, p, n);		\
+     } else {					\
+	  p = (T)X(scratch_get)(ego, n);	\
+     }						\
+}
+
+#define PLAN_BUF_FREE(ego, p, n)		\
+{						\
+     if ((n) < MAX_STACK_ALLOC) {			\
+	  STACK_FREE(p);			\
+     } else {					\
+	  X(scratch_put)(ego, p);		\
+     }						\
+}
+
+/* reserve the scratch for PLAN_BUF_ALLOC */
+#define PLAN_BUF_SCRATCH(ego, plnr, n)			\
+{							\
+     if ((n) >= MAX_STACK_ALLOC)			\
+	  X(plan_scratch)(ego, plnr, n);		\
+}
+
 /*-----------------------------------------------------------------------*/
 /* define uintptr_t if it is not already defined */
 
@@ -265,6 +304,12 @@ extern void X(debug)(const char *format, ...);
 extern void *X(kernel_malloc)(size_t n);
 extern void X(kernel_free)(void *p);
 
+/*-----------------------------------------------------------------------*/
+/* numa.c: */
+extern int X(numa_node)(void);
+extern void X(numa_bind)(void *p, size_t n, int node);
+extern void *X(kernel_malloc_onnode)(size_t n, int node);
+
 /*-----------------------------------------------------------------------*/
 /* alloc.c: */
 
@@ -325,6 +370,7 @@ IFFTW_EXTERN void *X(malloc_plain)(size_t sz);
 crude_time X(get_crude_time)(void);
 double X(elapsed_since)(const planner *plnr, const problem *p,
 			crude_time t0); /* time in seconds since t0 */
+double X(elapsed_since_local)(crude_time t0);
 
 /*-----------------------------------------------------------------------*/
 /* ops.c: */
@@ -338,6 +384,12 @@ typedef struct {
      double mul;
      double fma;
      double other;
+
+     /* for the learned estimator (see costmodel.c): the estimated
+	cost of the plan, and the flops and other operations above
+	that the estimate already accounts for */
+     double est;
+     double cflops, cother;
 } opcnt;
 
 void X(ops_zero)(opcnt *dst);
@@ -484,6 +536,10 @@ enum {
      PROBLEM_DFT, 
      PROBLEM_RDFT,
      PROBLEM_RDFT2,
+     PROBLEM_CZT,
+     PROBLEM_DFT_PRUNED,
+     PROBLEM_CONV,
+     PROBLEM_EDGE,
 
      /* for mpi/ subdirectory */
      PROBLEM_MPI_DFT,
@@ -500,6 +556,11 @@ typedef struct {
      void (*zero) (const problem *ego);
      void (*print) (const problem *ego, printer *p);
      void (*destroy) (problem *ego);
+
+     /* the size and vector tensors of the problem, or 0 if the
+	problem has none.  Used by the learned estimator. */
+     void (*tensors) (const problem *ego, 
+		      const tensor **sz, const tensor **vecsz);
 } problem_adt;
 
 struct problem_s {
@@ -519,6 +580,10 @@ struct printer_s {
      void (*cleanup)(printer *p);
      int indent;
      int indent_incr;
+
+     /* if nonzero, prints the plans of %p instead of print(),
+	see profile.c */
+     void (*print_plan)(printer *p, plan *x);
 };
 
 printer *X(mkprinter)(size_t size, 
@@ -555,12 +620,26 @@ typedef struct {
      void (*destroy)(plan *ego);
 } plan_adt;
 
+typedef struct plan_profile_s plan_profile;
+typedef struct scratch_pool_s scratch_pool;
+
 struct plan_s {
      const plan_adt *adt;
      opcnt ops;
      double pcost;
      enum wakefulness wakefulness; /* used for debugging only */
      int could_prune_now_p;
+
+     /* scratch needed by apply(), see scratch.c */
+     size_t scratchsz;
+     size_t scratchoff; /* in the caller's workspace */
+     scratch_pool *scratch; /* reserved while awake, or 0 */
+     int scratch_reserve;
+
+     /* execution profile, see profile.c */
+     void (*profile)(plan *ego, int on); /* wraps apply(), or 0 */
+     plan_profile *prof;  /* counters while profiled, or 0 */
+     double footprint;    /* bytes read and written by apply(), or 0 */
 };
 
 plan *X(mkplan)(size_t size, const plan_adt *adt);
@@ -568,6 +647,32 @@ void X(plan_destroy_internal)(plan *ego);
 IFFTW_EXTERN void X(plan_awake)(plan *ego, enum wakefulness wakefulness);
 void X(plan_null_destroy)(plan *ego);
 
+/*-----------------------------------------------------------------------*/
+/* profile.c */
+struct plan_profile_s {
+     void (*apply)(void); /* the apply() that the profile() hook wraps */
+     double time;         /* in the units of X(profile_now) */
+     double calls;
+     double self, root;   /* for printing */
+};
+
+void X(profile_tree)(plan *ego, int on);
+void X(profile_print_tree)(plan *ego, printer *p);
+double X(profile_now)(void);
+void X(profile_account)(plan_profile *pr, double t0);
+double X(profile_footprint)(const problem *p);
+
+/*-----------------------------------------------------------------------*/
+/* scratch.c */
+IFFTW_EXTERN void X(plan_scratch)(plan *ego, const planner *plnr, size_t n);
+void X(scratch_awake)(plan *ego, enum wakefulness wakefulness);
+IFFTW_EXTERN void *X(scratch_get)(const plan *ego, size_t n);
+IFFTW_EXTERN void X(scratch_put)(const plan *ego, void *p);
+void X(scratch_layout_begin)(size_t *wssz, int nthr);
+void X(scratch_layout_end)(void);
+IFFTW_EXTERN void *X(scratch_bind)(void *ws);
+IFFTW_EXTERN void *X(scratch_workspace)(void);
+
 /*-----------------------------------------------------------------------*/
 /* solver.c: */
 typedef struct {
@@ -683,6 +788,7 @@ enum {
 #define CONSERVE_MEMORYP(plnr) (PLNR_L(plnr) & CONSERVE_MEMORY)
 #define NO_DHT_R2HCP(plnr) (PLNR_L(plnr) & NO_DHT_R2HC)
 #define NO_BUFFERINGP(plnr) (PLNR_L(plnr) & NO_BUFFERING)
+#define NO_EXECUTE_ALLOCP(plnr) ((plnr)->no_execute_alloc)
 
 typedef enum { FORGET_ACCURSED, FORGET_EVERYTHING } amnesia;
 
@@ -725,6 +831,54 @@ typedef struct {
 
 typedef enum { COST_SUM, COST_MAX } cost_kind;
 
+/* The solver and flags chosen by each call to the planner while a
+   plan is created from wisdom, in call order.  Replaying the trace
+   recreates the plan without searching or hashing.  See planner.c */
+typedef struct {
+     flags_t *step;    /* flags and SLVNDX of each call */
+     unsigned n, nalloc;
+     unsigned pos;     /* next step to replay */
+     int nthr;         /* of the top-level call */
+     unsigned flags;   /* API flags of the top-level call */
+     int replay;       /* replay the trace, rather than record it */
+     int ok;           /* 0 if the trace is unusable */
+} plan_trace;
+
+plan_trace *X(mktrace)(void);
+void X(trace_destroy)(plan_trace *t);
+unsigned X(trace_push)(plan_trace *t);
+
+/* costmodel.c: per-solver coefficients for the estimator, fitted
+   to measurements on the host */
+typedef struct cost_model_s cost_model;
+
+void X(costmodel_attribute)(planner *ego, plan *pln, const problem *p,
+			    unsigned slvndx);
+int X(costmodel_estimatingp)(const planner *ego);
+int X(costmodel_recordingp)(const planner *ego);
+void X(costmodel_record)(planner *ego, int on);
+int X(costmodel_fit)(planner *ego);
+void X(costmodel_forget)(planner *ego);
+void X(costmodel_export)(planner *ego, printer *p);
+int X(costmodel_import)(planner *ego, scanner *sc);
+
+/* planlog.c: statistics and trace of the planner */
+typedef struct planlog_s planlog;
+
+int X(planlog_recordingp)(const planner *ego);
+double X(planlog_now)(const planner *ego);
+void X(planlog_problem)(planner *ego, const problem *p, const plan *pln,
+			unsigned slvndx, int wisdomp, double t0);
+void X(planlog_solver)(planner *ego, unsigned slvndx, const plan *pln,
+		       double t0);
+void X(planlog_measure)(planner *ego, unsigned slvndx, const plan *pln,
+			double t0);
+void X(planlog_timeout)(planner *ego);
+void X(planlog_record)(planner *ego, int on);
+void X(planlog_forget)(planner *ego);
+void X(planlog_export_stats)(planner *ego, printer *p);
+void X(planlog_export_trace)(planner *ego, printer *p);
+
 struct planner_s {
      const planner_adt *adt;
      void (*hook)(struct planner_s *plnr, plan *pln, 
@@ -745,23 +899,66 @@ struct planner_s {
 
      hashtab htab_blessed;
      hashtab htab_unblessed;
+     hashtab htab_mapped; /* read-only, see X(planner_map_wisdom) */
+     const void *mapped;
+     size_t mappedsz;
+     void (*unmap_hook)(const void *img, size_t len);
 
      int nthr;
      flags_t flags;
+     int no_execute_alloc; /* plans reserve their scratch, see scratch.c */
 
      crude_time start_time;
      double timelimit; /* elapsed_since(start_time) at which to bail out */
      int timed_out; /* whether most recent search timed out */
      int need_timeout_check;
+     int (*cancel_hook)(void *data); /* nonzero: stop as if timed out */
+     void *cancel_data;
+     int robust_timing; /* see X(measure_execution_time_err) */
+     double tick_rate;  /* ticks per second, for ROBUST_TIMING > 1 */
 
      /* various statistics */
      int nplan;    /* number of plans evaluated */
      double pcost, epcost; /* total pcost of measured/estimated plans */
      int nprob;    /* number of problems evaluated */
+
+     /* views and concurrent search, see planner.c.  The hooks are
+	installed by the threads library. */
+     struct planner_s *root; /* owner of the hash tables, EGO unless
+				EGO is a view */
+     int nsearch;  /* max # of threads searching at the top level */
+     void (*spawn_hook)(int nthr, void (*work)(void *data, int thr),
+			void *data);
+     void (*timing_lock_hook)(void);   /* one timing at a time, see */
+     void (*timing_unlock_hook)(void); /* search_par() */
+     /* a copy of P on private arrays, or 0; installed by the api */
+     problem *(*shadow_hook)(const problem *p, void **buf);
+     void (*lock_hook)(void);
+     void (*unlock_hook)(void);
+     void (*rdlock_hook)(void);
+     void (*rdunlock_hook)(void);
+
+     plan_trace *trace; /* if nonzero, record or replay the calls */
+
+     cost_model *cmodel; /* learned estimator, or 0, see costmodel.c */
+
+     planlog *log;  /* statistics and trace, or 0, see planlog.c */
+     int log_depth; /* nesting of the calls to mkplan() */
+     int log_tid;   /* 0, or the search thread of a view */
 };
 
 planner *X(mkplanner)(void);
 void X(planner_destroy)(planner *ego);
+planner *X(mkplanner_view)(planner *ego);
+void X(planner_destroy_view)(planner *v);
+void X(planner_lock)(const planner *ego);
+void X(planner_unlock)(const planner *ego);
+void X(planner_rdlock)(const planner *ego);
+void X(planner_rdunlock)(const planner *ego);
+void X(planner_signature)(planner *ego, md5 *m);
+size_t X(planner_wisdom_image)(planner *ego, void *buf, size_t len);
+int X(planner_map_wisdom)(planner *ego, const void *img, size_t len,
+			  void (*unmap_hook)(const void *img, size_t len));
 
 /*
   Iterate over all solvers.   Read:
@@ -886,13 +1083,23 @@ typedef struct twid_s {
      int refcnt;
      const tw_instr *instr;
      struct twid_s *cdr;
+     size_t bytes;             /* size of W */
      enum wakefulness wakefulness;
+     int node;                 /* NUMA node where W was first touched */
 } twid;
 
 INT X(twiddle_length)(INT r, const tw_instr *p);
 void X(twiddle_awake)(enum wakefulness wakefulness,
 		      twid **pp, const tw_instr *instr, INT n, INT r, INT m);
 
+/* statistics of the shared tables of twiddle.c and trig.c */
+typedef struct {
+     double hit, miss;         /* lookups that found/computed a table */
+     double nelem, bytes;      /* tables currently held, and their size */
+} table_stats;
+
+IFFTW_EXTERN void X(twiddle_stats)(table_stats *st);
+
 /*-----------------------------------------------------------------------*/
 /* trig.c */
 #if defined(TRIGREAL_IS_LONG_DOUBLE)
@@ -915,10 +1122,18 @@ struct triggen_s {
      INT twmsk;
      trigreal *W0, *W1;
      INT n;
+
+     /* generators are shared, see trig.c */
+     enum wakefulness wakefulness;
+     int refcnt;
+     triggen *cdr;
 };
 
 triggen *X(mktriggen)(enum wakefulness wakefulness, INT n);
 void X(triggen_destroy)(triggen *p);
+void X(triggen_cleanup)(void);
+IFFTW_EXTERN void X(triggen_stats)(table_stats *st);
+void X(cpow)(trigreal zr, trigreal zi, trigreal t, trigreal *res);
 
 /*-----------------------------------------------------------------------*/
 /* primes.c: */
@@ -1018,6 +1233,9 @@ extern unsigned X(random_estimate_seed);
 
 double X(measure_execution_time)(const planner *plnr, 
 				 plan *pln, const problem *p);
+double X(measure_execution_time_err)(const planner *plnr, plan *pln,
+				     const problem *p, double *err);
+double X(tick_rate)(void);
 IFFTW_EXTERN int X(ialignment_of)(R *p);
 unsigned X(hash)(const char *s);
 INT X(nbuf)(INT n, INT vl, INT maxnbuf);
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/* NUMA placement.  On a NUMA machine, a page of memory lives on the
+   node of the thread that first touches it, unless told otherwise.
+   Both routines below are hints: they do nothing on systems where we
+   don't know how to do it, which is fine since FFTW's results never
+   depend on where the memory lives. */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE /* for syscall() */
+#endif
+
+#include "kernel/ifftw.h"
+
+#if defined(__linux__) && defined(HAVE_UNISTD_H)
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif
+
+#define NUMA_MAXNODE 1024
+
+static int query_node(void)
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+     unsigned cpu, node;
+     if (syscall(SYS_getcpu, &cpu, &node, (void *)0) == 0
+	 && node < NUMA_MAXNODE)
+	  return (int)node;
+#endif
+     return 0;
+}
+
+/* NUMA node of the CPU on which the calling thread is running, or 0
+   if unknown.  Every twiddle awake asks, so we cache the answer of
+   the system per thread, and ask again only every NUMA_REFRESH calls
+   in case the thread has migrated.  The workers of the pool do not
+   migrate once X(threads_set_affinity) has pinned them, and for the
+   others the node only matters for the speed. */
+#define NUMA_REFRESH 256
+
+#ifdef THREAD_LOCAL
+static THREAD_LOCAL int cached_node;
+static THREAD_LOCAL int ncached; /* calls left before we ask again */
+
+int X(numa_node)(void)
+{
+     if (ncached-- <= 0) {
+	  cached_node = query_node();
+	  ncached = NUMA_REFRESH - 1;
+     }
+     return cached_node;
+}
+#else
+int X(numa_node)(void)
+{
+     return query_node();
+}
+#endif
+
+/* ask the operating system to place the pages entirely contained in
+   [P, P + N) on NODE, moving them there if they already exist */
+void X(numa_bind)(void *p, size_t n, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind) && defined(_SC_PAGESIZE)
+     /* constants from <linux/mempolicy.h> */
+     const int mpol_preferred = 1, mpol_mf_move = 2;
+     unsigned long mask[NUMA_MAXNODE / (8 * sizeof(unsigned long))];
+     const size_t nbits = 8 * sizeof(unsigned long);
+     uintptr_t pgsz, lo, hi;
+     size_t i;
+
+     if (!p || node < 0 || node >= NUMA_MAXNODE)
+	  return;
+
+     pgsz = (uintptr_t)sysconf(_SC_PAGESIZE);
+     if (pgsz <= 0)
+	  return;
+
+     /* whole pages only, lest we move somebody else's data */
+     lo = ((uintptr_t)p + pgsz - 1) & ~(pgsz - 1);
+     hi = ((uintptr_t)p + n) & ~(pgsz - 1);
+     if (hi <= lo)
+	  return;
+
+     for (i = 0; i < sizeof(mask) / sizeof(mask[0]); ++i)
+	  mask[i] = 0;
+     mask[node / nbits] |= 1UL << (node % nbits);
+
+     /* MPOL_PREFERRED rather than MPOL_BIND: if NODE is full, we
+	would rather have remote memory than no memory.  Failure
+	(e.g. no NUMA support in the kernel) is harmless. */
+     (void)syscall(SYS_mbind, (void *)lo, (unsigned long)(hi - lo),
+		   mpol_preferred, mask, (unsigned long)(NUMA_MAXNODE + 1),
+		   (unsigned)mpol_mf_move);
+#else
+     UNUSED(p); UNUSED(n); UNUSED(node);
+#endif
+}
+
+void *X(kernel_malloc_onnode)(size_t n, int node)
+{
+     void *p = X(kernel_malloc)(n);
+     X(numa_bind)(p, n, node);
+     return p;
+}
@@ -24,6 +24,7 @@
 void X(ops_zero)(opcnt *dst)
 {
      dst->add = dst->mul = dst->fma = dst->other = 0;
+     dst->est = dst->cflops = dst->cother = 0;
 }
 
 void X(ops_cpy)(const opcnt *src, opcnt *dst)
@@ -43,6 +44,9 @@ void X(ops_madd)(INT m, const opcnt *a, const opcnt *b, opcnt *dst)
      dst->mul = m * a->mul + b->mul;
      dst->fma = m * a->fma + b->fma;
      dst->other = m * a->other + b->other;
+     dst->est = m * a->est + b->est;
+     dst->cflops = m * a->cflops + b->cflops;
+     dst->cother = m * a->cother + b->cother;
 }
 
 void X(ops_add)(const opcnt *a, const opcnt *b, opcnt *dst)
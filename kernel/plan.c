@@ -35,6 +35,13 @@ plan *X(mkplan)(size_t size, const plan_adt *adt)
      p->pcost = 0.0;
      p->wakefulness = SLEEPY;
      p->could_prune_now_p = 0;
+     p->scratchsz = 0;
+     p->scratchoff = 0;
+     p->scratch = 0;
+     p->scratch_reserve = 0;
+     p->profile = 0;
+     p->prof = 0;
+     p->footprint = 0.0;
      
      return p;
 }
@@ -47,6 +54,7 @@ void X(plan_destroy_internal)(plan *ego)
      if (ego) {
 	  A(ego->wakefulness == SLEEPY);
           ego->adt->destroy(ego);
+	  X(ifree0)(ego->prof);
 	  X(ifree)(ego);
      }
 }
@@ -64,6 +72,7 @@ void X(plan_awake)(plan *ego, enum wakefulness wakefulness)
 	  A(((wakefulness == SLEEPY) ^ (ego->wakefulness == SLEEPY)));
 	  
 	  ego->adt->awake(ego, wakefulness);
+	  X(scratch_awake)(ego, wakefulness);
 	  ego->wakefulness = wakefulness;
      }
 }
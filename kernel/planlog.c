@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Statistics and trace of the planner.
+
+   While recording, the planner logs an event for each call to
+   mkplan(), for each call to a solver, and for each measurement of a
+   plan, and it counts the timeouts.  Together with the counters that
+   the planner maintains anyway (problems, plans, hash tables), taken
+   relative to their values when the recording began, the log tells
+   where the planning time goes: which solvers were tried, how long
+   they took including their children, how long was spent timing
+   plans, and which solver won each subproblem at what cost.
+
+   The log is exported either as a JSON summary, or as a trace in the
+   ``Trace Event'' format of Chrome, in which every event is a
+   complete event ("ph": "X"), nested by time within the thread that
+   planned it.  The views of a concurrent search (see planner.c) get
+   threads of their own. */
+
+#include "kernel/ifftw.h"
+#include <string.h>
+
+enum { EV_PROBLEM, EV_SOLVER, EV_MEASURE };
+
+typedef struct {
+     int kind;
+     unsigned slvndx;   /* >= nslvdesc if none */
+     char *prb;         /* printed problem of EV_PROBLEM */
+     int depth, tid;
+     int okp;           /* whether there is a plan */
+     int wisdomp;       /* whether the solver came from the wisdom */
+     double t0, dur;    /* seconds since the recording began */
+     double cost;       /* pcost of the plan, 0 if never evaluated */
+} event;
+
+struct planlog_s {
+     int recording;
+     crude_time start;
+     double stop;
+     int ntimeout;
+
+     /* statistics of the planner when the recording began */
+     int nplan, nprob;
+     double pcost, epcost;
+     hashtab ht[3];
+
+     event *ev;
+     unsigned nev, nevalloc;
+};
+
+int X(planlog_recordingp)(const planner *ego)
+{
+     return ego->log && ego->log->recording;
+}
+
+double X(planlog_now)(const planner *ego)
+{
+     return X(planlog_recordingp)(ego) ? 
+	  X(elapsed_since_local)(ego->log->start) : 0.0;
+}
+
+static void free_events(planlog *l)
+{
+     unsigned i;
+     for (i = 0; i < l->nev; ++i)
+	  X(ifree0)(l->ev[i].prb);
+     X(ifree0)(l->ev);
+     l->ev = 0;
+     l->nev = l->nevalloc = 0;
+}
+
+static void add_event(planner *ego, int kind, unsigned slvndx, char *prb,
+		      const plan *pln, int wisdomp, double t0)
+{
+     planlog *l = ego->log;
+     double t1 = X(planlog_now)(ego);
+     event *e;
+
+     X(planner_lock)(ego);
+     if (l->nev >= l->nevalloc) {
+	  unsigned i, nalloc = 2 * l->nevalloc + 256;
+	  event *ev = (event *)MALLOC(nalloc * sizeof(event), OTHER);
+	  for (i = 0; i < l->nev; ++i)
+	       ev[i] = l->ev[i];
+	  X(ifree0)(l->ev);
+	  l->ev = ev;
+	  l->nevalloc = nalloc;
+     }
+     e = l->ev + l->nev++;
+     e->kind = kind;
+     e->slvndx = slvndx;
+     e->prb = prb;
+     e->depth = ego->log_depth;
+     e->tid = ego->log_tid;
+     e->okp = pln != 0;
+     e->wisdomp = wisdomp;
+     e->t0 = t0;
+     e->dur = t1 - t0;
+     e->cost = pln ? pln->pcost : 0.0;
+     X(planner_unlock)(ego);
+}
+
+/* printer into a growing string */
+typedef struct {
+     printer super;
+     char *s;
+     size_t len, alloc;
+} P;
+
+static void putchr_grow(printer *p_, char c)
+{
+     P *p = (P *) p_;
+     if (p->len + 1 >= p->alloc) {
+	  size_t alloc = 2 * p->alloc + 64;
+	  char *s = (char *)MALLOC(alloc, OTHER);
+	  if (p->s)
+	       memcpy(s, p->s, p->len);
+	  X(ifree0)(p->s);
+	  p->s = s;
+	  p->alloc = alloc;
+     }
+     p->s[p->len++] = c;
+     p->s[p->len] = 0;
+}
+
+static char *problem_string(const problem *prb)
+{
+     P *p = (P *) X(mkprinter)(sizeof(P), putchr_grow, 0);
+     char *s;
+     p->s = 0;
+     p->len = p->alloc = 0;
+     prb->adt->print(prb, &p->super);
+     s = p->s;
+     X(printer_destroy)(&p->super);
+     return s;
+}
+
+void X(planlog_problem)(planner *ego, const problem *p, const plan *pln,
+			unsigned slvndx, int wisdomp, double t0)
+{
+     if (X(planlog_recordingp)(ego))
+	  add_event(ego, EV_PROBLEM, pln ? slvndx : ego->nslvdesc,
+		    problem_string(p), pln, wisdomp, t0);
+}
+
+void X(planlog_solver)(planner *ego, unsigned slvndx, const plan *pln,
+		       double t0)
+{
+     if (X(planlog_recordingp)(ego))
+	  add_event(ego, EV_SOLVER, slvndx, 0, pln, 0, t0);
+}
+
+void X(planlog_measure)(planner *ego, unsigned slvndx, const plan *pln,
+			double t0)
+{
+     if (X(planlog_recordingp)(ego))
+	  add_event(ego, EV_MEASURE, slvndx, 0, pln, 0, t0);
+}
+
+void X(planlog_timeout)(planner *ego)
+{
+     if (X(planlog_recordingp)(ego)) {
+	  X(planner_lock)(ego);
+	  ++ego->log->ntimeout;
+	  X(planner_unlock)(ego);
+     }
+}
+
+/* Start recording, discarding the previous log, or stop. */
+void X(planlog_record)(planner *ego, int on)
+{
+     planlog *l = ego->log;
+
+     if (on) {
+	  if (!l) {
+	       l = (planlog *)MALLOC(sizeof(planlog), OTHER);
+	       l->ev = 0;
+	       l->nev = l->nevalloc = 0;
+	       ego->log = l;
+	  }
+	  free_events(l);
+	  l->start = X(get_crude_time)();
+	  l->stop = 0;
+	  l->ntimeout = 0;
+	  l->nplan = ego->nplan;
+	  l->nprob = ego->nprob;
+	  l->pcost = ego->pcost;
+	  l->epcost = ego->epcost;
+	  l->ht[0] = ego->htab_blessed;
+	  l->ht[1] = ego->htab_unblessed;
+	  l->ht[2] = ego->htab_mapped;
+	  l->recording = 1;
+     } else if (l && l->recording) {
+	  l->stop = X(planlog_now)(ego);
+	  l->recording = 0;
+     }
+}
+
+void X(planlog_forget)(planner *ego)
+{
+     planlog *l = ego->log;
+     if (l) {
+	  free_events(l);
+	  X(ifree)(l);
+	  ego->log = 0;
+     }
+}
+
+/*
+ * export
+ */
+
+static void jstr(printer *p, const char *s)
+{
+     p->putchr(p, '"');
+     for (; *s; ++s) {
+	  if (*s == '"' || *s == '\\')
+	       p->putchr(p, '\\');
+	  p->putchr(p, (*s >= 0 && *s < ' ') ? ' ' : *s);
+     }
+     p->putchr(p, '"');
+}
+
+static void jsolver(planner *ego, printer *p, unsigned slvndx)
+{
+     if (slvndx < ego->nslvdesc) {
+	  jstr(p, ego->slvdescs[slvndx].reg_nam);
+	  p->print(p, ", \"id\": %d", ego->slvdescs[slvndx].reg_id);
+     } else
+	  p->print(p, "null");
+}
+
+static void jhashtab(printer *p, const char *nam, const hashtab *h, 
+		     const hashtab *h0, const char *sep)
+{
+     p->print(p, "    \"%s\": {\"lookups\": %d, \"hits\": %d, "
+	      "\"misses\": %d, \"lookup_probes\": %d, \"inserts\": %d, "
+	      "\"insert_probes\": %d, \"insert_unknown\": %d, "
+	      "\"rehashes\": %d}%s\n",
+	      nam, h->lookup - h0->lookup, h->succ_lookup - h0->succ_lookup,
+	      (h->lookup - h->succ_lookup) - (h0->lookup - h0->succ_lookup),
+	      h->lookup_iter - h0->lookup_iter, h->insert - h0->insert,
+	      h->insert_iter - h0->insert_iter,
+	      h->insert_unknown - h0->insert_unknown,
+	      h->nrehash - h0->nrehash, sep);
+}
+
+typedef struct {
+     int tried, applicable, wins, nmeasure;
+     double time, tmeasure;
+} slvstats;
+
+void X(planlog_export_stats)(planner *ego, printer *p)
+{
+     planlog *l = ego->log;
+     slvstats *st;
+     double tmeasure = 0;
+     unsigned i, n = ego->nslvdesc;
+     const char *sep;
+
+     if (!l) {
+	  p->print(p, "{}\n");
+	  return;
+     }
+
+     X(planner_rdlock)(ego);
+     st = (slvstats *)MALLOC((n + 1) * sizeof(slvstats), OTHER);
+     memset(st, 0, (n + 1) * sizeof(slvstats));
+     for (i = 0; i < l->nev; ++i) {
+	  const event *e = l->ev + i;
+	  slvstats *s = st + (e->slvndx < n ? e->slvndx : n);
+	  switch (e->kind) {
+	      case EV_PROBLEM:
+		   s->wins += e->okp;
+		   break;
+	      case EV_SOLVER:
+		   ++s->tried;
+		   s->applicable += e->okp;
+		   s->time += e->dur;
+		   break;
+	      case EV_MEASURE:
+		   ++s->nmeasure;
+		   s->tmeasure += e->dur;
+		   tmeasure += e->dur;
+		   break;
+	  }
+     }
+
+     p->print(p, "{\n  \"wall_time\": %g,\n",
+	      l->recording ? X(planlog_now)(ego) : l->stop);
+     p->print(p, "  \"problems\": %d,\n  \"plans_evaluated\": %d,\n",
+	      ego->nprob - l->nprob, ego->nplan - l->nplan);
+     p->print(p, "  \"measured_cost\": %g,\n  \"estimated_cost\": %g,\n",
+	      ego->pcost - l->pcost, ego->epcost - l->epcost);
+     p->print(p, "  \"measure_time\": %g,\n  \"timeouts\": %d,\n",
+	      tmeasure, l->ntimeout);
+
+     p->print(p, "  \"hashtables\": {\n");
+     jhashtab(p, "blessed", &ego->htab_blessed, l->ht + 0, ",");
+     jhashtab(p, "unblessed", &ego->htab_unblessed, l->ht + 1, ",");
+     jhashtab(p, "mapped", &ego->htab_mapped, l->ht + 2, "");
+     p->print(p, "  },\n");
+
+     p->print(p, "  \"solvers\": [");
+     for (sep = "\n", i = 0; i < n; ++i) {
+	  const slvstats *s = st + i;
+	  if (s->tried || s->wins) {
+	       p->print(p, "%s    {\"name\": ", sep);
+	       jsolver(ego, p, i);
+	       p->print(p, ", \"tried\": %d, \"applicable\": %d, "
+			"\"wins\": %d, \"time\": %g, \"measurements\": %d, "
+			"\"measure_time\": %g}",
+			s->tried, s->applicable, s->wins, s->time,
+			s->nmeasure, s->tmeasure);
+	       sep = ",\n";
+	  }
+     }
+     p->print(p, "\n  ],\n");
+
+     p->print(p, "  \"subproblems\": [");
+     for (sep = "\n", i = 0; i < l->nev; ++i) {
+	  const event *e = l->ev + i;
+	  if (e->kind == EV_PROBLEM) {
+	       p->print(p, "%s    {\"problem\": ", sep);
+	       jstr(p, e->prb ? e->prb : "");
+	       p->print(p, ", \"depth\": %d, \"solver\": ", e->depth);
+	       jsolver(ego, p, e->slvndx);
+	       p->print(p, ", \"wisdom\": %s, \"time\": %g, \"cost\": ",
+			e->wisdomp ? "true" : "false", e->dur);
+	       if (e->cost > 0)
+		    p->print(p, "%g}", e->cost);
+	       else
+		    p->print(p, "null}");
+	       sep = ",\n";
+	  }
+     }
+     p->print(p, "\n  ]\n}\n");
+
+     X(ifree)(st);
+     X(planner_rdunlock)(ego);
+}
+
+static INT usec(double t)
+{
+     return (INT)(t * 1.0e6 + 0.5);
+}
+
+void X(planlog_export_trace)(planner *ego, printer *p)
+{
+     planlog *l = ego->log;
+     unsigned i;
+     const char *sep = "\n";
+     static const char *const cat[] = { "problem", "solver", "measure" };
+
+     p->print(p, "{\"traceEvents\": [");
+     if (l) {
+	  X(planner_rdlock)(ego);
+	  for (i = 0; i < l->nev; ++i) {
+	       const event *e = l->ev + i;
+	       p->print(p, "%s{\"name\": ", sep);
+	       if (e->kind == EV_PROBLEM)
+		    jstr(p, e->prb ? e->prb : "");
+	       else if (e->slvndx < ego->nslvdesc)
+		    jstr(p, ego->slvdescs[e->slvndx].reg_nam);
+	       else
+		    jstr(p, "?");
+	       p->print(p, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %D, "
+			"\"dur\": %D, \"pid\": 1, \"tid\": %d, \"args\": {",
+			cat[e->kind], usec(e->t0), usec(e->dur), e->tid);
+	       switch (e->kind) {
+		   case EV_PROBLEM:
+			p->print(p, "\"depth\": %d, \"solver\": ", e->depth);
+			jsolver(ego, p, e->slvndx);
+			p->print(p, ", \"wisdom\": %s",
+				 e->wisdomp ? "true" : "false");
+			break;
+		   case EV_SOLVER:
+			p->print(p, "\"id\": %d, \"applicable\": %s",
+				 e->slvndx < ego->nslvdesc ?
+				 ego->slvdescs[e->slvndx].reg_id : 0,
+				 e->okp ? "true" : "false");
+			break;
+	       }
+	       if (e->cost > 0)
+		    p->print(p, "%s\"cost\": %g", 
+			     e->kind == EV_MEASURE ? "" : ", ", e->cost);
+	       p->print(p, "}}");
+	       sep = ",\n";
+	  }
+	  X(planner_rdunlock)(ego);
+     }
+     p->print(p, "\n],\n\"displayTimeUnit\": \"ms\"}\n");
+}
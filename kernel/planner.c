@@ -20,6 +20,7 @@
 
 #include "kernel/ifftw.h"
 #include <string.h>
+#include <math.h>
 
 /* GNU Coding Standards, Sec. 5.2: "Please write the comments in a GNU
    program in English, because English is the one language that nearly
@@ -198,15 +199,19 @@ static void sigcpy(const md5sig a, md5sig b)
 struct solution_s {
      md5sig s;
      flags_t flags;
+     float pcost; /* of the plan, if measured by this process, else 0 */
 };
 
-static solution *htab_lookup(hashtab *ht, const md5sig s, 
+/* STATS receives the statistics of the lookup.  It is HT itself,
+   unless HT is shared with other threads, in which case it is a
+   private copy (see hlookup0()) */
+static solution *htab_lookup(hashtab *ht, hashtab *stats, const md5sig s, 
 			     const flags_t *flagsp)
 {
      unsigned g, h = h1(ht, s), d = h2(ht, s);
      solution *best = 0;
 
-     ++ht->lookup;
+     ++stats->lookup;
 
      /* search all entries that match; select the one with
 	the lowest flags.u */
@@ -217,7 +222,7 @@ static solution *htab_lookup(hashtab *ht, const md5sig s,
      g = h;
      do {
 	  solution *l = ht->solutions + g;
-	  ++ht->lookup_iter;
+	  ++stats->lookup_iter;
 	  if (VALIDP(l)) {
 	       if (LIVEP(l)
 		   && md5eq(s, l->s)
@@ -232,20 +237,46 @@ static solution *htab_lookup(hashtab *ht, const md5sig s,
      } while (g != h);
 
      if (best) 
-	  ++ht->succ_lookup;
+	  ++stats->succ_lookup;
      return best;
 }
 
-static solution *hlookup(planner *ego, const md5sig s, 
-			 const flags_t *flagsp)
+/* The tables belong to EGO->ROOT, and the caller holds a lock on
+   them.  The statistics go to the tables of EGO, which in a view
+   are private copies that hold no solutions.  The mapped wisdom, if
+   any, comes after the blessed table, which overlays it. */
+static solution *hlookup0(planner *ego, const md5sig s, 
+			  const flags_t *flagsp)
 {
-     solution *sol = htab_lookup(&ego->htab_blessed, s, flagsp);
-     if (!sol) sol = htab_lookup(&ego->htab_unblessed, s, flagsp);
+     planner *r = ego->root;
+     solution *sol;
+
+     sol = htab_lookup(&r->htab_blessed, &ego->htab_blessed, s, flagsp);
+     if (!sol && r->htab_mapped.hashsiz)
+	  sol = htab_lookup(&r->htab_mapped, &ego->htab_mapped, s, flagsp);
+     if (!sol) 
+	  sol = htab_lookup(&r->htab_unblessed, &ego->htab_unblessed, 
+			    s, flagsp);
      return sol;
 }
 
+/* Copy the best solution for S into *SOLP, and return whether there
+   is one.  We return a copy rather than a pointer into the table,
+   which other threads may rehash at any time. */
+static int hlookup(planner *ego, const md5sig s, 
+		   const flags_t *flagsp, solution *solp)
+{
+     solution *sol;
+
+     X(planner_rdlock)(ego);
+     sol = hlookup0(ego, s, flagsp);
+     if (sol) *solp = *sol;
+     X(planner_rdunlock)(ego);
+     return sol != 0;
+}
+
 static void fill_slot(hashtab *ht, const md5sig s, const flags_t *flagsp,
-		      unsigned slvndx, solution *slot)
+		      unsigned slvndx, double pcost, solution *slot)
 {
      ++ht->insert;
      ++ht->nelem;
@@ -255,6 +286,7 @@ static void fill_slot(hashtab *ht, const md5sig s, const flags_t *flagsp,
      slot->flags.timelimit_impatience = flagsp->timelimit_impatience;
      slot->flags.hash_info |= H_VALID | H_LIVE;
      SLVNDX(slot) = slvndx;
+     slot->pcost = (float) pcost;
 
      /* keep this check enabled in case we add so many solvers
 	that the bitfield overflows */
@@ -271,7 +303,7 @@ static void kill_slot(hashtab *ht, solution *slot)
 }
 
 static void hinsert0(hashtab *ht, const md5sig s, const flags_t *flagsp, 
-		     unsigned slvndx)
+		     unsigned slvndx, double pcost)
 {
      solution *l;
      unsigned g, h = h1(ht, s), d = h2(ht, s); 
@@ -286,7 +318,7 @@ static void hinsert0(hashtab *ht, const md5sig s, const flags_t *flagsp,
 	  A((g + d) % ht->hashsiz != h);
      }
 
-     fill_slot(ht, s, flagsp, slvndx, l);
+     fill_slot(ht, s, flagsp, slvndx, pcost, l);
 }
 
 static void rehash(hashtab *ht, unsigned nsiz)
@@ -311,7 +343,7 @@ static void rehash(hashtab *ht, unsigned nsiz)
      for (h = 0; h < osiz; ++h) {
 	  solution *l = osol + h;
 	  if (LIVEP(l))
-	       hinsert0(ht, l->s, &l->flags, SLVNDX(l));
+	       hinsert0(ht, l->s, &l->flags, SLVNDX(l), l->pcost);
      }
 
      X(ifree0)(osol);
@@ -345,7 +377,7 @@ static void hshrink(hashtab *ht)
 #endif
 
 static void htab_insert(hashtab *ht, const md5sig s, const flags_t *flagsp,
-			unsigned slvndx)
+			unsigned slvndx, double pcost)
 {
      unsigned g, h = h1(ht, s), d = h2(ht, s);
      solution *first = 0;
@@ -378,19 +410,49 @@ static void htab_insert(hashtab *ht, const md5sig s, const flags_t *flagsp,
 
      if (first) {
 	  /* overwrite FIRST */
-	  fill_slot(ht, s, flagsp, slvndx, first);
+	  fill_slot(ht, s, flagsp, slvndx, pcost, first);
      } else {
 	  /* create a new entry */
  	  hgrow(ht);
-	  hinsert0(ht, s, flagsp, slvndx);
+	  hinsert0(ht, s, flagsp, slvndx, pcost);
      }
 }
 
+/* a solution at least as good as FLAGSP in HT, or, for blessed
+   solutions, in the mapped wisdom that HT overlays */
+static solution *hlookup_overlay(planner *ego, hashtab *ht, hashtab *stats,
+				 const md5sig s, const flags_t *flagsp)
+{
+     planner *r = ego->root;
+     solution *l = htab_lookup(ht, stats, s, flagsp);
+     if (!l && BLISS(*flagsp) && r->htab_mapped.hashsiz)
+	  l = htab_lookup(&r->htab_mapped, &ego->htab_mapped, s, flagsp);
+     return l;
+}
+
 static void hinsert(planner *ego, const md5sig s, const flags_t *flagsp, 
-		    unsigned slvndx)
+		    unsigned slvndx, double pcost)
 {
-     htab_insert(BLISS(*flagsp) ? &ego->htab_blessed : &ego->htab_unblessed,
-		 s, flagsp, slvndx );
+     planner *r = ego->root;
+     hashtab *ht = BLISS(*flagsp) ? &r->htab_blessed : &r->htab_unblessed;
+     hashtab *stats = 
+	  BLISS(*flagsp) ? &ego->htab_blessed : &ego->htab_unblessed;
+     solution *l;
+
+     /* If the table already has a solution at least as good, either
+	because we are planning from wisdom or because another thread
+	has solved the same problem in the meanwhile, that solution
+	stands.  In the former, common case, a read lock suffices. */
+     X(planner_rdlock)(ego);
+     l = hlookup_overlay(ego, ht, stats, s, flagsp);
+     X(planner_rdunlock)(ego);
+     if (l) 
+	  return;
+
+     X(planner_lock)(ego);
+     if (!hlookup_overlay(ego, ht, stats, s, flagsp))
+	  htab_insert(ht, s, flagsp, slvndx, pcost);
+     X(planner_unlock)(ego);
 }
 
 
@@ -425,29 +487,65 @@ static double random_estimate(const planner *ego, const plan *pln,
 
 double X(iestimate_cost)(const planner *ego, const plan *pln, const problem *p)
 {
-     double cost =
-	  + pln->ops.add
-	  + pln->ops.mul
-	  
+     double cost;
+
+     if (X(costmodel_estimatingp)(ego))
+	  cost = pln->ops.est; /* learned, see costmodel.c */
+     else
+	  cost =
+	       + pln->ops.add
+	       + pln->ops.mul
+	       
 #if HAVE_FMA
-	  + pln->ops.fma
+	       + pln->ops.fma
 #else
-	  + 2 * pln->ops.fma
+	       + 2 * pln->ops.fma
 #endif
-	  
-	  + pln->ops.other;
+	       
+	       + pln->ops.other;
      if (ego->cost_hook)
 	  cost = ego->cost_hook(p, cost, COST_MAX);
      return cost;
 }
 
-static void evaluate_plan(planner *ego, plan *pln, const problem *p)
+/* Measure PLN, account for the measurement, and return its time, or
+   -1 if the cycle counter is unavailable.  Set *ERR to the half-width
+   of its confidence interval, or 0 if we don't know it (see
+   X(measure_execution_time_err)) */
+static double measure(planner *ego, plan *pln, const problem *p,
+		      unsigned slvndx, double *err)
 {
-     if (ESTIMATEP(ego) || !BELIEVE_PCOSTP(ego) || pln->pcost == 0.0) {
+     double t0 = X(planlog_now)(ego);
+     double t;
+
+     /* see search_par() */
+     if (ego->timing_lock_hook)
+	  ego->timing_lock_hook();
+     t = X(measure_execution_time_err)(ego, pln, p, err);
+     if (ego->timing_unlock_hook)
+	  ego->timing_unlock_hook();
+
+     if (t >= 0) {
 	  ego->nplan++;
+	  ego->pcost += t;
+	  ego->need_timeout_check = 1;
+	  X(planlog_measure)(ego, slvndx, pln, t0);
+     }
+     return t;
+}
+
+/* Set the pcost of PLN, and return the half-width of its confidence
+   interval, or 0 if we don't know it */
+static double evaluate_plan(planner *ego, plan *pln, const problem *p,
+			    unsigned slvndx)
+{
+     double err = 0.0;
 
+     if (ESTIMATEP(ego) || !BELIEVE_PCOSTP(ego) || pln->pcost == 0.0) {
 	  if (ESTIMATEP(ego)) {
 	  estimate:
+	       ego->nplan++;
+
 	       /* heuristic */
 #ifdef FFTW_RANDOM_ESTIMATOR
 	       pln->pcost = random_estimate(ego, pln, p);
@@ -457,38 +555,52 @@ static void evaluate_plan(planner *ego, plan *pln, const problem *p)
 	       ego->epcost += pln->pcost;
 #endif
 	  } else {
-	       double t = X(measure_execution_time)(ego, pln, p);
-	       
+	       double t = measure(ego, pln, p, slvndx, &err);
+
 	       if (t < 0) {  /* unavailable cycle counter */
 		    /* Real programmers can write FORTRAN in any language */
+		    err = 0.0;
 		    goto estimate;
 	       }
 
 	       pln->pcost = t;
-	       ego->pcost += t;
-	       ego->need_timeout_check = 1;
 	  }
      }
      
      invoke_hook(ego, pln, p, 0);
+     return err;
 }
 
 /* maintain dynamic scoping of flags, nthr: */
-static plan *invoke_solver(planner *ego, const problem *p, solver *s, 
+static plan *invoke_solver(planner *ego, const problem *p, unsigned slvndx, 
 			   const flags_t *nflags)
 {
      flags_t flags = ego->flags;
      int nthr = ego->nthr;
+     solver *s = ego->slvdescs[slvndx].slv;
+     double t0 = X(planlog_now)(ego);
      plan *pln;
      ego->flags = *nflags;
      PLNR_TIMELIMIT_IMPATIENCE(ego) = 0;
      A(p->adt->problem_kind == s->adt->problem_kind);
      pln = s->adt->mkplan(s, p, ego);
+     if (pln)
+	  pln->footprint = X(profile_footprint)(p);
+     if (pln && ego->cmodel)
+	  X(costmodel_attribute)(ego, pln, p, slvndx);
+     X(planlog_solver)(ego, slvndx, pln, t0);
      ego->nthr = nthr;
      ego->flags = flags;
      return pln;
 }
 
+/* whether the caller has abandoned the search, which then stops as
+   if it timed out; see the plan upgrades in api/apiplan.c */
+static int cancelledp(const planner *ego)
+{
+     return ego->cancel_hook && ego->cancel_hook(ego->cancel_data);
+}
+
 /* maintain the invariant TIMED_OUT ==> NEED_TIMEOUT_CHECK */
 static int timeout_p(planner *ego, const problem *p)
 {
@@ -502,10 +614,12 @@ static int timeout_p(planner *ego, const problem *p)
 	       return 1;
 	  }
 
-	  if (ego->timelimit >= 0 &&
-	      X(elapsed_since)(ego, p, ego->start_time) >= ego->timelimit) {
+	  if ((ego->timelimit >= 0 &&
+	       X(elapsed_since)(ego, p, ego->start_time) >= ego->timelimit)
+	      || cancelledp(ego)) {
 	       ego->timed_out = 1;
 	       ego->need_timeout_check = 1;
+	       X(planlog_timeout)(ego);
 	       return 1;
 	  }
      }
@@ -515,21 +629,292 @@ static int timeout_p(planner *ego, const problem *p)
      return 0;
 }
 
+/* With robust timing, the costs of A and B are tied when their
+   confidence intervals overlap.  Then measure both again, in turn so
+   that a drift of the machine affects both alike, and average the
+   measurements, until the tie is broken, the planner times out, or we
+   give up, in which case the caller keeps the plan that comes first
+   as usual.  A plan may be remeasured in several ties, so each
+   carries the number N of measurements in its mean. */
+#define NREMEASURE 2
+
+typedef struct {
+     plan *pln;
+     unsigned slvndx;
+     double err; /* half-width of the confidence interval of the mean */
+     int n;      /* measurements averaged in PLN->PCOST */
+} timing;
+
+static int remeasure(planner *ego, const problem *p, timing *x)
+{
+     double e, t = measure(ego, x->pln, p, x->slvndx, &e);
+     double n = x->n, s;
+
+     if (t < 0)
+	  return 0;
+
+     /* the mean of N + 1 independent measurements, and the half-width
+	of its interval, from the sum of the squares of theirs */
+     s = n * n * x->err * x->err + e * e;
+     x->pln->pcost = (n * x->pln->pcost + t) / (n + 1);
+     x->err = sqrt(s) / (n + 1);
+     ++x->n;
+     return 1;
+}
+
+static void break_tie(planner *ego, const problem *p, timing *a, timing *b)
+{
+     int i;
+
+     for (i = 0; i < NREMEASURE; ++i) {
+	  double d = a->pln->pcost - b->pln->pcost;
+	  if (d < 0) d = -d;
+	  if (d > a->err + b->err)
+	       break;
+	  if (!remeasure(ego, p, a) || !remeasure(ego, p, b))
+	       break;
+	  if (timeout_p(ego, p))
+	       break; /* the caller sees EGO->TIMED_OUT */
+     }
+}
+
+/* A view of a planner is a copy that shares the hash tables and the
+   solvers of the original, but has its own flags, timeout state, and
+   statistics.  Views allow several threads to plan at the same time,
+   with the hash tables protected by the lock hooks of the root. */
+static void zero_stats(hashtab *ht)
+{
+     ht->solutions = 0;
+     ht->hashsiz = ht->nelem = 0U;
+     ht->nrehash = 0;
+     ht->succ_lookup = ht->lookup = ht->lookup_iter = 0;
+     ht->insert = ht->insert_iter = ht->insert_unknown = 0;
+}
+
+static void add_stats(hashtab *ht, const hashtab *v)
+{
+     ht->nrehash += v->nrehash;
+     ht->succ_lookup += v->succ_lookup;
+     ht->lookup += v->lookup;
+     ht->lookup_iter += v->lookup_iter;
+     ht->insert += v->insert;
+     ht->insert_iter += v->insert_iter;
+     ht->insert_unknown += v->insert_unknown;
+}
+
+static void mkview(planner *ego, planner *v)
+{
+     *v = *ego;
+     v->trace = 0;
+     v->nplan = v->nprob = 0;
+     v->pcost = v->epcost = 0.0;
+     zero_stats(&v->htab_blessed);
+     zero_stats(&v->htab_unblessed);
+     zero_stats(&v->htab_mapped);
+}
+
+static void merge_stats(planner *ego, const planner *v)
+{
+     ego->nplan += v->nplan;
+     ego->nprob += v->nprob;
+     ego->pcost += v->pcost;
+     ego->epcost += v->epcost;
+     add_stats(&ego->htab_blessed, &v->htab_blessed);
+     add_stats(&ego->htab_unblessed, &v->htab_unblessed);
+     add_stats(&ego->htab_mapped, &v->htab_mapped);
+}
+
+/* Concurrent search.  The candidate solvers for P are tried by up
+   to EGO->NSEARCH threads, each of which owns a view of EGO (see
+   X(mkplanner_view)).  The threads take the candidates in turn from a
+   shared counter, and plan and measure them.  A timing zeroes and
+   overwrites the arrays of the problem, so each thread plans on its
+   own copy of P (see EGO->SHADOW_HOOK), which has the same layout,
+   alignment, and hash as P, and thus the same plans; the threads then
+   plan and time concurrently.  A thread for which no copy can be made
+   plans on P itself, and its timings, including those of the
+   subproblems, take turns with those of the other such threads under
+   the timing lock.  Overlapping timings compete for the memory
+   bandwidth, which slows all candidates alike to a first
+   approximation.
+   The winner is then chosen as in search0(): the lowest cost,
+   ties going to the solver that comes first.  Thus, the outcome
+   depends on the measurements, but not on the scheduling of the
+   threads.
+
+   Only the first search in a planner call is concurrent; below it,
+   the views search serially.  Threaded plans are searched serially
+   too, since they would compete with the search threads for the
+   processors and the measurements would be meaningless.  Likewise
+   for the hooks used by MPI, which must be called in lockstep by all
+   processes, and for the user hook, which may execute the plan on the
+   arrays of the problem while the other threads are measuring.
+   Neither do we search concurrently while recording samples for the
+   cost model (see costmodel.c), nor with robust timing (see
+   X(measure_execution_time_err)), which must be timed on a quiet
+   machine. */
+typedef struct {
+     planner *views;
+     const problem **prbs; /* P, or a copy of it, for each view */
+     const flags_t *flagsp;
+     unsigned *cand;  /* slvndx of the candidates */
+     plan **plns;     /* plan for each candidate, or 0 */
+     int ncand, next;
+} search_data;
+
+static int concurrentp(const planner *ego)
+{
+     return (ego->nsearch > 1
+	     && ego->spawn_hook
+	     && ego->timing_lock_hook
+	     && ego->nthr == 1
+	     && !ESTIMATEP(ego)
+	     && !ALLOW_PRUNINGP(ego)
+	     && !ego->hook
+	     && !ego->cost_hook
+	     && !ego->wisdom_ok_hook
+	     && !ego->nowisdom_hook
+	     && !ego->bogosity_hook
+	     && !ego->robust_timing
+	     && !X(costmodel_recordingp)(ego));
+}
+
+static void search_thread(void *data, int thr)
+{
+     search_data *d = (search_data *) data;
+     planner *ego = d->views + thr;
+     const problem *p = d->prbs[thr];
+     plan *pln;
+     int k;
+
+     for (;;) {
+	  X(planner_lock)(ego);
+	  k = d->next++;
+	  X(planner_unlock)(ego);
+
+	  if (k >= d->ncand || ego->wisdom_state == WISDOM_IS_BOGUS)
+	       break;
+	  if (ego->need_timeout_check && timeout_p(ego, p))
+	       break;
+
+	  pln = invoke_solver(ego, p, d->cand[k], d->flagsp);
+	  if (pln)
+	       evaluate_plan(ego, pln, p, d->cand[k]);
+	  d->plns[k] = pln;
+     }
+}
+
+static plan *search_par(planner *ego, const problem *p, unsigned *slvndx, 
+			const flags_t *flagsp, int ncand)
+{
+     search_data d;
+     plan *best = 0;
+     void **bufs;
+     int i, k, nthr, timed_out = 0;
+
+     d.cand = (unsigned *)MALLOC(ncand * sizeof(unsigned), OTHER);
+     d.ncand = 0;
+     FORALL_SOLVERS_OF_KIND(p->adt->problem_kind, ego, s, sp, {
+	  UNUSED(s);
+	  d.cand[d.ncand++] = (unsigned)/*from ptrdiff_t*/(sp - ego->slvdescs);
+     });
+     A(d.ncand == ncand);
+
+     d.plns = (plan **)MALLOC(ncand * sizeof(plan *), OTHER);
+     for (k = 0; k < ncand; ++k)
+	  d.plns[k] = 0;
+
+     nthr = (int)X(imin)(ego->nsearch, ncand);
+     d.views = (planner *)MALLOC(nthr * sizeof(planner), PLANNERS);
+     d.prbs = (const problem **)MALLOC(nthr * sizeof(problem *), OTHER);
+     bufs = (void **)MALLOC(nthr * sizeof(void *), OTHER);
+     for (i = 0; i < nthr; ++i) {
+	  planner *v = d.views + i;
+	  problem *shadow = 0;
+	  mkview(ego, v);
+	  v->nsearch = 1; /* the views search serially */
+	  v->log_tid = i + 1;
+	  bufs[i] = 0;
+	  if (ego->shadow_hook)
+	       shadow = ego->shadow_hook(p, bufs + i);
+	  if (shadow) {
+	       d.prbs[i] = shadow;
+	       v->timing_lock_hook = v->timing_unlock_hook = 0;
+	  } else {
+	       d.prbs[i] = p;
+	  }
+     }
+     d.flagsp = flagsp;
+     d.next = 0;
+
+     ego->spawn_hook(nthr, search_thread, (void *) &d);
+
+     for (i = 0; i < nthr; ++i) {
+	  planner *v = d.views + i;
+	  merge_stats(ego, v);
+	  timed_out |= v->timed_out;
+	  if (v->wisdom_state == WISDOM_IS_BOGUS)
+	       ego->wisdom_state = WISDOM_IS_BOGUS;
+     }
+     ego->need_timeout_check = 1;
+     if (timed_out)
+	  ego->timed_out = 1;
+
+     for (k = 0; k < ncand; ++k) {
+	  plan *pln = d.plns[k];
+	  if (pln && !timed_out && (!best || pln->pcost < best->pcost)) {
+	       X(plan_destroy_internal)(best);
+	       best = pln;
+	       *slvndx = d.cand[k];
+	  } else {
+	       X(plan_destroy_internal)(pln);
+	  }
+     }
+
+     for (i = 0; i < nthr; ++i) {
+	  if (d.prbs[i] != p) {
+	       X(problem_destroy)((problem *) d.prbs[i]);
+	       X(ifree)(bufs[i]);
+	  }
+     }
+
+     X(ifree)(bufs);
+     X(ifree)(d.prbs);
+     X(ifree)(d.views);
+     X(ifree)(d.plns);
+     X(ifree)(d.cand);
+     return best;
+}
+
 static plan *search0(planner *ego, const problem *p, unsigned *slvndx, 
 		     const flags_t *flagsp)
 {
      plan *best = 0;
      int best_not_yet_timed = 1;
+     timing tb, tp;
 
      /* Do not start a search if the planner timed out. This check is
 	necessary, lest the relaxation mechanism kick in */
      if (timeout_p(ego, p))
 	  return 0;
 
+     if (concurrentp(ego)) {
+	  int ncand = 0;
+	  FORALL_SOLVERS_OF_KIND(p->adt->problem_kind, ego, s, sp, {
+	       UNUSED(s); UNUSED(sp);
+	       ++ncand;
+	  });
+	  if (ncand > 1)
+	       return search_par(ego, p, slvndx, flagsp, ncand);
+     }
+
      FORALL_SOLVERS_OF_KIND(p->adt->problem_kind, ego, s, sp, {
 	  plan *pln;
 
-	  pln = invoke_solver(ego, p, s, flagsp);
+	  UNUSED(s);
+	  pln = invoke_solver(ego, p, 
+			      (unsigned)/*from ptrdiff_t*/(sp - ego->slvdescs),
+			      flagsp);
 
 	  if (ego->need_timeout_check) 
 	       if (timeout_p(ego, p)) {
@@ -545,13 +930,28 @@ static plan *search0(planner *ego, const problem *p, unsigned *slvndx,
 
 	       if (best) {
 		    if (best_not_yet_timed) {
-			 evaluate_plan(ego, best, p);
+			 tb.pln = best;
+			 tb.slvndx = *slvndx;
+			 tb.err = evaluate_plan(ego, best, p, *slvndx);
+			 tb.n = 1;
 			 best_not_yet_timed = 0;
 		    }
-		    evaluate_plan(ego, pln, p);
+		    tp.pln = pln;
+		    tp.slvndx = (unsigned)/*from ptrdiff_t*/(sp - ego->slvdescs);
+		    tp.err = evaluate_plan(ego, pln, p, tp.slvndx);
+		    tp.n = 1;
+		    if (tp.err > 0 || tb.err > 0) {
+			 break_tie(ego, p, &tb, &tp);
+			 if (ego->timed_out) {
+			      X(plan_destroy_internal)(pln);
+			      X(plan_destroy_internal)(best);
+			      return 0;
+			 }
+		    }
 		    if (pln->pcost < best->pcost) {
 			 X(plan_destroy_internal)(best);
 			 best = pln;
+			 tb = tp;
                          *slvndx = (unsigned)/*from ptrdiff_t*/(sp - ego->slvdescs);
 		    } else {
 			 X(plan_destroy_internal)(pln);
@@ -620,14 +1020,106 @@ static plan *search(planner *ego, const problem *p, unsigned *slvndx,
 	  : ego->wisdom_state) == WISDOM_IS_BOGUS)			\
 	  goto wisdom_is_bogus;
 
-static plan *mkplan(planner *ego, const problem *p)
+/* Traces.  While recording, each call to mkplan() appends a step,
+   which is infeasible unless the call finds a solver in the wisdom.
+   Steps are in the order in which the calls begin, so that the
+   children of a solver follow its step.  A search cannot be
+   recorded, since the trace would contain the candidates that lost.
+
+   While replaying, each call consumes a step and invokes its solver
+   with its flags, which recreates the same plan as long as the
+   solvers behave as they did while recording.  If they do not, for
+   example because the arrays of the problem are aligned differently,
+   the trace is marked as unusable. */
+
+/* append an infeasible step to T, and return its index */
+unsigned X(trace_push)(plan_trace *t)
+{
+     if (t->n >= t->nalloc) {
+	  unsigned i, nalloc = 2 * t->nalloc + 16;
+	  flags_t *step = (flags_t *)MALLOC(nalloc * sizeof(flags_t), OTHER);
+	  for (i = 0; i < t->n; ++i)
+	       step[i] = t->step[i];
+	  X(ifree0)(t->step);
+	  t->step = step;
+	  t->nalloc = nalloc;
+     }
+     t->step[t->n].l = t->step[t->n].u = 0;
+     t->step[t->n].hash_info = 0;
+     t->step[t->n].timelimit_impatience = 0;
+     t->step[t->n].slvndx = INFEASIBLE_SLVNDX;
+     return t->n++;
+}
+
+static plan *replay(planner *ego, const problem *p, unsigned *slvndxp)
+{
+     plan_trace *t = ego->trace;
+     flags_t flags;
+     solver *s;
+     plan *pln;
+
+     if (!t->ok || t->pos >= t->n)
+	  goto bad;
+
+     flags = t->step[t->pos++];
+     if (flags.slvndx == INFEASIBLE_SLVNDX)
+	  return 0;
+     if (flags.slvndx >= ego->nslvdesc)
+	  goto bad;
+
+     s = ego->slvdescs[flags.slvndx].slv;
+     if (p->adt->problem_kind != s->adt->problem_kind)
+	  goto bad;
+
+     ++ego->nprob;
+     pln = invoke_solver(ego, p, flags.slvndx, &flags);
+     if (pln) {
+	  *slvndxp = flags.slvndx;
+	  return pln;
+     }
+
+ bad:
+     t->ok = 0;
+     return 0;
+}
+
+plan_trace *X(mktrace)(void)
+{
+     plan_trace *t = (plan_trace *)MALLOC(sizeof(plan_trace), OTHER);
+     t->step = 0;
+     t->n = t->nalloc = t->pos = 0;
+     t->nthr = 1;
+     t->flags = 0;
+     t->replay = 0;
+     t->ok = 1;
+     return t;
+}
+
+void X(trace_destroy)(plan_trace *t)
+{
+     if (t) {
+	  X(ifree0)(t->step);
+	  X(ifree)(t);
+     }
+}
+
+static plan *mkplan0(planner *ego, const problem *p, 
+		     unsigned *slvndxp, int *wisdomp)
 {
      plan *pln;
      md5 m;
      unsigned slvndx;
      flags_t flags_of_solution;
-     solution *sol;
+     solution sol;
      solver *s;
+     plan_trace *t = ego->trace;
+     unsigned step = 0;
+
+     *slvndxp = INFEASIBLE_SLVNDX;
+     *wisdomp = 0;
+
+     if (t && t->replay)
+	  return replay(ego, p, slvndxp);
 
      ASSERT_ALIGNED_DOUBLE;
      A(LEQ(PLNR_L(ego), PLNR_U(ego)));
@@ -637,8 +1129,10 @@ static plan *mkplan(planner *ego, const problem *p)
 
 
 #ifdef FFTW_DEBUG
-     check(&ego->htab_blessed);
-     check(&ego->htab_unblessed);
+     X(planner_lock)(ego);
+     check(&ego->root->htab_blessed);
+     check(&ego->root->htab_unblessed);
+     X(planner_unlock)(ego);
 #endif
 
      pln = 0;
@@ -650,19 +1144,22 @@ static plan *mkplan(planner *ego, const problem *p)
      ++ego->nprob;
      md5hash(&m, p, ego);
 
+     if (t)
+	  step = X(trace_push)(t);
+
      flags_of_solution = ego->flags;
 
      if (ego->wisdom_state != WISDOM_IGNORE_ALL) {
-	  if ((sol = hlookup(ego, m.s, &flags_of_solution))) { 
+	  if (hlookup(ego, m.s, &flags_of_solution, &sol)) { 
 	       /* wisdom is acceptable */
 	       wisdom_state_t owisdom_state = ego->wisdom_state;
 	       
 	       /* this hook is mainly for MPI, to make sure that
 		  wisdom is in sync across all processes for MPI problems */
-	       if (ego->wisdom_ok_hook && !ego->wisdom_ok_hook(p, sol->flags))
+	       if (ego->wisdom_ok_hook && !ego->wisdom_ok_hook(p, sol.flags))
 		    goto do_search; /* ignore not-ok wisdom */
 	       
-	       slvndx = SLVNDX(sol);
+	       slvndx = SLVNDX(&sol);
 	       
 	       if (slvndx == INFEASIBLE_SLVNDX) {
 		    if (ego->wisdom_state == WISDOM_IGNORE_INFEASIBLE)
@@ -671,7 +1168,7 @@ static plan *mkplan(planner *ego, const problem *p)
 			 return 0;   /* known to be infeasible */
 	       }
 	       
-	       flags_of_solution = sol->flags;
+	       flags_of_solution = sol.flags;
 	       
 	       /* inherit blessing either from wisdom
 		  or from the planner */
@@ -679,22 +1176,31 @@ static plan *mkplan(planner *ego, const problem *p)
 	       
 	       ego->wisdom_state = WISDOM_ONLY;
 	       
+	       if (slvndx >= ego->nslvdesc) /* corrupt mapped wisdom */
+		    goto wisdom_is_bogus;
+
 	       s = ego->slvdescs[slvndx].slv;
 	       if (p->adt->problem_kind != s->adt->problem_kind)
 		    goto wisdom_is_bogus;
+
+	       if (t) {
+		    t->step[step] = flags_of_solution;
+		    t->step[step].slvndx = slvndx;
+	       }
 	       
-	       pln = invoke_solver(ego, p, s, &flags_of_solution);
+	       pln = invoke_solver(ego, p, slvndx, &flags_of_solution);
 	       
 	       CHECK_FOR_BOGOSITY; 	  /* catch error in child solvers */
 	       
-	       sol = 0; /* Paranoia: SOL may be dangling after
-			   invoke_solver(); make sure we don't accidentally
-			   reuse it. */
-	       
 	       if (!pln)
 		    goto wisdom_is_bogus;
 	       
 	       ego->wisdom_state = owisdom_state;
+	       *wisdomp = 1;
+
+	       /* the cost of the plan that the wisdom records, if this
+		  process measured it, for X(cost) */
+	       pln->pcost = sol.pcost;
 	       
 	       goto skip_search;
 	  }
@@ -707,19 +1213,23 @@ static plan *mkplan(planner *ego, const problem *p)
      if (ego->wisdom_state == WISDOM_ONLY)
 	  goto wisdom_is_bogus;
 
+     if (t)
+	  t->ok = 0;
+
      flags_of_solution = ego->flags;
      pln = search(ego, p, &slvndx, &flags_of_solution);
      CHECK_FOR_BOGOSITY; 	  /* catch error in child solvers */
 
      if (ego->timed_out) {
 	  A(!pln);
-	  if (PLNR_TIMELIMIT_IMPATIENCE(ego) != 0) {
+	  if (PLNR_TIMELIMIT_IMPATIENCE(ego) != 0 && !cancelledp(ego)) {
 	       /* record (below) that this plan has failed because of
 		  timeout */
 	       flags_of_solution.hash_info |= BLESSING;
 	  } else {
-	       /* this is not the top-level problem or timeout is not
-		  active: record no wisdom. */
+	       /* this is not the top-level problem, timeout is not
+		  active, or the search was cancelled: record no
+		  wisdom. */
 	       return 0;
 	  }
      } else {
@@ -731,13 +1241,15 @@ static plan *mkplan(planner *ego, const problem *p)
      if (ego->wisdom_state == WISDOM_NORMAL ||
 	 ego->wisdom_state == WISDOM_ONLY) {
 	  if (pln) {
-	       hinsert(ego, m.s, &flags_of_solution, slvndx);
+	       hinsert(ego, m.s, &flags_of_solution, slvndx, pln->pcost);
 	       invoke_hook(ego, pln, p, 1);
 	  } else {
-	       hinsert(ego, m.s, &flags_of_solution, INFEASIBLE_SLVNDX);
+	       hinsert(ego, m.s, &flags_of_solution, INFEASIBLE_SLVNDX, 0.0);
 	  }
      }
 
+     if (pln)
+	  *slvndxp = slvndx;
      return pln;
 
  wisdom_is_bogus:
@@ -746,6 +1258,21 @@ static plan *mkplan(planner *ego, const problem *p)
      return 0;
 }
 
+/* mkplan0(), logged if so requested (see planlog.c) */
+static plan *mkplan(planner *ego, const problem *p)
+{
+     double t0 = X(planlog_now)(ego);
+     unsigned slvndx;
+     int wisdomp;
+     plan *pln;
+
+     ++ego->log_depth;
+     pln = mkplan0(ego, p, &slvndx, &wisdomp);
+     --ego->log_depth;
+     X(planlog_problem)(ego, p, pln, slvndx, wisdomp, t0);
+     return pln;
+}
+
 static void htab_destroy(hashtab *ht)
 {
      X(ifree)(ht->solutions);
@@ -764,40 +1291,186 @@ static void mkhashtab(hashtab *ht)
      hgrow(ht);			/* so that hashsiz > 0 */
 }
 
+/* drop the mapped wisdom of EGO, the caller holds the lock */
+static void unmap(planner *ego)
+{
+     if (ego->mapped && ego->unmap_hook)
+	  ego->unmap_hook(ego->mapped, ego->mappedsz);
+     ego->mapped = 0;
+     ego->mappedsz = 0;
+     ego->unmap_hook = 0;
+     ego->htab_mapped.solutions = 0;
+     ego->htab_mapped.hashsiz = ego->htab_mapped.nelem = 0U;
+}
+
 /* destroy hash table entries.  If FORGET_EVERYTHING, destroy the whole
    table.  If FORGET_ACCURSED, then destroy entries that are not blessed. */
 static void forget(planner *ego, amnesia a)
 {
+     planner *r = ego->root;
+
+     X(planner_lock)(ego);
      switch (a) {
 	 case FORGET_EVERYTHING:
-	      htab_destroy(&ego->htab_blessed);
-	      mkhashtab(&ego->htab_blessed);
+	      htab_destroy(&r->htab_blessed);
+	      mkhashtab(&r->htab_blessed);
+	      unmap(r);
 	      /* fall through */
 	 case FORGET_ACCURSED:
-	      htab_destroy(&ego->htab_unblessed);
-	      mkhashtab(&ego->htab_unblessed);
+	      htab_destroy(&r->htab_unblessed);
+	      mkhashtab(&r->htab_unblessed);
 	      break;
 	 default:
 	      break;
      }
+     X(planner_unlock)(ego);
 }
 
-/* FIXME: what sort of version information should we write? */
-#define WISDOM_PREAMBLE PACKAGE "-" VERSION " " STRINGIZE(X(wisdom))
-static const char stimeout[] = "TIMEOUT";
+/* the signature that wisdom is checked against, see above */
+void X(planner_signature)(planner *ego, md5 *m)
+{
+     signature_of_configuration(m, ego);
+}
 
-/* tantus labor non sit cassus */
-static void exprt(planner *ego, printer *p)
+/* Binary wisdom.  The image is a hash table of solutions in the
+   native layout, preceded by a header, so that X(planner_map_wisdom)
+   can look solutions up in place, e.g. in a file that many processes
+   map read-only.  The table is never written to: new solutions go to
+   the blessed table, which overlays it.  Since the solver indices
+   only make sense for the same solvers, the image carries the
+   signature of the configuration, and a probe solution with known
+   contents checks the layout of the structures. */
+typedef struct {
+     char magic[8];
+     md5uint sig[4];
+     unsigned solsz, hashsiz, nelem;
+     solution probe;
+} wisdom_image;
+
+static const char image_magic[8] = { 
+     'F', 'F', 'T', 'W', 'W', 'I', 'S', '1' 
+};
+
+/* copy the fields of L into D, leaving the padding zero */
+static void image_slot(solution *d, const solution *l)
+{
+     memset(d, 0, sizeof(solution));
+     if (VALIDP(l)) {
+	  sigcpy(l->s, d->s);
+	  d->flags.l = l->flags.l;
+	  d->flags.u = l->flags.u;
+	  d->flags.timelimit_impatience = l->flags.timelimit_impatience;
+	  d->flags.hash_info = l->flags.hash_info;
+	  d->flags.slvndx = l->flags.slvndx;
+     }
+}
+
+static void mkprobe(solution *probe)
+{
+     solution l;
+     static const md5uint sig[4] = { 0x01020304, 0x05060708, 1, 2 };
+
+     sigcpy(sig, l.s);
+     l.flags.l = 0xedcbaU;
+     l.flags.u = 0x12345U;
+     l.flags.timelimit_impatience = 0x155U;
+     l.flags.hash_info = H_VALID | H_LIVE;
+     l.flags.slvndx = 0x9a5U;
+     image_slot(probe, &l);
+}
+
+static void image_htab(hashtab *ht, const hashtab *from)
 {
      unsigned h;
-     hashtab *ht = &ego->htab_blessed;
+
+     for (h = 0; h < from->hashsiz; ++h) {
+	  const solution *l = from->solutions + h;
+	  if (LIVEP(l) && !htab_lookup(ht, ht, l->s, &l->flags))
+	       htab_insert(ht, l->s, &l->flags, SLVNDX(l), 0.0);
+     }
+}
+
+/* Write the image of the blessed and mapped wisdom into BUF, if LEN
+   bytes suffice, and return its size. */
+size_t X(planner_wisdom_image)(planner *ego, void *buf, size_t len)
+{
+     hashtab ht;
      md5 m;
+     size_t sz;
+     unsigned h;
 
      signature_of_configuration(&m, ego);
+     mkhashtab(&ht);
+     X(planner_rdlock)(ego);
+     image_htab(&ht, &ego->root->htab_mapped);
+     image_htab(&ht, &ego->root->htab_blessed);
+     X(planner_rdunlock)(ego);
+
+     sz = sizeof(wisdom_image) + ht.hashsiz * sizeof(solution);
+     if (buf && len >= sz) {
+	  wisdom_image *img = (wisdom_image *) buf;
+	  solution *sol = (solution *) (img + 1);
+
+	  memset(img, 0, sizeof(wisdom_image));
+	  memcpy(img->magic, image_magic, sizeof(image_magic));
+	  sigcpy(m.s, img->sig);
+	  img->solsz = (unsigned) sizeof(solution);
+	  img->hashsiz = ht.hashsiz;
+	  img->nelem = ht.nelem;
+	  mkprobe(&img->probe);
+	  for (h = 0; h < ht.hashsiz; ++h)
+	       image_slot(sol + h, ht.solutions + h);
+     }
 
-     p->print(p, 
-	      "(" WISDOM_PREAMBLE " #x%M #x%M #x%M #x%M\n",
-	      m.s[0], m.s[1], m.s[2], m.s[3]);
+     htab_destroy(&ht);
+     return sz;
+}
+
+/* Use the LEN bytes at IMG, written by X(planner_wisdom_image), as
+   read-only wisdom until it is forgotten, and then call UNMAP_HOOK.
+   Return 0, and leave IMG alone, if IMG is not valid wisdom for this
+   configuration. */
+int X(planner_map_wisdom)(planner *ego, const void *img_, size_t len,
+			  void (*unmap_hook)(const void *img, size_t len))
+{
+     const wisdom_image *img = (const wisdom_image *) img_;
+     planner *r = ego->root;
+     solution probe;
+     md5 m;
+
+     if (len < sizeof(wisdom_image))
+	  return 0;
+
+     signature_of_configuration(&m, ego);
+     mkprobe(&probe);
+     if (memcmp(img->magic, image_magic, sizeof(image_magic))
+	 || !md5eq(img->sig, m.s)
+	 || img->solsz != sizeof(solution)
+	 || memcmp(&img->probe, &probe, sizeof(solution))
+	 || img->hashsiz < 2 || img->nelem >= img->hashsiz
+	 || (len - sizeof(wisdom_image)) / sizeof(solution) < img->hashsiz)
+	  return 0;
+
+     X(planner_lock)(ego);
+     unmap(r);
+     r->htab_mapped.solutions = (solution *) (img + 1);
+     r->htab_mapped.hashsiz = img->hashsiz;
+     r->htab_mapped.nelem = img->nelem;
+     r->mapped = img_;
+     r->mappedsz = len;
+     r->unmap_hook = unmap_hook;
+     X(planner_unlock)(ego);
+     return 1;
+}
+
+/* FIXME: what sort of version information should we write? */
+#define WISDOM_PREAMBLE PACKAGE "-" VERSION " " STRINGIZE(X(wisdom))
+static const char stimeout[] = "TIMEOUT";
+
+/* tantus labor non sit cassus */
+static void exprt_htab(planner *ego, printer *p, const hashtab *ht)
+{
+     unsigned h;
 
      for (h = 0; h < ht->hashsiz; ++h) {
 	  solution *l = ht->solutions + h;
@@ -822,6 +1495,21 @@ static void exprt(planner *ego, printer *p)
 			l->s[0], l->s[1], l->s[2], l->s[3]);
 	  }
      }
+}
+
+static void exprt(planner *ego, printer *p)
+{
+     md5 m;
+
+     signature_of_configuration(&m, ego);
+     X(planner_rdlock)(ego);
+
+     p->print(p, 
+	      "(" WISDOM_PREAMBLE " #x%M #x%M #x%M #x%M\n",
+	      m.s[0], m.s[1], m.s[2], m.s[3]);
+     exprt_htab(ego, p, &ego->root->htab_mapped);
+     exprt_htab(ego, p, &ego->root->htab_blessed);
+     X(planner_rdunlock)(ego);
      p->print(p, ")\n");
 }
 
@@ -835,7 +1523,7 @@ static int imprt(planner *ego, scanner *sc)
      flags_t flags;
      int reg_id;
      unsigned slvndx;
-     hashtab *ht = &ego->htab_blessed;
+     hashtab *ht = &ego->root->htab_blessed;
      hashtab old;
      md5 m;
 
@@ -851,6 +1539,8 @@ static int imprt(planner *ego, scanner *sc)
 	  return 0;
      }
      
+     X(planner_lock)(ego);
+
      /* make a backup copy of the hash table (cache the hash) */
      {
 	  unsigned h, hsiz = ht->hashsiz;
@@ -891,10 +1581,11 @@ static int imprt(planner *ego, scanner *sc)
 	  CK(flags.u == u);
 	  CK(flags.timelimit_impatience == timelimit_impatience);
 
-	  if (!hlookup(ego, sig, &flags))
-	       hinsert(ego, sig, &flags, slvndx);
+	  if (!hlookup0(ego, sig, &flags))
+	       htab_insert(ht, sig, &flags, slvndx, 0.0);
      }
 
+     X(planner_unlock)(ego);
      X(ifree0)(old.solutions);
      return 1;
 
@@ -902,6 +1593,7 @@ static int imprt(planner *ego, scanner *sc)
      /* ``The wisdom of FFTW must be above suspicion.'' */
      X(ifree0)(ht->solutions);
      *ht = old;
+     X(planner_unlock)(ego);
      return 0;
 }
 
@@ -937,11 +1629,32 @@ planner *X(mkplanner)(void)
      p->flags.timelimit_impatience = 0;
      p->flags.hash_info = 0;
      p->nthr = 1;
+     p->no_execute_alloc = 0;
      p->need_timeout_check = 1;
+     p->cancel_hook = 0;
+     p->cancel_data = 0;
      p->timelimit = -1;
+     p->robust_timing = 0;
+     p->tick_rate = 0.0;
+
+     p->root = p;
+     p->nsearch = 1;
+     p->spawn_hook = 0;
+     p->timing_lock_hook = p->timing_unlock_hook = 0;
+     p->shadow_hook = 0;
+     p->lock_hook = p->unlock_hook = 0;
+     p->rdlock_hook = p->rdunlock_hook = 0;
+     p->trace = 0;
+     p->cmodel = 0;
+     p->log = 0;
+     p->log_depth = p->log_tid = 0;
 
      mkhashtab(&p->htab_blessed);
      mkhashtab(&p->htab_unblessed);
+     zero_stats(&p->htab_mapped);
+     p->mapped = 0;
+     p->mappedsz = 0;
+     p->unmap_hook = 0;
 
      for (i = 0; i < PROBLEM_LAST; ++i)
 	  p->slvdescs_for_problem_kind[i] = -1;
@@ -954,6 +1667,9 @@ void X(planner_destroy)(planner *ego)
      /* destroy hash table */
      htab_destroy(&ego->htab_blessed);
      htab_destroy(&ego->htab_unblessed);
+     unmap(ego);
+     X(costmodel_forget)(ego);
+     X(planlog_forget)(ego);
 
      /* destroy solvdesc table */
      FORALL_SOLVERS(ego, s, sp, {
@@ -965,6 +1681,52 @@ void X(planner_destroy)(planner *ego)
      X(ifree)(ego); /* dona eis requiem */
 }
 
+/* Create a view of EGO, for use by one thread.  The statistics of
+   the view are added to those of the root when the view is
+   destroyed. */
+planner *X(mkplanner_view)(planner *ego)
+{
+     planner *v = (planner *) MALLOC(sizeof(planner), PLANNERS);
+     mkview(ego, v);
+     return v;
+}
+
+void X(planner_destroy_view)(planner *v)
+{
+     X(planner_lock)(v);
+     merge_stats(v->root, v);
+     X(planner_unlock)(v);
+     X(ifree)(v);
+}
+
+/* Serialize access to the state that the views of a planner share:
+   the hash tables and the tables managed by X(plan_awake).  Lookups
+   in the hash tables only need the read lock.  Without lock hooks,
+   the planner is used by one thread at a time. */
+void X(planner_lock)(const planner *ego)
+{
+     if (ego->root->lock_hook)
+	  ego->root->lock_hook();
+}
+
+void X(planner_unlock)(const planner *ego)
+{
+     if (ego->root->unlock_hook)
+	  ego->root->unlock_hook();
+}
+
+void X(planner_rdlock)(const planner *ego)
+{
+     if (ego->root->rdlock_hook)
+	  ego->root->rdlock_hook();
+}
+
+void X(planner_rdunlock)(const planner *ego)
+{
+     if (ego->root->rdunlock_hook)
+	  ego->root->rdunlock_hook();
+}
+
 plan *X(mkplan_d)(planner *ego, problem *p)
 {
      plan *pln = ego->adt->mkplan(ego, p);
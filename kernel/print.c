@@ -156,6 +156,14 @@ static void vprint(printer *p, const char *format, va_list ap)
 			    putulong(p, (unsigned long)x, 16u, 0);
 			    break;
 		       }
+		       case 'g': {
+			    /* finite double */
+			    char buf[BSZ];
+			    double x = va_arg(ap, double);
+			    sprintf(buf, "%.6g", x);
+			    myputs(p, buf);
+			    break;
+		       }
 		       case '(': {
 			    /* newline, augment indent level */
 			    p->indent += p->indent_incr;
@@ -170,7 +178,9 @@ static void vprint(printer *p, const char *format, va_list ap)
 		       case 'p': {  /* note difference from C's %p */
 			    /* print plan */
 			    plan *x = va_arg(ap, plan *);
-			    if (x) 
+			    if (x && p->print_plan)
+				 p->print_plan(p, x);
+			    else if (x) 
 				 x->adt->print(x, p);
 			    else 
 				 goto putnull;
@@ -233,6 +243,7 @@ printer *X(mkprinter)(size_t size,
      s->cleanup = cleanup;
      s->indent = 0;
      s->indent_incr = 2;
+     s->print_plan = 0;
      return s;
 }
 
@@ -66,7 +66,8 @@ static const problem_adt padt =
      unsolvable_hash,
      unsolvable_zero,
      unsolvable_print,
-     unsolvable_destroy
+     unsolvable_destroy,
+     0
 };
 
 /* there is no point in malloc'ing this one */
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/* Execution profile of a plan.
+
+   Every plan whose type supports profiling (see the profile() hook
+   of X(mkplan_dft) and its siblings) can replace its apply() by a
+   wrapper that reads the cycle counter before and after calling the
+   original apply(), and counts the time and the calls in the
+   plan_profile of the plan.  Since parents call their children
+   through apply(), profiling every node of the tree shows where
+   the time of a transform goes.
+
+   The tree is walked through the print() methods of the plans, which
+   print every child with %p: a printer whose print_plan hook is set
+   sees every plan of the tree, parents before children.
+
+   The counters are not locked.  When several threads execute the
+   same node at once (threaded plans, or one plan executed by several
+   threads), some updates may be lost, and the times of the children
+   of a parallel loop add up to more than the time of the loop. */
+
+#include "kernel/ifftw.h"
+#include <math.h>
+
+#ifndef WITH_SLOW_TIMER
+#  include "cycle.h"
+#endif
+
+#ifdef HAVE_TICK_COUNTER
+static ticks origin;
+#  define UNITS "ticks"
+
+static void set_origin(void)
+{
+     origin = getticks();
+}
+
+double X(profile_now)(void)
+{
+     return elapsed(getticks(), origin);
+}
+#else
+static crude_time origin;
+#  define UNITS "s"
+
+static void set_origin(void)
+{
+     origin = X(get_crude_time)();
+}
+
+double X(profile_now)(void)
+{
+     return X(elapsed_since_local)(origin);
+}
+#endif
+
+static int origin_set = 0;
+
+void X(profile_account)(plan_profile *pr, double t0)
+{
+     pr->time += X(profile_now)() - t0;
+     pr->calls += 1;
+}
+
+/* bytes read and written by a plan for P, assuming that it reads
+   and writes every element once */
+double X(profile_footprint)(const problem *p)
+{
+     const tensor *sz, *vecsz;
+     double n;
+
+     if (!p->adt->tensors)
+	  return 0.0;
+     p->adt->tensors(p, &sz, &vecsz);
+     if (!FINITE_RNK(sz->rnk) || !FINITE_RNK(vecsz->rnk))
+	  return 0.0;
+     n = (double)X(tensor_sz)(sz) * (double)X(tensor_sz)(vecsz);
+
+     /* an rdft2 of size n has n reals on one side and about n/2
+	complex numbers on the other, that is, n reals again */
+     if (p->adt->problem_kind == PROBLEM_DFT)
+	  n *= 2.0;
+     return 2.0 * n * sizeof(R);
+}
+
+/*-----------------------------------------------------------------------*/
+/* walking the tree */
+
+typedef struct {
+     printer super;
+     int on;
+     plan *up;   /* the nearest profiled ancestor, or 0 */
+     double root;
+} walker;
+
+static void discard(printer *p, char c)
+{
+     UNUSED(p);
+     UNUSED(c);
+}
+
+static void walk(plan *pln, void (*visit)(printer *p, plan *x),
+		 int on)
+{
+     walker *w = (walker *) X(mkprinter)(sizeof(walker), discard, 0);
+     w->super.print_plan = visit;
+     w->on = on;
+     w->up = 0;
+     w->root = 0.0;
+     w->super.print(&w->super, "%p", pln);
+     X(printer_destroy)(&w->super);
+}
+
+static void reset(plan_profile *pr)
+{
+     pr->time = pr->calls = 0.0;
+     pr->self = pr->root = 0.0;
+}
+
+static void switch_profile(printer *p, plan *x)
+{
+     walker *w = (walker *) p;
+
+     if (x->profile) {
+	  if (w->on) {
+	       if (!x->prof) {
+		    x->prof = (plan_profile *) 
+			 MALLOC(sizeof(plan_profile), PLANS);
+		    x->profile(x, 1);
+	       }
+	       reset(x->prof);
+	  } else if (x->prof) {
+	       x->profile(x, 0);
+	       X(ifree)(x->prof);
+	       x->prof = 0;
+	  }
+     }
+     x->adt->print(x, p);
+}
+
+/* Profile the tree of EGO, or stop profiling it.  Profiling again a
+   profiled tree resets the counters.  The caller must not execute
+   the plan meanwhile. */
+void X(profile_tree)(plan *ego, int on)
+{
+     if (on && !origin_set) {
+	  set_origin();
+	  origin_set = 1;
+     }
+     walk(ego, switch_profile, on);
+}
+
+/*-----------------------------------------------------------------------*/
+/* printing */
+
+/* the self time of a node is its time minus the time of its
+   children, which are visited after their parent */
+static void tally(printer *p, plan *x)
+{
+     walker *w = (walker *) p;
+     plan *up = w->up;
+     plan_profile *pr = x->prof;
+
+     if (pr) {
+	  if (!up)
+	       w->root = pr->time;
+	  else
+	       up->prof->self -= pr->time;
+	  pr->self = pr->time;
+	  pr->root = w->root;
+	  w->up = x;
+     }
+     x->adt->print(x, p);
+     w->up = up;
+}
+
+static double percent(double t, double root)
+{
+     return floor(1000.0 * t / root + 0.5) / 10.0;
+}
+
+static void annotate(printer *p, plan *x)
+{
+     const plan_profile *pr = x->prof;
+
+     if (pr) {
+	  p->print(p, "[%g calls, %g " UNITS, pr->calls, pr->time);
+	  if (pr->root > 0)
+	       p->print(p, " %g%c, self %g%c",
+			percent(pr->time, pr->root), '%',
+			percent(pr->self > 0 ? pr->self : 0, pr->root), '%');
+	  if (x->footprint > 0)
+	       p->print(p, ", %g bytes", pr->calls * x->footprint);
+	  p->print(p, "] ");
+     }
+     x->adt->print(x, p);
+}
+
+/* print the tree of EGO like print(), with the counters of every
+   profiled node in front of it */
+void X(profile_print_tree)(plan *ego, printer *p)
+{
+     walk(ego, tally, 0);
+     p->print_plan = annotate;
+     p->print(p, "%p", ego);
+     p->print_plan = 0;
+}
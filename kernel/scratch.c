@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "kernel/ifftw.h"
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+/* Scratch space for apply().  The solver declares the size with
+   X(plan_scratch)() when it creates the plan, and apply() brackets
+   the use of the space with X(scratch_get)() and X(scratch_put)().
+   The space comes from, in order of preference:
+
+   1. the workspace that the caller of X(execute_dft_ws) & co. bound
+      to the executing thread.  Every plan in the tree owns the bytes
+      at SCRATCHOFF, assigned when the tree is awakened, so that
+      nested and threaded subplans never overlap;
+
+   2. the pool of spaces that the plan keeps while it is awake
+      (FFTW_NO_EXECUTE_ALLOC).  The pool has a space for each of the
+      threads that the apiplan was planned with, up to MAXSPACE, all
+      allocated when the tree is awakened.  Each execution claims a
+      free space of the pool, so that as many executions as threads,
+      be they the threads of the plan itself or those of
+      X(execute_batch) & co. with the same number of threads, may
+      overlap without allocating.  Further simultaneous executions
+      fall back to
+
+   3. malloc. */
+
+#define MAXSPACE 64
+
+typedef struct {
+     void *space;
+     int busy;             /* claimed by an execution */
+} scratch_slot;
+
+struct scratch_pool_s {
+     int n;
+     scratch_slot slot[1]; /* N of them */
+};
+
+#if defined(__ATOMIC_SEQ_CST) /* gcc >= 4.7, clang */
+static int claim(int *busy)
+{
+     int old = 0;
+     return __atomic_compare_exchange_n(busy, &old, 1, 0, __ATOMIC_ACQUIRE,
+					__ATOMIC_RELAXED);
+}
+
+static void release(int *busy)
+{
+     __atomic_store_n(busy, 0, __ATOMIC_RELEASE);
+}
+#elif defined(_MSC_VER)
+static int claim(int *busy)
+{
+     return _InterlockedCompareExchange((volatile long *) busy, 1, 0) == 0;
+}
+
+static void release(int *busy)
+{
+     _InterlockedExchange((volatile long *) busy, 0);
+}
+#else
+/* without atomic operations, overlapping executions may race on BUSY
+   and share a space; there are no threads to execute them anyway */
+static int claim(int *busy)
+{
+     if (*busy)
+	  return 0;
+     *busy = 1;
+     return 1;
+}
+
+static void release(int *busy)
+{
+     *busy = 0;
+}
+#endif
+
+#ifdef THREAD_LOCAL
+static THREAD_LOCAL char *workspace; /* bound to the calling thread */
+#endif
+
+/* the workspace size of the apiplan whose tree is being awakened,
+   i.e. the bytes assigned so far, or 0 outside of
+   X(scratch_layout_begin) and X(scratch_layout_end).  That awakening
+   holds the planner lock, and thus at most one is in progress.  The
+   planner meanwhile awakens plans for timing (AWAKE_ZERO) in other
+   threads, which never execute in a workspace and are left out. */
+static size_t *layout;
+
+/* the size of the pools of that awakening */
+static int layout_nspace;
+
+/* each plan's share of the workspace starts at this alignment, as
+   apply() may hand its scratch to SIMD codelets */
+#define WS_ALIGN 64
+
+/* EGO needs N bytes of scratch; reserve them while EGO is awake, if
+   PLNR asks for it */
+void X(plan_scratch)(plan *ego, const planner *plnr, size_t n)
+{
+     if (n > ego->scratchsz)
+	  ego->scratchsz = n;
+     if (NO_EXECUTE_ALLOCP(plnr))
+	  ego->scratch_reserve = 1;
+}
+
+static scratch_pool *mkpool(size_t n, int nspace)
+{
+     scratch_pool *pool = (scratch_pool *)
+	  MALLOC(sizeof(scratch_pool)
+		 + sizeof(scratch_slot) * (unsigned) (nspace - 1), BUFFERS);
+     int i;
+
+     pool->n = nspace;
+     for (i = 0; i < nspace; ++i) {
+	  pool->slot[i].space = MALLOC(n, BUFFERS);
+	  pool->slot[i].busy = 0;
+     }
+     return pool;
+}
+
+static void pool_destroy(scratch_pool *pool)
+{
+     int i;
+
+     for (i = 0; i < pool->n; ++i)
+	  X(ifree)(pool->slot[i].space);
+     X(ifree)(pool);
+}
+
+void X(scratch_awake)(plan *ego, enum wakefulness wakefulness)
+{
+     if (wakefulness == SLEEPY) {
+	  if (ego->scratch)
+	       pool_destroy(ego->scratch);
+	  ego->scratch = 0;
+     } else if (ego->scratchsz) {
+	  int inlayout = (layout && wakefulness != AWAKE_ZERO);
+	  if (ego->scratch_reserve && !ego->scratch)
+	       ego->scratch = mkpool(ego->scratchsz,
+				     inlayout ? layout_nspace : 1);
+	  if (inlayout) {
+	       ego->scratchoff = *layout;
+	       *layout += (ego->scratchsz + WS_ALIGN - 1)
+		    & ~(size_t)(WS_ALIGN - 1);
+	  }
+     }
+}
+
+/* bracket the awakening of the root plan of an apiplan planned with
+   NTHR threads, setting *WSSZ to the size of the workspace for the
+   whole tree, or to 0 if we cannot use workspaces */
+void X(scratch_layout_begin)(size_t *wssz, int nthr)
+{
+     *wssz = 0;
+     layout = wssz;
+     layout_nspace = nthr < 1 ? 1 : (nthr > MAXSPACE ? MAXSPACE : nthr);
+}
+
+void X(scratch_layout_end)(void)
+{
+#ifndef THREAD_LOCAL
+     *layout = 0;
+#endif
+     layout = 0;
+}
+
+/* make WS the workspace of the calling thread, returning the previous
+   one.  WS must be large enough for every plan executed meanwhile. */
+void *X(scratch_bind)(void *ws)
+{
+#ifdef THREAD_LOCAL
+     void *prev = workspace;
+     workspace = (char *) ws;
+     return prev;
+#else
+     UNUSED(ws);
+     return 0;
+#endif
+}
+
+void *X(scratch_workspace)(void)
+{
+#ifdef THREAD_LOCAL
+     return workspace;
+#else
+     return 0;
+#endif
+}
+
+/* apply() sees a const plan, but the pool is not part of its state */
+void *X(scratch_get)(const plan *ego, size_t n)
+{
+     scratch_pool *pool = ego->scratch;
+     int i;
+
+#ifdef THREAD_LOCAL
+     if (workspace && n <= ego->scratchsz)
+	  return workspace + ego->scratchoff;
+#endif
+     if (pool) {
+	  A(n <= ego->scratchsz);
+	  for (i = 0; i < pool->n; ++i)
+	       if (claim(&pool->slot[i].busy))
+		    return pool->slot[i].space;
+     }
+     return MALLOC(n, BUFFERS);
+}
+
+void X(scratch_put)(const plan *ego, void *p)
+{
+     scratch_pool *pool = ego->scratch;
+     int i;
+
+#ifdef THREAD_LOCAL
+     if (workspace && p == workspace + ego->scratchoff)
+	  return;
+#endif
+     if (pool)
+	  for (i = 0; i < pool->n; ++i)
+	       if (p == pool->slot[i].space) {
+		    release(&pool->slot[i].busy);
+		    return;
+	       }
+     X(ifree)(p);
+}
@@ -20,6 +20,7 @@
 
 
 #include "kernel/ifftw.h"
+#include <math.h>
 
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
@@ -106,6 +107,13 @@ double X(elapsed_since)(const planner *plnr, const problem *p, crude_time t0)
      return t;
 }
 
+/* the same, without the cost hook, which is a collective operation
+   under MPI */
+double X(elapsed_since_local)(crude_time t0)
+{
+     return elapsed_since(t0);
+}
+
 #ifdef WITH_SLOW_TIMER
 /* excruciatingly slow; only use this if there is no choice! */
 typedef crude_time ticks;
@@ -139,15 +147,13 @@ typedef crude_time ticks;
   }
 
 
-  double X(measure_execution_time)(const planner *plnr, 
-				   plan *pln, const problem *p)
+  /* the minimum of TIME_REPEAT runs */
+  static double measure_min(const planner *plnr, plan *pln,
+			    const problem *p)
   {
        int iter;
        int repeat;
 
-       X(plan_awake)(pln, AWAKE_ZERO);
-       p->adt->zero(p);
-
   start_over:
        for (iter = 1; iter; iter *= 2) {
 	    double tmin = 0;
@@ -172,23 +178,191 @@ typedef crude_time ticks;
 		      break;
 	    }
 
-	    if (tmin >= TIME_MIN) {
-		 X(plan_awake)(pln, SLEEPY);
+	    if (tmin >= TIME_MIN)
 		 return tmin / (double) iter;
-	    }
        }
        goto start_over; /* may happen if timer is screwed up */
   }
 
+  /* Robust timing, for machines where the minimum is not
+     reproducible, e.g. because other jobs share the cores or because
+     of frequency scaling.  After a warm-up, take TIME_NSAMPLE samples
+     and return the mean of the middle half of them, which is about as
+     robust as the median but less noisy.  *ERR is the half-width of
+     a 95% confidence interval of the median, estimated from the
+     interquartile range (McGill, Tukey and Larsen, 1978), which the
+     planner uses to detect ties (see break_tie() in planner.c).
+
+     With ROBUST_TIMING > 1, we also compare the tick counter with the
+     wall clock.  If the rate of the counter differs from the one that
+     X(tick_rate) found when the user enabled the check, then the
+     counter runs at the clock of the core, which has changed, and we
+     take the samples again, up to TIME_NRETRY times.  The comparison
+     only means something when the samples span TIME_MIN_SEC seconds
+     of wall clock, and we do not lengthen the samples to that end,
+     since a small plan that runs in a loop for that long is timed in
+     a state of the caches unlike the one of its parent plan. */
+#  ifndef TIME_NSAMPLE
+#    define TIME_NSAMPLE (2 * TIME_REPEAT + 1)
+#  endif
+
+#  define TIME_NRETRY 2
+#  define TIME_RATE_TOL 0.05
+
+  static void sort(double *t, int n)
+  {
+       int i, j;
+
+       for (i = 1; i < n; ++i) {
+	    double x = t[i];
+	    for (j = i; j > 0 && t[j - 1] > x; --j)
+		 t[j] = t[j - 1];
+	    t[j] = x;
+       }
+  }
+
+  static double measure_hooked(const planner *plnr, plan *pln,
+			       const problem *p, int iter)
+  {
+       double t = measure(pln, p, iter);
+       if (plnr->cost_hook)
+	    t = plnr->cost_hook(p, t, COST_MAX);
+       return t;
+  }
+
+  /* whether the rate of the counter has changed.  All processes
+     must agree under MPI, since they take the samples in lockstep */
+  static int rate_changedp(const planner *plnr, const problem *p,
+			   double nticks, double secs)
+  {
+       double changed = 0.0;
+
+       if (secs >= TIME_MIN_SEC)
+	    changed = fabs(nticks / secs / plnr->tick_rate - 1.0)
+		 > TIME_RATE_TOL;
+       if (plnr->cost_hook)
+	    changed = plnr->cost_hook(p, changed, COST_MAX);
+       return changed > 0.0;
+  }
+
+  static double measure_robust(const planner *plnr, plan *pln,
+			       const problem *p, double *err)
+  {
+       double t[TIME_NSAMPLE], tm;
+       int iter, n, i, q, retry;
+       int check = (plnr->robust_timing > 1 && plnr->tick_rate > 0);
+
+  start_over:
+       /* warm up, and find the number of iterations for which a
+	  sample lasts TIME_MIN */
+       for (iter = 1; iter; iter *= 2) {
+	    double t1 = measure_hooked(plnr, pln, p, iter);
+	    if (t1 < 0)
+		 goto start_over;
+	    if (t1 >= TIME_MIN)
+		 break;
+       }
+       if (!iter)
+	    goto start_over; /* may happen if timer is screwed up */
+
+       for (retry = 0; ; ++retry) {
+	    crude_time begin = X(get_crude_time)();
+	    ticks t0 = getticks(), t1;
+
+	    for (n = 0; n < TIME_NSAMPLE; ) {
+		 if ((t[n++] = measure_hooked(plnr, pln, p, iter)) < 0)
+		      goto start_over;
+
+		 /* do not run for too long */
+		 if (n >= 3
+		     && X(elapsed_since)(plnr, p, begin) > FFTW_TIME_LIMIT)
+		      break;
+	    }
+	    t1 = getticks();
+
+	    if (!check || retry >= TIME_NRETRY
+		|| !rate_changedp(plnr, p, elapsed(t1, t0),
+				  elapsed_since(begin)))
+		 break;
+       }
+
+       sort(t, n);
+       q = n / 4;
+       for (tm = 0.0, i = q; i < n - q; ++i)
+	    tm += t[i];
+       tm /= (double) (n - 2 * q);
+       *err = 1.57 * (t[n - 1 - q] - t[q]) / sqrt((double) n)
+	    / (double) iter;
+       return tm / (double) iter;
+  }
+
+  /* Return the execution time of PLN, and store into *ERR the
+     uncertainty of the result, or 0 if we don't know it */
+  double X(measure_execution_time_err)(const planner *plnr, plan *pln,
+				       const problem *p, double *err)
+  {
+       double t;
+
+       X(planner_lock)(plnr);
+       X(plan_awake)(pln, AWAKE_ZERO);
+       X(planner_unlock)(plnr);
+       p->adt->zero(p);
+
+       *err = 0.0;
+       if (plnr->robust_timing)
+	    t = measure_robust(plnr, pln, p, err);
+       else
+	    t = measure_min(plnr, pln, p);
+
+       X(planner_lock)(plnr);
+       X(plan_awake)(pln, SLEEPY);
+       X(planner_unlock)(plnr);
+       return t;
+  }
+
+#ifndef WITH_SLOW_TIMER
+  /* the rate of the tick counter, in ticks per second */
+  double X(tick_rate)(void)
+  {
+       crude_time begin = X(get_crude_time)();
+       ticks t0 = getticks(), t1;
+       double secs;
+
+       do {
+	    t1 = getticks();
+	    secs = elapsed_since(begin);
+       } while (secs < 10 * TIME_MIN_SEC);
+       return elapsed(t1, t0) / secs;
+  }
+#else
+  double X(tick_rate)(void)
+  {
+       return 0.0; /* the counter is the wall clock */
+  }
+#endif
+
 #else /* no cycle counter */
 
-  double X(measure_execution_time)(const planner *plnr, 
-				   plan *pln, const problem *p)
+  double X(measure_execution_time_err)(const planner *plnr, plan *pln,
+				       const problem *p, double *err)
   {
        UNUSED(plnr);
        UNUSED(p);
        UNUSED(pln);
+       *err = 0.0;
        return -1.0;
   }
 
+  double X(tick_rate)(void)
+  {
+       return 0.0;
+  }
+
 #endif
+
+double X(measure_execution_time)(const planner *plnr, 
+				 plan *pln, const problem *p)
+{
+     double err;
+     return X(measure_execution_time_err)(plnr, pln, p, &err);
+}
@@ -22,10 +22,15 @@
 /* trigonometric functions */
 #include "kernel/ifftw.h"
 #include <math.h>
+#include <float.h>
 
 #if defined(TRIGREAL_IS_LONG_DOUBLE)
 #  define COS cosl
 #  define SIN sinl
+#  define EXP expl
+#  define LOG logl
+#  define ATAN2 atan2l
+#  define TRIG_MANT_DIG LDBL_MANT_DIG
 #  define KTRIG(x) (x##L)
 #  if defined(HAVE_DECL_SINL) && !HAVE_DECL_SINL
      extern long double sinl(long double x);
@@ -36,12 +41,23 @@
 #elif defined(TRIGREAL_IS_QUAD)
 #  define COS cosq
 #  define SIN sinq
+#  define EXP expq
+#  define LOG logq
+#  define ATAN2 atan2q
+#  define TRIG_MANT_DIG 113
 #  define KTRIG(x) (x##Q)
    extern __float128 sinq(__float128 x);
    extern __float128 cosq(__float128 x);
+   extern __float128 expq(__float128 x);
+   extern __float128 logq(__float128 x);
+   extern __float128 atan2q(__float128 y, __float128 x);
 #else
 #  define COS cos
 #  define SIN sin
+#  define EXP exp
+#  define LOG log
+#  define ATAN2 atan2
+#  define TRIG_MANT_DIG DBL_MANT_DIG
 #  define KTRIG(x) (x)
 #endif
 
@@ -166,12 +182,13 @@ static void rotate_generic(triggen *p, INT m, R xr, R xi, R *res)
      res[1] = xi * w[0] + xr * (FFT_SIGN * w[1]);
 }
 
-triggen *X(mktriggen)(enum wakefulness wakefulness, INT n)
+static triggen *mktriggen(enum wakefulness wakefulness, INT n)
 {
      INT i, n0, n1;
      triggen *p = (triggen *)MALLOC(sizeof(*p), TWIDDLES);
 
      p->n = n;
+     p->wakefulness = wakefulness;
      p->W0 = p->W1 = 0;
      p->cexp = 0;
      p->rotate = 0;
@@ -226,9 +243,134 @@ triggen *X(mktriggen)(enum wakefulness wakefulness, INT n)
      return p;
 }
 
-void X(triggen_destroy)(triggen *p)
+static size_t triggen_bytes(const triggen *p)
+{
+     size_t sz = sizeof(*p);
+     if (p->W0)
+	  sz += (size_t)(p->twradix + (p->n + p->twradix - 1) / p->twradix)
+	       * 2 * sizeof(trigreal);
+     return sz;
+}
+
+/* Generators are memoized: the twiddles of many plans, and of the
+   same plan awakened over and over during planning, need the same
+   tables.  Generators in use are shared via REFCNT, and up to NKEEP
+   unused ones are kept in case they are needed again.  TRIGS lists
+   all of them, most recently used first.  Like the twiddle table, the
+   list is only accessed by X(plan_awake), under the planner lock. */
+#define NKEEP 16
+
+static triggen *trigs = 0;
+static int nunused = 0;
+static table_stats stats;
+
+triggen *X(mktriggen)(enum wakefulness wakefulness, INT n)
+{
+     triggen **q, *p;
+
+     for (q = &trigs; (p = *q); q = &p->cdr) {
+	  if (p->n == n && p->wakefulness == wakefulness) {
+	       /* move to front */
+	       *q = p->cdr;
+	       p->cdr = trigs;
+	       trigs = p;
+	       if (p->refcnt++ == 0)
+		    --nunused;
+	       ++stats.hit;
+	       return p;
+	  }
+     }
+
+     p = mktriggen(wakefulness, n);
+     p->refcnt = 1;
+     p->cdr = trigs;
+     trigs = p;
+     ++stats.miss;
+     ++stats.nelem;
+     stats.bytes += triggen_bytes(p);
+     return p;
+}
+
+/* deallocate the least recently used unused generator */
+static void evict(void)
 {
+     triggen **q, **lru = 0, *p;
+
+     for (q = &trigs; *q; q = &((*q)->cdr))
+	  if (!(*q)->refcnt)
+	       lru = q;
+
+     A(lru);
+     p = *lru;
+     *lru = p->cdr;
+     --nunused;
+     --stats.nelem;
+     stats.bytes -= triggen_bytes(p);
      X(ifree0)(p->W0);
      X(ifree0)(p->W1);
      X(ifree)(p);
 }
+
+void X(triggen_destroy)(triggen *p)
+{
+     A(p->refcnt > 0);
+     if (--p->refcnt == 0 && ++nunused > NKEEP)
+	  evict();
+}
+
+/* forget the unused generators */
+void X(triggen_cleanup)(void)
+{
+     while (nunused > 0)
+	  evict();
+}
+
+void X(triggen_stats)(table_stats *st)
+{
+     *st = stats;
+}
+
+/* split X into high and low halves whose products are exact
+   (Dekker) */
+static void split(trigreal x, trigreal *hi, trigreal *lo)
+{
+     trigreal c = 1, y;
+     int i;
+
+     for (i = 0; i < (TRIG_MANT_DIG + 1) / 2; ++i)
+	  c += c;
+     y = (c + 1) * x;
+     *hi = y - (y - x);
+     *lo = x - *hi;
+}
+
+/* X * Y = P + *E exactly, returning P */
+static trigreal two_product(trigreal x, trigreal y, trigreal *e)
+{
+     trigreal xh, xl, yh, yl, p;
+
+     split(x, &xh, &xl);
+     split(y, &yh, &yl);
+     p = x * y;
+     *e = ((xh * yh - p) + xh * yl + xl * yh) + xl * yl;
+     return p;
+}
+
+/* RES = Z^T for the complex Z = (ZR, ZI) != 0 and real T, on the
+   principal branch.  Unlike the generators above, the point Z need
+   not be a root of unity, as for the spirals of the chirp-z
+   transform.  We use Z as given, and thus the modulus of a Z within
+   rounding of the unit circle is raised to the power T as well.  The
+   rounding error of the phase T * arg(Z) grows with T, and COS and
+   SIN, which reduce their argument modulo 2 pi exactly, cannot
+   recover it; we keep it from two_product() and rotate by it. */
+void X(cpow)(trigreal zr, trigreal zi, trigreal t, trigreal *res)
+{
+     trigreal m2 = zr * zr + zi * zi;
+     trigreal r = (m2 == 1) ? 1 : EXP(t * LOG(m2) / 2);
+     trigreal e, theta = two_product(t, ATAN2(zi, zr), &e);
+     trigreal c = COS(theta), s = SIN(theta);
+
+     res[0] = r * (c - e * s);
+     res[1] = r * (s + e * c);
+}
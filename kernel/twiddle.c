@@ -24,10 +24,12 @@
 #include "kernel/ifftw.h"
 #include <math.h>
 
-#define HASHSZ 109
-
-/* hash table of known twiddle factors */
-static twid *twlist[HASHSZ];
+/* hash table of known twiddle factors, with HASHSZ buckets.  The
+   table grows with the number of entries, lest the chains get long
+   when many plans are alive, and it is deallocated when empty. */
+static twid **twlist = 0;
+static INT hashsz = 0;
+static table_stats stats;
 
 static INT hash(INT n, INT r)
 {
@@ -35,7 +37,28 @@ static INT hash(INT n, INT r)
 
      if (h < 0) h = -h;
 
-     return (h % HASHSZ);
+     return (h % hashsz);
+}
+
+static void rehash(INT nsz)
+{
+     twid **old = twlist, *p, *q;
+     INT osz = hashsz, h;
+
+     hashsz = nsz;
+     twlist = (twid **)MALLOC(nsz * sizeof(twid *), TWIDDLES);
+     for (h = 0; h < nsz; ++h)
+	  twlist[h] = 0;
+
+     for (h = 0; h < osz; ++h) {
+	  for (p = old[h]; p; p = q) {
+	       INT g = hash(p->n, p->r);
+	       q = p->cdr;
+	       p->cdr = twlist[g];
+	       twlist[g] = p;
+	  }
+     }
+     X(ifree0)(old);
 }
 
 static int equal_instr(const tw_instr *p, const tw_instr *q)
@@ -66,9 +89,10 @@ static int equal_instr(const tw_instr *p, const tw_instr *q)
 
 static int ok_twid(const twid *t, 
 		   enum wakefulness wakefulness,
-		   const tw_instr *q, INT n, INT r, INT m)
+		   const tw_instr *q, INT n, INT r, INT m, int node)
 {
      return (wakefulness == t->wakefulness &&
+	     node == t->node &&
 	     n == t->n &&
 	     r == t->r && 
 	     m <= t->m && 
@@ -76,12 +100,15 @@ static int ok_twid(const twid *t,
 }
 
 static twid *lookup(enum wakefulness wakefulness,
-		    const tw_instr *q, INT n, INT r, INT m)
+		    const tw_instr *q, INT n, INT r, INT m, int node)
 {
      twid *p;
 
+     if (!hashsz)
+	  return 0;
+
      for (p = twlist[hash(n,r)]; 
-	  p && !ok_twid(p, wakefulness, q, n, r, m); 
+	  p && !ok_twid(p, wakefulness, q, n, r, m, node); 
 	  p = p->cdr)
           ;
      return p;
@@ -200,9 +227,21 @@ static void mktwiddle(enum wakefulness wakefulness,
      twid *p;
      INT h;
 
-     if ((p = lookup(wakefulness, instr, n, r, m))) {
+     /* Tables are shared among plans, but not across NUMA nodes:
+	a thread that awakes a plan on another node gets its own
+	replica, computed (and thus first-touched) by itself.  See
+	X(threads_plan_awake) for how threaded plans exploit this. */
+     int node = X(numa_node)();
+
+     if ((p = lookup(wakefulness, instr, n, r, m, node))) {
           ++p->refcnt;
+	  ++stats.hit;
      } else {
+	  INT ntw, vl;
+
+	  if (stats.nelem >= hashsz)
+	       rehash(X(next_prime)(2 * (INT)stats.nelem + 109));
+
 	  p = (twid *) MALLOC(sizeof(twid), TWIDDLES);
 	  p->n = n;
 	  p->r = r;
@@ -210,7 +249,14 @@ static void mktwiddle(enum wakefulness wakefulness,
 	  p->instr = instr;
 	  p->refcnt = 1;
 	  p->wakefulness = wakefulness;
+	  p->node = node;
 	  p->W = compute(wakefulness, instr, n, r, m);
+	  ntw = twlen0(r, instr, &vl);
+	  p->bytes = (size_t)(ntw * (m / vl)) * sizeof(R);
+
+	  ++stats.miss;
+	  ++stats.nelem;
+	  stats.bytes += p->bytes;
 
 	  /* cons! onto twlist */
 	  h = hash(n, r);
@@ -231,9 +277,16 @@ static void twiddle_destroy(twid **pp)
 	  for (q = &twlist[hash(p->n, p->r)]; *q; q = &((*q)->cdr)) {
 	       if (*q == p) {
 		    *q = p->cdr;
+		    --stats.nelem;
+		    stats.bytes -= p->bytes;
 		    X(ifree)(p->W);
 		    X(ifree)(p);
 		    *pp = 0;
+		    if (stats.nelem == 0) {
+			 X(ifree)(twlist);
+			 twlist = 0;
+			 hashsz = 0;
+		    }
 		    return;
 	       }
 	  }
@@ -254,3 +307,8 @@ void X(twiddle_awake)(enum wakefulness wakefulness, twid **pp,
 	      break;
      }
 }
+
+void X(twiddle_stats)(table_stats *st)
+{
+     *st = stats;
+}
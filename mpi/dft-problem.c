@@ -78,7 +78,8 @@ static const problem_adt padt =
      hash,
      zero,
      print,
-     destroy
+     destroy,
+     0
 };
 
 problem *XM(mkproblem_dft)(const dtensor *sz, INT vn,
@@ -46,7 +46,8 @@ typedef struct {
      int preserve_input;
 } P;
 
-static void transpose_chunks(int *sched, int n_pes, int my_pe,
+static void transpose_chunks(const plan *ego_,
+			     int *sched, int n_pes, int my_pe,
 			     INT *sbs, INT *sbo, INT *rbs, INT *rbo,
 			     MPI_Comm comm,
 			     R *I, R *O)
@@ -58,7 +59,7 @@ static void transpose_chunks(int *sched, int n_pes, int my_pe,
 	  /* TODO: explore non-synchronous send/recv? */
 
 	  if (I == O) {
-	       R *buf = (R*) MALLOC(sizeof(R) * sbs[0], BUFFERS);
+	       R *buf = (R*) X(scratch_get)(ego_, sizeof(R) * sbs[0]);
 	       
 	       for (i = 0; i < n_pes; ++i) {
 		    int pe = sched[i];
@@ -78,7 +79,7 @@ static void transpose_chunks(int *sched, int n_pes, int my_pe,
 		    }
 	       }
 
-	       X(ifree)(buf);
+	       X(scratch_put)(ego_, buf);
 	  }
 	  else { /* I != O */
 	       for (i = 0; i < n_pes; ++i) {
@@ -111,14 +112,14 @@ static void apply(const plan *ego_, R *I, R *O)
 	  if (ego->preserve_input) I = O;
 
 	  /* transpose chunks globally */
-	  transpose_chunks(ego->sched, ego->n_pes, ego->my_pe,
+	  transpose_chunks(ego_, ego->sched, ego->n_pes, ego->my_pe,
 			   ego->send_block_sizes, ego->send_block_offsets,
 			   ego->recv_block_sizes, ego->recv_block_offsets,
 			   ego->comm, O, I);
      }
      else if (ego->preserve_input) {
 	  /* transpose chunks globally */
-	  transpose_chunks(ego->sched, ego->n_pes, ego->my_pe,
+	  transpose_chunks(ego_, ego->sched, ego->n_pes, ego->my_pe,
 			   ego->send_block_sizes, ego->send_block_offsets,
 			   ego->recv_block_sizes, ego->recv_block_offsets,
 			   ego->comm, I, O);
@@ -127,7 +128,7 @@ static void apply(const plan *ego_, R *I, R *O)
      }
      else {
 	  /* transpose chunks globally */
-	  transpose_chunks(ego->sched, ego->n_pes, ego->my_pe,
+	  transpose_chunks(ego_, ego->sched, ego->n_pes, ego->my_pe,
 			   ego->send_block_sizes, ego->send_block_offsets,
 			   ego->recv_block_sizes, ego->recv_block_offsets,
 			   ego->comm, I, I);
@@ -452,6 +453,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 	  fill1_comm_sched(pln->sched, my_pe, n_pes);
 	  if (sort_pe >= 0)
 	       sort1_comm_sched(pln->sched, n_pes, sort_pe, ascending);
+	  X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * sbs[0]);
      }
 
      X(ops_zero)(&pln->super.super.ops);
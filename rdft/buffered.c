@@ -47,7 +47,7 @@ static void apply(const plan *ego_, R *I, R *O)
      INT ivs_by_nbuf = ego->ivs_by_nbuf, ovs_by_nbuf = ego->ovs_by_nbuf;
      R *bufs;
 
-     bufs = (R *)MALLOC(sizeof(R) * nbuf * ego->bufdist, BUFFERS);
+     bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * ego->bufdist);
 
      for (i = nbuf; i <= vl; i += nbuf) {
           /* transform to bufs: */
@@ -59,7 +59,7 @@ static void apply(const plan *ego_, R *I, R *O)
 	  O += ovs_by_nbuf;
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_rdft *) ego->cldrest;
@@ -79,7 +79,7 @@ static void apply_hc2r(const plan *ego_, R *I, R *O)
      INT ivs_by_nbuf = ego->ivs_by_nbuf, ovs_by_nbuf = ego->ovs_by_nbuf;
      R *bufs;
 
-     bufs = (R *)MALLOC(sizeof(R) * nbuf * ego->bufdist, BUFFERS);
+     bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * ego->bufdist);
 
      for (i = nbuf; i <= vl; i += nbuf) {
           /* copy input into bufs: */
@@ -91,7 +91,7 @@ static void apply_hc2r(const plan *ego_, R *I, R *O)
 	  O += ovs_by_nbuf;
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_rdft *) ego->cldrest;
@@ -304,6 +304,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 
      pln->nbuf = nbuf;
      pln->bufdist = bufdist;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * nbuf * bufdist);
 
      {
 	  opcnt t;
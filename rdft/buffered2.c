@@ -48,7 +48,7 @@ static void apply_r2hc(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
      plan_dft *cldcpy = (plan_dft *) ego->cldcpy;
      INT i, vl = ego->vl, nbuf = ego->nbuf;
      INT ivs_by_nbuf = ego->ivs_by_nbuf, ovs_by_nbuf = ego->ovs_by_nbuf;
-     R *bufs = (R *)MALLOC(sizeof(R) * nbuf * ego->bufdist, BUFFERS);
+     R *bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * ego->bufdist);
      R *bufr = bufs + ego->roffset;
      R *bufi = bufs + ego->ioffset;
      plan_rdft2 *cldrest;
@@ -63,7 +63,7 @@ static void apply_r2hc(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
 	  cr += ovs_by_nbuf; ci += ovs_by_nbuf;
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_rdft2 *) ego->cldrest;
@@ -80,7 +80,7 @@ static void apply_hc2r(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
      plan_dft *cldcpy = (plan_dft *) ego->cldcpy;
      INT i, vl = ego->vl, nbuf = ego->nbuf;
      INT ivs_by_nbuf = ego->ivs_by_nbuf, ovs_by_nbuf = ego->ovs_by_nbuf;
-     R *bufs = (R *)MALLOC(sizeof(R) * nbuf * ego->bufdist, BUFFERS);
+     R *bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * ego->bufdist);
      R *bufr = bufs + ego->roffset;
      R *bufi = bufs + ego->ioffset;
      plan_rdft2 *cldrest;
@@ -95,7 +95,7 @@ static void apply_hc2r(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
 	  r0 += ovs_by_nbuf; r1 += ovs_by_nbuf;
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_rdft2 *) ego->cldrest;
@@ -342,6 +342,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 
      pln->nbuf = nbuf;
      pln->bufdist = bufdist;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * nbuf * bufdist);
 
      {
 	  opcnt t;
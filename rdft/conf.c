@@ -48,6 +48,11 @@ static const solvtab s =
 
      SOLVTAB(X(hc2hc_generic_register)),
 
+     SOLVTAB(X(conv_register)),
+     SOLVTAB(X(edge_register)),
+     SOLVTAB(X(edge_fourstep_register)),
+     SOLVTAB(X(edge_rank_geq2_register)),
+
      SOLVTAB_END
 };
 
@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "rdft/rdft.h"
+#include "dft/dft.h"
+
+/* Convolution by FFTs: transform the zero-padded input, multiply by
+   the spectrum of the kernel, and transform back.
+
+   With BLOCKF == 0, the whole input is transformed at once, in any
+   rank, with transform sizes n + nk - 1 rounded up to a 2,3,5-smooth
+   size for linear convolutions, and n for circular ones.
+
+   With BLOCKF > 0, a long one-dimensional linear convolution is
+   computed by overlap-save: blocks of N >= BLOCKF * nk inputs,
+   overlapping by nk - 1, are convolved circularly, and the last
+   N - nk + 1 outputs of each block belong to the linear convolution.
+   Each block stays in cache from the forward transform through the
+   multiplication to the inverse transform, rather than making three
+   passes over the whole signal. */
+
+/* smallest block for overlap-save, to amortize the per-block cost */
+#define MIN_BLOCK 256
+
+/* the BLOCKF of the registered solvers, in increasing order */
+static const INT blockfs[] = { 0, 4, 16 };
+
+typedef struct {
+     solver super;
+     INT blockf;
+} S;
+
+typedef struct {
+     plan_rdft super;
+     plan *cldf, *cldb;  /* forward and inverse FFTs of the buffer */
+     R *k;            /* the kernel, contiguous */
+     R *K;            /* spectrum of the kernel, divided by N */
+     tensor *isz;     /* input dims, user strides -> buffer strides */
+     tensor *osz;     /* output dims, buffer strides -> user strides */
+     tensor *ksz;     /* kernel dims, kernel strides -> buffer strides */
+     INT N;           /* number of points of the transform */
+     INT nb;          /* reals in the buffer */
+     INT ns;          /* complex numbers in the spectrum */
+     size_t bufsz;    /* bytes of buffer and spectrum */
+     int c;           /* reals per element */
+     int realp;
+     INT blockf;
+
+     /* overlap-save only: */
+     INT n, nk, nout, L, nblk, is, os;
+} P;
+
+static R *spectrum(const P *ego, R *b)
+{
+     return ego->realp ? b + ego->nb : b;
+}
+
+static void forward(const P *ego, R *b)
+{
+     if (ego->realp) {
+	  plan_rdft2 *cldf = (plan_rdft2 *) ego->cldf;
+	  R *s = spectrum(ego, b);
+	  cldf->apply(ego->cldf, b, b + 1, s, s + 1);
+     } else {
+	  plan_dft *cldf = (plan_dft *) ego->cldf;
+	  cldf->apply(ego->cldf, b, b + 1, b, b + 1);
+     }
+}
+
+static void inverse(const P *ego, R *b)
+{
+     if (ego->realp) {
+	  plan_rdft2 *cldb = (plan_rdft2 *) ego->cldb;
+	  R *s = spectrum(ego, b);
+	  cldb->apply(ego->cldb, b, b + 1, s, s + 1);
+     } else {
+	  /* backward DFT by swapping real and imaginary parts */
+	  plan_dft *cldb = (plan_dft *) ego->cldb;
+	  cldb->apply(ego->cldb, b + 1, b, b + 1, b);
+     }
+}
+
+static void multiply(INT ns, const R *K, R *s)
+{
+     INT i;
+
+     for (i = 0; i < ns; ++i) {
+	  E xr = s[2*i], xi = s[2*i+1];
+	  E wr = K[2*i], wi = K[2*i+1];
+	  s[2*i] = xr * wr - xi * wi;
+	  s[2*i+1] = xr * wi + xi * wr;
+     }
+}
+
+static void zerobuf(INT n, R *b)
+{
+     INT i;
+     for (i = 0; i < n; ++i) b[i] = K(0.0);
+}
+
+static void apply_whole(const plan *ego_, R *I, R *O)
+{
+     const P *ego = (const P *) ego_;
+     R *b = (R *) X(scratch_get)(ego_, ego->bufsz);
+
+     zerobuf(ego->nb, b);
+     X(conv_cpy)(ego->isz->rnk, ego->isz->dims, ego->c, I, b);
+     forward(ego, b);
+     multiply(ego->ns, ego->K, spectrum(ego, b));
+     inverse(ego, b);
+     X(conv_cpy)(ego->osz->rnk, ego->osz->dims, ego->c, b, O);
+
+     X(scratch_put)(ego_, b);
+}
+
+static void apply_blocks(const plan *ego_, R *I, R *O)
+{
+     const P *ego = (const P *) ego_;
+     INT i, i0, i1, blk, cnt, s0, t0;
+     INT N = ego->N, n = ego->n, nk = ego->nk, L = ego->L;
+     INT is = ego->is, os = ego->os;
+     int c = ego->c;
+     R *b = (R *) X(scratch_get)(ego_, ego->bufsz);
+
+     for (blk = 0; blk < ego->nblk; ++blk) {
+	  /* inputs s0 .. s0 + N - 1, zero outside 0 .. n - 1 */
+	  t0 = blk * L;
+	  s0 = t0 - (nk - 1);
+	  i0 = X(imax)(0, -s0);
+	  i1 = X(imin)(N, n - s0);
+	  zerobuf(c * i0, b);
+	  if (c == 1)
+	       for (i = i0; i < i1; ++i)
+		    b[i] = I[(s0 + i) * is];
+	  else
+	       for (i = i0; i < i1; ++i) {
+		    b[2*i] = I[(s0 + i) * is];
+		    b[2*i+1] = I[(s0 + i) * is + 1];
+	       }
+	  zerobuf(c * (N - i1), b + c * i1);
+
+	  forward(ego, b);
+	  multiply(ego->ns, ego->K, spectrum(ego, b));
+	  inverse(ego, b);
+
+	  /* the first nk - 1 outputs are corrupted by the wrap-around */
+	  cnt = X(imin)(L, ego->nout - t0);
+	  if (c == 1)
+	       for (i = 0; i < cnt; ++i)
+		    O[(t0 + i) * os] = b[nk - 1 + i];
+	  else
+	       for (i = 0; i < cnt; ++i) {
+		    O[(t0 + i) * os] = b[2*(nk - 1 + i)];
+		    O[(t0 + i) * os + 1] = b[2*(nk - 1 + i)+1];
+	       }
+     }
+
+     X(scratch_put)(ego_, b);
+}
+
+static void mkspectrum(P *ego)
+{
+     INT i;
+     R *b = (R *) MALLOC(ego->bufsz, BUFFERS);
+     const R *s;
+     E Nf = (E) ego->N;
+
+     zerobuf(ego->nb, b);
+     X(conv_cpy)(ego->ksz->rnk, ego->ksz->dims, ego->c, ego->k, b);
+
+     /* cldf must be awake */
+     forward(ego, b);
+
+     ego->K = (R *) MALLOC(sizeof(R) * 2 * ego->ns, TWIDDLES);
+     s = spectrum(ego, b);
+     for (i = 0; i < 2 * ego->ns; ++i)
+	  ego->K[i] = s[i] / Nf;
+
+     X(ifree)(b);
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+
+     X(plan_awake)(ego->cldf, wakefulness);
+     X(plan_awake)(ego->cldb, wakefulness);
+
+     switch (wakefulness) {
+	 case SLEEPY:
+	      X(ifree0)(ego->K);
+	      ego->K = 0;
+	      break;
+	 default:
+	      A(!ego->K);
+	      mkspectrum(ego);
+	      break;
+     }
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cldb);
+     X(plan_destroy_internal)(ego->cldf);
+     X(ifree)(ego->k);
+     X(tensor_destroy2)(ego->isz, ego->osz);
+     X(tensor_destroy)(ego->ksz);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *) ego_;
+     if (ego->blockf)
+	  p->print(p, "(conv-overlap-save-%D/%D-x%D%(%p%)%(%p%))",
+		   ego->nk, ego->N, ego->nblk, ego->cldf, ego->cldb);
+     else
+	  p->print(p, "(conv-%s-%D%(%p%)%(%p%))",
+		   ego->c == 1 ? "r" : "c", ego->N, ego->cldf, ego->cldb);
+}
+
+static INT choose_transform_size(INT minsz)
+{
+     while (!X(factors_into_small_primes)(minsz))
+	  ++minsz;
+     return minsz;
+}
+
+static INT block_size(INT blockf, INT nk)
+{
+     return choose_transform_size(X(imax)(blockf * nk, MIN_BLOCK));
+}
+
+static int applicable(const S *ego, const problem_conv *p, INT *N)
+{
+     int i, rnk = p->sz->rnk;
+
+     if (ego->blockf) {
+	  INT n = p->sz->dims[0].n, nk = p->ksz->dims[0].n;
+	  if (rnk != 1 || p->circular)
+	       return 0;
+
+	  /* blocks read inputs after the outputs that precede them */
+	  if (p->I == p->O)
+	       return 0;
+
+	  N[0] = block_size(ego->blockf, nk);
+
+	  /* at least two blocks, else use the whole transform */
+	  if (N[0] >= choose_transform_size(n + nk - 1))
+	       return 0;
+
+	  /* leave a block size to the first solver that picks it */
+	  for (i = 1; blockfs[i] < ego->blockf; ++i)
+	       if (block_size(blockfs[i], nk) == N[0])
+		    return 0;
+
+	  return 1;
+     }
+
+     for (i = 0; i < rnk; ++i)
+	  N[i] = p->circular ? p->sz->dims[i].n
+	       : choose_transform_size(p->sz->dims[i].n
+				       + p->ksz->dims[i].n - 1);
+     return 1;
+}
+
+/* row-major dimensions N, with real strides on one side and
+   complex strides of the r2c output on the other */
+static tensor *mkfftsz(int rnk, const INT *N, int realp, int r2c)
+{
+     tensor *sz = X(mktensor)(rnk);
+     INT rs = 1, cs = 2;
+     int i;
+
+     for (i = rnk - 1; i >= 0; --i) {
+	  sz->dims[i].n = N[i];
+	  if (!realp) {
+	       sz->dims[i].is = sz->dims[i].os = cs;
+	       cs *= N[i];
+	  } else {
+	       sz->dims[i].is = r2c ? rs : cs;
+	       sz->dims[i].os = r2c ? cs : rs;
+	       rs *= N[i];
+	       cs *= (i == rnk - 1) ? N[i] / 2 + 1 : N[i];
+	  }
+     }
+     return sz;
+}
+
+static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
+{
+     const S *ego = (const S *) ego_;
+     const problem_conv *p = (const problem_conv *) p_;
+     P *pln;
+     plan *cldf = 0, *cldb = 0;
+     R *buf = 0;
+     INT *N, Ntot, ns, nb, kn;
+     size_t bufsz;
+     tensor *fsz, *isz, *osz, *ksz;
+     int i, rnk = p->sz->rnk, c = p->realp ? 1 : 2;
+
+     static const plan_adt padt = {
+	  X(conv_solve), awake, print, destroy
+     };
+
+     N = (INT *) MALLOC(sizeof(INT) * (unsigned) rnk, PLANS);
+     if (!applicable(ego, p, N))
+	  goto nada;
+
+     for (i = 0, Ntot = 1; i < rnk; ++i)
+	  Ntot *= N[i];
+     if (p->realp) {
+	  nb = Ntot;
+	  ns = Ntot / N[rnk - 1] * (N[rnk - 1] / 2 + 1);
+     } else {
+	  nb = 2 * Ntot;
+	  ns = Ntot;
+     }
+
+     bufsz = sizeof(R) * (nb + (p->realp ? 2 * ns : 0));
+     buf = (R *) MALLOC(bufsz, BUFFERS);
+
+     /* the buffer is scratch, so the children may destroy it */
+     if (p->realp) {
+	  cldf = X(mkplan_f_d)(plnr,
+			       X(mkproblem_rdft2_d_3pointers)(
+				    mkfftsz(rnk, N, 1, 1),
+				    X(mktensor_1d)(1, 0, 0),
+				    buf, buf + nb, buf + nb + 1, R2HC),
+			       0, 0, NO_DESTROY_INPUT);
+	  if (!cldf) goto nada;
+	  cldb = X(mkplan_f_d)(plnr,
+			       X(mkproblem_rdft2_d_3pointers)(
+				    mkfftsz(rnk, N, 1, 0),
+				    X(mktensor_1d)(1, 0, 0),
+				    buf, buf + nb, buf + nb + 1, HC2R),
+			       0, 0, NO_DESTROY_INPUT);
+	  if (!cldb) goto nada;
+     } else {
+	  cldf = X(mkplan_f_d)(plnr,
+			       X(mkproblem_dft_d)(
+				    mkfftsz(rnk, N, 0, 1),
+				    X(mktensor_1d)(1, 0, 0),
+				    buf, buf + 1, buf, buf + 1),
+			       0, 0, NO_DESTROY_INPUT);
+	  if (!cldf) goto nada;
+	  cldb = X(mkplan_f_d)(plnr,
+			       X(mkproblem_dft_d)(
+				    mkfftsz(rnk, N, 0, 1),
+				    X(mktensor_1d)(1, 0, 0),
+				    buf + 1, buf, buf + 1, buf),
+			       0, 0, NO_DESTROY_INPUT);
+	  if (!cldb) goto nada;
+     }
+
+     X(ifree)(buf);
+     buf = 0;
+
+     /* copies between the user arrays and the buffer */
+     fsz = mkfftsz(rnk, N, p->realp, 1);
+     isz = X(tensor_copy)(p->sz);
+     osz = X(tensor_copy)(p->sz);
+     ksz = X(tensor_copy)(p->ksz);
+     for (i = 0; i < rnk; ++i) {
+	  INT bs = fsz->dims[i].is;
+	  isz->dims[i].os = bs;
+	  osz->dims[i].is = bs;
+	  if (!p->circular)
+	       osz->dims[i].n += p->ksz->dims[i].n - 1;
+	  ksz->dims[i].os = bs;
+     }
+     X(tensor_destroy)(fsz);
+     X(ifree)(N);
+
+     pln = MKPLAN_RDFT(P, &padt, ego->blockf ? apply_blocks : apply_whole);
+
+     for (i = 0, kn = c; i < rnk; ++i)
+	  kn *= p->ksz->dims[i].n;
+     pln->k = (R *) MALLOC(sizeof(R) * kn, PLANS);
+     for (i = 0; i < kn; ++i)
+	  pln->k[i] = p->k[i];
+
+     pln->cldf = cldf;
+     pln->cldb = cldb;
+     pln->K = 0;
+     pln->isz = isz;
+     pln->osz = osz;
+     pln->ksz = ksz;
+     pln->N = Ntot;
+     pln->nb = nb;
+     pln->ns = ns;
+     pln->bufsz = bufsz;
+     pln->c = c;
+     pln->realp = p->realp;
+     pln->blockf = ego->blockf;
+
+     if (ego->blockf) {
+	  pln->n = p->sz->dims[0].n;
+	  pln->nk = p->ksz->dims[0].n;
+	  pln->nout = pln->n + pln->nk - 1;
+	  pln->L = Ntot - pln->nk + 1;
+	  pln->nblk = (pln->nout + pln->L - 1) / pln->L;
+	  pln->is = p->sz->dims[0].is;
+	  pln->os = p->sz->dims[0].os;
+     } else {
+	  pln->n = pln->nk = pln->nout = pln->L = pln->is = pln->os = 0;
+	  pln->nblk = 1;
+     }
+
+     X(plan_scratch)(&pln->super.super, plnr, bufsz);
+
+     {
+	  /* operations for one block */
+	  opcnt ops;
+	  X(ops_zero)(&ops);
+	  X(ops_add2)(&cldf->ops, &ops);
+	  X(ops_add2)(&cldb->ops, &ops);
+	  ops.add += 2 * ns;
+	  ops.mul += 4 * ns;
+	  ops.other += 2 * nb;
+	  X(ops_zero)(&pln->super.super.ops);
+	  X(ops_madd2)(pln->nblk, &ops, &pln->super.super.ops);
+     }
+
+     return &(pln->super.super);
+
+ nada:
+     X(ifree)(N);
+     X(ifree0)(buf);
+     X(plan_destroy_internal)(cldb);
+     X(plan_destroy_internal)(cldf);
+     return (plan *) 0;
+}
+
+static solver *mksolver(INT blockf)
+{
+     static const solver_adt sadt = { PROBLEM_CONV, mkplan, 0 };
+     S *slv = MKSOLVER(S, &sadt);
+     slv->blockf = blockf;
+     return &(slv->super);
+}
+
+void X(conv_register)(planner *p)
+{
+     size_t i;
+
+     for (i = 0; i < NELEM(blockfs); ++i)
+	  REGISTER_SOLVER(p, mksolver(blockfs[i]));
+}
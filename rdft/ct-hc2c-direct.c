@@ -148,7 +148,7 @@ static void apply_buf(const plan *ego_, R *cr, R *ci)
      INT mb = 1, me = (ego->m+1) / 2;
      size_t bufsz = ego->r * batchsz * 2 * sizeof(R);
 
-     BUF_ALLOC(R *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, R *, buf, bufsz);
 
      for (i = 0; i < v; ++i, cr += ego->vs, ci += ego->vs) {
 	  R *Rp = cr;
@@ -169,7 +169,7 @@ static void apply_buf(const plan *ego_, R *cr, R *ci)
 
      }
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 /*************************************************************
@@ -365,6 +365,9 @@ static plan *mkcldw(const hc2c_solver *ego_, rdft_kind kind,
      pln->cld0 = cld0;
      pln->cldm = cldm;
      pln->extra_iter = extra_iter;
+     if (ego->bufferedp)
+	  PLAN_BUF_SCRATCH(&pln->super.super, plnr,
+			   r * compute_batchsize(r) * 2 * sizeof(R));
 
      X(ops_zero)(&pln->super.super.ops);
      X(ops_madd2)(v * (((m - 1) / 2) / e->genus->vl),
@@ -262,6 +262,9 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      pln->r = r;
      X(ops_add)(&cld->ops, &cldw->ops, &pln->super.super.ops);
 
+     /* the twiddle pass reads and writes the whole array, in place */
+     cldw->footprint = 2.0 * sizeof(R) * (double)n * (double)v;
+
      /* inherit could_prune_now_p attribute from cldw */
      pln->super.super.could_prune_now_p = cldw->could_prune_now_p;
 
@@ -285,12 +288,32 @@ hc2c_solver *X(mksolver_hc2c)(size_t size, INT r,
      return slv;
 }
 
+/* see kernel/profile.c */
+static void apply_profiled(const plan *ego, R *cr, R *ci)
+{
+     plan_profile *pr = ego->prof;
+     double t0 = X(profile_now)();
+     ((hc2capply) pr->apply)(ego, cr, ci);
+     X(profile_account)(pr, t0);
+}
+
+static void profile(plan *ego_, int on)
+{
+     plan_hc2c *ego = (plan_hc2c *) ego_;
+     if (on) {
+	  ego_->prof->apply = (void (*)(void)) ego->apply;
+	  ego->apply = apply_profiled;
+     } else
+	  ego->apply = (hc2capply) ego_->prof->apply;
+}
+
 plan *X(mkplan_hc2c)(size_t size, const plan_adt *adt, hc2capply apply)
 {
      plan_hc2c *ego;
 
      ego = (plan_hc2c *) X(mkplan)(size, adt);
      ego->apply = apply;
+     ego->super.profile = profile;
 
      return &(ego->super);
 }
@@ -66,7 +66,7 @@ static void apply(const plan *ego_, R *I, R *O)
      R *buf, *omega;
      R r0;
 
-     buf = (R *) MALLOC(sizeof(R) * npad, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * npad);
 
      /* First, permute the input, storing in buf: */
      g = ego->g; 
@@ -151,7 +151,7 @@ static void apply(const plan *ego_, R *I, R *O)
 #endif
      A(gpower == 1);
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 static R *mkomega(enum wakefulness wakefulness,
@@ -347,6 +347,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      pln->omega = 0;
      pln->n = n;
      pln->npad = npad;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * npad);
      pln->is = is;
      pln->os = os;
 
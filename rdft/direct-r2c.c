@@ -132,7 +132,7 @@ static void iterate(const P *ego, R *I, R *O,
      INT batchsz = compute_batchsize(n);
      size_t bufsz = n * batchsz * sizeof(R);
 
-     BUF_ALLOC(R *, buf, bufsz);
+     PLAN_BUF_ALLOC(&ego->super.super, R *, buf, bufsz);
 
      for (i = 0; i < vl - batchsz; i += batchsz) {
 	  dobatch(ego, I, O, buf, batchsz);
@@ -141,7 +141,7 @@ static void iterate(const P *ego, R *I, R *O,
      }
      dobatch(ego, I, O, buf, vl - i);
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(&ego->super.super, buf, bufsz);
 }
 
 static void apply_buf_r2hc(const plan *ego_, R *I, R *O)
@@ -298,6 +298,8 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 
      b = compute_batchsize(n);
      pln->brs = X(mkstride)(n, 2 * b);
+     if (ego->bufferedp)
+	  PLAN_BUF_SCRATCH(&pln->super.super, plnr, n * b * sizeof(R));
      pln->bcsr = X(mkstride)(n, b);
      pln->bcsi = X(mkstride)(n, -b);
      pln->bioffset = ioffset(p->kind[0], n, b);
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "rdft/rdft.h"
+#include "dft/dft.h"
+
+/* Edge operations on a large one-dimensional DFT, by the four-step
+   algorithm: for n = r * m,
+
+     X[k1 + m k2] = sum_j w_r^(j k2) w_n^(j k1) sum_i x[j + r i] w_m^(i k1),
+
+   computed as r DFTs of size m, the twiddle factors, and m DFTs of size
+   r.  The first pass gathers the inputs of a few size-m DFTs into a
+   buffer through the load operation; the last pass multiplies a few
+   columns k1 by the twiddle factors, transforms them, and applies the
+   store operation while they are in cache.  With r close to sqrt(n),
+   each pass works on blocks that fit in cache however large n is. */
+
+/* bytes of data in a block */
+#define MAXBYTES 262144
+
+typedef solver S;
+
+typedef struct {
+     plan_dft super;
+     plan *cld1, *cld1rem;  /* q and r % q DFTs of size m */
+     plan *cld2, *cld2rem;  /* b and m % b DFTs of size r, in place */
+     edgeop load, store;
+     triggen *t;
+     INT n, r, m, q, b, is, os;
+     int swapped;
+     size_t bufsz;
+} P;
+
+/* gather the inputs of the size-m DFTs j0 .. j0 + cnt - 1 into the
+   buffer B, as if transposed, and apply the load operation */
+static void gather(const P *ego, INT j0, INT cnt, const R *ri, const R *ii,
+		   R *b)
+{
+     INT i, j, r = ego->r, m = ego->m, is = ego->is;
+
+     for (i = 0; i < m; ++i) {
+	  const R *xr = ri + (j0 + r * i) * is, *xi = ii + (j0 + r * i) * is;
+	  R *br = b + 2 * i;
+	  for (j = 0; j < cnt; ++j) {
+	       br[2 * m * j] = xr[j * is];
+	       br[2 * m * j + 1] = xi[j * is];
+	  }
+	  if (ego->swapped)
+	       X(edge_apply)(&ego->load, br + 1, br, cnt, 2 * m, j0 + r * i);
+	  else
+	       X(edge_apply)(&ego->load, br, br + 1, cnt, 2 * m, j0 + r * i);
+     }
+}
+
+/* multiply the columns k0 .. k0 + cnt - 1 by the twiddle factors */
+static void twiddle(const P *ego, INT k0, INT cnt, R *ro, R *io)
+{
+     INT j, k, m = ego->m, os = ego->os;
+     triggen *t = ego->t;
+
+     for (j = 1; j < ego->r; ++j) {
+	  R *xr = ro + (j * m + k0) * os, *xi = io + (j * m + k0) * os;
+	  for (k = 0; k < cnt; ++k) {
+	       R res[2];
+	       t->rotate(t, j * (k0 + k), xr[k * os], xi[k * os], res);
+	       xr[k * os] = res[0];
+	       xi[k * os] = res[1];
+	  }
+     }
+}
+
+static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     INT j0, k0, cnt, r = ego->r, m = ego->m, os = ego->os;
+
+     if (ego->load.kind != EDGE_NONE) {
+	  R *b = (R *) X(scratch_get)(ego_, ego->bufsz);
+	  for (j0 = 0; j0 < r; j0 += ego->q) {
+	       plan_dft *cld1 = (plan_dft *)
+		    (j0 + ego->q <= r ? ego->cld1 : ego->cld1rem);
+	       cnt = X(imin)(ego->q, r - j0);
+	       gather(ego, j0, cnt, ri, ii, b);
+	       cld1->apply((plan *) cld1, b, b + 1,
+			   ro + j0 * m * os, io + j0 * m * os);
+	  }
+	  X(scratch_put)(ego_, b);
+     } else {
+	  plan_dft *cld1 = (plan_dft *) ego->cld1;
+	  cld1->apply((plan *) cld1, ri, ii, ro, io);
+     }
+
+     for (k0 = 0; k0 < m; k0 += ego->b) {
+	  plan_dft *cld2 = (plan_dft *)
+	       (k0 + ego->b <= m ? ego->cld2 : ego->cld2rem);
+	  R *xr = ro + k0 * os, *xi = io + k0 * os;
+	  INT k2;
+
+	  cnt = X(imin)(ego->b, m - k0);
+	  twiddle(ego, k0, cnt, ro, io);
+	  cld2->apply((plan *) cld2, xr, xi, xr, xi);
+	  if (ego->store.kind != EDGE_NONE)
+	       for (k2 = 0; k2 < r; ++k2) {
+		    R *yr = xr + m * k2 * os, *yi = xi + m * k2 * os;
+		    if (ego->swapped)
+			 X(edge_apply)(&ego->store, yi, yr, cnt, os,
+				       k0 + m * k2);
+		    else
+			 X(edge_apply)(&ego->store, yr, yi, cnt, os,
+				       k0 + m * k2);
+	       }
+     }
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+
+     X(plan_awake)(ego->cld1, wakefulness);
+     X(plan_awake)(ego->cld1rem, wakefulness);
+     X(plan_awake)(ego->cld2, wakefulness);
+     X(plan_awake)(ego->cld2rem, wakefulness);
+
+     switch (wakefulness) {
+	 case SLEEPY:
+	      X(triggen_destroy)(ego->t);
+	      ego->t = 0;
+	      break;
+	 default:
+	      A(!ego->t);
+	      /* there are as many twiddle factors as elements, too many
+		 to compute each of them from scratch */
+	      ego->t = X(mktriggen)(wakefulness == AWAKE_SINCOS ?
+				    AWAKE_SQRTN_TABLE : wakefulness, ego->n);
+	      break;
+     }
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cld2rem);
+     X(plan_destroy_internal)(ego->cld2);
+     X(plan_destroy_internal)(ego->cld1rem);
+     X(plan_destroy_internal)(ego->cld1);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *) ego_;
+     p->print(p, "(edge-fourstep-%D-%D%(%p%)%(%p%)%(%p%)%(%p%))",
+	      ego->r, ego->m, ego->cld1, ego->cld1rem,
+	      ego->cld2, ego->cld2rem);
+}
+
+/* the largest divisor of N not above sqrt(N) */
+static INT choose_radix(INT n)
+{
+     INT r;
+     for (r = X(isqrt)(n); r > 1; --r)
+	  if (n % r == 0)
+	       return r;
+     return 1;
+}
+
+static int applicable(const problem_edge *p, INT *r)
+{
+     const problem_dft *q = (const problem_dft *) p->p;
+
+     if (p->p->adt->problem_kind != PROBLEM_DFT
+	 || q->sz->rnk != 1 || q->vecsz->rnk != 0)
+	  return 0;
+
+     /* the first pass would overwrite inputs of later blocks */
+     if (q->ri == q->ro)
+	  return 0;
+
+     /* small transforms are a single block of edge.c */
+     if (q->sz->dims[0].n * 2 * (INT)sizeof(R) <= MAXBYTES)
+	  return 0;
+
+     *r = choose_radix(q->sz->dims[0].n);
+     return *r > 1;
+}
+
+static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
+{
+     const problem_edge *p = (const problem_edge *) p_;
+     const problem_dft *d;
+     P *pln;
+     plan *cld1 = 0, *cld1rem = 0, *cld2 = 0, *cld2rem = 0;
+     R *buf = 0;
+     INT n, r, m, q, b, is, os;
+     size_t bufsz = 0;
+     int loadp = (p->load.kind != EDGE_NONE);
+
+     static const plan_adt padt = {
+	  X(edge_solve), awake, print, destroy
+     };
+
+     UNUSED(ego);
+     if (!applicable(p, &r))
+	  return (plan *) 0;
+
+     d = (const problem_dft *) p->p;
+     n = d->sz->dims[0].n;
+     is = d->sz->dims[0].is;
+     os = d->sz->dims[0].os;
+     m = n / r;
+     q = X(imax)(1, X(imin)(r, MAXBYTES / (2 * m * (INT)sizeof(R))));
+     b = X(imax)(1, X(imin)(m, MAXBYTES / (2 * r * (INT)sizeof(R))));
+
+     if (loadp) {
+	  bufsz = sizeof(R) * 2 * (size_t)(q * m);
+	  buf = (R *) MALLOC(bufsz, BUFFERS);
+
+	  /* the buffer is scratch, so the children may destroy it */
+	  cld1 = X(mkplan_f_d)(plnr,
+			       X(mkproblem_dft_d)(
+				    X(mktensor_1d)(m, 2, os),
+				    X(mktensor_1d)(q, 2 * m, m * os),
+				    buf, buf + 1,
+				    TAINT(d->ro, q * m * os),
+				    TAINT(d->io, q * m * os)),
+			       0, 0, NO_DESTROY_INPUT);
+	  if (!cld1)
+	       goto nada;
+	  if (r % q) {
+	       INT od = (r / q) * q * m * os;
+	       cld1rem = X(mkplan_f_d)(plnr,
+				       X(mkproblem_dft_d)(
+					    X(mktensor_1d)(m, 2, os),
+					    X(mktensor_1d)(r % q, 2 * m,
+							   m * os),
+					    buf, buf + 1,
+					    d->ro + od, d->io + od),
+				       0, 0, NO_DESTROY_INPUT);
+	       if (!cld1rem)
+		    goto nada;
+	  }
+
+	  X(ifree)(buf);
+	  buf = 0;
+     } else {
+	  cld1 = X(mkplan_d)(plnr,
+			     X(mkproblem_dft_d)(
+				  X(mktensor_1d)(m, r * is, os),
+				  X(mktensor_1d)(r, is, m * os),
+				  d->ri, d->ii, d->ro, d->io));
+	  if (!cld1)
+	       goto nada;
+     }
+
+     cld2 = X(mkplan_d)(plnr,
+			X(mkproblem_dft_d)(
+			     X(mktensor_1d)(r, m * os, m * os),
+			     X(mktensor_1d)(b, os, os),
+			     TAINT(d->ro, b * os), TAINT(d->io, b * os),
+			     TAINT(d->ro, b * os), TAINT(d->io, b * os)));
+     if (!cld2)
+	  goto nada;
+     if (m % b) {
+	  INT od = (m / b) * b * os;
+	  cld2rem = X(mkplan_d)(plnr,
+				X(mkproblem_dft_d)(
+				     X(mktensor_1d)(r, m * os, m * os),
+				     X(mktensor_1d)(m % b, os, os),
+				     d->ro + od, d->io + od,
+				     d->ro + od, d->io + od));
+	  if (!cld2rem)
+	       goto nada;
+     }
+
+     pln = MKPLAN_DFT(P, &padt, apply);
+     pln->cld1 = cld1;
+     pln->cld1rem = cld1rem;
+     pln->cld2 = cld2;
+     pln->cld2rem = cld2rem;
+     pln->load = p->load;
+     pln->store = p->store;
+     pln->t = 0;
+     pln->n = n;
+     pln->r = r;
+     pln->m = m;
+     pln->q = q;
+     pln->b = b;
+     pln->is = is;
+     pln->os = os;
+     pln->swapped = p->swapped;
+     pln->bufsz = bufsz;
+     if (loadp)
+	  X(plan_scratch)(&pln->super.super, plnr, bufsz);
+
+     {
+	  opcnt t;
+	  X(ops_zero)(&t);
+	  if (loadp) {
+	       X(ops_madd2)(r / q, &cld1->ops, &t);
+	       if (cld1rem)
+		    X(ops_add2)(&cld1rem->ops, &t);
+	  } else
+	       X(ops_add2)(&cld1->ops, &t);
+	  X(ops_madd2)(m / b, &cld2->ops, &t);
+	  if (cld2rem)
+	       X(ops_add2)(&cld2rem->ops, &t);
+	  /* twiddle factors */
+	  t.add += 2 * (r - 1) * m;
+	  t.mul += 4 * (r - 1) * m;
+	  t.other += 2 * n * (loadp + (p->store.kind != EDGE_NONE));
+	  X(ops_cpy)(&t, &pln->super.super.ops);
+     }
+
+     return &(pln->super.super);
+
+ nada:
+     X(ifree0)(buf);
+     X(plan_destroy_internal)(cld2rem);
+     X(plan_destroy_internal)(cld2);
+     X(plan_destroy_internal)(cld1rem);
+     X(plan_destroy_internal)(cld1);
+     return (plan *) 0;
+}
+
+static solver *mksolver(void)
+{
+     static const solver_adt sadt = { PROBLEM_EDGE, mkplan, 0 };
+     return MKSOLVER(S, &sadt);
+}
+
+void X(edge_fourstep_register)(planner *p)
+{
+     REGISTER_SOLVER(p, mksolver());
+}
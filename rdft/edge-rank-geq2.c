@@ -0,0 +1,550 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "rdft/rdft.h"
+#include "dft/dft.h"
+
+/* Edge operations on a single multi-dimensional transform, by rows and
+   columns: the transforms of the rows (the last dimensions, for each
+   index of the first one) and those of the columns (the first
+   dimension, for each index of the others, in place).  The first pass
+   applies the load operation a block of rows or columns at a time, and
+   the last pass applies the store operation to each block right after
+   transforming it, so that neither costs a pass over the whole arrays.
+
+   The rows come first, the load copying them into a buffer as in
+   edge.c, except for c2r transforms, whose columns come first, the
+   load operation being applied in place to the input, which they
+   destroy anyway. */
+
+/* bytes of data in a block */
+#define MAXBYTES 262144
+
+typedef solver S;
+
+typedef struct {
+     plan_dft super;   /* or plan_rdft2, plan_rdft: the same layout */
+     plan *rows, *rowsrem;  /* b1 and n0 % b1 rows */
+     plan *cols, *colsrem;  /* b2 and n1 % b2 columns, in place */
+     edgeop load, store;
+     tensor *isz;      /* input: user strides -> buffer or user strides */
+     tensor *osz;      /* output, in place */
+     INT b1, b2;
+     int kind;         /* of the transform */
+     int colsfirst;    /* c2r */
+     int ireal, oreal; /* real input or output */
+     int swapped;
+     size_t bufsz;
+} P;
+
+/* apply OP to the rows I0 .. I0 + CNT - 1 of T, copying them from
+   (sr, si) to (dr, di) unless the two are the same */
+static void visit_rows(const P *ego, const edgeop *op, const tensor *t,
+		       INT i0, INT cnt, R *sr, R *si, R *dr, R *di)
+{
+     const iodim *d = t->dims;
+     INT i;
+
+     if (ego->swapped) {
+	  R *x;
+	  x = sr; sr = si; si = x;
+	  x = dr; dr = di; di = x;
+     }
+     for (i = 0; i < cnt; ++i)
+	  X(edge_visit)(op, d + 1, 0, t->rnk - 1, i0 + i,
+			sr + i * d[0].is, si ? si + i * d[0].is : 0,
+			dr + i * d[0].os, di ? di + i * d[0].os : 0);
+}
+
+/* apply OP in place to the columns J0 .. J0 + CNT - 1 of T, the
+   indices of its second dimension */
+static void visit_cols(const P *ego, const edgeop *op, const tensor *t,
+		       INT j0, INT cnt, R *xr, R *xi)
+{
+     const iodim *d = t->dims;
+     INT i, j;
+
+     if (ego->swapped) {
+	  R *x = xr; xr = xi; xi = x;
+     }
+     for (i = 0; i < d[0].n; ++i) {
+	  INT o = i * d[0].is + j0 * d[1].is, first = i * d[1].n + j0;
+	  R *yr = xr + o, *yi = xi ? xi + o : 0;
+	  if (t->rnk == 2)
+	       X(edge_apply)(op, yr, yi, cnt, d[1].is, first);
+	  else
+	       for (j = 0; j < cnt; ++j)
+		    X(edge_visit)(op, d + 2, 0, t->rnk - 2, first + j,
+				  yr + j * d[1].is, yi ? yi + j * d[1].is : 0,
+				  yr + j * d[1].is, yi ? yi + j * d[1].is : 0);
+     }
+}
+
+/* the transforms of rows, from the input (ri, ii) to the output
+   (ro, io), where a real array is passed as (r0, r1) */
+static void rowfn(const P *ego, const plan *cld, R *ri, R *ii,
+		  R *ro, R *io)
+{
+     switch (ego->kind) {
+	 case PROBLEM_DFT:
+	      ((const plan_dft *) cld)->apply(cld, ri, ii, ro, io);
+	      break;
+	 case PROBLEM_RDFT:
+	      ((const plan_rdft *) cld)->apply(cld, ri, ro);
+	      break;
+	 default:
+	      if (ego->colsfirst)
+		   ((const plan_rdft2 *) cld)->apply(cld, ro, io, ri, ii);
+	      else
+		   ((const plan_rdft2 *) cld)->apply(cld, ri, ii, ro, io);
+	      break;
+     }
+}
+
+/* the transforms of columns, in place on (xr, xi) */
+static void colfn(const P *ego, const plan *cld, R *xr, R *xi)
+{
+     if (ego->kind == PROBLEM_RDFT)
+	  ((const plan_rdft *) cld)->apply(cld, xr, xr);
+     else if (ego->colsfirst)
+	  /* HC2R must swap re/im parts to get IDFT, as in
+	     rank-geq2-rdft2.c */
+	  ((const plan_dft *) cld)->apply(cld, xi, xr, xi, xr);
+     else
+	  ((const plan_dft *) cld)->apply(cld, xr, xi, xr, xi);
+}
+
+static void rows(const P *ego, R *ri, R *ii, R *ro, R *io)
+{
+     const iodim *di = ego->isz->dims, *d = ego->osz->dims;
+     INT i0, cnt, n0 = d[0].n;
+     int loadp = !ego->colsfirst && ego->load.kind != EDGE_NONE;
+     int storep = ego->colsfirst && ego->store.kind != EDGE_NONE;
+     R *b = 0;
+
+     if (loadp)
+	  b = (R *) X(scratch_get)(&ego->super.super, ego->bufsz);
+
+     for (i0 = 0; i0 < n0; i0 += ego->b1) {
+	  R *xr = ri + i0 * di[0].is, *xi = ii ? ii + i0 * di[0].is : 0;
+	  R *yr = ro + i0 * d[0].is, *yi = io ? io + i0 * d[0].is : 0;
+	  const plan *cld = (i0 + ego->b1 <= n0) ? ego->rows : ego->rowsrem;
+
+	  cnt = X(imin)(ego->b1, n0 - i0);
+	  if (b) {
+	       visit_rows(ego, &ego->load, ego->isz, i0, cnt,
+			  xr, ego->ireal ? 0 : xi, b, ego->ireal ? 0 : b + 1);
+	       rowfn(ego, cld, b, b + 1, yr, yi);
+	  } else
+	       rowfn(ego, cld, xr, xi, yr, yi);
+
+	  if (storep)
+	       visit_rows(ego, &ego->store, ego->osz, i0, cnt,
+			  yr, ego->oreal ? 0 : yi, yr, ego->oreal ? 0 : yi);
+     }
+
+     if (b)
+	  X(scratch_put)(&ego->super.super, b);
+}
+
+static void cols(const P *ego, const tensor *t, R *xr, R *xi)
+{
+     INT j0, cnt, n1 = t->dims[1].n, s1 = t->dims[1].is;
+     int loadp = ego->colsfirst && ego->load.kind != EDGE_NONE;
+     int storep = !ego->colsfirst && ego->store.kind != EDGE_NONE;
+     int realp = ego->colsfirst ? ego->ireal : ego->oreal;
+
+     for (j0 = 0; j0 < n1; j0 += ego->b2) {
+	  R *yr = xr + j0 * s1, *yi = xi ? xi + j0 * s1 : 0;
+	  const plan *cld = (j0 + ego->b2 <= n1) ? ego->cols : ego->colsrem;
+
+	  cnt = X(imin)(ego->b2, n1 - j0);
+	  if (loadp)
+	       visit_cols(ego, &ego->load, t, j0, cnt, xr, realp ? 0 : xi);
+	  colfn(ego, cld, yr, yi);
+	  if (storep)
+	       visit_cols(ego, &ego->store, t, j0, cnt, xr, realp ? 0 : xi);
+     }
+}
+
+static void apply_any(const P *ego, R *ri, R *ii, R *ro, R *io)
+{
+     if (ego->colsfirst) {
+	  cols(ego, ego->isz, ri, ii);
+	  rows(ego, ri, ii, ro, io);
+     } else {
+	  rows(ego, ri, ii, ro, io);
+	  cols(ego, ego->osz, ro, io);
+     }
+}
+
+static void apply_dft(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     apply_any((const P *) ego_, ri, ii, ro, io);
+}
+
+static void apply_rdft2(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
+{
+     const P *ego = (const P *) ego_;
+     if (ego->colsfirst)
+	  apply_any(ego, cr, ci, r0, r1);
+     else
+	  apply_any(ego, r0, r1, cr, ci);
+}
+
+static void apply_rdft(const plan *ego_, R *I, R *O)
+{
+     apply_any((const P *) ego_, I, 0, O, 0);
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+     X(plan_awake)(ego->rows, wakefulness);
+     X(plan_awake)(ego->rowsrem, wakefulness);
+     X(plan_awake)(ego->cols, wakefulness);
+     X(plan_awake)(ego->colsrem, wakefulness);
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->colsrem);
+     X(plan_destroy_internal)(ego->cols);
+     X(plan_destroy_internal)(ego->rowsrem);
+     X(plan_destroy_internal)(ego->rows);
+     X(tensor_destroy2)(ego->isz, ego->osz);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *) ego_;
+     p->print(p, "(edge-rank>=2-%D-%D%(%p%)%(%p%)%(%p%)%(%p%))",
+	      ego->b1, ego->b2, ego->rows, ego->rowsrem,
+	      ego->cols, ego->colsrem);
+}
+
+static int inplacep(const problem *p_)
+{
+     switch (p_->adt->problem_kind) {
+	 case PROBLEM_DFT:
+	      return ((const problem_dft *) p_)->ri
+		   == ((const problem_dft *) p_)->ro;
+	 case PROBLEM_RDFT:
+	      return ((const problem_rdft *) p_)->I
+		   == ((const problem_rdft *) p_)->O;
+	 default:
+	      return ((const problem_rdft2 *) p_)->r0
+		   == ((const problem_rdft2 *) p_)->cr;
+     }
+}
+
+static const tensor *transform_sz(const problem *p_)
+{
+     switch (p_->adt->problem_kind) {
+	 case PROBLEM_DFT: return ((const problem_dft *) p_)->sz;
+	 case PROBLEM_RDFT: return ((const problem_rdft *) p_)->sz;
+	 default: return ((const problem_rdft2 *) p_)->sz;
+     }
+}
+
+static const tensor *transform_vecsz(const problem *p_)
+{
+     switch (p_->adt->problem_kind) {
+	 case PROBLEM_DFT: return ((const problem_dft *) p_)->vecsz;
+	 case PROBLEM_RDFT: return ((const problem_rdft *) p_)->vecsz;
+	 default: return ((const problem_rdft2 *) p_)->vecsz;
+     }
+}
+
+static int colsfirstp(const problem *p_)
+{
+     return (p_->adt->problem_kind == PROBLEM_RDFT2
+	     && !R2HC_KINDP(((const problem_rdft2 *) p_)->kind));
+}
+
+static int applicable(const problem_edge *p, const planner *plnr)
+{
+     const tensor *sz = transform_sz(p->p);
+
+     if (transform_vecsz(p->p)->rnk != 0 || sz->rnk < 2)
+	  return 0;
+
+     /* the columns of a c2r transform are transformed in place on the
+	input, as in rank-geq2-rdft2.c */
+     if (colsfirstp(p->p))
+	  return inplacep(p->p) || !NO_DESTROY_INPUTP(plnr);
+
+     /* in place, a block of rows would overwrite inputs of the next
+	one, as in edge.c */
+     return !(p->load.kind != EDGE_NONE && inplacep(p->p)
+	      && X(iabs)(sz->dims[0].os) > X(iabs)(sz->dims[0].is));
+}
+
+/* the side tensor of X(edge_side) without its vector dimension */
+static tensor *mkside(const problem *p, int outp)
+{
+     int vrnk;
+     tensor *t = X(edge_side)(p, outp, &vrnk), *u;
+
+     A(vrnk == 1 && t->dims[0].n == 1);
+     u = X(tensor_copy_sub)(t, 1, t->rnk - 1);
+     X(tensor_destroy)(t);
+     return u;
+}
+
+/* X offset by D strides S, or, if D == 0, by any multiple of N of them */
+static R *shift(R *x, INT d, INT n, INT s)
+{
+     UNUSED(n); /* without SIMD, TAINT ignores it */
+     return d ? x + d * s : TAINT(x, n * s);
+}
+
+/* The transforms of CNT rows from row D on, any multiple of CNT of them
+   if D == 0, from the buffer B if LOADP. */
+static problem *mkrows(const problem *p_, const tensor *isz, INT cnt,
+		       INT d, int loadp, R *b)
+{
+     const tensor *sz0 = transform_sz(p_);
+     tensor *sz = X(tensor_copy_sub)(sz0, 1, sz0->rnk - 1), *vecsz;
+     INT is = sz0->dims[0].is, os = sz0->dims[0].os;
+     int i;
+
+     vecsz = X(mktensor_1d)(cnt, loadp ? isz->dims[0].os : is, os);
+     if (loadp)
+	  for (i = 0; i < sz->rnk; ++i)
+	       sz->dims[i].is = isz->dims[1 + i].os;
+
+     if (p_->adt->problem_kind == PROBLEM_DFT) {
+	  const problem_dft *p = (const problem_dft *) p_;
+	  return X(mkproblem_dft_d)(sz, vecsz,
+				    loadp ? b : shift(p->ri, d, cnt, is),
+				    loadp ? b + 1 : shift(p->ii, d, cnt, is),
+				    shift(p->ro, d, cnt, os),
+				    shift(p->io, d, cnt, os));
+     } else if (p_->adt->problem_kind == PROBLEM_RDFT) {
+	  const problem_rdft *p = (const problem_rdft *) p_;
+	  return X(mkproblem_rdft_d)(sz, vecsz,
+				     loadp ? b : shift(p->I, d, cnt, is),
+				     shift(p->O, d, cnt, os), p->kind + 1);
+     } else {
+	  const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	  int r2c = R2HC_KINDP(p->kind);
+	  INT rs = r2c ? is : os, cs = r2c ? os : is;
+	  R *r0 = shift(p->r0, d, cnt, rs), *r1 = shift(p->r1, d, cnt, rs);
+	  if (loadp) {
+	       /* distance between even elements */
+	       sz->dims[sz->rnk - 1].is *= 2;
+	       r0 = b; r1 = b + 1;
+	  }
+	  return X(mkproblem_rdft2_d)(sz, vecsz, r0, r1,
+				      shift(p->cr, d, cnt, cs),
+				      shift(p->ci, d, cnt, cs), p->kind);
+     }
+}
+
+/* The transforms of CNT columns from column D on, any multiple of CNT
+   of them if D == 0, in place on the side T of the array. */
+static problem *mkcols(const problem *p_, const tensor *t, INT cnt, INT d)
+{
+     tensor *sz = X(mktensor_1d)(t->dims[0].n, t->dims[0].is, t->dims[0].is);
+     tensor *vecsz = X(tensor_copy_sub)(t, 1, t->rnk - 1);
+     INT s = t->dims[1].is;
+     int i;
+
+     vecsz->dims[0].n = cnt;
+     for (i = 0; i < vecsz->rnk; ++i)
+	  vecsz->dims[i].os = vecsz->dims[i].is;
+
+     if (p_->adt->problem_kind == PROBLEM_DFT) {
+	  const problem_dft *p = (const problem_dft *) p_;
+	  R *xr = shift(p->ro, d, cnt, s), *xi = shift(p->io, d, cnt, s);
+	  return X(mkproblem_dft_d)(sz, vecsz, xr, xi, xr, xi);
+     } else if (p_->adt->problem_kind == PROBLEM_RDFT) {
+	  const problem_rdft *p = (const problem_rdft *) p_;
+	  R *x = shift(p->O, d, cnt, s);
+	  return X(mkproblem_rdft_d)(sz, vecsz, x, x, p->kind);
+     } else {
+	  const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	  R *xr = shift(p->cr, d, cnt, s), *xi = shift(p->ci, d, cnt, s);
+	  if (R2HC_KINDP(p->kind))
+	       return X(mkproblem_dft_d)(sz, vecsz, xr, xi, xr, xi);
+	  /* HC2R must swap re/im parts to get IDFT */
+	  return X(mkproblem_dft_d)(sz, vecsz, xi, xr, xi, xr);
+     }
+}
+
+/* the block of N elements that fits in MAXBYTES, E reals each */
+static INT choose_block(INT n, INT e)
+{
+     return X(imax)(1, X(imin)(n, MAXBYTES / (e * (INT)sizeof(R))));
+}
+
+static plan *mkplan(const solver *ego, const problem *p_, planner *plnr)
+{
+     const problem_edge *p = (const problem_edge *) p_;
+     P *pln;
+     plan *rows = 0, *rowsrem = 0, *cols = 0, *colsrem = 0;
+     tensor *isz = 0, *osz = 0;
+     const tensor *ct;
+     R *buf = 0;
+     INT b1, b2, n0, n1;
+     size_t bufsz = 0;
+     int i, colsfirst, rowop, colop, loadp;
+     int kind = p->p->adt->problem_kind;
+
+     static const plan_adt padt = {
+	  X(edge_solve), awake, print, destroy
+     };
+
+     UNUSED(ego);
+     if (!applicable(p, plnr))
+	  return (plan *) 0;
+
+     colsfirst = colsfirstp(p->p);
+     rowop = (colsfirst ? p->store.kind : p->load.kind) != EDGE_NONE;
+     colop = (colsfirst ? p->load.kind : p->store.kind) != EDGE_NONE;
+     loadp = !colsfirst && p->load.kind != EDGE_NONE;
+
+     isz = mkside(p->p, 0);
+     osz = mkside(p->p, 1);
+
+     /* blocks of rows and columns, sized by the contiguous strides
+	before they are replaced by those of the arrays */
+     ct = colsfirst ? isz : osz;
+     n0 = isz->dims[0].n;
+     n1 = ct->dims[1].n;
+     b1 = rowop ? choose_block(n0, X(imax)(isz->dims[0].os,
+					  osz->dims[0].os)) : n0;
+     b2 = colop ? choose_block(n1, n0 * ct->dims[1].os) : n1;
+
+     if (!loadp)
+	  for (i = 0; i < isz->rnk; ++i)
+	       isz->dims[i].os = isz->dims[i].is;
+     for (i = 0; i < osz->rnk; ++i)
+	  osz->dims[i].os = osz->dims[i].is;
+
+     if (loadp) {
+	  bufsz = sizeof(R) * (size_t)(b1 * isz->dims[0].os);
+	  /* initial allocation for the purpose of planning */
+	  buf = (R *) MALLOC(bufsz, BUFFERS);
+
+	  /* the buffer is scratch, so the children may destroy it */
+	  rows = X(mkplan_f_d)(plnr, mkrows(p->p, isz, b1, 0, 1, buf),
+			       0, 0, NO_DESTROY_INPUT);
+	  if (!rows)
+	       goto nada;
+	  if (n0 % b1) {
+	       rowsrem = X(mkplan_f_d)(plnr,
+				       mkrows(p->p, isz, n0 % b1,
+					      (n0 / b1) * b1, 1, buf),
+				       0, 0, NO_DESTROY_INPUT);
+	       if (!rowsrem)
+		    goto nada;
+	  }
+
+	  X(ifree)(buf);
+	  buf = 0;
+     } else {
+	  rows = X(mkplan_d)(plnr, mkrows(p->p, isz, b1, 0, 0, 0));
+	  if (!rows)
+	       goto nada;
+	  if (n0 % b1) {
+	       rowsrem = X(mkplan_d)(plnr, mkrows(p->p, isz, n0 % b1,
+						  (n0 / b1) * b1, 0, 0));
+	       if (!rowsrem)
+		    goto nada;
+	  }
+     }
+
+     ct = colsfirst ? isz : osz;
+     cols = X(mkplan_d)(plnr, mkcols(p->p, ct, b2, 0));
+     if (!cols)
+	  goto nada;
+     if (n1 % b2) {
+	  colsrem = X(mkplan_d)(plnr, mkcols(p->p, ct, n1 % b2,
+					     (n1 / b2) * b2));
+	  if (!colsrem)
+	       goto nada;
+     }
+
+     if (kind == PROBLEM_DFT)
+	  pln = MKPLAN_DFT(P, &padt, apply_dft);
+     else if (kind == PROBLEM_RDFT)
+	  pln = MKPLAN_RDFT(P, &padt, apply_rdft);
+     else
+	  pln = MKPLAN_RDFT2(P, &padt, apply_rdft2);
+
+     pln->rows = rows;
+     pln->rowsrem = rowsrem;
+     pln->cols = cols;
+     pln->colsrem = colsrem;
+     pln->load = p->load;
+     pln->store = p->store;
+     pln->isz = isz;
+     pln->osz = osz;
+     pln->b1 = b1;
+     pln->b2 = b2;
+     pln->kind = kind;
+     pln->colsfirst = colsfirst;
+     pln->ireal = (kind == PROBLEM_RDFT || (kind == PROBLEM_RDFT2
+					    && !colsfirst));
+     pln->oreal = (kind == PROBLEM_RDFT || colsfirst);
+     pln->swapped = p->swapped;
+     pln->bufsz = bufsz;
+     if (loadp)
+	  X(plan_scratch)(&pln->super.super, plnr, bufsz);
+
+     {
+	  opcnt t;
+	  INT ne = (p->load.kind != EDGE_NONE ? X(tensor_sz)(isz) : 0)
+	       + (p->store.kind != EDGE_NONE ? X(tensor_sz)(osz) : 0);
+	  X(ops_zero)(&t);
+	  X(ops_madd2)(n0 / b1, &rows->ops, &t);
+	  if (rowsrem)
+	       X(ops_add2)(&rowsrem->ops, &t);
+	  X(ops_madd2)(n1 / b2, &cols->ops, &t);
+	  if (colsrem)
+	       X(ops_add2)(&colsrem->ops, &t);
+	  t.other += ne;
+	  X(ops_cpy)(&t, &pln->super.super.ops);
+     }
+
+     return &(pln->super.super);
+
+ nada:
+     X(ifree0)(buf);
+     X(plan_destroy_internal)(colsrem);
+     X(plan_destroy_internal)(cols);
+     X(plan_destroy_internal)(rowsrem);
+     X(plan_destroy_internal)(rows);
+     X(tensor_destroy2)(isz, osz);
+     return (plan *) 0;
+}
+
+static solver *mksolver(void)
+{
+     static const solver_adt sadt = { PROBLEM_EDGE, mkplan, 0 };
+     return MKSOLVER(S, &sadt);
+}
+
+void X(edge_rank_geq2_register)(planner *p)
+{
+     REGISTER_SOLVER(p, mksolver());
+}
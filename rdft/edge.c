@@ -0,0 +1,520 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "rdft/rdft.h"
+#include "dft/dft.h"
+
+/* Edge operations on blocks of the transform vector.  Each block of
+   transforms is copied into a buffer through the load operation,
+   transformed from the buffer, and its output is passed through the
+   store operation while it is still in cache, so that neither costs a
+   pass over the whole arrays.  Without a vector, the block is the
+   whole transform, which is slow if it does not fit in cache; see
+   edge-fourstep.c for large one-dimensional DFTs and edge-rank-geq2.c
+   for multi-dimensional transforms. */
+
+typedef struct {
+     solver super;
+     size_t maxbytes_ndx;
+} S;
+
+/* bytes of data in a block */
+static const INT maxbytes[] = { 32768, 262144 };
+
+typedef struct {
+     plan_dft super;   /* or plan_rdft2, plan_rdft: the same layout */
+     plan *cld, *cldrem;
+     edgeop load, store;
+     tensor *isz;      /* input of a block: user strides -> buffer strides */
+     tensor *osz;      /* output of a block, in place */
+     int vrnk;         /* vector dimensions of isz and osz, 0 is blocked */
+     INT b, nblk, rem;
+     INT ivs, ovs;     /* strides of the blocked dimension */
+     int swapped;
+     int r2c;          /* RDFT2 problems: R2HC, else HC2R */
+     size_t bufsz;
+} P;
+
+/* apply OP to CNT blocked transforms, copying them from (sr, si) to
+   (dr, di) unless the two are the same */
+static void visit(const P *ego, const edgeop *op, const tensor *t, INT cnt,
+		  R *sr, R *si, R *dr, R *di)
+{
+     const iodim *d = t->dims;
+     INT i;
+
+     if (ego->swapped) {
+	  R *x;
+	  x = sr; sr = si; si = x;
+	  x = dr; dr = di; di = x;
+     }
+     for (i = 0; i < cnt; ++i)
+	  X(edge_visit)(op, d + 1, ego->vrnk - 1, t->rnk - 1, 0,
+			sr + i * d[0].is, si ? si + i * d[0].is : 0,
+			dr + i * d[0].os, di ? di + i * d[0].os : 0);
+}
+
+static void block_dft(const P *ego, const plan *cld_, INT cnt, R *b,
+		      R *ri, R *ii, R *ro, R *io)
+{
+     const plan_dft *cld = (const plan_dft *) cld_;
+
+     if (b) {
+	  visit(ego, &ego->load, ego->isz, cnt, ri, ii, b, b + 1);
+	  cld->apply(cld_, b, b + 1, ro, io);
+     } else
+	  cld->apply(cld_, ri, ii, ro, io);
+
+     if (ego->store.kind != EDGE_NONE)
+	  visit(ego, &ego->store, ego->osz, cnt, ro, io, ro, io);
+}
+
+static void apply_dft(const plan *ego_, R *ri, R *ii, R *ro, R *io)
+{
+     const P *ego = (const P *) ego_;
+     INT k, id = ego->b * ego->ivs, od = ego->b * ego->ovs;
+     R *b = 0;
+
+     if (ego->load.kind != EDGE_NONE)
+	  b = (R *) X(scratch_get)(ego_, ego->bufsz);
+
+     for (k = 0; k < ego->nblk; ++k) {
+	  block_dft(ego, ego->cld, ego->b, b, ri, ii, ro, io);
+	  ri += id; ii += id; ro += od; io += od;
+     }
+     if (ego->cldrem)
+	  block_dft(ego, ego->cldrem, ego->rem, b, ri, ii, ro, io);
+
+     if (b)
+	  X(scratch_put)(ego_, b);
+}
+
+static void block_rdft2(const P *ego, const plan *cld_, INT cnt, R *b,
+			R *r0, R *r1, R *cr, R *ci)
+{
+     const plan_rdft2 *cld = (const plan_rdft2 *) cld_;
+
+     if (ego->r2c) {
+	  if (b) {
+	       visit(ego, &ego->load, ego->isz, cnt, r0, 0, b, 0);
+	       cld->apply(cld_, b, b + 1, cr, ci);
+	  } else
+	       cld->apply(cld_, r0, r1, cr, ci);
+	  if (ego->store.kind != EDGE_NONE)
+	       visit(ego, &ego->store, ego->osz, cnt, cr, ci, cr, ci);
+     } else {
+	  if (b) {
+	       visit(ego, &ego->load, ego->isz, cnt, cr, ci, b, b + 1);
+	       cld->apply(cld_, r0, r1, b, b + 1);
+	  } else
+	       cld->apply(cld_, r0, r1, cr, ci);
+	  if (ego->store.kind != EDGE_NONE)
+	       visit(ego, &ego->store, ego->osz, cnt, r0, 0, r0, 0);
+     }
+}
+
+static void apply_rdft2(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
+{
+     const P *ego = (const P *) ego_;
+     INT k, id = ego->b * ego->ivs, od = ego->b * ego->ovs;
+     INT rd = ego->r2c ? id : od, cd = ego->r2c ? od : id;
+     R *b = 0;
+
+     if (ego->load.kind != EDGE_NONE)
+	  b = (R *) X(scratch_get)(ego_, ego->bufsz);
+
+     for (k = 0; k < ego->nblk; ++k) {
+	  block_rdft2(ego, ego->cld, ego->b, b, r0, r1, cr, ci);
+	  r0 += rd; r1 += rd; cr += cd; ci += cd;
+     }
+     if (ego->cldrem)
+	  block_rdft2(ego, ego->cldrem, ego->rem, b, r0, r1, cr, ci);
+
+     if (b)
+	  X(scratch_put)(ego_, b);
+}
+
+static void block_rdft(const P *ego, const plan *cld_, INT cnt, R *b,
+		       R *I, R *O)
+{
+     const plan_rdft *cld = (const plan_rdft *) cld_;
+
+     if (b) {
+	  visit(ego, &ego->load, ego->isz, cnt, I, 0, b, 0);
+	  cld->apply(cld_, b, O);
+     } else
+	  cld->apply(cld_, I, O);
+
+     if (ego->store.kind != EDGE_NONE)
+	  visit(ego, &ego->store, ego->osz, cnt, O, 0, O, 0);
+}
+
+static void apply_rdft(const plan *ego_, R *I, R *O)
+{
+     const P *ego = (const P *) ego_;
+     INT k, id = ego->b * ego->ivs, od = ego->b * ego->ovs;
+     R *b = 0;
+
+     if (ego->load.kind != EDGE_NONE)
+	  b = (R *) X(scratch_get)(ego_, ego->bufsz);
+
+     for (k = 0; k < ego->nblk; ++k) {
+	  block_rdft(ego, ego->cld, ego->b, b, I, O);
+	  I += id; O += od;
+     }
+     if (ego->cldrem)
+	  block_rdft(ego, ego->cldrem, ego->rem, b, I, O);
+
+     if (b)
+	  X(scratch_put)(ego_, b);
+}
+
+static void awake(plan *ego_, enum wakefulness wakefulness)
+{
+     P *ego = (P *) ego_;
+     X(plan_awake)(ego->cld, wakefulness);
+     X(plan_awake)(ego->cldrem, wakefulness);
+}
+
+static void destroy(plan *ego_)
+{
+     P *ego = (P *) ego_;
+     X(plan_destroy_internal)(ego->cldrem);
+     X(plan_destroy_internal)(ego->cld);
+     X(tensor_destroy2)(ego->isz, ego->osz);
+}
+
+static void print(const plan *ego_, printer *p)
+{
+     const P *ego = (const P *) ego_;
+     p->print(p, "(edge-%D-x%D%v%(%p%)%(%p%))",
+	      ego->b, ego->nblk, ego->rem, ego->cld, ego->cldrem);
+}
+
+/* The dimensions of a block on the output (OUTP) or input side of the
+   transform P: the blocked vector dimension, the other vector
+   dimensions, and those of the transform, with the strides of the
+   arrays in is and contiguous strides of C reals per element in os.
+   The blocked dimension has size 1 if P has no vector. */
+tensor *X(edge_side)(const problem *p_, int outp, int *vrnk)
+{
+     const tensor *sz, *vecsz;
+     tensor *t;
+     INT s;
+     int i, c = 2, rnk;
+
+     if (p_->adt->problem_kind == PROBLEM_DFT) {
+	  const problem_dft *p = (const problem_dft *) p_;
+	  sz = p->sz; vecsz = p->vecsz;
+     } else if (p_->adt->problem_kind == PROBLEM_RDFT) {
+	  const problem_rdft *p = (const problem_rdft *) p_;
+	  sz = p->sz; vecsz = p->vecsz;
+	  c = 1;
+     } else {
+	  const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	  sz = p->sz; vecsz = p->vecsz;
+     }
+
+     *vrnk = X(imax)(vecsz->rnk, 1);
+     rnk = *vrnk + sz->rnk;
+     t = X(mktensor)(rnk);
+     if (vecsz->rnk == 0) {
+	  t->dims[0].n = 1;
+	  t->dims[0].is = 0;
+     }
+     for (i = 0; i < vecsz->rnk; ++i) {
+	  t->dims[i].n = vecsz->dims[i].n;
+	  t->dims[i].is = outp ? vecsz->dims[i].os : vecsz->dims[i].is;
+     }
+     for (i = 0; i < sz->rnk; ++i) {
+	  t->dims[*vrnk + i].n = sz->dims[i].n;
+	  t->dims[*vrnk + i].is = outp ? sz->dims[i].os : sz->dims[i].is;
+     }
+
+     if (p_->adt->problem_kind == PROBLEM_RDFT2 && sz->rnk > 0) {
+	  const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	  iodim *d = t->dims + rnk - 1;
+	  if (R2HC_KINDP(p->kind) != outp) {
+	       /* real elements, with the actual stride */
+	       d->is = UNTAINT(p->r1) - UNTAINT(p->r0);
+	       c = 1;
+	  } else
+	       d->n = X(rdft2_complex_n)(d->n, p->kind);
+     }
+
+     for (i = rnk - 1, s = c; i >= 0; --i) {
+	  t->dims[i].os = s;
+	  s *= t->dims[i].n;
+     }
+     return t;
+}
+
+static int applicable0(const problem_edge *p, const planner *plnr)
+{
+     UNUSED(plnr);
+     if (p->p->adt->problem_kind != PROBLEM_RDFT2)
+	  return 1;
+     {
+	  const problem_rdft2 *q = (const problem_rdft2 *) p->p;
+	  return (q->sz->rnk > 0 && (q->kind == R2HC || q->kind == HC2R));
+     }
+}
+
+static int inplacep(const problem *p_)
+{
+     switch (p_->adt->problem_kind) {
+	 case PROBLEM_DFT: {
+	      const problem_dft *p = (const problem_dft *) p_;
+	      return p->ri == p->ro;
+	 }
+	 case PROBLEM_RDFT: {
+	      const problem_rdft *p = (const problem_rdft *) p_;
+	      return p->I == p->O;
+	 }
+	 default: {
+	      const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	      return p->r0 == p->cr;
+	 }
+     }
+}
+
+static int applicable(const problem_edge *p, const tensor *isz,
+		      const tensor *osz)
+{
+     /* in place, a block would overwrite inputs of the next one, as
+	in edge-fourstep.c */
+     return !(inplacep(p->p)
+	      && X(iabs)(osz->dims[0].is) > X(iabs)(isz->dims[0].is));
+}
+
+/* X offset by D strides S, or, if D == 0, by any multiple of N of them */
+static R *shift(R *x, INT d, INT n, INT s)
+{
+     UNUSED(n); /* without SIMD, TAINT ignores it */
+     return d ? x + d * s : TAINT(x, n * s);
+}
+
+/* The transform of CNT blocked transforms, from the buffer B if LOADP,
+   with the arrays offset by D elements of the blocked dimension, any
+   multiple of CNT of them if D == 0. */
+static problem *mkcld(const problem *p_, const tensor *isz,
+		      const tensor *osz, int vrnk, INT cnt, INT d,
+		      int loadp, R *b)
+{
+     tensor *sz, *vecsz;
+     INT is = isz->dims[0].is, os = osz->dims[0].is;
+     int i;
+
+     vecsz = X(mktensor)(vrnk);
+     for (i = 0; i < vrnk; ++i) {
+	  vecsz->dims[i].n = i ? isz->dims[i].n : cnt;
+	  vecsz->dims[i].is = loadp ? isz->dims[i].os : isz->dims[i].is;
+	  vecsz->dims[i].os = osz->dims[i].is;
+     }
+
+     switch (p_->adt->problem_kind) {
+	 case PROBLEM_DFT:
+	      sz = X(tensor_copy)(((const problem_dft *) p_)->sz);
+	      break;
+	 case PROBLEM_RDFT:
+	      sz = X(tensor_copy)(((const problem_rdft *) p_)->sz);
+	      break;
+	 default:
+	      sz = X(tensor_copy)(((const problem_rdft2 *) p_)->sz);
+	      break;
+     }
+     if (loadp)
+	  for (i = 0; i < sz->rnk; ++i)
+	       sz->dims[i].is = isz->dims[vrnk + i].os;
+
+     if (p_->adt->problem_kind == PROBLEM_DFT) {
+	  const problem_dft *p = (const problem_dft *) p_;
+	  R *ri = shift(p->ri, d, cnt, is), *ii = shift(p->ii, d, cnt, is);
+	  if (loadp) {
+	       ri = b; ii = b + 1;
+	  }
+	  return X(mkproblem_dft_d)(sz, vecsz, ri, ii,
+				    shift(p->ro, d, cnt, os),
+				    shift(p->io, d, cnt, os));
+     } else if (p_->adt->problem_kind == PROBLEM_RDFT) {
+	  const problem_rdft *p = (const problem_rdft *) p_;
+	  return X(mkproblem_rdft_d)(sz, vecsz,
+				     loadp ? b : shift(p->I, d, cnt, is),
+				     shift(p->O, d, cnt, os), p->kind);
+     } else {
+	  const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	  int r2c = R2HC_KINDP(p->kind);
+	  INT rs = r2c ? is : os, cs = r2c ? os : is;
+	  R *r0 = shift(p->r0, d, cnt, rs), *r1 = shift(p->r1, d, cnt, rs);
+	  R *cr = shift(p->cr, d, cnt, cs), *ci = shift(p->ci, d, cnt, cs);
+	  if (loadp) {
+	       if (r2c) {
+		    /* distance between even elements */
+		    sz->dims[sz->rnk - 1].is *= 2;
+		    r0 = b; r1 = b + 1;
+	       } else {
+		    cr = b; ci = b + 1;
+	       }
+	  }
+	  return X(mkproblem_rdft2_d)(sz, vecsz, r0, r1, cr, ci, p->kind);
+     }
+}
+
+static plan *mkcldplan(planner *plnr, problem *cldp, int loadp)
+{
+     /* the buffer is scratch, so the child may destroy it */
+     if (loadp)
+	  return X(mkplan_f_d)(plnr, cldp, 0, 0, NO_DESTROY_INPUT);
+     return X(mkplan_d)(plnr, cldp);
+}
+
+static INT choose_block(const tensor *isz, const tensor *osz, size_t ndx)
+{
+     INT e = X(imax)(isz->dims[0].os, osz->dims[0].os) * (INT)sizeof(R);
+     return X(imax)(1, X(imin)(isz->dims[0].n, maxbytes[ndx] / e));
+}
+
+static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
+{
+     const S *ego = (const S *) ego_;
+     const problem_edge *p = (const problem_edge *) p_;
+     P *pln;
+     plan *cld = 0, *cldrem = 0;
+     tensor *isz = 0, *osz = 0;
+     R *buf = 0;
+     INT b, vn, nblk, rem;
+     size_t bufsz;
+     int i, vrnk, loadp = (p->load.kind != EDGE_NONE);
+     int kind = p->p->adt->problem_kind;
+
+     static const plan_adt padt = {
+	  X(edge_solve), awake, print, destroy
+     };
+
+     if (!applicable0(p, plnr))
+	  return (plan *) 0;
+
+     isz = X(edge_side)(p->p, 0, &vrnk);
+     osz = X(edge_side)(p->p, 1, &vrnk);
+     for (i = 0; i < osz->rnk; ++i)
+	  osz->dims[i].os = osz->dims[i].is;
+
+     if (!applicable(p, isz, osz))
+	  goto nada;
+
+     vn = isz->dims[0].n;
+     b = choose_block(isz, osz, ego->maxbytes_ndx);
+
+     /* prune the solver if a smaller block gives the same plan */
+     if (ego->maxbytes_ndx > 0
+	 && choose_block(isz, osz, ego->maxbytes_ndx - 1) == b)
+	  goto nada;
+
+     /* a block of one transform too large for the cache costs a pass
+	over the arrays for each operation: use it only as a last resort */
+     if (NO_SLOWP(plnr)
+	 && isz->dims[0].os * (INT)sizeof(R) > maxbytes[NELEM(maxbytes) - 1])
+	  goto nada;
+
+     nblk = vn / b;
+     rem = vn % b;
+     bufsz = loadp ? sizeof(R) * (size_t)(b * isz->dims[0].os) : 0;
+
+     /* initial allocation for the purpose of planning */
+     if (loadp)
+	  buf = (R *) MALLOC(bufsz, BUFFERS);
+
+     cld = mkcldplan(plnr, mkcld(p->p, isz, osz, vrnk, b, 0, loadp, buf),
+		     loadp);
+     if (!cld)
+	  goto nada;
+
+     if (rem) {
+	  cldrem = mkcldplan(plnr, mkcld(p->p, isz, osz, vrnk, rem,
+					 nblk * b, loadp, buf),
+			     loadp);
+	  if (!cldrem)
+	       goto nada;
+     }
+
+     X(ifree0)(buf);
+     buf = 0;
+
+     if (kind == PROBLEM_DFT)
+	  pln = MKPLAN_DFT(P, &padt, apply_dft);
+     else if (kind == PROBLEM_RDFT)
+	  pln = MKPLAN_RDFT(P, &padt, apply_rdft);
+     else
+	  pln = MKPLAN_RDFT2(P, &padt, apply_rdft2);
+
+     pln->cld = cld;
+     pln->cldrem = cldrem;
+     pln->load = p->load;
+     pln->store = p->store;
+     pln->isz = isz;
+     pln->osz = osz;
+     pln->vrnk = vrnk;
+     pln->b = b;
+     pln->nblk = nblk;
+     pln->rem = rem;
+     pln->ivs = isz->dims[0].is;
+     pln->ovs = osz->dims[0].is;
+     pln->swapped = p->swapped;
+     pln->r2c = (kind == PROBLEM_RDFT2
+		 && R2HC_KINDP(((const problem_rdft2 *) p->p)->kind));
+     pln->bufsz = bufsz;
+     if (loadp)
+	  X(plan_scratch)(&pln->super.super, plnr, bufsz);
+
+     {
+	  opcnt t;
+	  INT ne = (loadp ? isz->dims[0].os : 0)
+	       + (p->store.kind != EDGE_NONE ? osz->dims[0].os : 0);
+	  X(ops_zero)(&t);
+	  X(ops_madd2)(nblk, &cld->ops, &t);
+	  if (cldrem)
+	       X(ops_add2)(&cldrem->ops, &t);
+	  X(ops_other)(ne * vn, &pln->super.super.ops);
+	  X(ops_add2)(&t, &pln->super.super.ops);
+     }
+
+     return &(pln->super.super);
+
+ nada:
+     X(ifree0)(buf);
+     X(plan_destroy_internal)(cldrem);
+     X(plan_destroy_internal)(cld);
+     X(tensor_destroy2)(isz, osz);
+     return (plan *) 0;
+}
+
+static solver *mksolver(size_t maxbytes_ndx)
+{
+     static const solver_adt sadt = { PROBLEM_EDGE, mkplan, 0 };
+     S *slv = MKSOLVER(S, &sadt);
+     slv->maxbytes_ndx = maxbytes_ndx;
+     return &(slv->super);
+}
+
+void X(edge_register)(planner *p)
+{
+     size_t i;
+     for (i = 0; i < NELEM(maxbytes); ++i)
+	  REGISTER_SOLVER(p, mksolver(i));
+}
@@ -78,7 +78,7 @@ static void apply_r2hc(const plan *ego_, R *I, R *O)
      E *buf;
      size_t bufsz = n * sizeof(E);
 
-     BUF_ALLOC(E *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, E *, buf, bufsz);
      hartley_r2hc(n, I, is, buf, O);
 
      for (i = 1; i + i < n; ++i) {
@@ -86,7 +86,7 @@ static void apply_r2hc(const plan *ego_, R *I, R *O)
 	  W += n - 1;
      }
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 
@@ -133,7 +133,7 @@ static void apply_hc2r(const plan *ego_, R *I, R *O)
      E *buf;
      size_t bufsz = n * sizeof(E);
 
-     BUF_ALLOC(E *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, E *, buf, bufsz);
      hartley_hc2r(n, I, is, buf, O);
 
      for (i = 1; i + i < n; ++i) {
@@ -141,7 +141,7 @@ static void apply_hc2r(const plan *ego_, R *I, R *O)
 	  W += n - 1;
      }
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 
@@ -202,6 +202,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 		       R2HC_KINDP(p->kind[0]) ? apply_r2hc : apply_hc2r);
 
      pln->n = n = p->sz->dims[0].n;
+     PLAN_BUF_SCRATCH(&pln->super.super, plnr, n * sizeof(E));
      pln->is = p->sz->dims[0].is;
      pln->os = p->sz->dims[0].os;
      pln->td = 0;
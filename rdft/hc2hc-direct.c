@@ -102,7 +102,7 @@ static void apply_buf(const plan *ego_, R *IO)
      R *buf;
      size_t bufsz = r * batchsz * 2 * sizeof(R);
 
-     BUF_ALLOC(R *, buf, bufsz);
+     PLAN_BUF_ALLOC(ego_, R *, buf, bufsz);
 
      for (i = 0; i < v; ++i, IO += ego->vs) {
 	  R *IOp = IO;
@@ -118,7 +118,7 @@ static void apply_buf(const plan *ego_, R *IO)
 	  cldm->apply((plan *) cldm, IO + ms * (m/2), IO + ms * (m/2));
      }
 
-     BUF_FREE(buf, bufsz);
+     PLAN_BUF_FREE(ego_, buf, bufsz);
 }
 
 static void awake(plan *ego_, enum wakefulness wakefulness)
@@ -233,6 +233,9 @@ static plan *mkcldw(const hc2hc_solver *ego_,
      pln->cldm = cldm;
      pln->mb = mstart + CLD0P(mstart);
      pln->me = mstart + mcount - CLDMP(m, mstart, mcount);
+     if (ego->bufferedp)
+	  PLAN_BUF_SCRATCH(&pln->super.super, plnr,
+			   r * compute_batchsize(r) * 2 * sizeof(R));
 
      X(ops_zero)(&pln->super.super.ops);
      X(ops_madd2)(v * ((pln->me - pln->mb) / e->genus->vl),
@@ -183,6 +183,9 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      pln->r = r;
      X(ops_add)(&cld->ops, &cldw->ops, &pln->super.super.ops);
 
+     /* the twiddle pass reads and writes the whole array, in place */
+     cldw->footprint = 2.0 * sizeof(R) * (double)n * (double)v;
+
      /* inherit could_prune_now_p attribute from cldw */
      pln->super.super.could_prune_now_p = cldw->could_prune_now_p;
 
@@ -203,12 +206,32 @@ hc2hc_solver *X(mksolver_hc2hc)(size_t size, INT r, hc2hc_mkinferior mkcldw)
      return slv;
 }
 
+/* see kernel/profile.c */
+static void apply_profiled(const plan *ego, R *IO)
+{
+     plan_profile *pr = ego->prof;
+     double t0 = X(profile_now)();
+     ((hc2hcapply) pr->apply)(ego, IO);
+     X(profile_account)(pr, t0);
+}
+
+static void profile(plan *ego_, int on)
+{
+     plan_hc2hc *ego = (plan_hc2hc *) ego_;
+     if (on) {
+	  ego_->prof->apply = (void (*)(void)) ego->apply;
+	  ego->apply = apply_profiled;
+     } else
+	  ego->apply = (hc2hcapply) ego_->prof->apply;
+}
+
 plan *X(mkplan_hc2hc)(size_t size, const plan_adt *adt, hc2hcapply apply)
 {
      plan_hc2hc *ego;
 
      ego = (plan_hc2hc *) X(mkplan)(size, adt);
      ego->apply = apply;
+     ego->super.profile = profile;
 
      return &(ego->super);
 }
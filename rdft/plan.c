@@ -21,12 +21,32 @@
 
 #include "rdft/rdft.h"
 
+/* see kernel/profile.c */
+static void apply_profiled(const plan *ego, R *I, R *O)
+{
+     plan_profile *pr = ego->prof;
+     double t0 = X(profile_now)();
+     ((rdftapply) pr->apply)(ego, I, O);
+     X(profile_account)(pr, t0);
+}
+
+static void profile(plan *ego_, int on)
+{
+     plan_rdft *ego = (plan_rdft *) ego_;
+     if (on) {
+	  ego_->prof->apply = (void (*)(void)) ego->apply;
+	  ego->apply = apply_profiled;
+     } else
+	  ego->apply = (rdftapply) ego_->prof->apply;
+}
+
 plan *X(mkplan_rdft)(size_t size, const plan_adt *adt, rdftapply apply)
 {
      plan_rdft *ego;
 
      ego = (plan_rdft *) X(mkplan)(size, adt);
      ego->apply = apply;
+     ego->super.profile = profile;
 
      return &(ego->super);
 }
@@ -21,12 +21,32 @@
 
 #include "rdft/rdft.h"
 
+/* see kernel/profile.c */
+static void apply_profiled(const plan *ego, R *r0, R *r1, R *cr, R *ci)
+{
+     plan_profile *pr = ego->prof;
+     double t0 = X(profile_now)();
+     ((rdft2apply) pr->apply)(ego, r0, r1, cr, ci);
+     X(profile_account)(pr, t0);
+}
+
+static void profile(plan *ego_, int on)
+{
+     plan_rdft2 *ego = (plan_rdft2 *) ego_;
+     if (on) {
+	  ego_->prof->apply = (void (*)(void)) ego->apply;
+	  ego->apply = apply_profiled;
+     } else
+	  ego->apply = (rdft2apply) ego_->prof->apply;
+}
+
 plan *X(mkplan_rdft2)(size_t size, const plan_adt *adt, rdft2apply apply)
 {
      plan_rdft2 *ego;
 
      ego = (plan_rdft2 *) X(mkplan)(size, adt);
      ego->apply = apply;
+     ego->super.profile = profile;
 
      return &(ego->super);
 }
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "rdft/rdft.h"
+
+/* A convolution problem: given the input I with dimensions and strides
+   sz (n, is) and a kernel k of dimensions ksz,
+
+     O[t] = sum_s I[t - s] k[s],
+
+   where the sum is over s < ksz and I is taken to be zero outside of
+   sz (linear convolution, O has dimensions n + nk - 1), or where
+   t - s is taken modulo n (circular convolution, nk <= n, O has
+   dimensions n).  The output strides are the os of sz.
+
+   The data are real, or, if !realp, interleaved complex numbers, in
+   which case the strides count reals as usual.  The problem owns a
+   contiguous copy of the kernel, whose strides are those of ksz. */
+
+static void destroy(problem *ego_)
+{
+     problem_conv *ego = (problem_conv *) ego_;
+     X(ifree)(ego->k);
+     X(tensor_destroy2)(ego->sz, ego->ksz);
+     X(ifree)(ego_);
+}
+
+/* The kernel values do not enter the hash, as for CZT problems. */
+static void hash(const problem *p_, md5 *m)
+{
+     const problem_conv *p = (const problem_conv *) p_;
+     X(md5puts)(m, "conv");
+     X(md5int)(m, p->I == p->O);
+     X(md5int)(m, p->realp);
+     X(md5int)(m, p->circular);
+     X(md5int)(m, X(ialignment_of)(p->I));
+     X(md5int)(m, X(ialignment_of)(p->O));
+     X(tensor_md5)(m, p->sz);
+     X(tensor_md5)(m, p->ksz);
+}
+
+static void print(const problem *ego_, printer *p)
+{
+     const problem_conv *ego = (const problem_conv *) ego_;
+     p->print(p, "(conv %d %d %d %D %T %T)",
+	      ego->realp, ego->circular,
+	      X(ialignment_of)(ego->I),
+	      (INT)(ego->O - ego->I),
+	      ego->sz, ego->ksz);
+}
+
+static void zero(const problem *ego_)
+{
+     const problem_conv *ego = (const problem_conv *) ego_;
+     tensor *c = X(mktensor_1d)(ego->realp ? 1 : 2, 1, 1);
+     tensor *sz = X(tensor_append)(ego->sz, c);
+     X(rdft_zerotens)(sz, UNTAINT(ego->I));
+     X(tensor_destroy2)(sz, c);
+}
+
+static const problem_adt padt =
+{
+     PROBLEM_CONV,
+     hash,
+     zero,
+     print,
+     destroy,
+     0
+};
+
+/* copy the array I of dimensions d[0..rnk-1] with strides is to O with
+   strides os, C reals per element */
+void X(conv_cpy)(int rnk, const iodim *d, int c, const R *I, R *O)
+{
+     INT i, n = d[0].n, is = d[0].is, os = d[0].os;
+
+     if (rnk == 1) {
+	  if (c == 1)
+	       for (i = 0; i < n; ++i)
+		    O[i * os] = I[i * is];
+	  else
+	       for (i = 0; i < n; ++i) {
+		    O[i * os] = I[i * is];
+		    O[i * os + 1] = I[i * is + 1];
+	       }
+     } else {
+	  for (i = 0; i < n; ++i)
+	       X(conv_cpy)(rnk - 1, d + 1, c, I + i * is, O + i * os);
+     }
+}
+
+problem *X(mkproblem_conv)(const tensor *sz, const tensor *ksz,
+			   const R *k, R *I, R *O, int realp, int circular)
+{
+     problem_conv *ego;
+     tensor *kc;
+     INT i, kn;
+     int c = realp ? 1 : 2;
+
+     A(X(tensor_kosherp)(sz));
+     A(X(tensor_kosherp)(ksz));
+
+     /* enforce pointer equality if untainted pointers are equal */
+     if (UNTAINT(I) == UNTAINT(O))
+	  I = O = JOIN_TAINT(I, O);
+
+     if (!FINITE_RNK(sz->rnk) || sz->rnk < 1 || ksz->rnk != sz->rnk)
+	  return X(mkproblem_unsolvable)();
+
+     for (i = 0; i < sz->rnk; ++i)
+	  if (ksz->dims[i].n <= 0
+	      || (circular && ksz->dims[i].n > sz->dims[i].n))
+	       return X(mkproblem_unsolvable)();
+
+     /* contiguous copy of the kernel */
+     kc = X(tensor_copy)(ksz);
+     for (i = kc->rnk - 1, kn = c; i >= 0; --i) {
+	  kc->dims[i].os = kn;
+	  kn *= kc->dims[i].n;
+     }
+
+     ego = (problem_conv *)X(mkproblem)(sizeof(problem_conv), &padt);
+     ego->k = (R *) MALLOC(sizeof(R) * kn, PROBLEMS);
+     X(conv_cpy)(kc->rnk, kc->dims, c, k, ego->k);
+     for (i = 0; i < kc->rnk; ++i)
+	  kc->dims[i].is = kc->dims[i].os;
+
+     ego->sz = X(tensor_copy)(sz);
+     ego->ksz = kc;
+     ego->I = I;
+     ego->O = O;
+     ego->realp = realp;
+     ego->circular = circular;
+
+     return &(ego->super);
+}
+
+/* use the apply() operation for convolution problems */
+void X(conv_solve)(const plan *ego_, const problem *p_)
+{
+     const plan_rdft *ego = (const plan_rdft *) ego_;
+     const problem_conv *p = (const problem_conv *) p_;
+     ego->apply(ego_, UNTAINT(p->I), UNTAINT(p->O));
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2003, 2007-14 Matteo Frigo
+ * Copyright (c) 2003, 2007-14 Massachusetts Institute of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "rdft/rdft.h"
+#include "dft/dft.h"
+
+/* An edge problem: the transform P, whose input is first transformed
+   elementwise by LOAD and whose output is then transformed by STORE,
+   the same way for each transform of the vector.  The elements of one
+   transform are numbered 0, 1, ... in row-major order of the
+   dimensions of P (in the order of decreasing strides, see
+   X(tensor_compress)), the complex side of an RDFT2 problem counting
+   n/2+1 elements in the last dimension.  If SWAPPED, P is a DFT whose
+   real and imaginary arrays are exchanged, as for backward transforms
+   (see extract-reim.c), and the operations see the complex numbers
+   ii + i * ri.
+
+   Solvers apply LOAD and STORE in the passes of P that read the input
+   and write the output, while the data are in cache.  The problem owns
+   the window and modulation tables, but not the callback data. */
+
+static void destroy(problem *ego_)
+{
+     problem_edge *ego = (problem_edge *) ego_;
+     X(ifree0)(ego->load.w);
+     X(ifree0)(ego->store.w);
+     X(problem_destroy)(ego->p);
+     X(ifree)(ego_);
+}
+
+/* The tables and callbacks do not enter the hash, as for CZT problems. */
+static void hash(const problem *p_, md5 *m)
+{
+     const problem_edge *p = (const problem_edge *) p_;
+     X(md5puts)(m, "edge");
+     X(md5int)(m, p->load.kind);
+     X(md5int)(m, p->store.kind);
+     X(md5int)(m, p->swapped);
+     p->p->adt->hash(p->p, m);
+}
+
+static void print(const problem *ego_, printer *p)
+{
+     const problem_edge *ego = (const problem_edge *) ego_;
+     p->print(p, "(edge %d %d %d %P)",
+	      ego->load.kind, ego->store.kind, ego->swapped, ego->p);
+}
+
+static void zero(const problem *ego_)
+{
+     const problem_edge *ego = (const problem_edge *) ego_;
+     ego->p->adt->zero(ego->p);
+}
+
+static const problem_adt padt =
+{
+     PROBLEM_EDGE,
+     hash,
+     zero,
+     print,
+     destroy,
+     0
+};
+
+/* the number of elements of one transform on the output (OUTP) or
+   input side of P, and whether they are real */
+static INT side_n(const problem *p_, int outp, int *realp)
+{
+     if (p_->adt->problem_kind == PROBLEM_DFT) {
+	  const problem_dft *p = (const problem_dft *) p_;
+	  *realp = 0;
+	  return X(tensor_sz)(p->sz);
+     } else if (p_->adt->problem_kind == PROBLEM_RDFT) {
+	  const problem_rdft *p = (const problem_rdft *) p_;
+	  *realp = 1;
+	  return X(tensor_sz)(p->sz);
+     } else {
+	  const problem_rdft2 *p = (const problem_rdft2 *) p_;
+	  INT n = X(tensor_sz)(p->sz);
+	  *realp = (R2HC_KINDP(p->kind) != outp);
+	  if (*realp || p->sz->rnk == 0)
+	       return n;
+	  else {
+	       INT nl = p->sz->dims[p->sz->rnk - 1].n;
+	       return n / nl * X(rdft2_complex_n)(nl, p->kind);
+	  }
+     }
+}
+
+static int mkop(edgeop *d, const edgeop *op, const problem *p, int outp)
+{
+     int realp;
+     INT i, n = side_n(p, outp, &realp);
+
+     *d = *op;
+     d->w = 0;
+     switch (op->kind) {
+	 case EDGE_WINDOW:
+	      d->w = (R *) MALLOC(sizeof(R) * n, PROBLEMS);
+	      for (i = 0; i < n; ++i)
+		   d->w[i] = op->w[i] * op->s;
+	      d->s = K(1.0);
+	      break;
+	 case EDGE_MODULATE:
+	      if (realp)
+		   return 0;
+	      d->w = (R *) MALLOC(sizeof(R) * 2 * n, PROBLEMS);
+	      for (i = 0; i < 2 * n; ++i)
+		   d->w[i] = op->w[i] * op->s;
+	      d->s = K(1.0);
+	      break;
+     }
+     return 1;
+}
+
+/* Wrap P, whose ownership passes to the edge problem.  Problems
+   without operations, empty vectors of transforms, and problems other
+   than DFT, R2HC/HC2R and RDFT transforms of finite rank, are returned
+   as they are. */
+problem *X(mkproblem_edge)(problem *p, const edgeop *load,
+			   const edgeop *store, int swapped)
+{
+     problem_edge *ego;
+     const tensor *sz, *vecsz;
+
+     if (load->kind == EDGE_NONE && store->kind == EDGE_NONE)
+	  return p;
+
+     switch (p->adt->problem_kind) {
+	 case PROBLEM_DFT:
+	      sz = ((const problem_dft *) p)->sz;
+	      vecsz = ((const problem_dft *) p)->vecsz;
+	      break;
+	 case PROBLEM_RDFT2: {
+	      rdft_kind kind = ((const problem_rdft2 *) p)->kind;
+	      if (kind != R2HC && kind != HC2R)
+		   return p;
+	      sz = ((const problem_rdft2 *) p)->sz;
+	      vecsz = ((const problem_rdft2 *) p)->vecsz;
+	      swapped = 0;
+	      break;
+	 }
+	 case PROBLEM_RDFT:
+	      sz = ((const problem_rdft *) p)->sz;
+	      vecsz = ((const problem_rdft *) p)->vecsz;
+	      swapped = 0;
+	      break;
+	 default:
+	      return p;
+     }
+
+     if (!FINITE_RNK(sz->rnk) || !FINITE_RNK(vecsz->rnk)
+	 || X(tensor_sz)(vecsz) == 0)
+	  return p;
+
+     ego = (problem_edge *)X(mkproblem)(sizeof(problem_edge), &padt);
+     ego->p = p;
+     ego->swapped = swapped;
+     ego->load.w = ego->store.w = 0;
+     if (!mkop(&ego->load, load, p, 0) || !mkop(&ego->store, store, p, 1)) {
+	  X(problem_destroy)(&ego->super);
+	  return X(mkproblem_unsolvable)();
+     }
+     return &(ego->super);
+}
+
+/* If P is a problem of kind KIND, or an edge problem whose transform
+   is, and whose operations are scalings, which commute with the
+   transform, return the transform and set *S to the product of the
+   factors, so that a solver may fold it into a pass of its own.
+   Otherwise return 0. */
+const problem *X(edge_scaled)(const problem *p, int kind, R *s)
+{
+     *s = K(1.0);
+     if (p->adt->problem_kind == PROBLEM_EDGE) {
+	  const problem_edge *e = (const problem_edge *) p;
+	  const edgeop *op[2];
+	  int i;
+
+	  op[0] = &e->load; op[1] = &e->store;
+	  for (i = 0; i < 2; ++i) {
+	       if (op[i]->kind == EDGE_SCALE)
+		    *s *= op[i]->s;
+	       else if (op[i]->kind != EDGE_NONE)
+		    return 0;
+	  }
+	  p = e->p;
+     }
+     return p->adt->problem_kind == kind ? p : 0;
+}
+
+/* the transform of P, looking through the edge operations */
+const problem *X(edge_transform)(const problem *p)
+{
+     if (p->adt->problem_kind == PROBLEM_EDGE)
+	  return ((const problem_edge *) p)->p;
+     return p;
+}
+
+static void scale(R *re, R *im, INT n, INT s, E a)
+{
+     INT i;
+     for (i = 0; i < n; ++i)
+	  re[i * s] *= a;
+     if (im)
+	  for (i = 0; i < n; ++i)
+	       im[i * s] *= a;
+}
+
+/* apply OP to the N elements (re, im) with stride S, whose numbers are
+   FIRST, FIRST + 1, ...; IM is 0 for real data */
+void X(edge_apply)(const edgeop *op, R *re, R *im, INT n, INT s, INT first)
+{
+     INT i;
+
+     switch (op->kind) {
+	 case EDGE_SCALE:
+	      scale(re, im, n, s, op->s);
+	      break;
+	 case EDGE_WINDOW: {
+	      const R *w = op->w + first;
+	      for (i = 0; i < n; ++i)
+		   re[i * s] *= w[i];
+	      if (im)
+		   for (i = 0; i < n; ++i)
+			im[i * s] *= w[i];
+	      break;
+	 }
+	 case EDGE_MODULATE: {
+	      const R *w = op->w + 2 * first;
+	      A(im);
+	      for (i = 0; i < n; ++i) {
+		   E xr = re[i * s], xi = im[i * s];
+		   E wr = w[2 * i], wi = w[2 * i + 1];
+		   re[i * s] = xr * wr - xi * wi;
+		   im[i * s] = xr * wi + xi * wr;
+	      }
+	      break;
+	 }
+	 case EDGE_CALLBACK:
+	      op->f(re, im, n, s, first, op->data);
+	      if (op->s != K(1.0))
+		   scale(re, im, n, s, op->s);
+	      break;
+     }
+}
+
+/* Copy the array (sr, si) with dimensions d[0..rnk-1] and strides is to
+   (dr, di) with strides os, unless the two are the same, and apply OP
+   to the copy.  The first VRNK dimensions are vector dimensions, the
+   others number the elements from FIRST on.  SI and DI are 0 for real
+   data. */
+void X(edge_visit)(const edgeop *op, const iodim *d, int vrnk, int rnk,
+		   INT first, R *sr, R *si, R *dr, R *di)
+{
+     INT i, n, is, os;
+
+     if (rnk == 0) {
+	  if (sr != dr) {
+	       dr[0] = sr[0];
+	       if (di) di[0] = si[0];
+	  }
+	  X(edge_apply)(op, dr, di, 1, 0, first);
+	  return;
+     }
+
+     n = d[0].n; is = d[0].is; os = d[0].os;
+     if (rnk == 1 && vrnk == 0) {
+	  if (sr != dr) {
+	       for (i = 0; i < n; ++i)
+		    dr[i * os] = sr[i * is];
+	       if (di)
+		    for (i = 0; i < n; ++i)
+			 di[i * os] = si[i * is];
+	  }
+	  X(edge_apply)(op, dr, di, n, os, first * n);
+     } else {
+	  for (i = 0; i < n; ++i)
+	       X(edge_visit)(op, d + 1, vrnk - (vrnk > 0), rnk - 1,
+			     vrnk > 0 ? first : first * n + i,
+			     sr + i * is, si ? si + i * is : 0,
+			     dr + i * os, di ? di + i * os : 0);
+     }
+}
+
+/* use the apply() operation of the transform for edge problems */
+void X(edge_solve)(const plan *ego_, const problem *p_)
+{
+     const problem *p = X(edge_transform)(p_);
+
+     switch (p->adt->problem_kind) {
+	 case PROBLEM_DFT: X(dft_solve)(ego_, p); break;
+	 case PROBLEM_RDFT: X(rdft_solve)(ego_, p); break;
+	 default: X(rdft2_solve)(ego_, p); break;
+     }
+}
@@ -113,13 +113,22 @@ static void zero(const problem *ego_)
      X(tensor_destroy)(sz);
 }
 
+static void tensors(const problem *ego_, 
+		    const tensor **sz, const tensor **vecsz)
+{
+     const problem_rdft *ego = (const problem_rdft *) ego_;
+     *sz = ego->sz;
+     *vecsz = ego->vecsz;
+}
+
 static const problem_adt padt =
 {
      PROBLEM_RDFT,
      hash,
      zero,
      print,
-     destroy
+     destroy,
+     tensors
 };
 
 /* Dimensions of size 1 that are not REDFT/RODFT are no-ops and can be
@@ -133,13 +133,22 @@ static void zero(const problem *ego_)
      }
 }
 
+static void tensors(const problem *ego_, 
+		    const tensor **sz, const tensor **vecsz)
+{
+     const problem_rdft2 *ego = (const problem_rdft2 *) ego_;
+     *sz = ego->sz;
+     *vecsz = ego->vecsz;
+}
+
 static const problem_adt padt =
 {
      PROBLEM_RDFT2,
      hash,
      zero,
      print,
-     destroy
+     destroy,
+     tensors
 };
 
 problem *X(mkproblem_rdft2)(const tensor *sz, const tensor *vecsz,
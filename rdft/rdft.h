@@ -164,6 +164,66 @@ void X(rdft2_nop_register)(planner *p);
 void X(rdft2_rank0_register)(planner *p);
 void X(rdft2_rank_geq2_register)(planner *p);
 
+/****************************************************************************/
+/* problem-conv.c: */
+typedef struct {
+     problem super;
+     tensor *sz;      /* input dims, with input and output strides */
+     tensor *ksz;     /* kernel dims, with contiguous strides in k */
+     R *k;            /* the kernel, owned by the problem */
+     R *I, *O;
+     int realp;       /* real data, else interleaved complex */
+     int circular;    /* circular, else linear convolution */
+} problem_conv;
+
+problem *X(mkproblem_conv)(const tensor *sz, const tensor *ksz,
+			   const R *k, R *I, R *O, int realp, int circular);
+void X(conv_cpy)(int rnk, const iodim *d, int c, const R *I, R *O);
+void X(conv_solve)(const plan *ego_, const problem *p_);
+
+void X(conv_register)(planner *p);
+
+/****************************************************************************/
+/* problem-edge.c: */
+enum {
+     EDGE_NONE, EDGE_SCALE, EDGE_WINDOW, EDGE_MODULATE, EDGE_CALLBACK
+};
+
+typedef void (*edge_callback)(R *re, R *im, INT n, INT stride, INT first,
+			      void *data);
+
+/* an elementwise operation on the elements FIRST, FIRST + 1, ...,
+   followed by a multiplication by S for all kinds but EDGE_NONE */
+typedef struct {
+     int kind;         /* EDGE_* */
+     R s;              /* the scale factor */
+     R *w;             /* EDGE_WINDOW: reals, EDGE_MODULATE: complex */
+     edge_callback f;  /* EDGE_CALLBACK */
+     void *data;
+} edgeop;
+
+typedef struct {
+     problem super;
+     problem *p;       /* the transform, DFT, RDFT2 or RDFT */
+     edgeop load;      /* on the input, before the transform */
+     edgeop store;     /* on the output, after the transform */
+     int swapped;      /* DFT with real and imaginary parts exchanged */
+} problem_edge;
+
+problem *X(mkproblem_edge)(problem *p, const edgeop *load,
+			   const edgeop *store, int swapped);
+const problem *X(edge_transform)(const problem *p);
+const problem *X(edge_scaled)(const problem *p, int kind, R *s);
+void X(edge_apply)(const edgeop *op, R *re, R *im, INT n, INT s, INT first);
+void X(edge_visit)(const edgeop *op, const iodim *d, int vrnk, int rnk,
+		   INT first, R *sr, R *si, R *dr, R *di);
+void X(edge_solve)(const plan *ego_, const problem *p_);
+tensor *X(edge_side)(const problem *p_, int outp, int *vrnk);
+
+void X(edge_register)(planner *p);
+void X(edge_fourstep_register)(planner *p);
+void X(edge_rank_geq2_register)(planner *p);
+
 /****************************************************************************/
 
 /* configurations */
@@ -31,6 +31,7 @@ typedef struct {
      plan *cld, *cldrest;
      INT n, vl, nbuf, bufdist;
      INT cs, ivs, ovs;
+     R s;              /* the scale of an edge problem */
 } P;
 
 /***************************************************************************/
@@ -38,39 +39,40 @@ typedef struct {
 /* FIXME: have alternate copy functions that push a vector loop inside
    the n loops? */
 
-/* copy halfcomplex array r (contiguous) to complex (strided) array rio/iio. */
-static void hc2c(INT n, R *r, R *rio, R *iio, INT os)
+/* copy halfcomplex array r (contiguous) to complex (strided) array
+   rio/iio, times s. */
+static void hc2c(INT n, R *r, R *rio, R *iio, INT os, E s)
 {
      INT i;
 
-     rio[0] = r[0];
+     rio[0] = s * r[0];
      iio[0] = 0;
 
      for (i = 1; i + i < n; ++i) {
-	  rio[i * os] = r[i];
-	  iio[i * os] = r[n - i];
+	  rio[i * os] = s * r[i];
+	  iio[i * os] = s * r[n - i];
      }
 
      if (i + i == n) {	/* store the Nyquist frequency */
-	  rio[i * os] = r[i];
+	  rio[i * os] = s * r[i];
 	  iio[i * os] = K(0.0);
      }
 }
 
 /* reverse of hc2c */
-static void c2hc(INT n, R *rio, R *iio, INT is, R *r)
+static void c2hc(INT n, R *rio, R *iio, INT is, R *r, E s)
 {
      INT i;
 
-     r[0] = rio[0];
+     r[0] = s * rio[0];
 
      for (i = 1; i + i < n; ++i) {
-	  r[i] = rio[i * is];
-	  r[n - i] = iio[i * is];
+	  r[i] = s * rio[i * is];
+	  r[n - i] = s * iio[i * is];
      }
 
      if (i + i == n)		/* store the Nyquist frequency */
-	  r[i] = rio[i * is];
+	  r[i] = s * rio[i * is];
 }
 
 /***************************************************************************/
@@ -82,7 +84,7 @@ static void apply_r2hc(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
      INT i, j, vl = ego->vl, nbuf = ego->nbuf, bufdist = ego->bufdist;
      INT n = ego->n;
      INT ivs = ego->ivs, ovs = ego->ovs, os = ego->cs;
-     R *bufs = (R *)MALLOC(sizeof(R) * nbuf * bufdist, BUFFERS);
+     R *bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * bufdist);
      plan_rdft2 *cldrest;
 
      for (i = nbuf; i <= vl; i += nbuf) {
@@ -92,10 +94,10 @@ static void apply_r2hc(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
 
           /* copy back */
 	  for (j = 0; j < nbuf; ++j, cr += ovs, ci += ovs)
-	       hc2c(n, bufs + j*bufdist, cr, ci, os);
+	       hc2c(n, bufs + j*bufdist, cr, ci, os, ego->s);
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_rdft2 *) ego->cldrest;
@@ -109,20 +111,20 @@ static void apply_hc2r(const plan *ego_, R *r0, R *r1, R *cr, R *ci)
      INT i, j, vl = ego->vl, nbuf = ego->nbuf, bufdist = ego->bufdist;
      INT n = ego->n;
      INT ivs = ego->ivs, ovs = ego->ovs, is = ego->cs;
-     R *bufs = (R *)MALLOC(sizeof(R) * nbuf * bufdist, BUFFERS);
+     R *bufs = (R *)X(scratch_get)(ego_, sizeof(R) * nbuf * bufdist);
      plan_rdft2 *cldrest;
 
      for (i = nbuf; i <= vl; i += nbuf) {
           /* copy to bufs */
 	  for (j = 0; j < nbuf; ++j, cr += ivs, ci += ivs)
-	       c2hc(n, cr, ci, is, bufs + j*bufdist);
+	       c2hc(n, cr, ci, is, bufs + j*bufdist, ego->s);
 
           /* transform back: */
           cld->apply((plan *) cld, bufs, r0);
 	  r0 += ovs * nbuf; r1 += ovs * nbuf;
      }
 
-     X(ifree)(bufs);
+     X(scratch_put)(ego_, bufs);
 
      /* Do the remaining transforms, if any: */
      cldrest = (plan_rdft2 *) ego->cldrest;
@@ -201,7 +203,8 @@ static int applicable0(const problem *p_, const S *ego, const planner *plnr)
 	  );
 }
 
-static int applicable(const problem *p_, const S *ego, const planner *plnr)
+static int applicable(const problem *p_, const S *ego, const planner *plnr,
+		      int edgep)
 {
      const problem_rdft2 *p;
 
@@ -210,7 +213,9 @@ static int applicable(const problem *p_, const S *ego, const planner *plnr)
      if (!applicable0(p_, ego, plnr)) return 0;
 
      p = (const problem_rdft2 *) p_;
-     if (NO_UGLYP(plnr)) {
+
+     /* the copies are not ugly if they save a pass for the scale */
+     if (NO_UGLYP(plnr) && !edgep) {
 	  if (p->r0 != p->cr) return 0;
 	  if (X(toobig)(p->sz->dims[0].n)) return 0;
      }
@@ -223,18 +228,30 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      P *pln;
      plan *cld = (plan *) 0;
      plan *cldrest = (plan *) 0;
-     const problem_rdft2 *p = (const problem_rdft2 *) p_;
+     const problem_rdft2 *p;
      R *bufs = (R *) 0;
      INT nbuf = 0, bufdist, n, vl;
      INT ivs, ovs, rs, id, od;
+     R s;
+     edgeop none = { EDGE_NONE, K(1.0), 0, 0, 0 }, scale;
+     const problem *q = X(edge_scaled)(p_, PROBLEM_RDFT2, &s);
 
      static const plan_adt padt = {
-	  X(rdft2_solve), awake, print, destroy
+	  X(edge_solve), awake, print, destroy
      };
 
-     if (!applicable(p_, ego, plnr))
+     if (!q || !applicable(q, ego, plnr, q != p_))
           goto nada;
 
+     p = (const problem_rdft2 *) q;
+
+     /* the rest of the vector is scaled by an edge problem */
+     scale = none;
+     if (s != K(1.0)) {
+	  scale.kind = EDGE_SCALE;
+	  scale.s = s;
+     }
+
      n = p->sz->dims[0].n;
      X(tensor_tornk1)(p->vecsz, &vl, &ivs, &ovs);
 
@@ -260,12 +277,14 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 	  X(ifree)(bufs); bufs = 0;
 
 	  cldrest = X(mkplan_d)(plnr, 
-				X(mkproblem_rdft2_d)(
-				     X(tensor_copy)(p->sz),
-				     X(mktensor_1d)(vl % nbuf, ivs, ovs),
-				     p->r0 + id, p->r1 + id, 
-				     p->cr + od, p->ci + od,
-				     p->kind));
+				X(mkproblem_edge)(
+				     X(mkproblem_rdft2_d)(
+					  X(tensor_copy)(p->sz),
+					  X(mktensor_1d)(vl % nbuf, ivs, ovs),
+					  p->r0 + id, p->r1 + id, 
+					  p->cr + od, p->ci + od,
+					  p->kind),
+				     &none, &scale, 0));
 	  if (!cldrest) goto nada;
 
 	  pln = MKPLAN_RDFT2(P, &padt, apply_r2hc);
@@ -282,12 +301,14 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 	  X(ifree)(bufs); bufs = 0;
 
 	  cldrest = X(mkplan_d)(plnr, 
-				X(mkproblem_rdft2_d)(
-				     X(tensor_copy)(p->sz),
-				     X(mktensor_1d)(vl % nbuf, ivs, ovs),
-				     p->r0 + od, p->r1 + od, 
-				     p->cr + id, p->ci + id,
-				     p->kind));
+				X(mkproblem_edge)(
+				     X(mkproblem_rdft2_d)(
+					  X(tensor_copy)(p->sz),
+					  X(mktensor_1d)(vl % nbuf, ivs, ovs),
+					  p->r0 + od, p->r1 + od, 
+					  p->cr + id, p->ci + id,
+					  p->kind),
+				     &none, &scale, 0));
 	  if (!cldrest) goto nada;
 	  pln = MKPLAN_RDFT2(P, &padt, apply_hc2r);
      }
@@ -301,6 +322,8 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      X(rdft2_strides)(p->kind, &p->sz->dims[0], &rs, &pln->cs);
      pln->nbuf = nbuf;
      pln->bufdist = bufdist;
+     pln->s = s;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * nbuf * bufdist);
 
      X(ops_madd)(vl / nbuf, &cld->ops, &cldrest->ops,
 		 &pln->super.super.ops);
@@ -315,14 +338,19 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      return (plan *) 0;
 }
 
-static solver *mksolver(void)
+static solver *mksolver(int kind)
 {
      static const solver_adt sadt = { PROBLEM_RDFT2, mkplan, 0 };
-     S *slv = MKSOLVER(S, &sadt);
+     static const solver_adt sadt_edge = { PROBLEM_EDGE, mkplan, 0 };
+     S *slv = MKSOLVER(S, kind == PROBLEM_EDGE ? &sadt_edge : &sadt);
      return &(slv->super);
 }
 
 void X(rdft2_rdft_register)(planner *p)
 {
-     REGISTER_SOLVER(p, mksolver());
+     REGISTER_SOLVER(p, mksolver(PROBLEM_RDFT2));
+
+     /* transforms with a scale, e.g. FFTW_NORMALIZE_*, folded into the
+	copies */
+     REGISTER_SOLVER(p, mksolver(PROBLEM_EDGE));
 }
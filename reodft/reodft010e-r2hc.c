@@ -37,6 +37,7 @@ typedef struct {
      INT vl;
      INT ivs, ovs;
      rdft_kind kind;
+     R s;              /* the scale of an edge problem */
 } P;
 
 /* A real-even-01 DFT operates logically on a size-4N array:
@@ -89,25 +90,26 @@ static void apply_re01(const plan *ego_, R *I, R *O)
      INT iv, vl = ego->vl;
      INT ivs = ego->ivs, ovs = ego->ovs;
      R *W = ego->td->W;
+     E sc = ego->s;
      R *buf;
 
-     buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * n);
 
      for (iv = 0; iv < vl; ++iv, I += ivs, O += ovs) {
-	  buf[0] = I[0];
+	  buf[0] = sc * I[0];
 	  for (i = 1; i < n - i; ++i) {
 	       E a, b, apb, amb, wa, wb;
 	       a = I[is * i];
 	       b = I[is * (n - i)];
 	       apb = a + b;
 	       amb = a - b;
-	       wa = W[2*i];
-	       wb = W[2*i + 1];
+	       wa = sc * W[2*i];
+	       wb = sc * W[2*i + 1];
 	       buf[i] = wa * amb + wb * apb; 
 	       buf[n - i] = wa * apb - wb * amb; 
 	  }
 	  if (i == n - i) {
-	       buf[i] = K(2.0) * I[is * i] * W[2*i];
+	       buf[i] = K(2.0) * sc * I[is * i] * W[2*i];
 	  }
 	  
 	  {
@@ -130,7 +132,7 @@ static void apply_re01(const plan *ego_, R *I, R *O)
 	  }
      }
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 /* ro01 is same as re01, but with i <-> n - 1 - i in the input and
@@ -143,25 +145,26 @@ static void apply_ro01(const plan *ego_, R *I, R *O)
      INT iv, vl = ego->vl;
      INT ivs = ego->ivs, ovs = ego->ovs;
      R *W = ego->td->W;
+     E sc = ego->s;
      R *buf;
 
-     buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * n);
 
      for (iv = 0; iv < vl; ++iv, I += ivs, O += ovs) {
-	  buf[0] = I[is * (n - 1)];
+	  buf[0] = sc * I[is * (n - 1)];
 	  for (i = 1; i < n - i; ++i) {
 	       E a, b, apb, amb, wa, wb;
 	       a = I[is * (n - 1 - i)];
 	       b = I[is * (i - 1)];
 	       apb = a + b;
 	       amb = a - b;
-	       wa = W[2*i];
-	       wb = W[2*i+1];
+	       wa = sc * W[2*i];
+	       wb = sc * W[2*i+1];
 	       buf[i] = wa * amb + wb * apb; 
 	       buf[n - i] = wa * apb - wb * amb; 
 	  }
 	  if (i == n - i) {
-	       buf[i] = K(2.0) * I[is * (i - 1)] * W[2*i];
+	       buf[i] = K(2.0) * sc * I[is * (i - 1)] * W[2*i];
 	  }
 	  
 	  {
@@ -184,7 +187,7 @@ static void apply_ro01(const plan *ego_, R *I, R *O)
 	  }
      }
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 static void apply_re10(const plan *ego_, R *I, R *O)
@@ -195,9 +198,10 @@ static void apply_re10(const plan *ego_, R *I, R *O)
      INT iv, vl = ego->vl;
      INT ivs = ego->ivs, ovs = ego->ovs;
      R *W = ego->td->W;
+     E two = K(2.0) * ego->s;
      R *buf;
 
-     buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * n);
 
      for (iv = 0; iv < vl; ++iv, I += ivs, O += ovs) {
 	  buf[0] = I[0];
@@ -218,22 +222,22 @@ static void apply_re10(const plan *ego_, R *I, R *O)
 	       cld->apply((plan *) cld, buf, buf);
 	  }
 	  
-	  O[0] = K(2.0) * buf[0];
+	  O[0] = two * buf[0];
 	  for (i = 1; i < n - i; ++i) {
 	       E a, b, wa, wb;
-	       a = K(2.0) * buf[i];
-	       b = K(2.0) * buf[n - i];
+	       a = two * buf[i];
+	       b = two * buf[n - i];
 	       wa = W[2*i];
 	       wb = W[2*i + 1];
 	       O[os * i] = wa * a + wb * b;
 	       O[os * (n - i)] = wb * a - wa * b;
 	  }
 	  if (i == n - i) {
-	       O[os * i] = K(2.0) * buf[i] * W[2*i];
+	       O[os * i] = two * buf[i] * W[2*i];
 	  }
      }
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 /* ro10 is same as re10, but with i <-> n - 1 - i in the output and
@@ -246,9 +250,10 @@ static void apply_ro10(const plan *ego_, R *I, R *O)
      INT iv, vl = ego->vl;
      INT ivs = ego->ivs, ovs = ego->ovs;
      R *W = ego->td->W;
+     E two = K(2.0) * ego->s;
      R *buf;
 
-     buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * n);
 
      for (iv = 0; iv < vl; ++iv, I += ivs, O += ovs) {
 	  buf[0] = I[0];
@@ -269,22 +274,22 @@ static void apply_ro10(const plan *ego_, R *I, R *O)
 	       cld->apply((plan *) cld, buf, buf);
 	  }
 	  
-	  O[os * (n - 1)] = K(2.0) * buf[0];
+	  O[os * (n - 1)] = two * buf[0];
 	  for (i = 1; i < n - i; ++i) {
 	       E a, b, wa, wb;
-	       a = K(2.0) * buf[i];
-	       b = K(2.0) * buf[n - i];
+	       a = two * buf[i];
+	       b = two * buf[n - i];
 	       wa = W[2*i];
 	       wb = W[2*i + 1];
 	       O[os * (n - 1 - i)] = wa * a + wb * b;
 	       O[os * (i - 1)] = wb * a - wa * b;
 	  }
 	  if (i == n - i) {
-	       O[os * (i - 1)] = K(2.0) * buf[i] * W[2*i];
+	       O[os * (i - 1)] = two * buf[i] * W[2*i];
 	  }
      }
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 static void awake(plan *ego_, enum wakefulness wakefulness)
@@ -328,9 +333,12 @@ static int applicable0(const solver *ego_, const problem *p_)
 	  );
 }
 
-static int applicable(const solver *ego, const problem *p, const planner *plnr)
+/* With a scale to fold (EDGEP), the alternative would be this plan
+   anyway, followed by a pass over the output. */
+static int applicable(const solver *ego, const problem *p, const planner *plnr,
+		      int edgep)
 {
-     return (!NO_SLOWP(plnr) && applicable0(ego, p));
+     return ((!NO_SLOWP(plnr) || edgep) && applicable0(ego, p));
 }
 
 static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
@@ -341,15 +349,17 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      R *buf;
      INT n;
      opcnt ops;
+     R s;
+     const problem *q = X(edge_scaled)(p_, PROBLEM_RDFT, &s);
 
      static const plan_adt padt = {
-	  X(rdft_solve), awake, print, destroy
+	  X(edge_solve), awake, print, destroy
      };
 
-     if (!applicable(ego_, p_, plnr))
+     if (!q || !applicable(ego_, q, plnr, q != p_))
           return (plan *)0;
 
-     p = (const problem_rdft *) p_;
+     p = (const problem_rdft *) q;
 
      n = p->sz->dims[0].n;
      buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
@@ -370,11 +380,13 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
      }
 
      pln->n = n;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * n);
      pln->is = p->sz->dims[0].is;
      pln->os = p->sz->dims[0].os;
      pln->cld = cld;
      pln->td = 0;
      pln->kind = p->kind[0];
+     pln->s = s;
      
      X(tensor_tornk1)(p->vecsz, &pln->vl, &pln->ivs, &pln->ovs);
      
@@ -397,14 +409,19 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 }
 
 /* constructor */
-static solver *mksolver(void)
+static solver *mksolver(int kind)
 {
      static const solver_adt sadt = { PROBLEM_RDFT, mkplan, 0 };
-     S *slv = MKSOLVER(S, &sadt);
+     static const solver_adt sadt_edge = { PROBLEM_EDGE, mkplan, 0 };
+     S *slv = MKSOLVER(S, kind == PROBLEM_EDGE ? &sadt_edge : &sadt);
      return &(slv->super);
 }
 
 void X(reodft010e_r2hc_register)(planner *p)
 {
-     REGISTER_SOLVER(p, mksolver());
+     REGISTER_SOLVER(p, mksolver(PROBLEM_RDFT));
+
+     /* transforms with a scale, e.g. FFTW_NORMALIZE_*, folded into the
+	pre- or postprocessing */
+     REGISTER_SOLVER(p, mksolver(PROBLEM_EDGE));
 }
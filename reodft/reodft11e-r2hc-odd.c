@@ -71,7 +71,7 @@ static void apply_re11(const plan *ego_, R *I, R *O)
      INT ivs = ego->ivs, ovs = ego->ovs;
      R *buf;
 
-     buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * n);
 
      for (iv = 0; iv < vl; ++iv, I += ivs, O += ovs) {
 	  {
@@ -126,7 +126,7 @@ static void apply_re11(const plan *ego_, R *I, R *O)
 	  O[os * n2] = SQRT2 * SGN_SET(buf[0], (n2+1)/2);
      }
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 /* like for rodft01, rodft11 is obtained from redft11 by
@@ -140,7 +140,7 @@ static void apply_ro11(const plan *ego_, R *I, R *O)
      INT ivs = ego->ivs, ovs = ego->ovs;
      R *buf;
 
-     buf = (R *) MALLOC(sizeof(R) * n, BUFFERS);
+     buf = (R *) X(scratch_get)(ego_, sizeof(R) * n);
 
      for (iv = 0; iv < vl; ++iv, I += ivs, O += ovs) {
 	  {
@@ -197,7 +197,7 @@ static void apply_ro11(const plan *ego_, R *I, R *O)
 	  O[os * n2] = SQRT2 * SGN_SET(buf[0], (n2+1)/2 + n2);
      }
 
-     X(ifree)(buf);
+     X(scratch_put)(ego_, buf);
 }
 
 static void awake(plan *ego_, enum wakefulness wakefulness)
@@ -267,6 +267,7 @@ static plan *mkplan(const solver *ego_, const problem *p_, planner *plnr)
 
      pln = MKPLAN_RDFT(P, &padt, p->kind[0]==REDFT11 ? apply_re11:apply_ro11);
      pln->n = n;
+     X(plan_scratch)(&pln->super.super, plnr, sizeof(R) * n);
      pln->is = p->sz->dims[0].is;
      pln->os = p->sz->dims[0].os;
      pln->cld = cld;
@@ -0,0 +1,1527 @@
+/* Accuracy checks of the transforms that the bench program cannot
+   express, against direct sums in long double.
+
+   Usage: apicheck [-v]
+
+   Each check prints its name and relative rms error with -v, and the
+   program exits with status 1 if any error exceeds the tolerance,
+   which is a multiple of the epsilon of the precision of fftw. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define CALLING_FFTW /* hack */
+#include "api/api.h"
+
+typedef long double lcplx[2];
+
+#if defined(FFTW_SINGLE)
+#  define EPS FLT_EPSILON
+#elif defined(FFTW_LDOUBLE) || defined(FFTW_QUAD)
+#  define EPS LDBL_EPSILON /* that of the reference */
+#else
+#  define EPS DBL_EPSILON
+#endif
+#define TOL (1000 * EPS)
+
+static const long double K2PI = 6.2831853071795864769252867665590057683943388L;
+
+static int verbose = 0, failed = 0;
+
+static void report(const char *name, double err, double tol)
+{
+     if (verbose || !(err <= tol))
+	  printf("%-40s %10.3g%s\n", name, err, err <= tol ? "" : "  FAILED");
+     if (!(err <= tol))
+	  failed = 1;
+}
+
+/* deterministic inputs in [-0.5, 0.5) */
+static R rnd(void)
+{
+     static unsigned s = 12345u;
+     s = s * 1103515245u + 12345u;
+     return (R)((double)((s >> 8) & 0xffffff) / 16777216.0 - 0.5);
+}
+
+static void fill(C *x, int n)
+{
+     int i;
+     for (i = 0; i < n; ++i) {
+	  x[i][0] = rnd();
+	  x[i][1] = rnd();
+     }
+}
+
+/* the relative rms error of Y against REF */
+static double relerr(const C *y, const lcplx *ref, int n)
+{
+     long double e = 0, m = 0;
+     int i;
+
+     for (i = 0; i < n; ++i) {
+	  long double dr = y[i][0] - ref[i][0], di = y[i][1] - ref[i][1];
+	  e += dr * dr + di * di;
+	  m += ref[i][0] * ref[i][0] + ref[i][1] * ref[i][1];
+     }
+     return m > 0 ? (double) sqrtl(e / m) : (double) sqrtl(e);
+}
+
+/* RES = Z^T, on the principal branch */
+static void lpow(const C z, long double t, lcplx res)
+{
+     long double zr = z[0], zi = z[1];
+     long double r = expl(t * logl(zr * zr + zi * zi) / 2);
+     long double th = t * atan2l(zi, zr);
+     res[0] = r * cosl(th);
+     res[1] = r * sinl(th);
+}
+
+/*************************************************************************/
+/* chirp-z transform, see X(plan_czt) */
+
+static void czt_direct(int n, int m, const C w, const C a, const C *x,
+		       lcplx *y)
+{
+     int j, k;
+
+     for (k = 0; k < m; ++k) {
+	  long double yr = 0, yi = 0;
+	  for (j = 0; j < n; ++j) {
+	       lcplx aj, wjk;
+	       long double fr, fi;
+	       lpow(a, -(long double) j, aj);
+	       lpow(w, (long double) j * k, wjk);
+	       fr = aj[0] * wjk[0] - aj[1] * wjk[1];
+	       fi = aj[0] * wjk[1] + aj[1] * wjk[0];
+	       yr += x[j][0] * fr - x[j][1] * fi;
+	       yi += x[j][0] * fi + x[j][1] * fr;
+	  }
+	  y[k][0] = yr;
+	  y[k][1] = yi;
+     }
+}
+
+/* the spiral of modulus RW, RA through the angles TW, TA (in turns) */
+static void check_czt(int n, int m, double rw, double tw,
+		      double ra, double ta)
+{
+     C w, a, *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) m);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) m);
+     X(plan) p;
+     char name[64];
+     /* the phase of W^{jk} is only as accurate as the angle of W,
+	which fftw computes in its own precision */
+     double tol = TOL + EPS * (double) n * (double) m;
+
+     w[0] = (R)(rw * cos(K2PI * tw));
+     w[1] = (R)(rw * sin(K2PI * tw));
+     a[0] = (R)(ra * cos(K2PI * ta));
+     a[1] = (R)(ra * sin(K2PI * ta));
+     sprintf(name, "czt n=%d m=%d |w|=%g", n, m, rw);
+
+     p = X(plan_czt)(n, m, &w, &a, x, y, FFTW_ESTIMATE);
+     if (!p) {
+	  report(name, HUGE_VAL, tol);
+     } else {
+	  fill(x, n);
+	  czt_direct(n, m, w, a, x, ref);
+	  X(execute)(p);
+	  report(name, relerr(y, ref, m), tol);
+	  X(destroy_plan)(p);
+     }
+
+     X(free)(x);
+     X(free)(y);
+     free(ref);
+}
+
+static void czt(void)
+{
+     check_czt(45, 45, 1.0, -1.0 / 45, 1.0, 0.0);      /* the DFT */
+     check_czt(20, 26, 1.0, -0.05 / 26, 1.0, 0.1);     /* zoom */
+     check_czt(37, 45, 1.001, 0.013, 0.99, -0.2);      /* spiral */
+     check_czt(60, 16, 0.999, 0.3, 1.01, 0.45);
+     check_czt(1000, 1500, 1.0, -0.01 / 1500, 1.0, 0.25);
+     check_czt(700, 900, 1.0, 0.37, 1.0, 0.1);         /* large phases */
+}
+
+/*************************************************************************/
+/* pruned DFT, see X(plan_dft_pruned) */
+
+/* the first NO outputs of the DFT of size N of the NI inputs X,
+   padded with zeros */
+static void dft_direct(int n, int ni, int no, int sign, const C *x,
+		       lcplx *y)
+{
+     int j, k;
+
+     for (k = 0; k < no; ++k) {
+	  long double yr = 0, yi = 0;
+	  for (j = 0; j < ni; ++j) {
+	       long double th = sign * K2PI * (long double)
+		    (((long long) j * k) % n) / n;
+	       long double c = cosl(th), s = sinl(th);
+	       yr += x[j][0] * c - x[j][1] * s;
+	       yi += x[j][0] * s + x[j][1] * c;
+	  }
+	  y[k][0] = yr;
+	  y[k][1] = yi;
+     }
+}
+
+static void check_pruned(int n, int ni, int no, int sign, int inplace)
+{
+     int nx = ni > no ? ni : no;
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) nx);
+     C *y = inplace ? x : (C *) X(malloc)(sizeof(C) * (size_t) no);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) ni);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) no);
+     X(plan) p;
+     char name[64];
+
+     sprintf(name, "pruned n=%d in=%d out=%d%s%s", n, ni, no,
+	     sign > 0 ? " backward" : "", inplace ? " in-place" : "");
+
+     p = X(plan_dft_pruned)(n, ni, no, x, y, sign, FFTW_ESTIMATE);
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  fill(x, ni);
+	  memcpy(x0, x, sizeof(C) * (size_t) ni);
+	  dft_direct(n, ni, no, sign, x0, ref);
+	  X(execute)(p);
+	  report(name, relerr(y, ref, no), TOL);
+	  X(destroy_plan)(p);
+     }
+
+     if (!inplace)
+	  X(free)(y);
+     X(free)(x);
+     free(x0);
+     free(ref);
+}
+
+static void pruned(void)
+{
+     check_pruned(240, 16, 30, FFTW_FORWARD, 0);
+     check_pruned(240, 240, 7, FFTW_FORWARD, 0);   /* outputs only */
+     check_pruned(240, 5, 240, FFTW_BACKWARD, 0);  /* inputs only */
+     check_pruned(1000, 37, 100, FFTW_BACKWARD, 0);
+     check_pruned(128, 8, 20, FFTW_FORWARD, 1);
+     check_pruned(97, 10, 5, FFTW_FORWARD, 0);     /* prime: padded */
+     check_pruned(64, 1, 1, FFTW_FORWARD, 1);
+}
+
+/*************************************************************************/
+/* plan export and binary wisdom, see X(export_plan) and
+   X(import_binary_wisdom_from_filename) */
+
+/* export a measured DFT of size N, forget the wisdom, and import the
+   plan on other arrays, in place if INPLACE */
+static void check_export(int n, int inplace)
+{
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = inplace ? x : (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x1 = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y1 = inplace ? x1 : (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     X(plan) p, q = 0;
+     char *blob = 0;
+     size_t len = 0;
+     char name[64];
+
+     sprintf(name, "export n=%d%s", n, inplace ? " in-place" : "");
+
+     X(forget_wisdom)();
+     p = X(plan_dft_1d)(n, x, y, FFTW_FORWARD, FFTW_MEASURE);
+     if (p && (len = X(export_plan)(p, 0, 0)) > 0) {
+	  blob = (char *) malloc(len);
+	  if (X(export_plan)(p, blob, len) != len)
+	       len = 0;
+     }
+     X(forget_wisdom)();
+     if (len > 0) {
+	  /* a truncated blob is invalid */
+	  q = X(import_plan)(blob, len - 1, x1, y1);
+	  if (q) {
+	       X(destroy_plan)(q);
+	       len = 0;
+	  }
+     }
+     if (len > 0)
+	  q = X(import_plan)(blob, len, x1, y1);
+
+     if (!q) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  fill(x1, n);
+	  memcpy(x0, x1, sizeof(C) * (size_t) n);
+	  dft_direct(n, n, n, FFTW_FORWARD, x0, ref);
+	  X(execute)(q);
+	  report(name, relerr(y1, ref, n), TOL);
+	  X(destroy_plan)(q);
+     }
+
+     if (p)
+	  X(destroy_plan)(p);
+     free(blob);
+     if (!inplace) {
+	  X(free)(y);
+	  X(free)(y1);
+     }
+     X(free)(x);
+     X(free)(x1);
+     free(x0);
+     free(ref);
+}
+
+/* save the wisdom of a DFT of size N in a binary file, forget it, and
+   plan from the imported file only */
+static void check_binary_wisdom(int n)
+{
+     const char *file = "apicheck.wisdom";
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     X(plan) p;
+     char name[64];
+     int ok;
+
+     sprintf(name, "binary wisdom n=%d", n);
+
+     X(forget_wisdom)();
+     p = X(plan_dft_1d)(n, x, y, FFTW_FORWARD, FFTW_MEASURE);
+     ok = p && X(export_binary_wisdom_to_filename)(file);
+     if (p)
+	  X(destroy_plan)(p);
+     X(forget_wisdom)();
+     ok = ok && X(import_binary_wisdom_from_filename)(file);
+
+     /* the wisdom of N only */
+     p = X(plan_dft_1d)(n + 1, x, y, FFTW_FORWARD,
+			FFTW_MEASURE | FFTW_WISDOM_ONLY);
+     if (p) {
+	  X(destroy_plan)(p);
+	  ok = 0;
+     }
+     p = ok ? X(plan_dft_1d)(n, x, y, FFTW_FORWARD,
+			     FFTW_MEASURE | FFTW_WISDOM_ONLY) : 0;
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  fill(x, n);
+	  memcpy(x0, x, sizeof(C) * (size_t) n);
+	  dft_direct(n, n, n, FFTW_FORWARD, x0, ref);
+	  X(execute)(p);
+	  report(name, relerr(y, ref, n), TOL);
+	  X(destroy_plan)(p);
+     }
+
+     X(forget_wisdom)();
+     remove(file);
+     X(free)(x);
+     X(free)(y);
+     free(x0);
+     free(ref);
+}
+
+static void export_plans(void)
+{
+     check_binary_wisdom(60);
+     check_binary_wisdom(64 * 35);
+     check_export(60, 0);
+     check_export(64 * 35, 1);
+     check_export(1031, 0);
+}
+
+/*************************************************************************/
+/* normalization, see FFTW_NORMALIZE_ORTHO and FFTW_NORMALIZE_BACKWARD */
+
+/* the DFT of size N with FLAGS against the direct one times S */
+static void check_norm_dft(int n, int sign, unsigned flags, long double s)
+{
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     X(plan) p;
+     char name[64];
+     int i;
+
+     sprintf(name, "normalize dft n=%d%s%s", n,
+	     sign > 0 ? " backward" : "",
+	     (flags & FFTW_NORMALIZE_ORTHO) ? " ortho" : " 1/n");
+
+     p = X(plan_dft_1d)(n, x, y, sign, FFTW_ESTIMATE | flags);
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  fill(x, n);
+	  memcpy(x0, x, sizeof(C) * (size_t) n);
+	  dft_direct(n, n, n, sign, x0, ref);
+	  for (i = 0; i < n; ++i) {
+	       ref[i][0] *= s;
+	       ref[i][1] *= s;
+	  }
+	  X(execute)(p);
+	  report(name, relerr(y, ref, n), TOL);
+	  X(destroy_plan)(p);
+     }
+
+     X(free)(x);
+     X(free)(y);
+     free(x0);
+     free(ref);
+}
+
+/* the relative rms error of the real Y against X */
+static double rrelerr(const R *y, const R *x, int n)
+{
+     long double e = 0, m = 0;
+     int i;
+
+     for (i = 0; i < n; ++i) {
+	  long double d = (long double) y[i] - x[i];
+	  e += d * d;
+	  m += (long double) x[i] * x[i];
+     }
+     return m > 0 ? (double) sqrtl(e / m) : (double) sqrtl(e);
+}
+
+/* FWD from X to Y then BWD from Y to Z, which must give X back */
+static void roundtrip(const char *name, X(plan) fwd, X(plan) bwd,
+		      R *x, R *z, int n)
+{
+     R *x0 = (R *) malloc(sizeof(R) * (size_t) n);
+     int i;
+
+     if (!fwd || !bwd) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  for (i = 0; i < n; ++i)
+	       x0[i] = x[i] = rnd();
+	  X(execute)(fwd);
+	  X(execute)(bwd);
+	  report(name, rrelerr(z, x0, n), TOL);
+     }
+     if (fwd)
+	  X(destroy_plan)(fwd);
+     if (bwd)
+	  X(destroy_plan)(bwd);
+     free(x0);
+}
+
+/* r2c/c2r of size N0 x N1, the forward one with FWD_FLAGS */
+static void check_norm_rdft2(int n0, int n1, unsigned fwd_flags,
+			     unsigned bwd_flags)
+{
+     int nc = n0 * (n1 / 2 + 1);
+     R *x = (R *) X(malloc)(sizeof(R) * (size_t) (n0 * n1));
+     R *z = (R *) X(malloc)(sizeof(R) * (size_t) (n0 * n1));
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) nc);
+     char name[64];
+
+     sprintf(name, "normalize r2c/c2r %dx%d%s", n0, n1,
+	     (bwd_flags & FFTW_NORMALIZE_ORTHO) ? " ortho" : " 1/n");
+     roundtrip(name,
+	       X(plan_dft_r2c_2d)(n0, n1, x, y, FFTW_ESTIMATE | fwd_flags),
+	       X(plan_dft_c2r_2d)(n0, n1, y, z, FFTW_ESTIMATE | bwd_flags),
+	       x, z, n0 * n1);
+
+     X(free)(x);
+     X(free)(y);
+     X(free)(z);
+}
+
+/* the r2r transform FWD of size N followed by BWD, in place */
+static void check_norm_r2r(int n, X(r2r_kind) fwd, X(r2r_kind) bwd,
+			   unsigned flags)
+{
+     R *x = (R *) X(malloc)(sizeof(R) * (size_t) n);
+     char name[64];
+
+     sprintf(name, "normalize r2r %d/%d n=%d%s", (int) fwd, (int) bwd, n,
+	     (flags & FFTW_NORMALIZE_ORTHO) ? " ortho" : " 1/n");
+     roundtrip(name,
+	       X(plan_r2r_1d)(n, x, x, fwd, FFTW_ESTIMATE | flags),
+	       X(plan_r2r_1d)(n, x, x, bwd, FFTW_ESTIMATE | flags),
+	       x, x, n);
+
+     X(free)(x);
+}
+
+static void normalize(void)
+{
+     const unsigned ortho = FFTW_NORMALIZE_ORTHO;
+     const unsigned inv = FFTW_NORMALIZE_BACKWARD;
+
+     check_norm_dft(60, FFTW_FORWARD, ortho, 1 / sqrtl(60));
+     check_norm_dft(60, FFTW_BACKWARD, ortho, 1 / sqrtl(60));
+     check_norm_dft(60, FFTW_FORWARD, inv, 1);
+     check_norm_dft(60, FFTW_BACKWARD, inv, 1.0L / 60);
+     check_norm_dft(1031, FFTW_BACKWARD, inv, 1.0L / 1031);
+     check_norm_rdft2(12, 10, ortho, ortho);
+     check_norm_rdft2(9, 16, inv, inv);
+     check_norm_rdft2(1, 1000, inv, inv);
+     check_norm_rdft2(1, 999, ortho, ortho);
+     check_norm_r2r(30, FFTW_R2HC, FFTW_HC2R, inv);
+     check_norm_r2r(30, FFTW_R2HC, FFTW_HC2R, ortho);
+     check_norm_r2r(24, FFTW_REDFT10, FFTW_REDFT01, inv);
+     check_norm_r2r(24, FFTW_RODFT10, FFTW_RODFT01, ortho);
+     check_norm_r2r(17, FFTW_REDFT00, FFTW_REDFT00, ortho);
+     check_norm_r2r(17, FFTW_RODFT00, FFTW_RODFT00, ortho);
+     check_norm_r2r(32, FFTW_DHT, FFTW_DHT, ortho);
+}
+
+/*************************************************************************/
+/* load and store operations, see X(plan_with_load) */
+
+enum { EDGE_DFT, EDGE_IDFT, EDGE_R2C, EDGE_C2R, EDGE_R2R };
+
+/* multiply the N elements of X, of C reals each, by the window or, if
+   C == 2, by the complex modulation W */
+static void edge_mul(R *x, const R *w, int n, int c)
+{
+     int i;
+
+     for (i = 0; i < n; ++i)
+	  if (c == 2) {
+	       R xr = x[2 * i], xi = x[2 * i + 1];
+	       x[2 * i] = xr * w[2 * i] - xi * w[2 * i + 1];
+	       x[2 * i + 1] = xr * w[2 * i + 1] + xi * w[2 * i];
+	  } else
+	       x[i] *= w[i];
+}
+
+static X(plan) edge_plan(int kind, int rnk, const int *n, R *x, R *y)
+{
+     static const X(r2r_kind) k[3] = {
+	  FFTW_REDFT10, FFTW_R2HC, FFTW_RODFT00
+     };
+
+     switch (kind) {
+	 case EDGE_DFT: case EDGE_IDFT:
+	      return X(plan_dft)(rnk, n, (C *) x, (C *) y,
+				 kind == EDGE_DFT ? FFTW_FORWARD
+				 : FFTW_BACKWARD, FFTW_ESTIMATE);
+	 case EDGE_R2C:
+	      return X(plan_dft_r2c)(rnk, n, x, (C *) y, FFTW_ESTIMATE);
+	 case EDGE_C2R:
+	      return X(plan_dft_c2r)(rnk, n, (C *) x, y, FFTW_ESTIMATE);
+	 default:
+	      return X(plan_r2r)(rnk, n, x, y, k, FFTW_ESTIMATE);
+     }
+}
+
+/* the transform KIND of size N0 x N1 x N2 (of rank 2 if N2 == 1) with
+   a window or modulation on the input and on the output, against the
+   transform of the modulated input without operations; the arrays are
+   too large for a single block, so that the operations are applied to
+   blocks of rows and columns */
+static void check_edge(int kind, int n0, int n1, int n2, int inplace)
+{
+     int n[3], rnk = n2 > 1 ? 3 : 2, tot = n0 * n1 * n2;
+     int nh, ni, no, ci, co;
+     R *x, *y, *x0, *wi, *wo, *ref;
+     X(plan) p, q;
+     char name[64];
+     int i;
+
+     n[0] = n0; n[1] = n1; n[2] = n2;
+     nh = tot / n[rnk - 1] * (n[rnk - 1] / 2 + 1);
+     ci = (kind == EDGE_DFT || kind == EDGE_IDFT || kind == EDGE_C2R) + 1;
+     co = (kind == EDGE_DFT || kind == EDGE_IDFT || kind == EDGE_R2C) + 1;
+     ni = kind == EDGE_C2R ? nh : tot;
+     no = kind == EDGE_R2C ? nh : tot;
+
+     sprintf(name, "edge %s %dx%dx%d%s",
+	     kind == EDGE_DFT ? "dft" : kind == EDGE_IDFT ? "idft" :
+	     kind == EDGE_R2C ? "r2c" : kind == EDGE_C2R ? "c2r" : "r2r",
+	     n0, n1, n2, inplace ? " in place" : "");
+
+     x = (R *) X(malloc)(sizeof(R) * (size_t) (ci * ni));
+     y = inplace ? x : (R *) X(malloc)(sizeof(R) * (size_t) (co * no));
+     x0 = (R *) X(malloc)(sizeof(R) * (size_t) (ci * ni));
+     ref = (R *) X(malloc)(sizeof(R) * (size_t) (co * no));
+     wi = (R *) malloc(sizeof(R) * (size_t) (ci * ni));
+     wo = (R *) malloc(sizeof(R) * (size_t) (co * no));
+     for (i = 0; i < ci * ni; ++i)
+	  wi[i] = rnd() + 1;
+     for (i = 0; i < co * no; ++i)
+	  wo[i] = rnd() + 1;
+
+     X(plan_with_load)(ci == 2 ? FFTW_EDGE_MODULATE : FFTW_EDGE_WINDOW,
+		       wi, 0, 0);
+     X(plan_with_store)(co == 2 ? FFTW_EDGE_MODULATE : FFTW_EDGE_WINDOW,
+			wo, 0, 0);
+     p = edge_plan(kind, rnk, n, x, y);
+     X(plan_with_load)(FFTW_EDGE_NONE, 0, 0, 0);
+     X(plan_with_store)(FFTW_EDGE_NONE, 0, 0, 0);
+     q = edge_plan(kind, rnk, n, x0, ref);
+
+     if (!p || !q) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  for (i = 0; i < ci * ni; ++i)
+	       x0[i] = x[i] = rnd();
+	  edge_mul(x0, wi, ni, ci);
+	  X(execute)(q);
+	  edge_mul(ref, wo, no, co);
+	  X(execute)(p);
+	  report(name, rrelerr(y, ref, co * no), TOL);
+     }
+
+     if (p)
+	  X(destroy_plan)(p);
+     if (q)
+	  X(destroy_plan)(q);
+     if (!inplace)
+	  X(free)(y);
+     X(free)(x);
+     X(free)(x0);
+     X(free)(ref);
+     free(wi);
+     free(wo);
+}
+
+static void edge(void)
+{
+     check_edge(EDGE_DFT, 200, 150, 1, 0);
+     check_edge(EDGE_DFT, 200, 150, 1, 1);
+     check_edge(EDGE_IDFT, 12, 40, 100, 0);
+     check_edge(EDGE_R2C, 160, 250, 1, 0);
+     check_edge(EDGE_R2C, 30, 40, 36, 0);
+     check_edge(EDGE_C2R, 160, 250, 1, 0);
+     check_edge(EDGE_C2R, 10, 60, 70, 0);
+     check_edge(EDGE_R2R, 200, 180, 1, 0);
+
+     /* small enough for a single block */
+     check_edge(EDGE_DFT, 8, 12, 1, 0);
+     check_edge(EDGE_R2C, 6, 10, 1, 0);
+     check_edge(EDGE_C2R, 6, 10, 1, 0);
+}
+
+/*************************************************************************/
+/* execution scratch, see X(execute_ws) and FFTW_NO_EXECUTE_ALLOC */
+
+/* execute one plan with reserved scratch on NX pairs of arrays at
+   once, by X(execute_batch) and by X(execute_async), which overlap
+   the executions if there are threads */
+static void check_shared(int n, int nx)
+{
+     C **x = (C **) malloc(sizeof(C *) * (size_t) nx);
+     C **y = (C **) malloc(sizeof(C *) * (size_t) nx);
+     X(plan) *plans = (X(plan) *) malloc(sizeof(X(plan)) * (size_t) nx);
+     X(request) *r = (X(request) *) malloc(sizeof(X(request)) * (size_t) nx);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) (n * nx));
+     X(plan) p;
+     char name[64];
+     double e;
+     int i, how;
+
+     for (i = 0; i < nx; ++i) {
+	  x[i] = (C *) X(malloc)(sizeof(C) * (size_t) n);
+	  y[i] = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     }
+
+     /* a scratch space for each of 4 threads, which execute NX > 4 */
+#ifdef HAVE_THREADS
+     X(plan_with_nthreads)(4);
+#endif
+     p = X(plan_dft_1d)(n, x[0], y[0], FFTW_FORWARD,
+			FFTW_ESTIMATE | FFTW_NO_EXECUTE_ALLOC);
+     for (how = 0; how < 2; ++how) {
+	  sprintf(name, "no_execute_alloc n=%d x%d %s", n, nx,
+		  how ? "async" : "batch");
+	  if (!p) {
+	       report(name, HUGE_VAL, TOL);
+	       continue;
+	  }
+	  for (i = 0; i < nx; ++i) {
+	       plans[i] = p;
+	       fill(x[i], n);
+	       dft_direct(n, n, n, FFTW_FORWARD, x[i], ref + i * n);
+	  }
+	  if (how) {
+	       for (i = 0; i < nx; ++i)
+		    r[i] = X(execute_async)(p, x[i], y[i]);
+	       for (i = 0; i < nx; ++i)
+		    X(wait)(r[i]);
+	  } else {
+	       X(execute_batch)(plans, (void **) x, (void **) y, nx);
+	  }
+	  for (e = 0, i = 0; i < nx; ++i) {
+	       double ei = relerr(y[i], ref + i * n, n);
+	       if (!(ei <= e)) e = ei;
+	  }
+	  report(name, e, TOL);
+     }
+#ifdef HAVE_THREADS
+     X(plan_with_nthreads)(1);
+#endif
+
+     if (p)
+	  X(destroy_plan)(p);
+     for (i = 0; i < nx; ++i) {
+	  X(free)(x[i]);
+	  X(free)(y[i]);
+     }
+     free(x);
+     free(y);
+     free(plans);
+     free(r);
+     free(ref);
+}
+
+/* execute a plan of size N on two pairs of arrays, with a workspace
+   of the user filled with garbage */
+static void check_ws(int n, unsigned flags)
+{
+     C *x[2], *y[2];
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     void *ws = 0;
+     size_t sz;
+     X(plan) p;
+     char name[64];
+     double e = 0, ei;
+     int i;
+
+     for (i = 0; i < 2; ++i) {
+	  x[i] = (C *) X(malloc)(sizeof(C) * (size_t) n);
+	  y[i] = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     }
+
+     p = X(plan_dft_1d)(n, x[0], y[0], FFTW_FORWARD, flags);
+     sz = p ? X(plan_workspace_size)(p) : 0;
+     sprintf(name, "execute_ws n=%d ws=%lu%s", n, (unsigned long) sz,
+	     (flags & FFTW_NO_EXECUTE_ALLOC) ? " no_execute_alloc" : "");
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  if (sz > 0) {
+	       ws = X(malloc)(sz);
+	       memset(ws, 0xff, sz);
+	  }
+	  for (i = 0; i < 4; ++i) {
+	       fill(x[i % 2], n);
+	       memcpy(x0, x[i % 2], sizeof(C) * (size_t) n);
+	       dft_direct(n, n, n, FFTW_FORWARD, x0, ref);
+	       X(execute_dft_ws)(p, x[i % 2], y[i % 2], ws);
+	       ei = relerr(y[i % 2], ref, n);
+	       if (!(ei <= e)) e = ei;
+	  }
+	  report(name, e, TOL);
+	  if (ws)
+	       X(free)(ws);
+	  X(destroy_plan)(p);
+     }
+
+     for (i = 0; i < 2; ++i) {
+	  X(free)(x[i]);
+	  X(free)(y[i]);
+     }
+     free(x0);
+     free(ref);
+}
+
+/* NX async in-place transforms of size N on a buffer, each at N/2
+   past the previous one modulo N, which overlap and thus must run in
+   order */
+static void check_async_order(int n, int nx)
+{
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) (n + n / 2));
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) (n + n / 2));
+     X(request) *r = (X(request) *) malloc(sizeof(X(request)) * (size_t) nx);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) (n + n / 2));
+     X(plan) p;
+     char name[64];
+     int i, j;
+
+     sprintf(name, "async order n=%d x%d", n, nx);
+
+#ifdef HAVE_THREADS
+     X(plan_with_nthreads)(4);
+#endif
+     p = X(plan_dft_1d)(n, x, x, FFTW_FORWARD, FFTW_ESTIMATE);
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  /* serially on x0, with the result of each step in REF */
+	  fill(x, n + n / 2);
+	  memcpy(x0, x, sizeof(C) * (size_t) (n + n / 2));
+	  for (i = 0; i < nx; ++i) {
+	       C *y = x0 + (i % 2) * (n / 2);
+	       dft_direct(n, n, n, FFTW_FORWARD, y, ref);
+	       for (j = 0; j < n; ++j) {
+		    y[j][0] = (R) ref[j][0];
+		    y[j][1] = (R) ref[j][1];
+	       }
+	  }
+	  for (i = 0; i < n + n / 2; ++i) {
+	       ref[i][0] = x0[i][0];
+	       ref[i][1] = x0[i][1];
+	  }
+
+	  for (i = 0; i < nx; ++i) {
+	       C *y = x + (i % 2) * (n / 2);
+	       r[i] = X(execute_async)(p, y, y);
+	  }
+	  for (i = 0; i < nx; ++i)
+	       X(wait)(r[i]);
+	  report(name, relerr(x, ref, n + n / 2), nx * TOL);
+	  X(destroy_plan)(p);
+     }
+#ifdef HAVE_THREADS
+     X(plan_with_nthreads)(1);
+#endif
+
+     X(free)(x);
+     free(x0);
+     free(r);
+     free(ref);
+}
+
+static void shared(void)
+{
+     check_async_order(256, 6);
+     check_async_order(1000, 5);
+     check_ws(1031, FFTW_ESTIMATE);
+     check_ws(1031, FFTW_ESTIMATE | FFTW_NO_EXECUTE_ALLOC);
+     check_ws(64 * 35, FFTW_MEASURE);
+     check_shared(1031, 8);   /* prime: Rader or Bluestein */
+     check_shared(2 * 263, 8);
+}
+
+/*************************************************************************/
+/* anytime planning, see FFTW_ANYTIME */
+
+/* execute the plan of size N with FLAGS while it is being upgraded,
+   then after the upgrade unless CANCEL, in which case destroy it
+   during the upgrade */
+static void check_anytime(int n, unsigned flags, int cancel)
+{
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     X(plan) p;
+     char name[64];
+     double e, ei;
+     int i;
+
+     sprintf(name, "anytime n=%d%s", n, cancel ? " cancel" : "");
+
+     fill(x, n);
+     memcpy(x0, x, sizeof(C) * (size_t) n);
+     dft_direct(n, n, n, FFTW_FORWARD, x0, ref);
+
+     X(forget_wisdom)();
+     p = X(plan_dft_1d)(n, x, y, FFTW_FORWARD, flags | FFTW_ANYTIME);
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+	  goto done;
+     }
+
+     /* the upgrade measures on arrays of its own */
+     e = 0;
+     for (i = 0; i < 1000 && (cancel ? i < 1 : !X(test_upgrade)(p)); ++i) {
+	  X(execute)(p);
+	  ei = relerr(y, ref, n);
+	  if (!(ei <= e)) e = ei;
+	  if (memcmp(x, x0, sizeof(C) * (size_t) n))
+	       e = HUGE_VAL;
+     }
+     if (!cancel) {
+	  X(wait_upgrade)(p);
+	  if (!X(test_upgrade)(p))
+	       e = HUGE_VAL;
+	  memset(y, 0, sizeof(C) * (size_t) n);
+	  X(execute)(p);
+	  ei = relerr(y, ref, n);
+	  if (!(ei <= e)) e = ei;
+     }
+     X(destroy_plan)(p);
+     report(name, e, TOL);
+
+ done:
+     X(free)(x);
+     X(free)(y);
+     free(x0);
+     free(ref);
+}
+
+static void anytime(void)
+{
+#ifdef HAVE_THREADS
+     X(make_planner_thread_safe)();
+#endif
+     check_anytime(2 * 263, FFTW_MEASURE, 0);
+     check_anytime(64 * 35, FFTW_PATIENT, 0);
+     check_anytime(64 * 35, FFTW_EXHAUSTIVE, 1);
+     X(forget_wisdom)();
+}
+
+/*************************************************************************/
+/* planner statistics, see X(record_planner_stats) */
+
+/* the contents of the temporary file F, which it closes */
+static char *slurp(FILE *f)
+{
+     long len;
+     char *buf;
+
+     fflush(f);
+     len = ftell(f);
+     buf = (char *) malloc((size_t) (len > 0 ? len : 0) + 1);
+     rewind(f);
+     len = (long) fread(buf, 1, (size_t) (len > 0 ? len : 0), f);
+     buf[len] = 0;
+     fclose(f);
+     return buf;
+}
+
+/* the integer that follows KEY in the JSON S, or -1 */
+static int json_int(const char *s, const char *key)
+{
+     const char *k = strstr(s, key);
+     int v;
+     return (k && sscanf(k + strlen(key), "\": %d", &v) == 1) ? v : -1;
+}
+
+static void planner_stats(void)
+{
+     const int n = 64 * 35;
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     FILE *f;
+     char *stats = 0, *trace = 0;
+     X(plan) p;
+     int ok;
+
+     X(forget_wisdom)();
+     X(record_planner_stats)(1);
+     p = X(plan_dft_1d)(n, x, x, FFTW_FORWARD, FFTW_MEASURE);
+     X(record_planner_stats)(0);
+
+     if ((f = tmpfile())) {
+	  X(export_planner_stats_to_file)(f);
+	  stats = slurp(f);
+     }
+     if ((f = tmpfile())) {
+	  X(export_planner_trace_to_file)(f);
+	  trace = slurp(f);
+     }
+     ok = p && stats && trace;
+     report("planner stats",
+	    ok && json_int(stats, "\"problems") > 0
+	    && json_int(stats, "\"plans_evaluated") > 0
+	    && strstr(stats, "\"solvers\"") ? 0.0 : HUGE_VAL, TOL);
+     report("planner trace",
+	    ok && strstr(trace, "\"traceEvents\"")
+	    && strstr(trace, "\"ph\": \"X\"") ? 0.0 : HUGE_VAL, TOL);
+
+     X(forget_planner_stats)();
+     if (p)
+	  X(destroy_plan)(p);
+     X(forget_wisdom)();
+     free(stats);
+     free(trace);
+     X(free)(x);
+}
+
+/*************************************************************************/
+/* cost profiles, see X(fit_cost_profile) */
+
+/* the DFT of size N planned with FLAGS against the direct one */
+static double dft_err(int n, unsigned flags)
+{
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     X(plan) p;
+     double e = HUGE_VAL;
+
+     p = X(plan_dft_1d)(n, x, y, FFTW_FORWARD, flags);
+     if (p) {
+	  fill(x, n);
+	  memcpy(x0, x, sizeof(C) * (size_t) n);
+	  dft_direct(n, n, n, FFTW_FORWARD, x0, ref);
+	  X(execute)(p);
+	  e = relerr(y, ref, n);
+	  X(destroy_plan)(p);
+     }
+     X(free)(x);
+     X(free)(y);
+     free(x0);
+     free(ref);
+     return e;
+}
+
+static void cost_profile(void)
+{
+     static const int sizes[] = { 64, 60, 256, 1000, 64 * 35 };
+     const int nsizes = (int) (sizeof(sizes) / sizeof(sizes[0]));
+     FILE *f;
+     double e = 0, ei;
+     int i, ok;
+
+     X(forget_wisdom)();
+     X(record_cost_samples)(1);
+     for (i = 0; i < nsizes; ++i) {
+	  ei = dft_err(sizes[i], FFTW_MEASURE);
+	  if (!(ei <= e)) e = ei;
+     }
+     X(record_cost_samples)(0);
+     ok = (X(fit_cost_profile)() > 0);
+
+     /* through a file, to plan with the imported profile */
+     if ((f = tmpfile())) {
+	  X(export_cost_profile_to_file)(f);
+	  X(forget_cost_profile)();
+	  rewind(f);
+	  ok = ok && X(import_cost_profile_from_file)(f);
+	  fclose(f);
+     } else {
+	  ok = 0;
+     }
+     X(forget_wisdom)();
+     for (i = 0; i < nsizes; ++i) {
+	  ei = dft_err(sizes[i] + 1, FFTW_ESTIMATE);
+	  if (!(ei <= e)) e = ei;
+     }
+     report("cost profile", ok ? e : HUGE_VAL, TOL);
+     X(forget_cost_profile)();
+}
+
+/*************************************************************************/
+/* robust timing, see X(set_robust_timing) */
+
+static void robust_timing(void)
+{
+     char name[64];
+     double e, ei;
+     int level;
+
+     for (level = 1; level <= 2; ++level) {
+	  sprintf(name, "robust timing %d", level);
+	  X(forget_wisdom)();
+	  X(set_robust_timing)(level);
+	  e = dft_err(60, FFTW_MEASURE);
+	  ei = dft_err(64 * 35, FFTW_MEASURE);
+	  if (!(ei <= e)) e = ei;
+	  report(name, e, TOL);
+     }
+     X(set_robust_timing)(0);
+     X(forget_wisdom)();
+}
+
+/*************************************************************************/
+/* execution profile, see X(profile_plan) */
+
+/* profile NX executions of a DFT of size N, which must count them and
+   still compute the transform */
+static void check_profile(int n, int nx)
+{
+     C *x = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *y = (C *) X(malloc)(sizeof(C) * (size_t) n);
+     C *x0 = (C *) malloc(sizeof(C) * (size_t) n);
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) n);
+     char name[64], calls[32];
+     char *prof = 0;
+     FILE *f;
+     X(plan) p;
+     double e;
+     int i;
+
+     sprintf(name, "profile n=%d x%d", n, nx);
+
+     p = X(plan_dft_1d)(n, x, y, FFTW_FORWARD, FFTW_ESTIMATE);
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+	  goto done;
+     }
+     fill(x, n);
+     memcpy(x0, x, sizeof(C) * (size_t) n);
+     dft_direct(n, n, n, FFTW_FORWARD, x0, ref);
+
+     X(profile_plan)(p, 1);
+     X(execute)(p);        /* discarded by the reset below */
+     X(profile_plan)(p, 1);
+     for (i = 0; i < nx; ++i)
+	  X(execute)(p);
+     e = relerr(y, ref, n);
+     if ((f = tmpfile())) {
+	  X(fprint_plan_profile)(p, f);
+	  prof = slurp(f);
+     }
+     sprintf(calls, "[%d calls", nx);
+     if (!prof || strncmp(prof, calls, strlen(calls)))
+	  e = HUGE_VAL;
+
+     /* unprofiled again */
+     X(profile_plan)(p, 0);
+     memset(y, 0, sizeof(C) * (size_t) n);
+     X(execute)(p);
+     if (!(relerr(y, ref, n) <= e))
+	  e = relerr(y, ref, n);
+     report(name, e, TOL);
+     X(destroy_plan)(p);
+
+ done:
+     free(prof);
+     X(free)(x);
+     X(free)(y);
+     free(x0);
+     free(ref);
+}
+
+static void profile(void)
+{
+     check_profile(60, 3);
+     check_profile(1031, 5);
+     check_profile(64 * 35, 2);
+}
+
+/*************************************************************************/
+/* convolution and correlation, see X(plan_convolve) */
+
+/* index in the input of size N of the term S of the output T, or -1
+   if it is outside of a linear problem */
+static int conv_index(int kind, int t, int s, int n, int nk)
+{
+     switch (kind) {
+	 case FFTW_CONV_CIRCULAR: return ((t - s) % n + n) % n;
+	 case FFTW_CORR_CIRCULAR: return (t + s) % n;
+	 case FFTW_CORR_LINEAR: t += s - nk + 1; break;
+	 default: t -= s; break;
+     }
+     return (t >= 0 && t < n) ? t : -1;
+}
+
+/* the problem of rank 1 or 2, with N[0] = NK[0] = 1 for rank 1 */
+static void conv_direct(const int *n, const int *nk, int kind,
+			const C *k, const C *x, lcplx *y)
+{
+     int lin = !(kind & 1), corr = (kind & 2) != 0;
+     int m0 = lin ? n[0] + nk[0] - 1 : n[0];
+     int m1 = lin ? n[1] + nk[1] - 1 : n[1];
+     int t0, t1, s0, s1;
+
+     for (t0 = 0; t0 < m0; ++t0)
+	  for (t1 = 0; t1 < m1; ++t1) {
+	       long double yr = 0, yi = 0;
+	       for (s0 = 0; s0 < nk[0]; ++s0)
+		    for (s1 = 0; s1 < nk[1]; ++s1) {
+			 int i0 = conv_index(kind, t0, s0, n[0], nk[0]);
+			 int i1 = conv_index(kind, t1, s1, n[1], nk[1]);
+			 const R *a, *b;
+			 long double bi;
+			 if (i0 < 0 || i1 < 0)
+			      continue;
+			 a = x[i0 * n[1] + i1];
+			 b = k[s0 * nk[1] + s1];
+			 bi = corr ? -b[1] : b[1];
+			 yr += a[0] * (long double) b[0] - a[1] * bi;
+			 yi += a[0] * bi + a[1] * (long double) b[0];
+		    }
+	       y[t0 * m1 + t1][0] = yr;
+	       y[t0 * m1 + t1][1] = yi;
+	  }
+}
+
+static void check_conv(int rank, int n0, int n1, int nk0, int nk1,
+		       int kind, int realp)
+{
+     static const char *const kinds[] = {
+	  "conv", "conv circular", "corr", "corr circular"
+     };
+     int n[2], nk[2], m[2], i, nx, nkt, ny;
+     C *x, *y, *k, *x0;
+     lcplx *ref;
+     X(plan) p;
+     char name[64];
+
+     n[0] = n0; n[1] = n1; nk[0] = nk0; nk[1] = nk1;
+     for (i = 0; i < 2; ++i)
+	  m[i] = (kind & 1) ? n[i] : n[i] + nk[i] - 1;
+     nx = n[0] * n[1]; nkt = nk[0] * nk[1]; ny = m[0] * m[1];
+
+     /* complex arrays, of which the real problems use the first reals */
+     x = (C *) X(malloc)(sizeof(C) * (size_t) nx);
+     y = (C *) X(malloc)(sizeof(C) * (size_t) ny);
+     k = (C *) X(malloc)(sizeof(C) * (size_t) nkt);
+     x0 = (C *) malloc(sizeof(C) * (size_t) nx);
+     ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) ny);
+
+     if (rank == 1)
+	  sprintf(name, "%s%s n=%d nk=%d", kinds[kind], realp ? " r" : "",
+		  n1, nk1);
+     else
+	  sprintf(name, "%s%s n=%dx%d nk=%dx%d", kinds[kind],
+		  realp ? " r" : "", n0, n1, nk0, nk1);
+
+     fill(k, nkt);
+     if (realp) {
+	  R *kr = (R *) k;
+	  for (i = 0; i < nkt; ++i)
+	       kr[i] = k[i][0];
+	  p = X(plan_convolve_r)(rank, n + 2 - rank, nk + 2 - rank, kr,
+				 (R *) x, (R *) y,
+				 (X(conv_kind)) kind, FFTW_ESTIMATE);
+     } else {
+	  p = X(plan_convolve)(rank, n + 2 - rank, nk + 2 - rank, k, x, y,
+			       (X(conv_kind)) kind, FFTW_ESTIMATE);
+     }
+
+     if (!p) {
+	  report(name, HUGE_VAL, TOL);
+     } else {
+	  fill(x0, nx);
+	  if (realp) {
+	       /* the reference from the complex copies of the reals */
+	       R *xr = (R *) x;
+	       C *kc = (C *) malloc(sizeof(C) * (size_t) nkt);
+	       for (i = 0; i < nx; ++i) {
+		    xr[i] = x0[i][0];
+		    x0[i][1] = 0;
+	       }
+	       for (i = nkt - 1; i >= 0; --i) {
+		    kc[i][0] = ((R *) k)[i];
+		    kc[i][1] = 0;
+	       }
+	       conv_direct(n, nk, kind, kc, x0, ref);
+	       free(kc);
+	       X(execute)(p);
+	       for (i = ny - 1; i >= 0; --i) {
+		    y[i][0] = ((R *) y)[i];
+		    y[i][1] = 0;
+	       }
+	  } else {
+	       memcpy(x, x0, sizeof(C) * (size_t) nx);
+	       conv_direct(n, nk, kind, k, x0, ref);
+	       X(execute)(p);
+	  }
+	  report(name, relerr(y, ref, ny), TOL);
+	  X(destroy_plan)(p);
+     }
+
+     X(free)(x);
+     X(free)(y);
+     X(free)(k);
+     free(x0);
+     free(ref);
+}
+
+static void conv(void)
+{
+     int kind;
+
+     for (kind = FFTW_CONV_LINEAR; kind <= FFTW_CORR_CIRCULAR; ++kind) {
+	  check_conv(1, 1, 100, 1, 7, kind, 0);
+	  check_conv(1, 1, 63, 1, 10, kind, 1);
+	  check_conv(2, 12, 10, 3, 5, kind, 0);
+	  check_conv(2, 9, 16, 4, 4, kind, 1);
+     }
+
+     /* long signals, which may be convolved block by block */
+     check_conv(1, 1, 5000, 1, 5, FFTW_CONV_LINEAR, 0);
+     check_conv(1, 1, 5000, 1, 17, FFTW_CONV_LINEAR, 1);
+     check_conv(1, 1, 3000, 1, 40, FFTW_CORR_LINEAR, 0);
+     check_conv(1, 1, 4096, 1, 100, FFTW_CORR_LINEAR, 1);
+}
+
+/*************************************************************************/
+/* short-time Fourier transform, see X(plan_stft) */
+
+/* whether the checks below plan with load and store operations, which
+   apply to the plans of the user but not to those that stft and nufft
+   create internally; the table is too short for those anyway */
+static int edges = 0;
+
+static void edge_ops(int on)
+{
+     static const R arg[2] = { 3.0, 0.5 };
+
+     X(plan_with_load)(on ? FFTW_EDGE_MODULATE : FFTW_EDGE_NONE,
+		       arg, 0, 0);
+     X(plan_with_store)(on ? FFTW_EDGE_SCALE : FFTW_EDGE_NONE, arg, 0, 0);
+}
+
+/* feed NX samples in chunks of pseudo-random lengths up to MAXCHUNK,
+   and compare each frame with X(execute_dft_r2c) of the windowed
+   frame; OFS misaligns the output array */
+static void check_stft(int n, int hop, int windowp, int nx, int maxchunk,
+		       int ofs)
+{
+     int nc = n / 2 + 1, nfr = nx < n ? 0 : (nx - n) / hop + 1;
+     R *x = (R *) malloc(sizeof(R) * (size_t) nx);
+     R *w = (R *) malloc(sizeof(R) * (size_t) n);
+     R *f = (R *) X(malloc)(sizeof(R) * (size_t) n);
+     C *spec = (C *) X(malloc)(sizeof(C) * (size_t) nc);
+     C *out = (C *) X(malloc)(sizeof(C) * ((size_t) nfr * nc + 1));
+     lcplx *ref = (lcplx *) malloc(sizeof(lcplx) * ((size_t) nfr * nc + 1));
+     X(stft) s;
+     X(plan) p;
+     char name[64];
+     int i, j, got = 0;
+
+     sprintf(name, "stft n=%d hop=%d chunk<=%d%s%s%s", n, hop, maxchunk,
+	     windowp ? " window" : "", ofs ? " unaligned" : "",
+	     edges ? " edges" : "");
+
+     for (i = 0; i < n; ++i)
+	  w[i] = (R)(0.5 - 0.5 * cos(K2PI * i / n));
+     for (i = 0; i < nx; ++i)
+	  x[i] = rnd();
+
+     edge_ops(edges);
+     s = X(plan_stft)(windowp ? w : 0, n, hop, FFTW_ESTIMATE);
+     edge_ops(0);
+     p = X(plan_dft_r2c_1d)(n, f, spec, FFTW_ESTIMATE);
+     if (!s || !p) {
+	  report(name, HUGE_VAL, TOL);
+	  goto done;
+     }
+
+     for (i = 0; i < nx; ) {
+	  int m = 1 + (int) ((rnd() + 0.5) * maxchunk);
+	  int k;
+	  if (m > nx - i)
+	       m = nx - i;
+	  k = X(stft_frames)(s, m);
+	  if (got + k > nfr
+	      || X(stft_execute)(s, x + i, m, out + ofs + (size_t) got * nc)
+	      != k) {
+	       report(name, HUGE_VAL, TOL);
+	       goto done;
+	  }
+	  got += k;
+	  i += m;
+     }
+     if (got != nfr) {
+	  report(name, HUGE_VAL, TOL);
+	  goto done;
+     }
+
+     for (j = 0; j < nfr; ++j) {
+	  for (i = 0; i < n; ++i)
+	       f[i] = windowp ? x[j * hop + i] * w[i] : x[j * hop + i];
+	  X(execute_dft_r2c)(p, f, spec);
+	  for (i = 0; i < nc; ++i) {
+	       ref[ofs + (size_t) j * nc + i][0] = spec[i][0];
+	       ref[ofs + (size_t) j * nc + i][1] = spec[i][1];
+	  }
+     }
+     report(name, relerr(out + ofs, ref + ofs, nfr * nc), TOL);
+
+ done:
+     X(destroy_stft)(s);
+     if (p)
+	  X(destroy_plan)(p);
+     free(x);
+     free(w);
+     X(free)(f);
+     X(free)(spec);
+     X(free)(out);
+     free(ref);
+}
+
+static void stft(void)
+{
+     check_stft(64, 16, 1, 5000, 100, 0);
+     check_stft(64, 16, 0, 5000, 3, 0);
+     check_stft(60, 60, 1, 3000, 500, 1);    /* hop == n */
+     check_stft(32, 50, 1, 4000, 70, 0);     /* hop > n: gaps */
+     check_stft(128, 1, 0, 2000, 1000, 0);   /* hop == 1 */
+     check_stft(1000, 300, 1, 20000, 5000, 1);
+
+     /* a few frames per call, less than a batch, split among the
+	plans for 1, 2, 4, ... frames, some at odd offsets */
+     check_stft(256, 32, 1, 20000, 700, 1);
+     check_stft(25, 5, 1, 3000, 60, 0);
+     check_stft(33, 3, 0, 3000, 200, 0);
+
+     edges = 1;
+     check_stft(64, 16, 1, 3000, 100, 0);
+     edges = 0;
+}
+
+/*************************************************************************/
+/* non-uniform FFTs, see X(plan_nufft) */
+
+/* the frequencies of the modes of types 1 and 2, row-major */
+static void nufft_modes(int rank, const int *n, int nf, long double *s)
+{
+     int k, d;
+
+     for (k = 0; k < nf; ++k) {
+	  int r = k;
+	  for (d = rank - 1; d >= 0; --d) {
+	       s[k * rank + d] = r % n[d] - n[d] / 2;
+	       r /= n[d];
+	  }
+     }
+}
+
+/* Y[t] = sum over j of IN[j] exp(sign i a_j . b_t), for NA sources a
+   and NB targets b of RANK coordinates */
+static void nufft_direct(int rank, int na, const long double *a, int nb,
+			 const long double *b, int sign, const C *in,
+			 lcplx *y)
+{
+     int j, t, d;
+
+     for (t = 0; t < nb; ++t) {
+	  long double yr = 0, yi = 0;
+	  for (j = 0; j < na; ++j) {
+	       long double th = 0, c, s;
+	       for (d = 0; d < rank; ++d)
+		    th += a[j * rank + d] * b[t * rank + d];
+	       c = cosl(th);
+	       s = sign * sinl(th);
+	       yr += in[j][0] * c - in[j][1] * s;
+	       yi += in[j][0] * s + in[j][1] * c;
+	  }
+	  y[t][0] = yr;
+	  y[t][1] = yi;
+     }
+}
+
+/* CNT coordinates uniform in [-A, A), in X and their copies in XL */
+static void fill_pts(R *x, long double *xl, int cnt, double a)
+{
+     int i;
+     for (i = 0; i < cnt; ++i)
+	  xl[i] = x[i] = (R)(2 * a * rnd());
+}
+
+/* M points, and for type 3, 200 frequencies */
+static void check_nufft(int type, int rank, int n0, int n1, int n2, int m,
+			int sign, double tol)
+{
+     int n[3], nf = 1, nk = (type == 3) ? 200 : 0, d, ok;
+     R *x = (R *) malloc(sizeof(R) * (size_t) (m * rank));
+     R *s = (R *) malloc(sizeof(R) * (size_t) (nk * rank + 1));
+     long double *xl, *sl;
+     C *c, *f;
+     lcplx *ref;
+     X(nufft) p;
+     char name[64];
+
+     n[0] = n0; n[1] = n1; n[2] = n2;
+     if (type == 3)
+	  nf = nk;
+     else
+	  for (d = 0; d < rank; ++d)
+	       nf *= n[d];
+     c = (C *) X(malloc)(sizeof(C) * (size_t) m);
+     f = (C *) X(malloc)(sizeof(C) * (size_t) nf);
+     xl = (long double *) malloc(sizeof(long double) * (size_t) (m * rank));
+     sl = (long double *) malloc(sizeof(long double) * (size_t) (nf * rank));
+     ref = (lcplx *) malloc(sizeof(lcplx) * (size_t) (type == 2 ? m : nf));
+
+     sprintf(name, "nufft type %d rank %d tol=%g%s%s", type, rank, tol,
+	     sign > 0 ? " backward" : "", edges ? " edges" : "");
+
+     if (type == 3) {
+	  fill_pts(x, xl, m * rank, 2.0);
+	  fill_pts(s, sl, nk * rank, 40.0);
+     } else {
+	  fill_pts(x, xl, m * rank, 7.0); /* wrapped around 2 pi */
+	  nufft_modes(rank, n, nf, sl);
+     }
+
+     /* type 3 plans its inner transforms in X(nufft_setpts) */
+     edge_ops(edges);
+     p = X(plan_nufft)(type, rank, n, sign, tol, FFTW_ESTIMATE);
+     ok = p && X(nufft_setpts)(p, m, x, nk, s);
+     edge_ops(0);
+     if (!ok) {
+	  report(name, HUGE_VAL, tol);
+     } else if (type == 2) {
+	  fill(f, nf);
+	  nufft_direct(rank, nf, sl, m, xl, sign, f, ref);
+	  X(nufft_execute)(p, c, f);
+	  report(name, relerr(c, ref, m), 10 * tol);
+     } else {
+	  fill(c, m);
+	  nufft_direct(rank, m, xl, nf, sl, sign, c, ref);
+	  X(nufft_execute)(p, c, f);
+	  report(name, relerr(f, ref, nf), 10 * tol);
+     }
+
+     if (p)
+	  X(destroy_nufft)(p);
+     free(x);
+     free(s);
+     free(xl);
+     free(sl);
+     X(free)(c);
+     X(free)(f);
+     free(ref);
+}
+
+static void nufft(void)
+{
+     static const double tols[] = { 1e-3, 1e-6, 1e-9, 1e-12 };
+     unsigned i;
+
+     /* down to a little above the epsilon of the precision */
+     for (i = 0; i < sizeof(tols) / sizeof(tols[0]) && tols[i] >= 1e3 * EPS;
+	  ++i) {
+	  double tol = tols[i];
+	  check_nufft(1, 1, 1, 1, 100, 500, FFTW_FORWARD, tol);
+	  check_nufft(2, 1, 1, 1, 77, 300, FFTW_BACKWARD, tol);
+	  check_nufft(1, 2, 24, 17, 1, 400, FFTW_BACKWARD, tol);
+	  check_nufft(2, 2, 16, 20, 1, 400, FFTW_FORWARD, tol);
+	  check_nufft(1, 3, 8, 10, 6, 300, FFTW_FORWARD, tol);
+	  check_nufft(2, 3, 7, 8, 9, 300, FFTW_BACKWARD, tol);
+	  check_nufft(3, 1, 1, 1, 1, 300, FFTW_FORWARD, tol);
+	  check_nufft(3, 2, 1, 1, 1, 300, FFTW_BACKWARD, tol);
+     }
+
+     edges = 1;
+     check_nufft(1, 2, 24, 17, 1, 400, FFTW_BACKWARD, 1e-6);
+     check_nufft(3, 1, 1, 1, 1, 300, FFTW_FORWARD, 1e-6);
+     edges = 0;
+}
+
+/*************************************************************************/
+
+int main(int argc, char *argv[])
+{
+     verbose = (argc > 1 && !strcmp(argv[1], "-v"));
+#ifdef HAVE_THREADS
+     X(init_threads)();
+#endif
+
+     czt();
+     pruned();
+     export_plans();
+     normalize();
+     edge();
+     shared();
+     anytime();
+     planner_stats();
+     cost_profile();
+     robust_timing();
+     profile();
+     conv();
+     stft();
+     nufft();
+
+#ifdef HAVE_THREADS
+     X(cleanup_threads)();
+#else
+     X(cleanup)();
+#endif
+     return failed;
+}
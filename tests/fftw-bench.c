@@ -33,7 +33,17 @@ int paranoid = 0;
 int usewisdom = 0;
 int havewisdom = 0;
 int nthreads = 1;
+int nsearch = 1;
 int amnesia = 0;
+int useworkspace = 0;
+int profile = 0;
+static void *the_workspace = 0;
+const char *planner_stats_file = 0;  /* JSON statistics, if nonzero */
+const char *planner_trace_file = 0;  /* Chrome trace, if nonzero */
+
+#define MAXCPUS 1024
+static int cpus[MAXCPUS];
+static int ncpus = 0;
 
 extern void install_hook(void);  /* in hook.c */
 extern void uninstall_hook(void);  /* in hook.c */
@@ -69,6 +79,36 @@ static void setup_sigfpe_handler(void)
 }
 #endif
 
+/* parse a list of cpus such as "0-3,8,10-11" */
+static void parse_cpus(const char *s)
+{
+     int lo, hi, n;
+
+     ncpus = 0;
+     while (sscanf(s, "%d%n", &lo, &n) == 1) {
+	  s += n;
+	  hi = lo;
+	  if (*s == '-' && sscanf(s + 1, "%d%n", &hi, &n) == 1)
+	       s += 1 + n;
+	  for (; lo <= hi && ncpus < MAXCPUS; ++lo)
+	       cpus[ncpus++] = lo;
+	  if (*s != ',') break;
+	  ++s;
+     }
+}
+
+/* identity load operation, for testing the fused edge operations */
+static void edge_identity(bench_real *re, bench_real *im, ptrdiff_t n,
+			  ptrdiff_t stride, ptrdiff_t first, void *data)
+{
+     ptrdiff_t i;
+     (void) first; (void) data; /* unused */
+     for (i = 0; i < n; ++i) {
+	  re[i * stride] *= 1.0;
+	  if (im) im[i * stride] *= 1.0;
+     }
+}
+
 /* dummy serial threads backend for testing threads_set_callback */
 static void serial_threads(void *(*work)(char *), char *jobdata, size_t elsize, int njobs, void *data)
 {
@@ -91,11 +131,20 @@ void useropt(const char *arg)
      else if (!strcmp(arg, "nosimd")) the_flags |= FFTW_NO_SIMD;
      else if (!strcmp(arg, "noindirectop")) the_flags |= FFTW_NO_INDIRECT_OP;
      else if (!strcmp(arg, "wisdom-only")) the_flags |= FFTW_WISDOM_ONLY;
+     else if (!strcmp(arg, "noexecalloc")) the_flags |= FFTW_NO_EXECUTE_ALLOC;
+     else if (!strcmp(arg, "anytime")) the_flags |= FFTW_ANYTIME;
      else if (sscanf(arg, "flag=%d", &x) == 1) the_flags |= x;
      else if (sscanf(arg, "bflag=%d", &x) == 1) the_flags |= 1U << x;
      else if (!strcmp(arg, "paranoid")) paranoid = 1;
      else if (!strcmp(arg, "wisdom")) usewisdom = 1;
      else if (!strcmp(arg, "amnesia")) amnesia = 1;
+     else if (!strcmp(arg, "workspace")) useworkspace = 1;
+     else if (!strcmp(arg, "profile")) profile = 1;
+     else if (!strcmp(arg, "edge")) {
+	  static const bench_real one = 1.0;
+	  FFTW(plan_with_load)(FFTW_EDGE_CALLBACK, 0, edge_identity, 0);
+	  FFTW(plan_with_store)(FFTW_EDGE_SCALE, &one, 0, 0);
+     }
      else if (!strcmp(arg, "threads_callback"))
 #ifdef HAVE_SMP
           FFTW(threads_set_callback)(serial_threads, NULL);
@@ -103,12 +152,28 @@ void useropt(const char *arg)
           fprintf(stderr, "Serial FFTW; ignoring threads_callback option.\n");
 #endif
      else if (sscanf(arg, "nthreads=%d", &x) == 1) nthreads = x;
+     else if (sscanf(arg, "nsearch=%d", &x) == 1) nsearch = x;
+     else if (!strncmp(arg, "cpus=", 5)) parse_cpus(arg + 5);
 #ifdef FFTW_RANDOM_ESTIMATOR
      else if (sscanf(arg, "eseed=%d", &x) == 1) FFTW(random_estimate_seed) = x;
 #endif
      else if (sscanf(arg, "timelimit=%lg", &y) == 1) {
 	  FFTW(set_timelimit)(y);
      }
+     else if (sscanf(arg, "robust-timing=%d", &x) == 1)
+	  FFTW(set_robust_timing)(x);
+     else if (!strncmp(arg, "planner-stats=", 14)) {
+	  planner_stats_file = arg + 14;
+	  FFTW(record_planner_stats)(1);
+     }
+     else if (!strncmp(arg, "planner-trace=", 14)) {
+	  planner_trace_file = arg + 14;
+	  FFTW(record_planner_stats)(1);
+     }
+     else if (!strncmp(arg, "cost-profile=", 13)) {
+	  if (!FFTW(import_cost_profile_from_filename)(arg + 13))
+	       fprintf(stderr, "error reading cost profile %s\n", arg + 13);
+     }
 
      else fprintf(stderr, "unknown user option: %s.  Ignoring.\n", arg);
 }
@@ -126,6 +191,10 @@ void rdwisdom(void)
 	  BENCH_ASSERT(FFTW(init_threads)());
 	  FFTW(plan_with_nthreads)(nthreads);
 	  BENCH_ASSERT(FFTW(planner_nthreads)() == nthreads);
+	  if (ncpus > 0)
+	       FFTW(plan_with_affinity)(cpus, ncpus);
+	  if (nsearch > 1)
+	       FFTW(plan_with_search_nthreads)(nsearch);
           FFTW(make_planner_thread_safe)();
 #ifdef _OPENMP
 	  omp_set_num_threads(nthreads);
@@ -175,6 +244,17 @@ void wrwisdom(void)
      if (verbose > 1) printf("write wisdom took %g seconds\n", tim);
 }
 
+static void wrplannerstats(void)
+{
+     FFTW(record_planner_stats)(0);
+     if (planner_stats_file
+	 && !FFTW(export_planner_stats_to_filename)(planner_stats_file))
+	  fprintf(stderr, "bench: ERROR writing %s\n", planner_stats_file);
+     if (planner_trace_file
+	 && !FFTW(export_planner_trace_to_filename)(planner_trace_file))
+	  fprintf(stderr, "bench: ERROR writing %s\n", planner_trace_file);
+}
+
 static unsigned preserve_input_flags(bench_problem *p)
 {
      /*
@@ -234,7 +314,10 @@ void setup(bench_problem *p)
      }
 
      rdwisdom();
-     install_hook();
+     /* the hook checks every plan on the arrays of the problem, which
+	rules out planning in the background */
+     if (!(the_flags & FFTW_ANYTIME))
+	  install_hook();
 
 #ifdef HAVE_SMP
      if (verbose > 1 && nthreads > 1) printf("NTHREADS = %d\n", nthreads);
@@ -245,10 +328,43 @@ void setup(bench_problem *p)
      tim = timer_stop(USER_TIMER);
      if (verbose > 1) printf("planner time: %g s\n", tim);
 
+     if (the_flags & FFTW_ANYTIME) {
+	  /* time the final plan, and don't let import_plan below
+	     replace it with the estimated one */
+	  timer_start(USER_TIMER);
+	  FFTW(wait_upgrade)(plan);
+	  tim = timer_stop(USER_TIMER);
+	  if (verbose > 1) printf("upgrade time: %g s\n", tim);
+     }
+
      the_plan = FFTW(copy_plan)(plan); /* test copy_plan */
      BENCH_ASSERT(the_plan);
      FFTW(destroy_plan)(plan); /* the_plan should still exist */
 
+     {
+	  /* test export_plan/import_plan, when the plan allows it */
+	  size_t len = FFTW(export_plan)(the_plan, 0, 0);
+	  if (len) {
+	       void *blob = bench_malloc(len);
+	       BENCH_ASSERT(FFTW(export_plan)(the_plan, blob, len) == len);
+	       plan = FFTW(import_plan)(blob, len, p->in, p->out);
+	       BENCH_ASSERT(plan);
+	       bench_free(blob);
+	       FFTW(destroy_plan)(the_plan);
+	       the_plan = plan;
+	  }
+     }
+
+     if (useworkspace) {
+	  size_t wssz = FFTW(plan_workspace_size)(the_plan);
+	  if (verbose > 1) printf("workspace: %lu bytes\n",
+				  (unsigned long) wssz);
+	  the_workspace = FFTW(malloc)(wssz);
+     }
+
+     if (profile)
+	  FFTW(profile_plan)(the_plan, 1);
+
      {
 	  double add, mul, nfma, cost, pcost;
 	  FFTW(flops)(the_plan, &add, &mul, &nfma);
@@ -271,15 +387,25 @@ void doit(int iter, bench_problem *p)
      FFTW(plan) q = the_plan;
 
      UNUSED(p);
-     for (i = 0; i < iter; ++i)
-	  FFTW(execute)(q);
+     if (useworkspace)
+	  for (i = 0; i < iter; ++i)
+	       FFTW(execute_ws)(q, the_workspace);
+     else
+	  for (i = 0; i < iter; ++i)
+	       FFTW(execute)(q);
 }
 
 void done(bench_problem *p)
 {
      UNUSED(p);
 
+     if (profile) {
+	  FFTW(print_plan_profile)(the_plan);
+	  printf("\n");
+     }
      FFTW(destroy_plan)(the_plan);
+     FFTW(free)(the_workspace);
+     the_workspace = 0;
      uninstall_hook();
 }
 
@@ -288,6 +414,7 @@ void cleanup(void)
      initial_cleanup();
 
      wrwisdom();
+     wrplannerstats();
 #ifdef HAVE_SMP
      FFTW(cleanup_threads)();
 #else
@@ -0,0 +1,78 @@
+/* Microbenchmark for the fork/join latency of X(spawn_loop).
+
+   Usage: forkjoin [maxthreads [iterations]]
+
+   For each number of threads from 1 to MAXTHREADS, time ITERATIONS
+   calls to X(spawn_loop) with a trivial loop body, both flat and
+   nested one level deep, and print the average cost of a call.
+
+   This program is not part of fftw. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CALLING_FFTW /* hack */
+#include "threads/threads.h"
+#include "api/api.h"
+
+static volatile int sink;
+
+static void *nop(spawn_data *d)
+{
+     sink = d->min;
+     return 0;
+}
+
+static void *nested(spawn_data *d)
+{
+     int nthr = *(int *)d->data;
+     X(spawn_loop)(nthr, nthr, nop, 0);
+     return 0;
+}
+
+static double now(void)
+{
+     crude_time t = X(get_crude_time)();
+#if defined(HAVE_GETTIMEOFDAY) && !defined(FAKE_CRUDE_TIME)
+     return (double)t.tv_sec + 1.0e-6 * (double)t.tv_usec;
+#else
+     return (double)t / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+static double timeit(int nthr, int iter, spawn_function proc, int inner)
+{
+     double t0;
+     int i;
+
+     /* warm up, so that the pool exists */
+     for (i = 0; i < 100; ++i)
+	  X(spawn_loop)(nthr, nthr, proc, &inner);
+
+     t0 = now();
+     for (i = 0; i < iter; ++i)
+	  X(spawn_loop)(nthr, nthr, proc, &inner);
+     return (now() - t0) / iter;
+}
+
+int main(int argc, char *argv[])
+{
+     int maxthr = argc > 1 ? atoi(argv[1]) : 8;
+     int iter = argc > 2 ? atoi(argv[2]) : 100000;
+     int nthr;
+
+     if (!X(init_threads)()) {
+	  fprintf(stderr, "forkjoin: cannot initialize threads\n");
+	  return 1;
+     }
+
+     printf("%8s %16s %16s\n", "nthreads", "flat (us)", "nested (us)");
+     for (nthr = 1; nthr <= maxthr; ++nthr) {
+	  double tf = timeit(nthr, iter, nop, 1);
+	  double tn = timeit(nthr, iter / 10 + 1, nested, 2);
+	  printf("%8d %16.3f %16.3f\n", nthr, tf * 1.0e6, tn * 1.0e6);
+     }
+
+     X(cleanup_threads)();
+     return 0;
+}
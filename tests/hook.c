@@ -215,6 +215,7 @@ static void hook(planner *plnr, plan *pln, const problem *p_, int optimalp)
 	       the_plan = (apiplan *) MALLOC(sizeof(apiplan), PLANS);
 	       the_plan->pln = pln;
 	       the_plan->prb = (problem *) p_;
+	       the_plan->trace = 0;
 
 	       X(plan_awake)(pln, AWAKE_SQRTN_TABLE);
 	       verify_problem(bp, rounds, tol);
@@ -22,17 +22,67 @@
 #include "threads/threads.h"
 
 static int threads_inited = 0;
+static int planner_thread_safe = 0;
+
+/* X(execute_batch) uses as many threads as the planner */
+static void execute_batch(int n, void (*work)(void *data, int i),
+			  void *data)
+{
+     X(spawn_each)(n, X(the_planner)()->nthr, work, data);
+}
+
+/* X(execute_async) runs as many requests at once as the planner
+   has threads */
+static void *async_spawn(void (*work)(void *data), void *data,
+			 void *const *range, int nrange)
+{
+     return X(spawn_async)(work, data, range, nrange,
+			   X(the_planner)()->nthr);
+}
+
+static int async_test(void *task)
+{
+     return X(async_test)((async_task *) task);
+}
+
+static void async_wait(void *task)
+{
+     X(async_wait)((async_task *) task);
+}
+
+/* the upgrade of a plan runs on a worker of its own, see
+   X(spawn_async) */
+static void *upgrade_spawn(void (*work)(void *data), void *data)
+{
+     return X(spawn_async)(work, data, 0, 0, 0);
+}
 
 static void threads_register_hooks(void)
 {
      X(mksolver_ct_hook) = X(mksolver_ct_threads);
      X(mksolver_hc2hc_hook) = X(mksolver_hc2hc_threads);
+     X(set_batch_hook)(execute_batch);
+     X(set_async_hooks)(async_spawn, async_test, async_wait);
+     X(set_upgrade_hooks)(upgrade_spawn, async_test, async_wait,
+			  X(threads_loadp), X(threads_storep));
 }
 
 static void threads_unregister_hooks(void)
 {
      X(mksolver_ct_hook) = 0;
      X(mksolver_hc2hc_hook) = 0;
+     X(set_batch_hook)(0);
+     X(set_async_hooks)(0, 0, 0);
+     X(set_upgrade_hooks)(0, 0, 0, 0, 0);
+}
+
+/* let threads share the planner, see X(planner_lock) */
+static void install_planner_lock(planner *plnr)
+{
+     plnr->lock_hook = X(threads_planner_lock);
+     plnr->unlock_hook = X(threads_planner_unlock);
+     plnr->rdlock_hook = X(threads_planner_rdlock);
+     plnr->rdunlock_hook = X(threads_planner_rdunlock);
 }
 
 /* should be called before all other FFTW functions! */
@@ -50,6 +100,8 @@ int X(init_threads)(void)
 	     and hence the time it is configured */
 	  plnr = X(the_planner)();
 	  X(threads_conf_standard)(plnr);
+	  if (planner_thread_safe)
+	       install_planner_lock(plnr);
 
           threads_inited = 1;
      }
@@ -85,9 +137,66 @@ int X(planner_nthreads)(void)
     return X(the_planner)()->nthr;
 }
 
+void X(plan_with_affinity)(const int *cpus, int ncpus)
+{
+     if (!threads_inited) {
+	  X(cleanup)();
+	  X(init_threads)();
+     }
+     A(threads_inited);
+     X(threads_set_affinity)(cpus, ncpus);
+}
+
+typedef struct {
+     void (*work)(void *data, int thr);
+     void *data;
+} search_spawn;
+
+static void *search_thunk(spawn_data *d)
+{
+     search_spawn *ss = (search_spawn *) d->data;
+     ss->work(ss->data, d->thr_num);
+     return 0;
+}
+
+static void spawn_search(int nthr, void (*work)(void *data, int thr),
+			 void *data)
+{
+     search_spawn ss;
+     ss.work = work;
+     ss.data = data;
+     X(spawn_loop)(nthr, nthr, search_thunk, (void *) &ss);
+}
+
+void X(plan_with_search_nthreads)(int nthreads)
+{
+     planner *plnr;
+
+     if (!threads_inited) {
+	  X(cleanup)();
+	  X(init_threads)();
+     }
+     A(threads_inited);
+     plnr = X(the_planner)();
+     plnr->nsearch = X(imax)(1, nthreads);
+     plnr->spawn_hook = spawn_search;
+     plnr->timing_lock_hook = X(threads_timing_lock);
+     plnr->timing_unlock_hook = X(threads_timing_unlock);
+     install_planner_lock(plnr);
+}
+
 void X(make_planner_thread_safe)(void)
 {
+     planner *plnr;
+
      X(threads_register_planner_hooks)();
+
+     /* create the planner now, so that X(mkapiplan) can look at it
+	before taking the planner hooks */
+     plnr = X(the_planner)();
+     planner_thread_safe = 1;
+     if (threads_inited)
+	  install_planner_lock(plnr);
 }
 
 spawnloop_function X(spawnloop_callback) = (spawnloop_function) 0;
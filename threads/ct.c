@@ -83,10 +83,8 @@ static void apply_dif(const plan *ego_, R *ri, R *ii, R *ro, R *io)
 static void awake(plan *ego_, enum wakefulness wakefulness)
 {
      P *ego = (P *) ego_;
-     int i;
      X(plan_awake)(ego->cld, wakefulness);
-     for (i = 0; i < ego->nthr; ++i)
-	  X(plan_awake)(ego->cldws[i], wakefulness);
+     X(threads_plan_awake)(ego->cldws, ego->nthr, wakefulness);
 }
 
 static void destroy(plan *ego_)
@@ -72,9 +72,7 @@ static void apply(const plan *ego_, R *ri, R *ii, R *ro, R *io)
 static void awake(plan *ego_, enum wakefulness wakefulness)
 {
      P *ego = (P *) ego_;
-     int i;
-     for (i = 0; i < ego->nthr; ++i)
-	  X(plan_awake)(ego->cldrn[i], wakefulness);
+     X(threads_plan_awake)(ego->cldrn, ego->nthr, wakefulness);
 }
 
 static void destroy(plan *ego_)
@@ -33,6 +33,17 @@ FFTW_VOIDFUNC F77(planner_nthreads, PLANNER_NTHREADS)(int *nthreads)
     *nthreads = X(planner_nthreads)();
 }
 
+FFTW_VOIDFUNC F77(plan_with_affinity, PLAN_WITH_AFFINITY)(const int *cpus,
+							  int *ncpus)
+{
+     X(plan_with_affinity)(cpus, *ncpus);
+}
+
+FFTW_VOIDFUNC F77(plan_with_search_nthreads, PLAN_WITH_SEARCH_NTHREADS)(int *nthreads)
+{
+     X(plan_with_search_nthreads)(*nthreads);
+}
+
 FFTW_VOIDFUNC F77(init_threads, INIT_THREADS)(int *okay)
 {
      *okay = X(init_threads)();
@@ -26,11 +26,38 @@
 #error OpenMP enabled but not using an OpenMP compiler
 #endif
 
+#include <omp.h>
+
+/* serializes the planner's search threads, see kernel/planner.c */
+static omp_lock_t search_lock;
+static omp_lock_t timing_lock; /* see search_par() in planner.c */
+
 int X(ithreads_init)(void)
 {
+     omp_init_lock(&search_lock);
+     omp_init_lock(&timing_lock);
      return 0; /* no error */
 }
 
+/* see threads.c */
+typedef struct {
+     spawn_function proc;
+     void *data;
+     void *ws;
+} ws_data;
+
+static void *ws_thunk(spawn_data *d)
+{
+     ws_data *w = (ws_data *) d->data;
+     void *ws = X(scratch_bind)(w->ws);
+     void *ret;
+
+     d->data = w->data;
+     ret = w->proc(d);
+     X(scratch_bind)(ws);
+     return ret;
+}
+
 /* Distribute a loop from 0 to loopmax-1 over nthreads threads.
    proc(d) is called to execute a block of iterations from d->min
    to d->max-1.  d->thr_num indicate the number of the thread
@@ -43,6 +70,7 @@ void X(spawn_loop)(int loopmax, int nthr, spawn_function proc, void *data)
      int block_size;
      spawn_data d;
      int i;
+     ws_data w;
 
      A(loopmax >= 0);
      A(nthr > 0);
@@ -50,6 +78,13 @@ void X(spawn_loop)(int loopmax, int nthr, spawn_function proc, void *data)
 
      if (!loopmax) return;
 
+     if ((w.ws = X(scratch_workspace)())) {
+	  w.proc = proc;
+	  w.data = data;
+	  proc = ws_thunk;
+	  data = (void *) &w;
+     }
+
      /* Choose the block size and number of threads in order to (1)
         minimize the critical path and (2) use the fewest threads that
         achieve the same critical path (to minimize overhead).
@@ -85,8 +120,161 @@ void X(spawn_loop)(int loopmax, int nthr, spawn_function proc, void *data)
      }
 }
 
+typedef struct {
+     void (*work)(void *data, int i);
+     void *data;
+} each_data;
+
+static void *each_block(spawn_data *d)
+{
+     each_data *e = (each_data *) d->data;
+     int i;
+
+     for (i = d->min; i < d->max; ++i)
+	  e->work(e->data, i);
+     return 0;
+}
+
+/* see threads.c */
+void X(spawn_each)(int n, int nthr, void (*work)(void *data, int i),
+		   void *data)
+{
+     int i;
+
+     if (n <= 0) return;
+
+     /* user-defined spawnloop backend, or workspace to propagate */
+     if (X(spawnloop_callback) || X(scratch_workspace)()) {
+	  each_data e;
+	  e.work = work;
+	  e.data = data;
+	  X(spawn_loop)(n, nthr, each_block, (void *) &e);
+	  return;
+     }
+
+#pragma omp parallel for schedule(dynamic) num_threads(nthr)
+     for (i = 0; i < n; ++i)
+	  work(data, i);
+}
+
+/* OpenMP offers no portable way to run a task past the end of the
+   current parallel region, so asynchronous tasks are executed
+   immediately, which trivially preserves their order.  A null handle
+   means ``done''. */
+async_task *X(spawn_async)(void (*work)(void *data), void *data,
+			   void *const *range, int nrange, int nthr)
+{
+     UNUSED(range);
+     UNUSED(nrange);
+     UNUSED(nthr);
+     work(data);
+     return 0;
+}
+
+int X(async_test)(async_task *t)
+{
+     UNUSED(t);
+     return 1;
+}
+
+void X(async_wait)(async_task *t)
+{
+     UNUSED(t);
+}
+
+/* Since asynchronous tasks run immediately, no other thread can
+   replace the pointer while we read it */
+void *X(threads_loadp)(void **p)
+{
+     return *p;
+}
+
+void X(threads_storep)(void **p, void *x)
+{
+     *p = x;
+}
+
+typedef struct {
+     plan **plns;
+     enum wakefulness wakefulness;
+} awake_data;
+
+/* > 0 iff the calling thread is in the critical section */
+static int awake_depth;
+#pragma omp threadprivate(awake_depth)
+
+static void *awake_one(spawn_data *d)
+{
+     awake_data *ad = (awake_data *) d->data;
+
+#pragma omp critical (fftw_plan_awake)
+     {
+	  ++awake_depth;
+	  X(plan_awake)(ad->plns[d->thr_num], ad->wakefulness);
+	  --awake_depth;
+     }
+     return 0;
+}
+
+/* see threads.c */
+void X(threads_plan_awake)(plan **plns, int npln, enum wakefulness wakefulness)
+{
+     int i;
+
+     if (wakefulness == SLEEPY || npln <= 1 || awake_depth > 0) {
+	  for (i = 0; i < npln; ++i)
+	       X(plan_awake)(plns[i], wakefulness);
+     } else {
+	  awake_data ad;
+	  ad.plns = plns;
+	  ad.wakefulness = wakefulness;
+	  X(spawn_loop)(npln, npln, awake_one, (void *) &ad);
+     }
+}
+
+void X(threads_planner_lock)(void)
+{
+     omp_set_lock(&search_lock);
+}
+
+void X(threads_planner_unlock)(void)
+{
+     omp_unset_lock(&search_lock);
+}
+
+/* OpenMP has no reader-writer locks, and the readers do not stay
+   long anyway */
+void X(threads_planner_rdlock)(void)
+{
+     omp_set_lock(&search_lock);
+}
+
+void X(threads_planner_rdunlock)(void)
+{
+     omp_unset_lock(&search_lock);
+}
+
+void X(threads_timing_lock)(void)
+{
+     omp_set_lock(&timing_lock);
+}
+
+void X(threads_timing_unlock)(void)
+{
+     omp_unset_lock(&timing_lock);
+}
+
 void X(threads_cleanup)(void)
 {
+     omp_destroy_lock(&search_lock);
+     omp_destroy_lock(&timing_lock);
+}
+
+/* OpenMP has its own mechanism (OMP_PROC_BIND, OMP_PLACES) */
+void X(threads_set_affinity)(const int *cpus, int ncpus)
+{
+     UNUSED(cpus);
+     UNUSED(ncpus);
 }
 
 /* FIXME [Matteo Frigo 2015-05-25] What does "thread-safe"
@@ -69,9 +69,7 @@ static void apply(const plan *ego_, R *I, R *O)
 static void awake(plan *ego_, enum wakefulness wakefulness)
 {
      P *ego = (P *) ego_;
-     int i;
-     for (i = 0; i < ego->nthr; ++i)
-	  X(plan_awake)(ego->cldrn[i], wakefulness);
+     X(threads_plan_awake)(ego->cldrn, ego->nthr, wakefulness);
 }
 
 static void destroy(plan *ego_)
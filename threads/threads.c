@@ -22,12 +22,17 @@
    function.  The first portion of this file is a set of macros to
    spawn and join threads on various systems. */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE /* for pthread_setaffinity_np */
+#endif
+
 #include "threads/threads.h"
 #include "api/api.h"
 
 #if defined(USING_POSIX_THREADS)
 
 #include <pthread.h>
+#include <sched.h>
 
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
@@ -150,12 +155,142 @@ static void os_destroy_thread(void)
      pthread_exit((void *)0);
 }
 
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(CPU_SETSIZE)
+static cpu_set_t process_set; /* the affinity of the process at init */
+static int have_process_set;
+#endif
+
+/* remember the affinity of the calling thread, which os_pin_thread
+   restores when unbinding */
+static void os_save_affinity(void)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(CPU_SETSIZE)
+     CPU_ZERO(&process_set);
+     have_process_set =
+	  (sched_getaffinity(0, sizeof(process_set), &process_set) == 0);
+#endif
+}
+
+/* bind the calling thread to CPU, or restore the saved affinity if
+   CPU < 0 */
+static void os_pin_thread(int cpu)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(CPU_SETSIZE)
+     cpu_set_t set;
+
+     if (cpu >= 0) {
+	  CPU_ZERO(&set);
+	  CPU_SET(cpu % CPU_SETSIZE, &set);
+	  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+     } else if (have_process_set) {
+	  pthread_setaffinity_np(pthread_self(), sizeof(process_set),
+				 &process_set);
+     }
+#else
+     UNUSED(cpu); /* no portable way to do it */
+#endif
+}
+
 /* support for static mutexes */
 typedef pthread_mutex_t os_static_mutex_t;
 #define OS_STATIC_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
 static void os_static_mutex_lock(os_static_mutex_t *s) { pthread_mutex_lock(s); }
 static void os_static_mutex_unlock(os_static_mutex_t *s) { pthread_mutex_unlock(s); }
 
+static void os_yield(void) { sched_yield(); }
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+static void os_pause(void) { __asm__ __volatile__("pause"); }
+#else
+static void os_pause(void) { }
+#endif
+
+/* atomic operations.  All of them are sequentially consistent. */
+typedef int os_atomic;
+
+#if defined(__ATOMIC_SEQ_CST) /* gcc >= 4.7, clang */
+static int os_atomic_load(os_atomic *p)
+{
+     return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static void os_atomic_store(os_atomic *p, int x)
+{
+     __atomic_store_n(p, x, __ATOMIC_SEQ_CST);
+}
+
+/* return the old value */
+static int os_atomic_add(os_atomic *p, int x)
+{
+     return __atomic_fetch_add(p, x, __ATOMIC_SEQ_CST);
+}
+
+static int os_atomic_cas(os_atomic *p, int old, int x)
+{
+     return __atomic_compare_exchange_n(p, &old, x, 0, __ATOMIC_SEQ_CST,
+					__ATOMIC_SEQ_CST);
+}
+
+static void *os_atomic_loadp(void **p)
+{
+     return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static void os_atomic_storep(void **p, void *x)
+{
+     __atomic_store_n(p, x, __ATOMIC_SEQ_CST);
+}
+
+#else
+   /* No atomic builtins.  Fake them with a global mutex, which is
+      correct but defeats the purpose of the whole exercise. */
+static os_static_mutex_t atomic_mutex = OS_STATIC_MUTEX_INITIALIZER;
+#define WITH_ATOMIC_MUTEX(what)			\
+{						\
+     os_static_mutex_lock(&atomic_mutex);	\
+     what;					\
+     os_static_mutex_unlock(&atomic_mutex);	\
+}
+
+static int os_atomic_load(os_atomic *p)
+{
+     int x;
+     WITH_ATOMIC_MUTEX(x = *p);
+     return x;
+}
+
+static void os_atomic_store(os_atomic *p, int x)
+{
+     WITH_ATOMIC_MUTEX(*p = x);
+}
+
+static int os_atomic_add(os_atomic *p, int x)
+{
+     int o;
+     WITH_ATOMIC_MUTEX({ o = *p; *p = o + x; });
+     return o;
+}
+
+static int os_atomic_cas(os_atomic *p, int old, int x)
+{
+     int ok;
+     WITH_ATOMIC_MUTEX({ ok = (*p == old); if (ok) *p = x; });
+     return ok;
+}
+
+static void *os_atomic_loadp(void **p)
+{
+     void *x;
+     WITH_ATOMIC_MUTEX(x = *p);
+     return x;
+}
+
+static void os_atomic_storep(void **p, void *x)
+{
+     WITH_ATOMIC_MUTEX(*p = x);
+}
+#endif
+
 #elif defined(__WIN32__) || defined(_WIN32) || defined(_WINDOWS)
 /* hack: windef.h defines INT for its own purposes and this causes
    a conflict with our own INT in ifftw.h.  Divert the windows
@@ -229,6 +364,22 @@ static void os_destroy_thread(void)
      _endthreadex(0);
 }
 
+static void os_save_affinity(void)
+{
+     /* os_pin_thread asks for the process mask instead */
+}
+
+static void os_pin_thread(int cpu)
+{
+     DWORD_PTR pmask, smask;
+
+     if (cpu >= 0)
+	  SetThreadAffinityMask(GetCurrentThread(),
+				(DWORD_PTR)1 << (cpu % (8 * sizeof(DWORD_PTR))));
+     else if (GetProcessAffinityMask(GetCurrentProcess(), &pmask, &smask))
+	  SetThreadAffinityMask(GetCurrentThread(), pmask);
+}
+
 /* windows does not have statically-initialized mutexes---fake a
    spinlock */
 typedef volatile LONG os_static_mutex_t;
@@ -245,45 +396,163 @@ static void os_static_mutex_unlock(os_static_mutex_t *s)
      LONG old = InterlockedExchange(s, 0);
      A(old == 1);
 }
-#else
-#error "No threading layer defined"
-#endif
 
-/************************************************************************/
+static void os_yield(void) { SwitchToThread(); }
+static void os_pause(void) { YieldProcessor(); }
 
-/* Main code: */
-struct worker {
-     os_sem_t ready;
-     os_sem_t done;
-     struct work *w;
-     struct worker *cdr;
-};
+/* Interlocked* operations are full barriers */
+typedef volatile LONG os_atomic;
+
+static int os_atomic_load(os_atomic *p)
+{
+     return InterlockedCompareExchange(p, 0, 0);
+}
+
+static void os_atomic_store(os_atomic *p, int x)
+{
+     InterlockedExchange(p, x);
+}
+
+static int os_atomic_add(os_atomic *p, int x)
+{
+     return InterlockedExchangeAdd(p, x);
+}
 
-static struct worker *make_worker(void)
+static int os_atomic_cas(os_atomic *p, int old, int x)
 {
-     struct worker *q = (struct worker *)MALLOC(sizeof(*q), OTHER);
-     os_sem_init(&q->ready);
-     os_sem_init(&q->done);
-     return q;
+     return InterlockedCompareExchange(p, x, old) == old;
 }
 
-static void unmake_worker(struct worker *q)
+static void *os_atomic_loadp(void **p)
 {
-     os_sem_destroy(&q->done);
-     os_sem_destroy(&q->ready);
-     X(ifree)(q);
+     return InterlockedCompareExchangePointer(p, 0, 0);
 }
 
-struct work {
+static void os_atomic_storep(void **p, void *x)
+{
+     InterlockedExchangePointer(p, x);
+}
+#else
+#error "No threading layer defined"
+#endif
+
+/************************************************************************/
+
+/* Main code:
+
+   The workers form a persistent pool.  Each X(spawn_loop) in
+   progress publishes its loop, split into blocks, in a slot of the
+   global SLOTS table.  Blocks are claimed by atomically incrementing
+   the NEXT counter of the loop, both by the thread that called
+   X(spawn_loop) and by any idle thread that finds the loop in the
+   table (``stealing'').  Thus, nested loops are executed by whatever
+   threads happen to be idle, rather than by the spawning thread
+   alone.
+
+   Idle threads spin for a while looking for work, and then park on
+   the WAKEUP semaphore.  X(spawn_loop) posts WAKEUP only if there
+   are parked workers, so that back-to-back loops do not pay for the
+   operating system.
+
+   Worker I has a ``home'' block 1 + I mod (NBLK - 1) in each loop
+   (block 0 being the home of the spawning thread), which it claims
+   before any other block.  Thus, as long as nobody runs out of work,
+   the same slice of the data is always processed by the same
+   worker, which X(threads_set_affinity) pins to a fixed CPU.
+
+   Besides loops, idle workers run the asynchronous tasks of
+   X(spawn_async), which wait in the READY queue.  Threads joining a
+   loop do not run them, and only help the loops nested within their
+   own (see join()), so that a loop is never delayed by unrelated
+   work. */
+
+#define NSLOT 256    /* max # of loops in progress at the same time */
+#define NSPIN 2048   /* iterations of busy waiting before parking */
+
+struct slot;
+
+struct job {
      spawn_function proc;
-     spawn_data d;
-     struct worker *q; /* the worker responsible for performing this work */
+     void *data;
+     void *ws;         /* workspace of the owner, see kernel/scratch.c */
+     int loopmax, block_size, nblk;
+     os_atomic next;   /* next block to be claimed */
+     os_atomic *taken; /* taken[b] != 0 iff block b has been claimed */
+     os_atomic state;  /* 2 * (# of blocks done) + (owner is parked) */
+     struct slot *s;
+     struct job *parent; /* the loop whose block spawned us, or 0 */
+};
+
+struct slot {
+     os_atomic busy;   /* slot belongs to some X(spawn_loop) */
+     os_atomic nvisit; /* # of thieves looking at JOB */
+     void *job;        /* published job, or 0; accessed atomically */
+     os_sem_t done;    /* the owner of the slot parks here */
+     char pad[64];     /* avoid false sharing between slots */
 };
 
+static struct slot slots[NSLOT];
+static os_atomic nslot;     /* high-water mark of busy slots */
+
+#ifdef THREAD_LOCAL
+/* the loop whose block the calling thread is executing, or 0 */
+static THREAD_LOCAL struct job *current;
+#endif
+
 static os_mutex_t queue_lock;
 static os_sem_t termination_semaphore;
+static os_sem_t wakeup;
+static os_atomic nworker;   /* # of workers in the pool */
+static os_atomic nidle;     /* # of workers looking for work */
+static os_atomic nsleep;    /* # of parked workers not yet woken up */
+static os_atomic terminate;
+
+/* affinity of the workers, protected by AFF_LOCK.  Not QUEUE_LOCK,
+   which kill_workforce() holds while waiting for the workers */
+static os_mutex_t aff_lock;
+
+/* serializes X(threads_plan_awake), see below */
+static os_mutex_t awake_lock;
+#ifdef THREAD_LOCAL
+/* > 0 iff the calling thread holds AWAKE_LOCK */
+static THREAD_LOCAL int awake_depth;
+#endif
+
+/* The planner lock (see kernel/planner.c).  Writers hold
+   SEARCH_LOCK.  NREADER counts the readers, plus WRITER while a
+   writer holds the lock or waits for the readers to leave. */
+#define WRITER (1 << 30)
+static os_mutex_t search_lock;
+static os_mutex_t timing_lock; /* see search_par() in planner.c */
+static os_atomic nreader;
+static int *aff_cpus;
+static int aff_ncpus;
+static os_atomic aff_gen;   /* incremented when the affinity changes */
+
+/* asynchronous tasks, see X(spawn_async).  The lists are protected
+   by ASYNC_LOCK */
+#define NRANGE 2
+enum { PENDING, RUNNING, DONE };
+
+struct async_task_s {
+     void (*work)(void *data);
+     void *data;
+     char *range[2 * NRANGE]; /* tasks whose ranges overlap run in order */
+     int nrange, nthr;
+     int npred;        /* # of unfinished earlier overlapping tasks */
+     int state;
+     int waiting;      /* somebody is parked on DONE */
+     os_sem_t done;
+     async_task *prev, *next;  /* list of unfinished tasks */
+     async_task *qnext;        /* READY queue */
+};
+
+static os_mutex_t async_lock;
+static async_task *async_first, *async_last;
+static async_task *ready_first, *ready_last;
+static os_atomic nready;    /* # of tasks in the READY queue */
+static os_atomic nrunning;  /* # of tasks being executed */
 
-static struct worker *worker_queue;
 #define WITH_QUEUE_LOCK(what)			\
 {						\
      os_mutex_lock(&queue_lock);		\
@@ -291,27 +560,198 @@ static struct worker *worker_queue;
      os_mutex_unlock(&queue_lock);		\
 }
 
-static FFTW_WORKER worker(void *arg)
+static int dec_if_positive(os_atomic *p)
 {
-     struct worker *ego = (struct worker *)arg;
-     struct work *w;
+     int x;
+     do {
+	  x = os_atomic_load(p);
+	  if (x <= 0) return 0;
+     } while (!os_atomic_cas(p, x, x - 1));
+     return 1;
+}
 
-     for (;;) {
-	  /* wait until work becomes available */
-	  os_sem_down(&ego->ready);
+/* claim block HOME if possible, otherwise the first unclaimed block.
+   Return -1 if all blocks have been claimed. */
+static int claim(struct job *j, int home)
+{
+     int b;
+
+     if (home >= 0 && home < j->nblk
+	 && !os_atomic_load(&j->taken[home])
+	 && os_atomic_cas(&j->taken[home], 0, 1))
+	  return home;
+
+     while (os_atomic_load(&j->next) < j->nblk) {
+	  b = os_atomic_add(&j->next, 1);
+	  if (b >= j->nblk)
+	       break;
+	  if (os_atomic_cas(&j->taken[b], 0, 1))
+	       return b;
+     }
+     return -1;
+}
+
+/* home block of worker ID in a loop of NBLK blocks */
+static int home_of(int id, int nblk)
+{
+     return (id >= 0 && nblk > 1) ? 1 + id % (nblk - 1) : -1;
+}
+
+/* execute block B of J.  J may be deallocated as soon as the
+   completion is recorded, so don't touch it afterwards.  J->S is
+   accessed only if the owner is parked, which implies J->S != 0 */
+static void run(struct job *j, int b)
+{
+     spawn_data d;
+     struct slot *s = j->s;
+     int nblk = j->nblk;
+     int st;
+     void *ws;
+
+     d.max = (d.min = b * j->block_size) + j->block_size;
+     if (d.max > j->loopmax)
+	  d.max = j->loopmax;
+     d.thr_num = b;
+     d.data = j->data;
+
+     /* the thief may be in the middle of some other loop */
+     ws = X(scratch_bind)(j->ws);
+#ifdef THREAD_LOCAL
+     {
+	  struct job *cur = current;
+	  current = j;
+	  j->proc(&d);
+	  current = cur;
+     }
+#else
+     j->proc(&d);
+#endif
+     X(scratch_bind)(ws);
+
+     st = os_atomic_add(&j->state, 2);
+     if ((st >> 1) + 1 == nblk && (st & 1))
+	  os_sem_up(&s->done); /* last block, and the owner is parked */
+}
+
+static int run_async(void);
+
+/* 1 if J is nested within the loop UNDER, following the parents.
+   The ancestors of a published loop are alive, since each of them
+   waits for the block that spawned its child */
+static int within(const struct job *j, const struct job *under)
+{
+     for (; j; j = j->parent)
+	  if (j == under)
+	       return 1;
+     return 0;
+}
+
+/* execute one block of a published loop on behalf of worker ID (or
+   of a spawning thread, if ID < 0), or else an asynchronous task if
+   ID >= 0.  If UNDER is not 0, only loops nested within UNDER
+   qualify.  Return 1 if successful */
+static int steal(int id, const struct job *under)
+{
+     int i, n = os_atomic_load(&nslot);
+
+     for (i = 0; i < n; ++i) {
+	  struct slot *s = slots + i;
+	  struct job *j;
+	  int b = -1;
+
+	  if (!os_atomic_loadp(&s->job))
+	       continue;
+
+	  /* the owner does not deallocate the job while NVISIT > 0 */
+	  os_atomic_add(&s->nvisit, 1);
+	  j = (struct job *)os_atomic_loadp(&s->job);
+	  if (j && (!under || within(j, under)))
+	       b = claim(j, home_of(id, j->nblk));
+	  os_atomic_add(&s->nvisit, -1);
+
+	  if (b >= 0) {
+	       /* J cannot complete before we execute B */
+	       run(j, b);
+	       return 1;
+	  }
+     }
+
+     if (id >= 0 && os_atomic_load(&nready) > 0)
+	  return run_async();
+     return 0;
+}
+
+/* bind worker ID according to the current affinity.  A worker that
+   was never bound is left alone, so that it keeps the affinity that
+   the process has (e.g. from taskset); *PINNED says whether we have
+   bound it since */
+static void pin(int id, int *gen, int *pinned)
+{
+     int cpu = -1;
+
+     os_mutex_lock(&aff_lock);
+     *gen = os_atomic_load(&aff_gen);
+     if (aff_ncpus > 0)
+	  cpu = aff_cpus[id % aff_ncpus];
+     os_mutex_unlock(&aff_lock);
+
+     if (cpu >= 0 || *pinned)
+	  os_pin_thread(cpu);
+     *pinned = (cpu >= 0);
+}
+
+/* wait until some work is available.  Return 1 if the worker
+   must terminate instead */
+static int idle(int id, int *gen, int *pinned)
+{
+     int i;
 
-	  w = ego->w;
+     os_atomic_add(&nidle, 1);
+     for (;;) {
+	  for (i = 0; i < NSPIN; ++i) {
+	       if (os_atomic_load(&terminate))
+		    goto die;
+	       if (os_atomic_load(&aff_gen) != *gen)
+		    pin(id, gen, pinned);
+	       if (steal(id, 0))
+		    goto done;
+	       os_pause();
+	  }
 
-	  /* !w->proc ==> terminate worker */
-	  if (!w->proc) break;
+	  os_atomic_add(&nsleep, 1);
 
-	  /* do the work */
-          w->proc(&w->d);
+	  /* look again, lest we miss a wakeup that happened before
+	     the increment of NSLEEP */
+	  if (steal(id, 0)) {
+	       /* if we cannot retract our sleep, somebody has posted
+		  WAKEUP on our behalf, and we must consume it */
+	       if (!dec_if_positive(&nsleep))
+		    os_sem_down(&wakeup);
+	       goto done;
+	  }
 
-	  /* signal that work is done */
-	  os_sem_up(&ego->done);
+	  os_sem_down(&wakeup);
      }
 
+ done:
+     os_atomic_add(&nidle, -1);
+     return 0;
+
+ die:
+     os_atomic_add(&nidle, -1);
+     return 1;
+}
+
+static FFTW_WORKER worker(void *arg)
+{
+     int id = (int)(uintptr_t)arg;
+     int gen, pinned = 0;
+
+     pin(id, &gen, &pinned);
+     while (!idle(id, &gen, &pinned))
+	  while (steal(id, 0))
+	       ;
+
      /* termination protocol */
      os_sem_up(&termination_semaphore);
 
@@ -320,56 +760,86 @@ static FFTW_WORKER worker(void *arg)
      return 0;
 }
 
-static void enqueue(struct worker *q)
+/* get NHELP threads to look at a newly published loop */
+static void recruit(int nhelp)
 {
-     WITH_QUEUE_LOCK({
-	  q->cdr = worker_queue;
-	  worker_queue = q;
-     });
+     int i, n;
+
+     for (i = 0; i < nhelp && dec_if_positive(&nsleep); ++i)
+	  os_sem_up(&wakeup);
+
+     /* if not enough workers are idle, grow the pool */
+     n = nhelp - os_atomic_load(&nidle);
+     if (n > 0) {
+	  WITH_QUEUE_LOCK({
+	       for (i = 0; i < n; ++i) {
+		    int id = os_atomic_add(&nworker, 1);
+		    os_create_thread(worker, (void *)(uintptr_t)id);
+	       }
+	  });
+     }
 }
 
-static struct worker *dequeue(void)
+static struct slot *grab_slot(void)
 {
-     struct worker *q;
-
-     WITH_QUEUE_LOCK({
-	  q = worker_queue;
-	  if (q)
-	       worker_queue = q->cdr;
-     });
+     int i, n;
+
+     for (i = 0; i < NSLOT; ++i) {
+	  struct slot *s = slots + i;
+	  if (!os_atomic_load(&s->busy) && os_atomic_cas(&s->busy, 0, 1)) {
+	       do {
+		    n = os_atomic_load(&nslot);
+	       } while (n < i + 1 && !os_atomic_cas(&nslot, n, i + 1));
+	       return s;
+	  }
+     }
+     return 0;
+}
 
-     if (!q) {
-	  /* no worker is available.  Create one */
-	  q = make_worker();
-	  os_create_thread(worker, q);
+/* wait until all the blocks of J are done, helping the loops nested
+   within J in the meanwhile.  Those are the only ones whose blocks
+   cannot outlast J; a block of an unrelated loop, e.g. a candidate of
+   a concurrent planner or an asynchronous execution, might keep us
+   long after J is done.  Without THREAD_LOCAL, loops have no parents,
+   and we only wait */
+static void join(struct job *j)
+{
+     struct slot *s = j->s;
+     int i, st;
+
+     for (i = 0; i < NSPIN; ++i) {
+	  if ((os_atomic_load(&j->state) >> 1) == j->nblk)
+	       return;
+	  if (steal(-1, j))
+	       i = 0;
+	  else
+	       os_pause();
      }
 
-     return q;
-}
+     /* park, unless the last block completed in the meanwhile */
+     do {
+	  st = os_atomic_load(&j->state);
+	  if ((st >> 1) == j->nblk)
+	       return;
+     } while (!os_atomic_cas(&j->state, st, st | 1));
 
+     os_sem_down(&s->done);
+}
 
 static void kill_workforce(void)
 {
-     struct work w;
-
-     w.proc = 0;
+     int i, n;
 
      WITH_QUEUE_LOCK({
-	  /* tell all workers that they must terminate.
-
-	     Because workers enqueue themselves before signaling the
-	     completion of the work, all workers belong to the worker queue
-	     if we get here.  Also, all workers are waiting at
-	     os_sem_down(ready), so we can hold the queue lock without
-	     deadlocking */
-	  while (worker_queue) {
-	       struct worker *q = worker_queue;
-	       worker_queue = q->cdr;
-	       q->w = &w;
-	       os_sem_up(&q->ready);
+	  /* All workers are idle if we get here, since no
+	     X(spawn_loop) is in progress.  Wake them all. */
+	  n = os_atomic_load(&nworker);
+	  os_atomic_store(&terminate, 1);
+	  for (i = 0; i < n; ++i)
+	       os_sem_up(&wakeup);
+	  for (i = 0; i < n; ++i)
 	       os_sem_down(&termination_semaphore);
-	       unmake_worker(q);
-	  }
+	  os_atomic_store(&nworker, 0);
      });
 }
 
@@ -377,18 +847,69 @@ static os_static_mutex_t initialization_mutex = OS_STATIC_MUTEX_INITIALIZER;
 
 int X(ithreads_init)(void)
 {
+     int i;
+
      os_static_mutex_lock(&initialization_mutex); {
           os_mutex_init(&queue_lock);
+          os_mutex_init(&aff_lock);
+          os_mutex_init(&awake_lock);
+          os_mutex_init(&search_lock);
+          os_mutex_init(&timing_lock);
+          os_mutex_init(&async_lock);
+	  os_atomic_store(&nreader, 0);
+	  async_first = async_last = 0;
+	  ready_first = ready_last = 0;
+	  os_atomic_store(&nready, 0);
+	  os_atomic_store(&nrunning, 0);
           os_sem_init(&termination_semaphore);
+          os_sem_init(&wakeup);
+
+	  for (i = 0; i < NSLOT; ++i) {
+	       os_sem_init(&slots[i].done);
+	       os_atomic_store(&slots[i].busy, 0);
+	       os_atomic_store(&slots[i].nvisit, 0);
+	       os_atomic_storep(&slots[i].job, 0);
+	  }
 
           WITH_QUEUE_LOCK({
-               worker_queue = 0;
+	       os_atomic_store(&nslot, 0);
+	       os_atomic_store(&nworker, 0);
+	       os_atomic_store(&nidle, 0);
+	       os_atomic_store(&nsleep, 0);
+	       os_atomic_store(&terminate, 0);
           });
+
+	  os_save_affinity();
+	  os_mutex_lock(&aff_lock);
+	  os_atomic_store(&aff_gen, 0);
+	  aff_cpus = 0;
+	  aff_ncpus = 0;
+	  os_mutex_unlock(&aff_lock);
      } os_static_mutex_unlock(&initialization_mutex);
 
      return 0; /* no error */
 }
 
+/* The workspace bound to the spawning thread (see kernel/scratch.c)
+   must be bound to whatever thread executes the loop. */
+typedef struct {
+     spawn_function proc;
+     void *data;
+     void *ws;
+} ws_data;
+
+static void *ws_thunk(spawn_data *d)
+{
+     ws_data *w = (ws_data *) d->data;
+     void *ws = X(scratch_bind)(w->ws);
+     void *ret;
+
+     d->data = w->data;
+     ret = w->proc(d);
+     X(scratch_bind)(ws);
+     return ret;
+}
+
 /* Distribute a loop from 0 to loopmax-1 over nthreads threads.
    proc(d) is called to execute a block of iterations from d->min
    to d->max-1.  d->thr_num indicate the number of the thread
@@ -400,6 +921,7 @@ void X(spawn_loop)(int loopmax, int nthr, spawn_function proc, void *data)
 {
      int block_size;
      int i;
+     ws_data w;
 
      A(loopmax >= 0);
      A(nthr > 0);
@@ -417,6 +939,14 @@ void X(spawn_loop)(int loopmax, int nthr, spawn_function proc, void *data)
 
      if (X(spawnloop_callback)) { /* user-defined spawnloop backend */
           spawn_data *sdata;
+
+	  if ((w.ws = X(scratch_workspace)())) {
+	       w.proc = proc;
+	       w.data = data;
+	       proc = ws_thunk;
+	       data = (void *) &w;
+	  }
+
           STACK_MALLOC(spawn_data *, sdata, sizeof(spawn_data) * nthr);
           for (i = 0; i < nthr; ++i) {
                spawn_data *d = &sdata[i];
@@ -430,49 +960,431 @@ void X(spawn_loop)(int loopmax, int nthr, spawn_function proc, void *data)
           STACK_FREE(sdata);
      }
      else {
-          struct work *r;
-          STACK_MALLOC(struct work *, r, sizeof(struct work) * nthr);
+	  struct job j;
+	  struct slot *s;
+	  os_atomic *taken;
+
+	  STACK_MALLOC(os_atomic *, taken, sizeof(os_atomic) * nthr);
+	  for (i = 0; i < nthr; ++i)
+	       os_atomic_store(&taken[i], 0);
+
+	  j.proc = proc;
+	  j.data = data;
+	  j.ws = X(scratch_workspace)();
+	  j.loopmax = loopmax;
+	  j.block_size = block_size;
+	  j.nblk = nthr;
+	  os_atomic_store(&j.next, 0);
+	  os_atomic_store(&j.state, 0);
+	  j.taken = taken;
+#ifdef THREAD_LOCAL
+	  j.parent = current;
+#else
+	  j.parent = 0;
+#endif
+	  j.s = s = (nthr > 1) ? grab_slot() : 0;
+
+	  if (!s) {
+	       /* do all the work ourselves */
+	       for (i = 0; i < nthr; ++i)
+		    run(&j, i);
+	       STACK_FREE(taken);
+	       return;
+	  }
 
-          /* distribute work: */
-          for (i = 0; i < nthr; ++i) {
-               struct work *w = &r[i];
-               spawn_data *d = &w->d;
+	  os_atomic_storep(&s->job, &j);
+	  recruit(nthr - 1);
 
-               d->max = (d->min = i * block_size) + block_size;
-               if (d->max > loopmax)
-                    d->max = loopmax;
-               d->thr_num = i;
-               d->data = data;
-               w->proc = proc;
-
-               if (i == nthr - 1) {
-                    /* do the work ourselves */
-                    proc(d);
-               } else {
-                    /* assign a worker to W */
-                    w->q = dequeue();
-
-                    /* tell worker w->q to do it */
-                    w->q->w = w; /* Dirac could have written this */
-                    os_sem_up(&w->q->ready);
-               }
-          }
+	  while ((i = claim(&j, 0)) >= 0)
+	       run(&j, i);
 
-          for (i = 0; i < nthr - 1; ++i) {
-               struct work *w = &r[i];
-               os_sem_down(&w->q->done);
-               enqueue(w->q);
-          }
+	  /* retract J, and wait until nobody is looking at it */
+	  os_atomic_storep(&s->job, 0);
+	  while (os_atomic_load(&s->nvisit))
+	       os_yield();
+
+	  join(&j);
+	  os_atomic_store(&s->busy, 0);
+	  STACK_FREE(taken);
+     }
+}
+
+typedef struct {
+     void (*work)(void *data, int i);
+     void *data;
+     int n;
+     os_atomic next;
+} each_data;
+
+static void *each_thunk(spawn_data *d)
+{
+     each_data *e = (each_data *) d->data;
+     int i;
+
+     while ((i = os_atomic_add(&e->next, 1)) < e->n)
+	  e->work(e->data, i);
+     return 0;
+}
+
+/* Call WORK(DATA, I) for 0 <= I < N on up to NTHR threads.  Unlike
+   X(spawn_loop), the iterations are handed out one at a time, so
+   that iterations of different cost are balanced. */
+void X(spawn_each)(int n, int nthr, void (*work)(void *data, int i),
+		   void *data)
+{
+     each_data e;
+
+     e.work = work;
+     e.data = data;
+     e.n = n;
+     os_atomic_store(&e.next, 0);
+     nthr = X(imax)(1, X(imin)(n, nthr));
+     X(spawn_loop)(nthr, nthr, each_thunk, (void *) &e);
+}
+
+/* 1 if a range [LO, HI) of A overlaps one of B */
+static int conflict(const async_task *a, const async_task *b)
+{
+     int i, k;
+
+     for (i = 0; i < 2 * a->nrange; i += 2)
+	  for (k = 0; k < 2 * b->nrange; k += 2)
+	       if (a->range[i] < b->range[k + 1]
+		   && b->range[k] < a->range[i + 1])
+		    return 1;
+     return 0;
+}
+
+/* append T to the READY queue.  Called with ASYNC_LOCK held */
+static void make_ready(async_task *t)
+{
+     t->qnext = 0;
+     if (ready_last)
+	  ready_last->qnext = t;
+     else
+	  ready_first = t;
+     ready_last = t;
+     os_atomic_add(&nready, 1);
+}
+
+/* get up to N more workers running tasks, as long as at most NTHR
+   tasks run at the same time.  Tasks grow the pool only up to NTHR
+   workers, otherwise a burst of X(spawn_async) would create a thread
+   per task before any of them starts.  Busy workers look at the
+   READY queue when they are done, so a task is never stranded. */
+static void kick(int n, int nthr)
+{
+     n = X(imin)(n, nthr - os_atomic_load(&nrunning));
+     if (os_atomic_load(&nworker) >= nthr)
+	  n = X(imin)(n, os_atomic_load(&nidle));
+     if (n > 0)
+	  recruit(n);
+}
 
-          STACK_FREE(r);
+/* execute the first ready task that may start, i.e. whose NTHR is 0
+   or exceeds the number of tasks running.  NRUNNING only changes
+   under ASYNC_LOCK, so the limit holds whoever calls us.  Return 1 if
+   successful */
+static int run_async(void)
+{
+     async_task *t, *prev = 0, *u;
+     int n = 0, nthr;
+
+     os_mutex_lock(&async_lock);
+     for (t = ready_first; t; prev = t, t = t->qnext)
+	  if (!t->nthr || os_atomic_load(&nrunning) < t->nthr)
+	       break;
+     if (t) {
+	  if (prev)
+	       prev->qnext = t->qnext;
+	  else
+	       ready_first = t->qnext;
+	  if (ready_last == t)
+	       ready_last = prev;
+	  os_atomic_add(&nready, -1);
+	  if (t->nthr)
+	       os_atomic_add(&nrunning, 1);
+	  t->state = RUNNING;
      }
+     os_mutex_unlock(&async_lock);
+
+     if (!t)
+	  return 0;
+
+     t->work(t->data);
+
+     os_mutex_lock(&async_lock);
+
+     /* Every later task overlapping T counted T among its
+	predecessors when it was spawned */
+     for (u = t->next; u; u = u->next)
+	  if (conflict(t, u) && --u->npred == 0) {
+	       make_ready(u);
+	       ++n;
+	  }
+
+     if (t->prev) t->prev->next = t->next; else async_first = t->next;
+     if (t->next) t->next->prev = t->prev; else async_last = t->prev;
+
+     /* T may be deallocated as soon as we release the lock */
+     nthr = t->nthr;
+     t->state = DONE;
+     if (t->waiting)
+	  os_sem_up(&t->done);
+     if (nthr)
+	  os_atomic_add(&nrunning, -1);
+     os_mutex_unlock(&async_lock);
+
+     /* we take the first released task ourselves, on return to the
+	worker loop */
+     kick(n - 1, nthr);
+     return 1;
+}
+
+/* Call WORK(DATA) in the background, on a worker of the pool, and
+   return a handle for X(async_test) and X(async_wait).  Tasks whose
+   byte ranges [RANGE[2*i], RANGE[2*i+1]), 0 <= i < NRANGE, overlap
+   run in the order in which they are spawned, and at most NTHR tasks
+   run at once.
+   Tasks with NTHR == 0 are long-running background work (see the
+   plan upgrades in api/apiplan.c), which gets a worker of its own
+   and does not count against the NTHR of the other tasks.  Every
+   task must eventually be waited for, and all of them must be done
+   before X(threads_cleanup). */
+async_task *X(spawn_async)(void (*work)(void *data), void *data,
+			   void *const *range, int nrange, int nthr)
+{
+     async_task *t, *u;
+     int i, ready;
+
+     A(nrange >= 0 && nrange <= NRANGE);
+
+     t = (async_task *) MALLOC(sizeof(async_task), OTHER);
+     t->work = work;
+     t->data = data;
+     for (i = 0; i < 2 * nrange; ++i)
+	  t->range[i] = (char *) range[i];
+     t->nrange = nrange;
+     t->nthr = nthr = X(imax)(0, nthr);
+     t->npred = 0;
+     t->state = PENDING;
+     t->waiting = 0;
+     os_sem_init(&t->done);
+
+     os_mutex_lock(&async_lock);
+     for (u = async_first; u; u = u->next)
+	  if (conflict(t, u))
+	       ++t->npred;
+     t->prev = async_last;
+     t->next = 0;
+     if (async_last)
+	  async_last->next = t;
+     else
+	  async_first = t;
+     async_last = t;
+     if ((ready = !t->npred))
+	  make_ready(t);
+     os_mutex_unlock(&async_lock);
+
+     if (ready) {
+	  if (nthr)
+	       kick(1, nthr);
+	  else
+	       recruit(1);
+     }
+     return t;
+}
+
+/* 1 if T is done, 0 otherwise.  Does not block */
+int X(async_test)(async_task *t)
+{
+     int done;
+
+     os_mutex_lock(&async_lock);
+     done = (t->state == DONE);
+     os_mutex_unlock(&async_lock);
+     return done;
+}
+
+/* wait until T is done, and deallocate it */
+void X(async_wait)(async_task *t)
+{
+     os_mutex_lock(&async_lock);
+     if (t->state != DONE) {
+	  t->waiting = 1;
+	  os_mutex_unlock(&async_lock);
+	  os_sem_down(&t->done);
+
+	  /* the worker posts DONE while holding ASYNC_LOCK */
+	  os_mutex_lock(&async_lock);
+     }
+     os_mutex_unlock(&async_lock);
+
+     os_sem_destroy(&t->done);
+     X(ifree)(t);
+}
+
+/* sequentially consistent access to a pointer that another thread
+   may replace, see the plan upgrades in api/apiplan.c */
+void *X(threads_loadp)(void **p)
+{
+     return os_atomic_loadp(p);
+}
+
+void X(threads_storep)(void **p, void *x)
+{
+     os_atomic_storep(p, x);
+}
+
+/* bind worker I to CPUS[I mod NCPUS], or give all workers back the
+   affinity of the process if NCPUS <= 0.  Workers apply the change
+   the next time they look for work. */
+void X(threads_set_affinity)(const int *cpus, int ncpus)
+{
+     int i, *c = 0;
+
+     if (cpus && ncpus > 0) {
+	  c = (int *)MALLOC(sizeof(int) * ncpus, OTHER);
+	  for (i = 0; i < ncpus; ++i)
+	       c[i] = cpus[i];
+     } else
+	  ncpus = 0;
+
+     os_mutex_lock(&aff_lock);
+     X(ifree0)(aff_cpus);
+     aff_cpus = c;
+     aff_ncpus = ncpus;
+     os_atomic_add(&aff_gen, 1);
+     os_mutex_unlock(&aff_lock);
+
+     /* wake up parked workers, so that they notice */
+     recruit(os_atomic_load(&nsleep));
+}
+
+typedef struct {
+     plan **plns;
+     enum wakefulness wakefulness;
+} awake_data;
+
+static void *awake_one(spawn_data *d)
+{
+     awake_data *ad = (awake_data *) d->data;
+
+     os_mutex_lock(&awake_lock);
+#ifdef THREAD_LOCAL
+     ++awake_depth;
+#endif
+     X(plan_awake)(ad->plns[d->thr_num], ad->wakefulness);
+#ifdef THREAD_LOCAL
+     --awake_depth;
+#endif
+     os_mutex_unlock(&awake_lock);
+     return 0;
+}
+
+static int awake_in_place(void)
+{
+#ifdef THREAD_LOCAL
+     return awake_depth > 0;
+#else
+     return 1;
+#endif
+}
+
+/* Awake PLNS[0..NPLN-1], where PLNS[i] is executed by block i of a
+   loop of NPLN blocks.  Each plan is awakened by the thread that
+   will (most likely) execute it, so that its twiddle factors and
+   other tables are computed, first-touched, and if need be
+   replicated on the NUMA node of that thread.  The planner data
+   structures are not thread-safe, so the awakenings are serialized;
+   only the placement is parallel.
+
+   A threaded plan nested within PLNS[i] calls us again from the
+   thread that holds AWAKE_LOCK.  Such calls proceed in place, lest
+   they deadlock, which is why AWAKE_DEPTH is per thread: another
+   thread awaking an unrelated plan at the same time must still wait
+   for the lock.  Without thread-local storage we cannot tell the two
+   apart, and all awakenings proceed in place on the calling
+   thread. */
+void X(threads_plan_awake)(plan **plns, int npln, enum wakefulness wakefulness)
+{
+     int i;
+
+     if (wakefulness == SLEEPY || npln <= 1 || awake_in_place()) {
+	  for (i = 0; i < npln; ++i)
+	       X(plan_awake)(plns[i], wakefulness);
+     } else {
+	  awake_data ad;
+	  ad.plns = plns;
+	  ad.wakefulness = wakefulness;
+	  X(spawn_loop)(npln, npln, awake_one, (void *) &ad);
+     }
+}
+
+void X(threads_planner_lock)(void)
+{
+     os_mutex_lock(&search_lock);
+     os_atomic_add(&nreader, WRITER);
+     while (os_atomic_load(&nreader) != WRITER)
+	  os_yield(); /* readers do not stay long */
+}
+
+void X(threads_planner_unlock)(void)
+{
+     os_atomic_add(&nreader, -WRITER);
+     os_mutex_unlock(&search_lock);
+}
+
+void X(threads_planner_rdlock)(void)
+{
+     int x;
+
+     for (;;) {
+	  x = os_atomic_load(&nreader);
+	  if (x < WRITER) {
+	       if (os_atomic_cas(&nreader, x, x + 1))
+		    return;
+	  } else {
+	       /* sleep until the writer is done */
+	       os_mutex_lock(&search_lock);
+	       os_mutex_unlock(&search_lock);
+	  }
+     }
+}
+
+void X(threads_planner_rdunlock)(void)
+{
+     os_atomic_add(&nreader, -1);
+}
+
+void X(threads_timing_lock)(void)
+{
+     os_mutex_lock(&timing_lock);
+}
+
+void X(threads_timing_unlock)(void)
+{
+     os_mutex_unlock(&timing_lock);
 }
 
 void X(threads_cleanup)(void)
 {
+     int i;
+
      kill_workforce();
+     X(ifree0)(aff_cpus);
+     aff_cpus = 0;
+     aff_ncpus = 0;
+     for (i = 0; i < NSLOT; ++i)
+	  os_sem_destroy(&slots[i].done);
      os_mutex_destroy(&queue_lock);
+     os_mutex_destroy(&aff_lock);
+     os_mutex_destroy(&awake_lock);
+     os_mutex_destroy(&search_lock);
+     os_mutex_destroy(&timing_lock);
+     os_mutex_destroy(&async_lock);
      os_sem_destroy(&termination_semaphore);
+     os_sem_destroy(&wakeup);
 }
 
 static os_static_mutex_t install_planner_hooks_mutex = OS_STATIC_MUTEX_INITIALIZER;
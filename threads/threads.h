@@ -34,8 +34,28 @@ typedef void *(*spawn_function) (spawn_data *);
 
 void X(spawn_loop)(int loopmax, int nthreads,
 		   spawn_function proc, void *data);
+void X(spawn_each)(int n, int nthreads,
+		   void (*work)(void *data, int i), void *data);
+
+typedef struct async_task_s async_task;
+async_task *X(spawn_async)(void (*work)(void *data), void *data,
+			   void *const *range, int nrange, int nthreads);
+int X(async_test)(async_task *t);
+void X(async_wait)(async_task *t);
+void *X(threads_loadp)(void **p);
+void X(threads_storep)(void **p, void *x);
+
 int X(ithreads_init)(void);
 void X(threads_cleanup)(void);
+void X(threads_set_affinity)(const int *cpus, int ncpus);
+void X(threads_plan_awake)(plan **plns, int npln,
+			  enum wakefulness wakefulness);
+void X(threads_planner_lock)(void);
+void X(threads_planner_unlock)(void);
+void X(threads_planner_rdlock)(void);
+void X(threads_planner_rdunlock)(void);
+void X(threads_timing_lock)(void);
+void X(threads_timing_unlock)(void);
 
 typedef void (*spawnloop_function)(spawn_function, spawn_data *, size_t, int, void *);
 extern spawnloop_function X(spawnloop_callback);
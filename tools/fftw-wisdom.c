@@ -30,6 +30,7 @@
 extern unsigned the_flags;
 extern int usewisdom;
 extern int nthreads;
+extern const char *planner_stats_file, *planner_trace_file;
 
 /* dummy routines to replace those in hook.c */
 void install_hook(void) {}
@@ -88,6 +89,10 @@ static struct my_option options[] =
   {"no-system-wisdom", NOARG, 'n'},
   {"wisdom-file", REQARG, 'w'},
 
+  {"cost-profile", NOARG, 'p'},
+  {"planner-stats", REQARG, 's'},
+  {"planner-trace", REQARG, 'r'},
+
 #ifdef HAVE_SMP
   {"threads", REQARG, 'T'},
 #endif
@@ -116,6 +121,10 @@ static void help(FILE *f, const char *program_name)
  "             -x, --exhaustive: plan in EXHAUSTIVE mode (may be slow)\n"
  "       -n, --no-system-wisdom: don't read /etc/fftw/ system wisdom file\n"
  "  -w FILE, --wisdom-file=FILE: read wisdom from FILE (stdin if -)\n"
+ "           -p, --cost-profile: output a profile for the ESTIMATE mode,\n"
+ "                               fitted to timings of the sizes, not wisdom\n"
+ "-s FILE, --planner-stats=FILE: write planner statistics (JSON) to FILE\n"
+ "-r FILE, --planner-trace=FILE: write a planner trace (Chrome) to FILE\n"
 #ifdef HAVE_SMP
  "            -T N, --threads=N: plan with N threads\n"
 #endif
@@ -154,6 +163,7 @@ int bench_main(int argc, char *argv[])
      int impatient = 0;
      int system_wisdom = 1;
      int canonical = 0;
+     int cost_profile = 0;
      double hours = 0;
      FILE *output_file;
      char *output_fname = 0;
@@ -244,6 +254,20 @@ int bench_main(int argc, char *argv[])
 		   system_wisdom = 0;
 		   break;
 
+	      case 'p':
+		   cost_profile = 1;
+		   break;
+
+	      case 's':
+		   planner_stats_file = my_optarg;
+		   FFTW(record_planner_stats)(1);
+		   break;
+
+	      case 'r':
+		   planner_trace_file = my_optarg;
+		   FFTW(record_planner_stats)(1);
+		   break;
+
 	      case 'w': {
 		   FILE *w = stdin;
 		   if (strcmp(my_optarg, "-") && !(w = fopen(my_optarg, "r"))) {
@@ -334,6 +358,14 @@ int bench_main(int argc, char *argv[])
 	       exit(EXIT_FAILURE);
 	  }
 
+     if (cost_profile) {
+	  if (the_flags & FFTW_ESTIMATE) {
+	       fprintf(stderr, "fftw-wisdom: cannot profile in ESTIMATE mode\n");
+	       exit(EXIT_FAILURE);
+	  }
+	  FFTW(record_cost_samples)(1);
+     }
+
      begin = time((time_t*)0);
      for (iproblem = 0; iproblem < nproblems; ++iproblem) {
 	  if (hours <= 0
@@ -348,7 +380,13 @@ int bench_main(int argc, char *argv[])
 	 && hours < (time((time_t*)0) - begin) / 3600.0)
 	  fprintf(stderr, "EXCEEDED TIME LIMIT OF %g HOURS.\n", hours);
 
-     FFTW(export_wisdom_to_file)(output_file);
+     if (cost_profile) {
+	  FFTW(record_cost_samples)(0);
+	  if (!FFTW(fit_cost_profile)() && verbose)
+	       fprintf(stderr, "fftw-wisdom: no timings, empty profile\n");
+	  FFTW(export_cost_profile_to_file)(output_file);
+     } else
+	  FFTW(export_wisdom_to_file)(output_file);
      if (output_file != stdout)
 	  fclose(output_file);
      if (output_fname)